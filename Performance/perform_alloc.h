@@ -0,0 +1,96 @@
+#ifndef TOYSTL_PERFORMANCE_PERFORM_ALLOC_H_
+#define TOYSTL_PERFORMANCE_PERFORM_ALLOC_H_
+
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "alloc.h"
+#include "profiler.h"
+
+namespace toystl {
+namespace profiler {
+// 每个线程反复申请 batch 个小对象再全部释放，对象大小在 8 ~ 128 bytes 之间轮换
+void alloc_worker(int rounds, const std::function<void*(std::size_t)>& allocate,
+                  const std::function<void(void*, std::size_t)>& deallocate) {
+  const int batch = 64;
+  void* ptrs[batch];
+  for (int r = 0; r != rounds; ++r) {
+    for (int i = 0; i != batch; ++i) {
+      ptrs[i] = allocate(((i & 15) + 1) * 8);
+    }
+    for (int i = 0; i != batch; ++i) {
+      deallocate(ptrs[i], ((i & 15) + 1) * 8);
+    }
+  }
+}
+
+void alloc_run(int threads, int rounds,
+               const std::function<void*(std::size_t)>& allocate,
+               const std::function<void(void*, std::size_t)>& deallocate) {
+  std::vector<std::thread> workers;
+  ProfilerInstance::start();
+  for (int i = 0; i != threads; ++i) {
+    workers.emplace_back(alloc_worker, rounds / threads, std::cref(allocate),
+                         std::cref(deallocate));
+  }
+  for (auto& t : workers) {
+    t.join();
+  }
+  ProfilerInstance::end();
+  ProfilerInstance::dumpDuringTime();
+}
+
+void alloc_perform() {
+  // 总工作量固定，线程数增加时每个线程分到的轮数减少
+  const int rounds = 200000;
+  const int thread_counts[] = {1, 2, 4, 8};
+
+  std::function<void*(std::size_t)> malloc_allocate = [](std::size_t n) {
+    return ::malloc(n);
+  };
+  std::function<void(void*, std::size_t)> malloc_deallocate =
+      [](void* p, std::size_t) { ::free(p); };
+  std::function<void*(std::size_t)> pool_allocate = [](std::size_t n) {
+    return toystl::alloc::allocate(n);
+  };
+  std::function<void(void*, std::size_t)> pool_deallocate =
+      [](void* p, std::size_t n) { toystl::alloc::deallocate(p, n); };
+
+  std::cout << "[------------------ Run alloc performance test "
+               "------------------]\n";
+  std::cout << "|---------------------|-------------|-------------|-------------"
+               "|-------------|\n";
+  std::cout << "|  allocate/release   |  1 thread   |  2 threads  |  4 threads  "
+               "|  8 threads  |\n";
+  std::cout << "[---------------------------- malloc "
+               "----------------------------]\n";
+  for (int threads : thread_counts) {
+    alloc_run(threads, rounds, malloc_allocate, malloc_deallocate);
+  }
+  std::cout << "\n";
+
+  std::cout << "[------------------- toystl::alloc (single pool) "
+               "-------------------]\n";
+  toystl::alloc::set_thread_cache_enabled(false);
+  for (int threads : thread_counts) {
+    alloc_run(threads, rounds, pool_allocate, pool_deallocate);
+  }
+  toystl::alloc::set_thread_cache_enabled(true);
+  std::cout << "\n";
+
+  std::cout << "[------------------- toystl::alloc (thread cache) "
+               "------------------]\n";
+  for (int threads : thread_counts) {
+    alloc_run(threads, rounds, pool_allocate, pool_deallocate);
+  }
+  std::cout << "\n";
+  ProfilerInstance::dumpAllocStats();
+  std::cout
+      << "[---------------------------------------------------------------]\n";
+}
+}  // namespace profiler
+}  // namespace toystl
+#endif  // TOYSTL_PERFORMANCE_PERFORM_ALLOC_H_
@@ -0,0 +1,150 @@
+#ifndef TOYSTL_PERFORMANCE_PERFORM_BTREE_H_
+#define TOYSTL_PERFORMANCE_PERFORM_BTREE_H_
+
+#include <algorithm>
+#include <iostream>
+#include <map>
+#include <random>
+#include <vector>
+
+#include "allocator.h"
+#include "btree_map.h"
+#include "map.h"
+#include "profiler.h"
+
+namespace toystl {
+namespace profiler {
+// 统计容器当前从分配器申请的字节数，不含内存池自身的开销
+struct btree_counting_bytes {
+  static size_t bytes;
+};
+size_t btree_counting_bytes::bytes = 0;
+
+template <class T>
+class btree_counting_allocator : public toystl::allocator<T> {
+ public:
+  template <class U>
+  class rebind {
+   public:
+    using other = btree_counting_allocator<U>;
+  };
+
+  btree_counting_allocator() noexcept {}
+  template <class U>
+  btree_counting_allocator(const btree_counting_allocator<U>&) noexcept {}
+
+  static btree_counting_allocator select_on_container_copy_construction() {
+    return btree_counting_allocator();
+  }
+
+  static T* allocate(size_t n = 1) {
+    btree_counting_bytes::bytes += sizeof(T) * n;
+    return toystl::allocator<T>::allocate(n);
+  }
+
+  static void deallocate(T* p, size_t n = 1) {
+    btree_counting_bytes::bytes -= sizeof(T) * n;
+    toystl::allocator<T>::deallocate(p, n);
+  }
+};
+
+// 每个元素平均占用的字节数
+template <class Map>
+void btree_memory_run(const std::vector<int>& keys) {
+  const size_t before = btree_counting_bytes::bytes;
+  {
+    Map map;
+    for (int key : keys) {
+      map[key] = key;
+    }
+    std::cout << "bytes per element: "
+              << static_cast<double>(btree_counting_bytes::bytes - before) /
+                     map.size()
+              << "\n";
+  }
+}
+
+// 以随机顺序逐个查找全部的键，输出总时间
+template <class Map>
+void btree_lookup_run(const Map& map, const std::vector<int>& probes) {
+  long long sum = 0;
+  ProfilerInstance::start();
+  for (int key : probes) {
+    sum += map.find(key)->second;
+  }
+  ProfilerInstance::end();
+  ProfilerInstance::dumpDuringTime();
+  volatile long long sink = sum;
+  (void)sink;
+}
+
+// 从头到尾遍历 rounds 次
+template <class Map>
+void btree_scan_run(const Map& map, int rounds) {
+  long long sum = 0;
+  ProfilerInstance::start();
+  for (int r = 0; r != rounds; ++r) {
+    for (typename Map::const_iterator it = map.begin(); it != map.end();
+         ++it) {
+      sum += it->second;
+    }
+  }
+  ProfilerInstance::end();
+  ProfilerInstance::dumpDuringTime();
+  volatile long long sink = sum;
+  (void)sink;
+}
+
+template <class Map>
+void btree_compare_run(const std::vector<int>& keys,
+                       const std::vector<int>& probes, int scan_rounds) {
+  Map map;
+  for (int key : keys) {
+    map[key] = key;
+  }
+  std::cout << "random find x" << probes.size() << ": ";
+  btree_lookup_run(map, probes);
+  std::cout << "full scan x" << scan_rounds << ": ";
+  btree_scan_run(map, scan_rounds);
+}
+
+void btree_perform() {
+  const size_t sizes[] = {1000, 100000, 1000000};
+  std::cout << "[----------------- Run Btree performance test "
+               "--------------------]\n";
+  for (size_t size : sizes) {
+    std::vector<int> keys;
+    for (size_t i = 0; i != size; ++i) {
+      keys.push_back(static_cast<int>(i * 2));
+    }
+    std::mt19937 rng(7);
+    std::shuffle(keys.begin(), keys.end(), rng);
+    // 查找次数固定为 2M，遍历的元素总数固定为 20M
+    std::vector<int> probes;
+    for (size_t i = 0; i != 2000000; ++i) {
+      probes.push_back(keys[rng() % size]);
+    }
+    const int scan_rounds = static_cast<int>(20000000 / size);
+
+    std::cout << "|  " << size << " random int -> int"
+              << "                                       |\n";
+    std::cout << "[----------- toystl::map (rb_tree) "
+                 "-------------------------------]\n";
+    btree_memory_run<toystl::map<int, int, toystl::less<int>,
+                                 btree_counting_allocator<int>>>(keys);
+    btree_compare_run<toystl::map<int, int>>(keys, probes, scan_rounds);
+    std::cout << "[----------- toystl::btree_map "
+                 "-----------------------------------]\n";
+    btree_memory_run<toystl::btree_map<int, int, toystl::less<int>,
+                                       btree_counting_allocator<int>>>(keys);
+    btree_compare_run<toystl::btree_map<int, int>>(keys, probes, scan_rounds);
+    std::cout << "[----------- std::map "
+                 "--------------------------------------------]\n";
+    btree_compare_run<std::map<int, int>>(keys, probes, scan_rounds);
+  }
+  std::cout
+      << "[---------------------------------------------------------------]\n";
+}
+}  // namespace profiler
+}  // namespace toystl
+#endif  // TOYSTL_PERFORMANCE_PERFORM_BTREE_H_
@@ -0,0 +1,115 @@
+#ifndef TOYSTL_PERFORMANCE_PERFORM_CONCURRENT_MAP_H_
+#define TOYSTL_PERFORMANCE_PERFORM_CONCURRENT_MAP_H_
+
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "concurrent_unordered_map.h"
+#include "profiler.h"
+#include "unordered_map.h"
+
+namespace toystl {
+namespace profiler {
+// 对照组：一把全局互斥锁保护的 unordered_map
+class concurrent_map_global_lock {
+ public:
+  bool find(int key, int& value) const {
+    std::lock_guard<std::mutex> guard(lock_);
+    toystl::unordered_map<int, int>::const_iterator it = map_.find(key);
+    if (it == map_.end()) {
+      return false;
+    }
+    value = it->second;
+    return true;
+  }
+
+  bool insert_or_assign(int key, int value) {
+    std::lock_guard<std::mutex> guard(lock_);
+    return map_.insert_or_assign(key, value).second;
+  }
+
+ private:
+  mutable std::mutex lock_;
+  toystl::unordered_map<int, int> map_;
+};
+
+// threads 个线程共执行 ops 次操作，其中 read_percent% 为查找，其余为
+// insert_or_assign。键值从 key_count 个键中以 xorshift 随机选取，
+// 输出总时间和每秒的操作数
+template <class Map>
+void concurrent_map_run(Map& map, int threads, int read_percent, int ops,
+                        int key_count) {
+  std::vector<std::thread> workers;
+  const int ops_per_thread = ops / threads;
+
+  ProfilerInstance::start();
+  for (int t = 0; t != threads; ++t) {
+    workers.push_back(std::thread([&map, t, read_percent, ops_per_thread,
+                                   key_count]() {
+      unsigned x = 2463534242u + t;
+      int sum = 0;
+      for (int i = 0; i != ops_per_thread; ++i) {
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        const int key = static_cast<int>(x % key_count);
+        if (static_cast<int>(x >> 25) % 100 < read_percent) {
+          int value = 0;
+          map.find(key, value);
+          sum += value;
+        } else {
+          map.insert_or_assign(key, i);
+        }
+      }
+      volatile int sink = sum;
+      (void)sink;
+    }));
+  }
+  for (std::thread& worker : workers) {
+    worker.join();
+  }
+  ProfilerInstance::end();
+  std::cout << "threads " << threads << ": total "
+            << ProfilerInstance::milliSecond() << "ms, "
+            << ops / ProfilerInstance::second() / 1e6 << " Mops/s\n";
+}
+
+template <class Map>
+void concurrent_map_scaling(int read_percent) {
+  const int thread_counts[] = {1, 2, 4, 8, 16, 32, 64};
+  const int ops = 4000000;
+  const int key_count = 100000;
+  for (int threads : thread_counts) {
+    Map map;
+    for (int key = 0; key != key_count; ++key) {
+      map.insert_or_assign(key, key);
+    }
+    concurrent_map_run(map, threads, read_percent, ops, key_count);
+  }
+  std::cout << "\n";
+}
+
+void concurrent_map_perform() {
+  const int read_percents[] = {90, 50};
+  std::cout << "[------------ Run Concurrent Map performance test "
+               "----------------]\n";
+  for (int read_percent : read_percents) {
+    std::cout << "|  4M ops on 100000 int keys, " << read_percent
+              << "% find / " << 100 - read_percent
+              << "% insert_or_assign                |\n";
+    std::cout << "[------------ unordered_map + one global mutex "
+                 "-------------------]\n";
+    concurrent_map_scaling<concurrent_map_global_lock>(read_percent);
+    std::cout << "[------------ toystl::concurrent_unordered_map (32 shards) "
+                 "-------]\n";
+    concurrent_map_scaling<toystl::concurrent_unordered_map<int, int>>(
+        read_percent);
+  }
+  std::cout
+      << "[---------------------------------------------------------------]\n";
+}
+}  // namespace profiler
+}  // namespace toystl
+#endif  // TOYSTL_PERFORMANCE_PERFORM_CONCURRENT_MAP_H_
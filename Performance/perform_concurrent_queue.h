@@ -0,0 +1,205 @@
+#ifndef TOYSTL_PERFORMANCE_PERFORM_CONCURRENT_QUEUE_H_
+#define TOYSTL_PERFORMANCE_PERFORM_CONCURRENT_QUEUE_H_
+
+#include <atomic>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "concurrent_queue.h"
+#include "profiler.h"
+#include "queue.h"
+
+namespace toystl {
+namespace profiler {
+// 对照组：一把互斥锁保护的 toystl::queue，容量与无锁队列相同
+class concurrent_queue_global_lock {
+ public:
+  explicit concurrent_queue_global_lock(size_t capacity)
+      : capacity_(capacity) {}
+
+  bool try_push(int value) {
+    std::lock_guard<std::mutex> guard(lock_);
+    if (queue_.size() == capacity_) {
+      return false;
+    }
+    queue_.push(value);
+    return true;
+  }
+
+  bool try_pop(int& value) {
+    std::lock_guard<std::mutex> guard(lock_);
+    if (queue_.empty()) {
+      return false;
+    }
+    value = queue_.front();
+    queue_.pop();
+    return true;
+  }
+
+  size_t try_push_n(const int* first, size_t n) {
+    std::lock_guard<std::mutex> guard(lock_);
+    size_t count = 0;
+    for (; count != n && queue_.size() != capacity_; ++count) {
+      queue_.push(first[count]);
+    }
+    return count;
+  }
+
+  size_t try_pop_n(int* result, size_t n) {
+    std::lock_guard<std::mutex> guard(lock_);
+    size_t count = 0;
+    for (; count != n && !queue_.empty(); ++count) {
+      result[count] = queue_.front();
+      queue_.pop();
+    }
+    return count;
+  }
+
+ private:
+  std::mutex lock_;
+  toystl::queue<int> queue_;
+  const size_t capacity_;
+};
+
+// pairs 个生产者和 pairs 个消费者共传递 items 个元素，batch 为 1 时逐个
+// try_push / try_pop，否则使用批量接口。失败时 yield 让出 CPU。
+// 输出总时间和每秒传递的元素个数
+template <class Queue>
+void concurrent_queue_run(int pairs, int batch, int items) {
+  Queue queue(1024);
+  const int per_producer = items / pairs;
+  std::atomic<long long> remaining(static_cast<long long>(per_producer) *
+                                   pairs);
+  std::vector<std::thread> workers;
+
+  ProfilerInstance::start();
+  for (int p = 0; p != pairs; ++p) {
+    workers.push_back(std::thread([&queue, per_producer, batch]() {
+      std::vector<int> values(batch, 1);
+      int sent = 0;
+      while (sent != per_producer) {
+        if (batch == 1) {
+          if (queue.try_push(sent)) {
+            ++sent;
+            continue;
+          }
+        } else {
+          const int want = per_producer - sent < batch ? per_producer - sent
+                                                       : batch;
+          const int n = static_cast<int>(queue.try_push_n(values.data(), want));
+          if (n != 0) {
+            sent += n;
+            continue;
+          }
+        }
+        std::this_thread::yield();
+      }
+    }));
+  }
+  for (int c = 0; c != pairs; ++c) {
+    workers.push_back(std::thread([&queue, &remaining, batch]() {
+      std::vector<int> values(batch);
+      long long sum = 0;
+      while (remaining.load(std::memory_order_relaxed) > 0) {
+        const size_t n = batch == 1 ? queue.try_pop(values[0])
+                                    : queue.try_pop_n(values.data(), batch);
+        if (n == 0) {
+          std::this_thread::yield();
+          continue;
+        }
+        for (size_t i = 0; i != n; ++i) {
+          sum += values[i];
+        }
+        remaining.fetch_sub(static_cast<long long>(n),
+                            std::memory_order_relaxed);
+      }
+      volatile long long sink = sum;
+      (void)sink;
+    }));
+  }
+  for (std::thread& worker : workers) {
+    worker.join();
+  }
+  ProfilerInstance::end();
+  std::cout << pairs << " producers / " << pairs << " consumers, batch "
+            << batch << ": total " << ProfilerInstance::milliSecond() << "ms, "
+            << items / ProfilerInstance::second() / 1e6 << " M items/s\n";
+}
+
+template <class Queue>
+void concurrent_queue_scaling(int batch) {
+  const int pair_counts[] = {1, 2, 4, 8, 16};
+  const int items = 4000000;
+  for (int pairs : pair_counts) {
+    concurrent_queue_run<Queue>(pairs, batch, items);
+  }
+  std::cout << "\n";
+}
+
+// 延迟：两个线程经由两个队列来回传递一个元素 rounds 次，输出平均往返时间
+template <class Queue>
+void concurrent_queue_latency(int rounds) {
+  Queue ping(1024);
+  Queue pong(1024);
+  std::thread echo([&ping, &pong, rounds]() {
+    int value = 0;
+    for (int r = 0; r != rounds; ++r) {
+      while (!ping.try_pop(value)) {
+        std::this_thread::yield();
+      }
+      while (!pong.try_push(value)) {
+        std::this_thread::yield();
+      }
+    }
+  });
+  ProfilerInstance::start();
+  int value = 0;
+  for (int r = 0; r != rounds; ++r) {
+    while (!ping.try_push(r)) {
+      std::this_thread::yield();
+    }
+    while (!pong.try_pop(value)) {
+      std::this_thread::yield();
+    }
+  }
+  ProfilerInstance::end();
+  echo.join();
+  std::cout << "round trip: " << ProfilerInstance::milliSecond() * 1e6 / rounds
+            << "ns\n";
+}
+
+void concurrent_queue_perform() {
+  std::cout << "[------------ Run Concurrent Queue performance test "
+               "--------------]\n";
+  std::cout << "|  4M int items, capacity 1024"
+            << "                                   |\n";
+  std::cout << "[------------ toystl::queue + one global mutex "
+               "------------------]\n";
+  concurrent_queue_scaling<concurrent_queue_global_lock>(1);
+  concurrent_queue_scaling<concurrent_queue_global_lock>(32);
+  std::cout << "[------------ toystl::concurrent_queue (MPMC) "
+               "-------------------]\n";
+  concurrent_queue_scaling<toystl::concurrent_queue<int>>(1);
+  concurrent_queue_scaling<toystl::concurrent_queue<int>>(32);
+  std::cout << "[------------ toystl::spsc_queue "
+               "--------------------------------]\n";
+  concurrent_queue_run<toystl::spsc_queue<int>>(1, 1, 4000000);
+  concurrent_queue_run<toystl::spsc_queue<int>>(1, 32, 4000000);
+  std::cout << "\n";
+
+  std::cout << "|  ping-pong latency, 100000 round trips"
+            << "                         |\n";
+  std::cout << "mutex: ";
+  concurrent_queue_latency<concurrent_queue_global_lock>(100000);
+  std::cout << "mpmc:  ";
+  concurrent_queue_latency<toystl::concurrent_queue<int>>(100000);
+  std::cout << "spsc:  ";
+  concurrent_queue_latency<toystl::spsc_queue<int>>(100000);
+  std::cout
+      << "[---------------------------------------------------------------]\n";
+}
+}  // namespace profiler
+}  // namespace toystl
+#endif  // TOYSTL_PERFORMANCE_PERFORM_CONCURRENT_QUEUE_H_
@@ -0,0 +1,222 @@
+#ifndef TOYSTL_PERFORMANCE_PERFORM_DEQUE_H_
+#define TOYSTL_PERFORMANCE_PERFORM_DEQUE_H_
+
+#include <cstddef>
+#include <deque>
+#include <iostream>
+#include <queue>
+#include <vector>
+
+#include "algo.h"
+#include "deque.h"
+#include "profiler.h"
+#include "queue.h"
+
+namespace toystl {
+namespace profiler {
+// 生产者 / 消费者队列：先填入 depth 个元素，之后每轮 push batch 个、
+// pop batch 个，队列长度在 depth 和 depth + batch 之间波动。
+// 输出总时间和每秒的操作数（push 和 pop 各算一次）
+template <class Queue>
+void deque_fifo_run(int depth, int batch, int ops) {
+  Queue queue;
+  for (int i = 0; i != depth; ++i) {
+    queue.push(i);
+  }
+  long long sum = 0;
+  const int rounds = ops / (2 * batch);
+  ProfilerInstance::start();
+  for (int r = 0; r != rounds; ++r) {
+    for (int i = 0; i != batch; ++i) {
+      queue.push(i);
+    }
+    for (int i = 0; i != batch; ++i) {
+      sum += queue.front();
+      queue.pop();
+    }
+  }
+  ProfilerInstance::end();
+  std::cout << "depth " << depth << ", batch " << batch << ": total "
+            << ProfilerInstance::milliSecond() << "ms, "
+            << ops / ProfilerInstance::second() / 1e6 << " Mops/s\n";
+  volatile long long sink = sum;
+  (void)sink;
+}
+
+template <class Queue>
+void deque_fifo_perform() {
+  const int depths[] = {0, 1000, 100000};
+  const int batches[] = {1, 1000};
+  const int ops = 100000000;
+  for (int depth : depths) {
+    for (int batch : batches) {
+      deque_fifo_run<Queue>(depth, batch, ops);
+    }
+  }
+  std::cout << "\n";
+}
+
+// 大小为 Size 字节的元素
+template <size_t Size>
+struct deque_element {
+  long long value;
+  char padding[Size - sizeof(long long)];
+};
+
+// 缓冲区为 BufBytes 字节时，push_back 和遍历 bytes 字节数据的耗时；
+// BufBytes 为 0 表示默认的缓冲区大小
+template <size_t Size, size_t BufBytes>
+void deque_buffer_run(size_t bytes) {
+  using element = deque_element<Size>;
+  using deque_type =
+      toystl::deque<element, toystl::allocator<element>,
+                    BufBytes == 0 ? 0 : (BufBytes < Size ? 1 : BufBytes / Size)>;
+  const size_t count = bytes / Size;
+  long long sum = 0;
+  std::cout << "buffer " << deque_type::iterator::deque_buf_size()
+            << " elements: ";
+  {
+    deque_type deque;
+    element x = element();
+    ProfilerInstance::start();
+    for (size_t i = 0; i != count; ++i) {
+      x.value = static_cast<long long>(i);
+      deque.push_back(x);
+    }
+    ProfilerInstance::end();
+    std::cout << "push_back " << count / ProfilerInstance::second() / 1e6
+              << " M/s, ";
+    ProfilerInstance::start();
+    for (int r = 0; r != 4; ++r) {
+      for (typename deque_type::const_iterator it = deque.begin();
+           it != deque.end(); ++it) {
+        sum += it->value;
+      }
+    }
+    ProfilerInstance::end();
+    std::cout << "iterate " << 4 * count / ProfilerInstance::second() / 1e6
+              << " M/s\n";
+  }
+  volatile long long sink = sum;
+  (void)sink;
+}
+
+template <size_t Size>
+void deque_buffer_perform(size_t bytes) {
+  std::cout << "|  element " << Size << " bytes"
+            << "                                              |\n";
+  deque_buffer_run<Size, 0>(bytes);
+  deque_buffer_run<Size, 512>(bytes);
+  deque_buffer_run<Size, 4096>(bytes);
+  deque_buffer_run<Size, 65536>(bytes);
+}
+
+// 10M 个 int 的 deque 上的 copy / fill / find：逐个元素跨段检查的旧版本
+// （直接调用非分段的实现），与逐段按原生指针处理的版本对比
+template <class Run>
+void deque_algo_run(const char* name, Run run) {
+  const int rounds = 20;
+  ProfilerInstance::start();
+  for (int r = 0; r != rounds; ++r) {
+    run();
+  }
+  ProfilerInstance::end();
+  std::cout << name << ": " << ProfilerInstance::milliSecond() / rounds
+            << "ms per pass\n";
+}
+
+void deque_algo_perform() {
+  using deque_type = toystl::deque<int>;
+  using iterator = deque_type::iterator;
+  const size_t count = 10000000;
+  deque_type deque;
+  std::deque<int> std_deque;
+  for (size_t i = 0; i != count; ++i) {
+    deque.push_back(static_cast<int>(i % 1000));
+    std_deque.push_back(static_cast<int>(i % 1000));
+  }
+  std::vector<int> out(count);
+  volatile long long sink = 0;
+
+  std::cout << "|  copy deque -> array"
+            << "                                          |\n";
+  deque_algo_run("element-wise", [&] {
+    toystl::__copy_dispatch<iterator, int*>()(deque.begin(), deque.end(),
+                                               out.data());
+  });
+  deque_algo_run("segmented   ", [&] {
+    toystl::copy(deque.begin(), deque.end(), out.data());
+  });
+  deque_algo_run("std::deque  ", [&] {
+    std::copy(std_deque.begin(), std_deque.end(), out.begin());
+  });
+
+  std::cout << "|  copy array -> deque"
+            << "                                          |\n";
+  deque_algo_run("element-wise", [&] {
+    toystl::__copy_dispatch<int*, iterator>()(out.data(), out.data() + count,
+                                               deque.begin());
+  });
+  deque_algo_run("segmented   ", [&] {
+    toystl::copy(out.data(), out.data() + count, deque.begin());
+  });
+  deque_algo_run("std::deque  ", [&] {
+    std::copy(out.begin(), out.end(), std_deque.begin());
+  });
+
+  std::cout << "|  fill"
+            << "                                                         |\n";
+  deque_algo_run("element-wise", [&] {
+    toystl::__fill_segmented(deque.begin(), deque.end(), 7,
+                             toystl::false_type());
+  });
+  deque_algo_run("segmented   ", [&] {
+    toystl::fill(deque.begin(), deque.end(), 7);
+  });
+  deque_algo_run("std::deque  ", [&] {
+    std::fill(std_deque.begin(), std_deque.end(), 7);
+  });
+
+  // 要找的值不存在，遍历整个区间
+  std::cout << "|  find (miss)"
+            << "                                                  |\n";
+  deque_algo_run("element-wise", [&] {
+    sink += toystl::__find_segmented(deque.begin(), deque.end(), -1,
+                                     toystl::false_type()) -
+            deque.begin();
+  });
+  deque_algo_run("segmented   ", [&] {
+    sink += toystl::find(deque.begin(), deque.end(), -1) - deque.begin();
+  });
+  deque_algo_run("std::deque  ", [&] {
+    sink += std::find(std_deque.begin(), std_deque.end(), -1) -
+            std_deque.begin();
+  });
+  (void)sink;
+}
+
+void deque_perform() {
+  std::cout << "[----------------- Run Deque performance test "
+               "--------------------]\n";
+  std::cout << "|  sustained push_back / pop_front, 100M ops"
+               "                       |\n";
+  std::cout << "[----------- toystl::queue<int> (toystl::deque) "
+               "------------------]\n";
+  deque_fifo_perform<toystl::queue<int>>();
+  std::cout << "[----------- std::queue<int> (std::deque) "
+               "------------------------]\n";
+  deque_fifo_perform<std::queue<int>>();
+  std::cout << "[----------- buffer size: push_back / iterate 64MB "
+               "--------------]\n";
+  deque_buffer_perform<8>(64 << 20);
+  deque_buffer_perform<64>(64 << 20);
+  deque_buffer_perform<1024>(64 << 20);
+  std::cout << "[----------- segmented algorithms, 10M int "
+               "-----------------------]\n";
+  deque_algo_perform();
+  std::cout
+      << "[---------------------------------------------------------------]\n";
+}
+}  // namespace profiler
+}  // namespace toystl
+#endif  // TOYSTL_PERFORMANCE_PERFORM_DEQUE_H_
@@ -0,0 +1,138 @@
+#ifndef TOYSTL_PERFORMANCE_PERFORM_HASH_H_
+#define TOYSTL_PERFORMANCE_PERFORM_HASH_H_
+
+#include <algorithm>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "hash_fun.h"
+#include "profiler.h"
+
+namespace toystl {
+namespace profiler {
+// 原先 SGI 风格的字符串哈希，保留在这里作为对照
+struct hash_sgi_string {
+  size_t operator()(const std::string& s) const {
+    size_t h = 0;
+    for (char c : s) {
+      h = 5 * h + static_cast<unsigned char>(c);
+    }
+    return h;
+  }
+};
+
+// 对每个长度生成 keys 个随机内容的字符串，反复求哈希直到处理 total 个字节
+template <class Hash>
+void hash_throughput_run(const std::vector<std::string>& keys,
+                         size_t total) {
+  volatile size_t sink = 0;
+  Hash hash_fun;
+  size_t h = 0;
+  const size_t rounds = total / (keys.size() * keys[0].size()) + 1;
+
+  ProfilerInstance::start();
+  for (size_t r = 0; r != rounds; ++r) {
+    for (const std::string& key : keys) {
+      h ^= hash_fun(key);
+    }
+  }
+  ProfilerInstance::end();
+  ProfilerInstance::dumpDuringTime();
+  sink = h;
+  (void)sink;
+}
+
+std::vector<std::string> hash_random_keys(size_t length, size_t count) {
+  std::vector<std::string> keys;
+  keys.reserve(count);
+  unsigned x = 2463534242u;
+  for (size_t i = 0; i != count; ++i) {
+    std::string key(length, ' ');
+    for (size_t j = 0; j != length; ++j) {
+      x ^= x << 13;
+      x ^= x >> 17;
+      x ^= x << 5;
+      key[j] = static_cast<char>('a' + x % 26);
+    }
+    keys.push_back(key);
+  }
+  return keys;
+}
+
+template <class Hash>
+void hash_throughput_perform(const size_t (&lengths)[6], size_t total) {
+  for (size_t length : lengths) {
+    hash_throughput_run<Hash>(hash_random_keys(length, 1024), total);
+  }
+  std::cout << "\n";
+}
+
+// 哈希质量：完整哈希值的冲突数，以及取低 20 位放进 2^20 个桶时
+// 最长的桶和空桶所占的比例（理想情况约为 1/e = 36.8%）
+template <class Hash>
+void hash_quality_run(const std::vector<std::string>& keys) {
+  const size_t bucket_count = size_t(1) << 20;
+  Hash hash_fun;
+  std::vector<size_t> hashes;
+  std::vector<unsigned> buckets(bucket_count, 0);
+  hashes.reserve(keys.size());
+  for (const std::string& key : keys) {
+    const size_t h = hash_fun(key);
+    hashes.push_back(h);
+    ++buckets[h & (bucket_count - 1)];
+  }
+  std::sort(hashes.begin(), hashes.end());
+  const size_t distinct =
+      std::unique(hashes.begin(), hashes.end()) - hashes.begin();
+  const size_t empty = std::count(buckets.begin(), buckets.end(), 0u);
+
+  std::cout << "collisions " << keys.size() - distinct << ", longest bucket "
+            << *std::max_element(buckets.begin(), buckets.end())
+            << ", empty buckets " << 100.0 * empty / bucket_count << "%\n";
+}
+
+void hash_perform() {
+  const size_t lengths[] = {8, 16, 32, 64, 256, 4096};
+  const size_t total = size_t(1) << 30;
+
+  std::cout << "[------------------ Run Hash performance test "
+               "--------------------]\n";
+  std::cout << "|  hash 1GB of keys, key length 8 / 16 / 32 / 64 / 256 / "
+               "4096 bytes |\n";
+  std::cout << "[------------------ SGI h = 5 * h + c (old) "
+               "----------------------]\n";
+  hash_throughput_perform<hash_sgi_string>(lengths, total);
+  std::cout << "[------------------ toystl::hash<std::string> "
+               "--------------------]\n";
+  hash_throughput_perform<toystl::hash<std::string>>(lengths, total);
+  std::cout
+      << "[----------------------------- std -----------------------------]\n";
+  hash_throughput_perform<std::hash<std::string>>(lengths, total);
+
+  // 前缀相同、只有末尾数字不同的 URL 型键
+  std::vector<std::string> urls;
+  const size_t count = 1000000;
+  urls.reserve(count);
+  for (size_t i = 0; i != count; ++i) {
+    urls.push_back("https://example.com/api/v1/users/" + std::to_string(i) +
+                   "/profile");
+  }
+  std::cout << "|  1000000 URL keys, 2^20 buckets (low bits) "
+               "                     |\n";
+  std::cout << "[------------------ SGI h = 5 * h + c (old) "
+               "----------------------]\n";
+  hash_quality_run<hash_sgi_string>(urls);
+  std::cout << "[------------------ toystl::hash<std::string> "
+               "--------------------]\n";
+  hash_quality_run<toystl::hash<std::string>>(urls);
+  std::cout
+      << "[----------------------------- std -----------------------------]\n";
+  hash_quality_run<std::hash<std::string>>(urls);
+  std::cout
+      << "[---------------------------------------------------------------]\n";
+}
+}  // namespace profiler
+}  // namespace toystl
+#endif  // TOYSTL_PERFORMANCE_PERFORM_HASH_H_
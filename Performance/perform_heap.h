@@ -0,0 +1,155 @@
+#ifndef TOYSTL_PERFORMANCE_PERFORM_HEAP_H_
+#define TOYSTL_PERFORMANCE_PERFORM_HEAP_H_
+
+#include <iostream>
+#include <queue>
+#include <random>
+#include <vector>
+
+#include "functional.h"
+#include "heap.h"
+#include "profiler.h"
+#include "queue.h"
+#include "vector.h"
+
+namespace toystl {
+namespace profiler {
+// 当前的二叉堆：直接在 vector 上调用 push_heap / pop_heap
+class heap_binary_baseline {
+ public:
+  void push(unsigned value) {
+    c_.push_back(value);
+    toystl::push_heap(c_.begin(), c_.end(), toystl::greater<unsigned>());
+  }
+  void pop() {
+    toystl::pop_heap(c_.begin(), c_.end(), toystl::greater<unsigned>());
+    c_.pop_back();
+  }
+  unsigned top() const { return c_.front(); }
+  bool empty() const { return c_.empty(); }
+
+ private:
+  toystl::vector<unsigned> c_;
+};
+
+// 定时器队列（小顶堆）：先 push size 个随机时刻，再执行 hold 次
+// “取出最早的定时器、在其后随机一段时间重新加入”，最后全部 pop。
+// 分别输出三个阶段的时间
+template <class Queue>
+void heap_timer_run(const std::vector<unsigned>& deadlines, int hold) {
+  Queue queue;
+  unsigned long long sum = 0;
+  ProfilerInstance::start();
+  for (unsigned d : deadlines) {
+    queue.push(d);
+  }
+  ProfilerInstance::end();
+  std::cout << "push " << ProfilerInstance::milliSecond() << "ms, ";
+
+  unsigned x = 2463534242u;
+  ProfilerInstance::start();
+  for (int i = 0; i != hold; ++i) {
+    const unsigned now = queue.top();
+    queue.pop();
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    queue.push(now + (x & 0xfffff));
+  }
+  ProfilerInstance::end();
+  std::cout << "hold " << ProfilerInstance::milliSecond() << "ms, ";
+
+  ProfilerInstance::start();
+  while (!queue.empty()) {
+    sum += queue.top();
+    queue.pop();
+  }
+  ProfilerInstance::end();
+  std::cout << "pop all " << ProfilerInstance::milliSecond() << "ms\n";
+  volatile unsigned long long sink = sum;
+  (void)sink;
+}
+
+// 调度器：size 个定时器中随机选 ops 个提前，
+// decrease_key 与 “erase 再 push” 两种做法对比
+template <size_t Arity>
+void heap_decrease_key_run(const std::vector<unsigned>& deadlines, int ops) {
+  using queue_type = toystl::indexed_priority_queue<
+      unsigned, toystl::greater<unsigned>, Arity>;
+  queue_type a;
+  queue_type b;
+  std::vector<size_t> handles;
+  for (unsigned d : deadlines) {
+    handles.push_back(a.push(d));
+    b.push(d);
+  }
+  std::mt19937 rng(3);
+  std::vector<size_t> picks;
+  for (int i = 0; i != ops; ++i) {
+    picks.push_back(handles[rng() % handles.size()]);
+  }
+
+  ProfilerInstance::start();
+  for (size_t h : picks) {
+    a.decrease_key(h, a.get(h) / 2);
+  }
+  ProfilerInstance::end();
+  std::cout << "arity " << Arity << ": decrease_key "
+            << ProfilerInstance::milliSecond() << "ms, ";
+
+  ProfilerInstance::start();
+  for (size_t h : picks) {
+    const unsigned d = b.get(h) / 2;
+    b.erase(h);
+    b.push(d);  // 刚释放的 handle 被复用，仍然是 h
+  }
+  ProfilerInstance::end();
+  std::cout << "erase + push " << ProfilerInstance::milliSecond() << "ms\n";
+}
+
+void heap_perform() {
+  const size_t sizes[] = {100000, 10000000};
+  const int hold = 5000000;
+  std::cout << "[----------------- Run Heap performance test "
+               "---------------------]\n";
+  for (size_t size : sizes) {
+    std::mt19937 rng(7);
+    std::vector<unsigned> deadlines;
+    for (size_t i = 0; i != size; ++i) {
+      deadlines.push_back(rng());
+    }
+    std::cout << "|  timer queue, " << size << " entries, 5M hold ops"
+              << "                       |\n";
+    std::cout << "binary push_heap / pop_heap:   ";
+    heap_timer_run<heap_binary_baseline>(deadlines, hold);
+    std::cout << "priority_queue, arity 2:       ";
+    heap_timer_run<toystl::priority_queue<
+        unsigned, toystl::vector<unsigned>, toystl::greater<unsigned>, 2>>(
+        deadlines, hold);
+    std::cout << "priority_queue, arity 4:       ";
+    heap_timer_run<toystl::priority_queue<
+        unsigned, toystl::vector<unsigned>, toystl::greater<unsigned>, 4>>(
+        deadlines, hold);
+    std::cout << "priority_queue, arity 8:       ";
+    heap_timer_run<toystl::priority_queue<
+        unsigned, toystl::vector<unsigned>, toystl::greater<unsigned>, 8>>(
+        deadlines, hold);
+    std::cout << "indexed_priority_queue, 4:     ";
+    heap_timer_run<toystl::indexed_priority_queue<
+        unsigned, toystl::greater<unsigned>, 4>>(deadlines, hold);
+    std::cout << "std::priority_queue:           ";
+    heap_timer_run<std::priority_queue<unsigned, std::vector<unsigned>,
+                                       std::greater<unsigned>>>(deadlines,
+                                                                hold);
+    std::cout << "|  reschedule 1M random timers"
+              << "                                   |\n";
+    heap_decrease_key_run<2>(deadlines, 1000000);
+    heap_decrease_key_run<4>(deadlines, 1000000);
+    std::cout << "\n";
+  }
+  std::cout
+      << "[---------------------------------------------------------------]\n";
+}
+}  // namespace profiler
+}  // namespace toystl
+#endif  // TOYSTL_PERFORMANCE_PERFORM_HEAP_H_
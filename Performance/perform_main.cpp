@@ -1,5 +1,25 @@
+#include "perform_alloc.h"
+#include "perform_btree.h"
+#include "perform_concurrent_map.h"
+#include "perform_concurrent_queue.h"
+#include "perform_deque.h"
+#include "perform_hash.h"
+#include "perform_heap.h"
+#include "perform_map.h"
+#include "perform_unordered_map.h"
 #include "perform_vector.h"
 
 using namespace toystl::profiler;
 
-int main() { vector_perform(); }
+int main() {
+  alloc_perform();
+  vector_perform();
+  unordered_map_perform();
+  hash_perform();
+  concurrent_map_perform();
+  map_perform();
+  btree_perform();
+  deque_perform();
+  concurrent_queue_perform();
+  heap_perform();
+}
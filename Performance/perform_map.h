@@ -0,0 +1,103 @@
+#ifndef TOYSTL_PERFORMANCE_PERFORM_MAP_H_
+#define TOYSTL_PERFORMANCE_PERFORM_MAP_H_
+
+#include <iostream>
+#include <map>
+#include <utility>
+#include <vector>
+
+#include "map.h"
+#include "profiler.h"
+
+namespace toystl {
+namespace profiler {
+// 模拟启动时从有序的快照中载入 map：以区间构造函数一次建好
+template <class Map, class Values>
+void map_load_run(const Values& values) {
+  ProfilerInstance::start();
+  Map map(values.begin(), values.end());
+  ProfilerInstance::end();
+  ProfilerInstance::dumpDuringTime();
+  if (map.size() != values.size()) {
+    std::cout << "size mismatch\n";
+  }
+}
+
+// 对照组：同样的有序数据逐个 insert
+template <class Map, class Values>
+void map_insert_run(const Values& values) {
+  ProfilerInstance::start();
+  Map map;
+  for (typename Values::const_iterator it = values.begin();
+       it != values.end(); ++it) {
+    map.insert(*it);
+  }
+  ProfilerInstance::end();
+  ProfilerInstance::dumpDuringTime();
+}
+
+// 顺序追加递增的键值（时间戳、序列号），hinted 为 true 时以 end() 作为提示
+template <class Map>
+void map_append_run(int count, bool hinted) {
+  typedef typename Map::value_type value_type;
+  Map map;
+  ProfilerInstance::start();
+  if (hinted) {
+    for (int key = 0; key != count; ++key) {
+      map.insert(map.end(), value_type(key, key));
+    }
+  } else {
+    for (int key = 0; key != count; ++key) {
+      map.insert(value_type(key, key));
+    }
+  }
+  ProfilerInstance::end();
+  ProfilerInstance::dumpDuringTime();
+}
+
+void map_perform() {
+  const size_t sizes[] = {1000000, 10000000};
+  std::cout << "[----------------- Run Map performance test "
+               "----------------------]\n";
+  std::cout << "|  load sorted int keys at startup (snapshot -> map)"
+               "               |\n";
+  for (size_t i = 0; i != 2; ++i) {
+    std::vector<toystl::pair<const int, int>> values;
+    std::vector<std::pair<const int, int>> std_values;
+    values.reserve(sizes[i]);
+    std_values.reserve(sizes[i]);
+    for (size_t k = 0; k != sizes[i]; ++k) {
+      values.push_back(toystl::pair<const int, int>(static_cast<int>(k), 0));
+      std_values.push_back(std::pair<const int, int>(static_cast<int>(k), 0));
+    }
+    std::cout << "[----------- " << sizes[i]
+              << " keys, toystl::map (range constructor) ----------]\n";
+    map_load_run<toystl::map<int, int>>(values);
+    std::cout << "[----------- " << sizes[i]
+              << " keys, toystl::map (insert one by one) ----------]\n";
+    map_insert_run<toystl::map<int, int>>(values);
+    std::cout << "[----------- " << sizes[i]
+              << " keys, std::map (range constructor) -------------]\n";
+    map_load_run<std::map<int, int>>(std_values);
+  }
+
+  std::cout << "|  append increasing int keys one at a time"
+               "                        |\n";
+  for (size_t i = 0; i != 2; ++i) {
+    const int count = static_cast<int>(sizes[i]);
+    std::cout << "[----------- " << count
+              << " keys, toystl::map insert(value) ----------------]\n";
+    map_append_run<toystl::map<int, int>>(count, false);
+    std::cout << "[----------- " << count
+              << " keys, toystl::map insert(end(), value) ---------]\n";
+    map_append_run<toystl::map<int, int>>(count, true);
+    std::cout << "[----------- " << count
+              << " keys, std::map insert(end(), value) ------------]\n";
+    map_append_run<std::map<int, int>>(count, true);
+  }
+  std::cout
+      << "[---------------------------------------------------------------]\n";
+}
+}  // namespace profiler
+}  // namespace toystl
+#endif  // TOYSTL_PERFORMANCE_PERFORM_MAP_H_
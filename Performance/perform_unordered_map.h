@@ -0,0 +1,287 @@
+#ifndef TOYSTL_PERFORMANCE_PERFORM_UNORDERED_MAP_H_
+#define TOYSTL_PERFORMANCE_PERFORM_UNORDERED_MAP_H_
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "flat_unordered_map.h"
+#include "profiler.h"
+#include "unordered_map.h"
+
+namespace toystl {
+namespace profiler {
+// 以 xorshift 生成互不相同的乱序键，避免连续整数让链式表的恒等哈希占便宜
+std::vector<int> unordered_map_keys(int count) {
+  std::vector<int> keys;
+  keys.reserve(count);
+  unsigned x = 2463534242u;
+  for (int i = 0; i != count; ++i) {
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    keys.push_back(static_cast<int>(x));
+  }
+  return keys;
+}
+
+// 依次计时：插入全部键、查找全部键和同样多的不存在的键、删除全部键
+template <class Map>
+void unordered_map_run(const std::vector<int>& keys,
+                       const std::vector<int>& misses) {
+  typedef typename Map::value_type value_type;
+  // 防止编译器把查找循环优化掉
+  volatile size_t sink = 0;
+  Map map;
+
+  ProfilerInstance::start();
+  for (int key : keys) {
+    map.insert(value_type(key, key));
+  }
+  ProfilerInstance::end();
+  ProfilerInstance::dumpDuringTime();
+
+  ProfilerInstance::start();
+  size_t found = 0;
+  for (int key : keys) {
+    found += map.find(key) != map.end();
+  }
+  for (int key : misses) {
+    found += map.find(key) != map.end();
+  }
+  ProfilerInstance::end();
+  ProfilerInstance::dumpDuringTime();
+  sink = found;
+
+  ProfilerInstance::start();
+  for (int key : keys) {
+    map.erase(key);
+  }
+  ProfilerInstance::end();
+  ProfilerInstance::dumpDuringTime();
+  std::cout << "\n";
+  (void)sink;
+}
+
+// 表格建好之后反复查找其中的键，共查找 lookups 次，只计查找的时间
+template <class Map>
+void unordered_map_lookup_run(const std::vector<int>& keys, int lookups) {
+  typedef typename Map::value_type value_type;
+  volatile size_t sink = 0;
+  Map map;
+  for (int key : keys) {
+    map.insert(value_type(key, key));
+  }
+
+  ProfilerInstance::start();
+  size_t sum = 0;
+  for (int r = lookups / static_cast<int>(keys.size()); r > 0; --r) {
+    for (int key : keys) {
+      sum += map.find(key)->second;
+    }
+  }
+  ProfilerInstance::end();
+  ProfilerInstance::dumpDuringTime();
+  sink = sum;
+  (void)sink;
+}
+
+template <class Map>
+void unordered_map_lookup_perform(const std::vector<int>& all,
+                                  const int (&sizes)[3], int lookups) {
+  for (int size : sizes) {
+    std::vector<int> keys(all.begin(), all.begin() + size);
+    unordered_map_lookup_run<Map>(keys, lookups);
+  }
+  std::cout << "\n";
+}
+
+// 逐个记录每次插入的耗时，输出总时间以及 p50 / p99 / p999 / 最大值。
+// 一次性 rehash 只发生在少数几次插入上，平均值看不出来，要看尾延迟
+template <class Map>
+void unordered_map_tail_run(const std::vector<int>& keys) {
+  typedef typename Map::value_type value_type;
+  typedef std::chrono::steady_clock clock;
+  std::vector<double> latency;  // 单位 us
+  latency.reserve(keys.size());
+  Map map;
+
+  ProfilerInstance::start();
+  for (int key : keys) {
+    clock::time_point begin = clock::now();
+    map.insert(value_type(key, key));
+    latency.push_back(
+        std::chrono::duration<double, std::micro>(clock::now() - begin)
+            .count());
+  }
+  ProfilerInstance::end();
+  ProfilerInstance::dumpDuringTime();
+
+  std::sort(latency.begin(), latency.end());
+  const size_t n = latency.size();
+  std::cout << "p50 " << latency[n / 2] << "us, p99 " << latency[n * 99 / 100]
+            << "us, p999 " << latency[n * 999 / 1000] << "us, max "
+            << latency[n - 1] / 1000 << "ms\n\n";
+}
+
+// 以 hash_string 求字符串的哈希，每次都要走完整个字符串
+struct unordered_map_string_hash {
+  size_t operator()(const std::string& s) const {
+    return toystl::hash_string(s.c_str());
+  }
+};
+
+// 同样的哈希函数，但是不在节点中缓存哈希值
+struct unordered_map_uncached_string_hash : unordered_map_string_hash {};
+}  // namespace profiler
+
+template <>
+struct hashtable_cache_hash<std::string,
+                            profiler::unordered_map_uncached_string_hash>
+    : false_type {};
+
+namespace profiler {
+// 生成 count 个长度为 40 左右、前缀相同的字符串键
+std::vector<std::string> unordered_map_string_keys(int count) {
+  std::vector<std::string> keys;
+  keys.reserve(count);
+  for (int key : unordered_map_keys(count)) {
+    keys.push_back("/user/profile/session/" + std::to_string(key));
+  }
+  return keys;
+}
+
+// 依次计时：插入全部键（包含各次 rehash）、遍历整张表 10 次、查找全部键
+template <class Map>
+void unordered_map_string_run(const std::vector<std::string>& keys) {
+  typedef typename Map::value_type value_type;
+  volatile size_t sink = 0;
+  Map map;
+
+  ProfilerInstance::start();
+  for (size_t i = 0; i != keys.size(); ++i) {
+    map.insert(value_type(keys[i], static_cast<int>(i)));
+  }
+  ProfilerInstance::end();
+  ProfilerInstance::dumpDuringTime();
+
+  ProfilerInstance::start();
+  size_t sum = 0;
+  for (int r = 0; r != 10; ++r) {
+    for (auto it = map.begin(); it != map.end(); ++it) {
+      sum += it->second;
+    }
+  }
+  ProfilerInstance::end();
+  ProfilerInstance::dumpDuringTime();
+
+  ProfilerInstance::start();
+  for (const std::string& key : keys) {
+    sum += map.find(key)->second;
+  }
+  ProfilerInstance::end();
+  ProfilerInstance::dumpDuringTime();
+  std::cout << "\n";
+  sink = sum;
+  (void)sink;
+}
+
+void unordered_map_perform() {
+  typedef toystl::unordered_map<
+      int, int, toystl::hash<int>, toystl::equal_to<int>,
+      toystl::allocator<toystl::pair<const int, int>>,
+      toystl::hashtable_power2_policy>
+      power2_map;
+  const int count = 1000000;
+  // 前一半作为插入的键，后一半作为查找失败的键
+  std::vector<int> all = unordered_map_keys(count * 2);
+  std::vector<int> keys(all.begin(), all.begin() + count);
+  std::vector<int> misses(all.begin() + count, all.end());
+
+  std::cout << "[-------------- Run Unordered Map performance test "
+               "--------------]\n";
+  std::cout << "|---------------------|-------------|-------------|----------"
+               "---|\n";
+  std::cout << "|   1000000 int keys  |    insert   |  find (x2)  |    erase"
+               "    |\n";
+  std::cout << "[-------------- toystl::flat_unordered_map (open) "
+               "---------------]\n";
+  unordered_map_run<toystl::flat_unordered_map<int, int>>(keys, misses);
+  std::cout << "[----------- toystl::unordered_map (chained, prime) "
+               "-------------]\n";
+  unordered_map_run<toystl::unordered_map<int, int>>(keys, misses);
+  std::cout << "[---------- toystl::unordered_map (chained, power2) "
+               "-------------]\n";
+  unordered_map_run<power2_map>(keys, misses);
+  std::cout
+      << "[----------------------------- std -----------------------------]\n";
+  unordered_map_run<std::unordered_map<int, int>>(keys, misses);
+
+  const int sizes[] = {10000, 100000, 1000000};
+  const int lookups = 20000000;
+  std::cout << "|---------------------|-------------|-------------|----------"
+               "---|\n";
+  std::cout << "|  20M hits in table  |  10000 keys | 100000 keys |  1M keys "
+               "   |\n";
+  std::cout << "[-------------- toystl::flat_unordered_map (open) "
+               "---------------]\n";
+  unordered_map_lookup_perform<toystl::flat_unordered_map<int, int>>(
+      all, sizes, lookups);
+  std::cout << "[----------- toystl::unordered_map (chained, prime) "
+               "-------------]\n";
+  unordered_map_lookup_perform<toystl::unordered_map<int, int>>(all, sizes,
+                                                                lookups);
+  std::cout << "[---------- toystl::unordered_map (chained, power2) "
+               "-------------]\n";
+  unordered_map_lookup_perform<power2_map>(all, sizes, lookups);
+  std::cout
+      << "[----------------------------- std -----------------------------]\n";
+  unordered_map_lookup_perform<std::unordered_map<int, int>>(all, sizes,
+                                                             lookups);
+
+  std::vector<int> many = unordered_map_keys(5000000);
+  std::cout << "|---------------------|-------------|-------------|----------"
+               "---|\n";
+  std::cout << "|   insert 5M keys, latency of each insert  "
+               "                    |\n";
+  std::cout << "[----------- toystl::unordered_map (chained, prime) "
+               "-------------]\n";
+  unordered_map_tail_run<toystl::unordered_map<int, int>>(many);
+  std::cout << "[-------- toystl::unordered_map (incremental rehash) "
+               "------------]\n";
+  unordered_map_tail_run<toystl::unordered_map<
+      int, int, toystl::hash<int>, toystl::equal_to<int>,
+      toystl::allocator<toystl::pair<const int, int>>,
+      toystl::hashtable_incremental_policy<>>>(many);
+  std::cout
+      << "[----------------------------- std -----------------------------]\n";
+  unordered_map_tail_run<std::unordered_map<int, int>>(many);
+
+  std::vector<std::string> strings = unordered_map_string_keys(count);
+  std::cout << "|---------------------|-------------|-------------|----------"
+               "---|\n";
+  std::cout << "|  1000000 string keys|    insert   | iterate x10 |    find "
+               "    |\n";
+  std::cout << "[--------- toystl::unordered_map (hash not cached) "
+               "--------------]\n";
+  unordered_map_string_run<toystl::unordered_map<
+      std::string, int, unordered_map_uncached_string_hash>>(strings);
+  std::cout << "[----------- toystl::unordered_map (hash cached) "
+               "----------------]\n";
+  unordered_map_string_run<
+      toystl::unordered_map<std::string, int, unordered_map_string_hash>>(
+      strings);
+  std::cout
+      << "[----------------------------- std -----------------------------]\n";
+  unordered_map_string_run<
+      std::unordered_map<std::string, int, unordered_map_string_hash>>(
+      strings);
+  std::cout
+      << "[---------------------------------------------------------------]\n";
+}
+}  // namespace profiler
+}  // namespace toystl
+#endif  // TOYSTL_PERFORMANCE_PERFORM_UNORDERED_MAP_H_
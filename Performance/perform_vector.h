@@ -1,79 +1,114 @@
 #ifndef TOYSTL_PERFORMANCE_PERFORM_VECTOR_H_
 #define TOYSTL_PERFORMANCE_PERFORM_VECTOR_H_
 
-#include <unistd.h>
-#include <functional>
-#include <string>
+#include <iostream>
 #include <vector>
 
 #include "profiler.h"
+#include "small_vector.h"
 #include "vector.h"
 
-namespace toystl
-{
-  namespace profiler
-  {
-    void vector_perform()
-    {
-      {
-        std::cout << "[----------------- Run Vector performance test "
-                     "-----------------]\n";
-        std::cout << "|---------------------|-------------|-------------|----------"
-                     "---|\n";
-        std::cout << "|      push_back      |    500000   |   5000000   |   "
-                     "50000000  |\n";
-        std::cout << "[---------------------------- toystl "
-                     "----------------------------]\n";
-        int count = 500000;
-        // toystl
-        toystl::vector<int> mvec;
-        // 1
-        ProfilerInstance::start();
-        for (int i = 0; i != count; ++i)
-          mvec.push_back(1);
-        ProfilerInstance::end();
-        ProfilerInstance::dumpDuringTime();
-        // 2
-        ProfilerInstance::start();
-        for (int i = 0; i != count * 10; ++i)
-          mvec.push_back(1);
-        ProfilerInstance::end();
-        ProfilerInstance::dumpDuringTime();
-        // 3
-        ProfilerInstance::start();
-        for (int i = 0; i != count * 100; ++i)
-          mvec.push_back(1);
-        ProfilerInstance::end();
-        ProfilerInstance::dumpDuringTime();
-        std::cout << "\n";
-      }
-      std::cout
-          << "[----------------------------- std -----------------------------]\n";
-      int count = 500000;
-      // std
-      std::vector<int> svec;
-      // 1
-      ProfilerInstance::start();
-      for (int i = 0; i != count; ++i)
-        svec.push_back(1);
-      ProfilerInstance::end();
-      ProfilerInstance::dumpDuringTime();
-      // 2
-      ProfilerInstance::start();
-      for (int i = 0; i != count * 10; ++i)
-        svec.push_back(1);
-      ProfilerInstance::end();
-      ProfilerInstance::dumpDuringTime();
-      // 3
-      ProfilerInstance::start();
-      for (int i = 0; i != count * 100; ++i)
-        svec.push_back(1);
-      ProfilerInstance::end();
-      ProfilerInstance::dumpDuringTime();
-      std::cout << "\n";
-      std::cout
-          << "[---------------------------------------------------------------]\n";
+namespace toystl {
+namespace profiler {
+// 没有特化 __type_traits 的 int 包装，扩容时逐个搬移元素，作为对照组
+struct boxed_int {
+  boxed_int(int v) : value(v) {}
+  int value;
+};
+
+// 每组规模都从空 vector 开始 push_back，计时包含全部扩容
+template <class Vector>
+void vector_push_back_run(int count) {
+  Vector vec;
+  ProfilerInstance::start();
+  for (int i = 0; i != count; ++i) {
+    vec.push_back(i);
+  }
+  ProfilerInstance::end();
+  ProfilerInstance::dumpDuringTime();
+}
+
+template <class Vector>
+void vector_push_back_perform(const int (&counts)[3]) {
+  for (int count : counts) {
+    vector_push_back_run<Vector>(count);
+  }
+  std::cout << "\n";
+}
+
+// 反复创建只装少量元素的临时 vector，对应每个请求内的小集合
+template <class Vector>
+void small_push_back_run(int rounds, int elements) {
+  // 防止编译器把整个循环优化掉
+  volatile int sink = 0;
+  ProfilerInstance::start();
+  for (int r = 0; r != rounds; ++r) {
+    Vector vec;
+    for (int i = 0; i != elements; ++i) {
+      vec.push_back(i);
     }
-  } // namespace profiler
-} // namespace toystl
-#endif // TOYSTL_PERFORMANCE_PERFORM_VECTOR_H_
\ No newline at end of file
+    sink = vec.back();
+  }
+  ProfilerInstance::end();
+  ProfilerInstance::dumpDuringTime();
+  (void)sink;
+}
+
+template <class Vector>
+void small_push_back_perform(int rounds) {
+  const int elements[] = {4, 8, 16};
+  for (int n : elements) {
+    small_push_back_run<Vector>(rounds, n);
+  }
+  std::cout << "\n";
+}
+
+void vector_perform() {
+  const int counts[] = {500000, 5000000, 50000000};
+
+  std::cout << "[----------------- Run Vector performance test "
+               "-----------------]\n";
+  std::cout << "|---------------------|-------------|-------------|----------"
+               "---|\n";
+  std::cout << "|      push_back      |    500000   |   5000000   |   "
+               "50000000  |\n";
+  std::cout << "[------------------ toystl (int, realloc) "
+               "-----------------------]\n";
+  vector_push_back_perform<toystl::vector<int>>(counts);
+  std::cout << "[---------------- toystl (boxed int, copy) "
+               "----------------------]\n";
+  vector_push_back_perform<toystl::vector<boxed_int>>(counts);
+  std::cout << "[------------------ toystl (int, 1.5x growth) "
+               "-------------------]\n";
+  vector_push_back_perform<
+      toystl::vector<int, toystl::allocator<int>, toystl::vector_growth_1_5x>>(
+      counts);
+  std::cout << "[---------------- toystl (int, page aligned) "
+               "--------------------]\n";
+  vector_push_back_perform<toystl::vector<
+      int, toystl::allocator<int>, toystl::vector_growth_page_aligned<>>>(
+      counts);
+  std::cout
+      << "[----------------------------- std -----------------------------]\n";
+  vector_push_back_perform<std::vector<int>>(counts);
+
+  const int rounds = 1000000;
+  std::cout << "|---------------------|-------------|-------------|----------"
+               "---|\n";
+  std::cout << "| 1M vectors, each of |  4 elements |  8 elements | "
+               "16 elements |\n";
+  std::cout << "[--------------------- toystl::vector "
+               "---------------------------]\n";
+  small_push_back_perform<toystl::vector<int>>(rounds);
+  std::cout << "[------------------ toystl::small_vector<16> "
+               "--------------------]\n";
+  small_push_back_perform<toystl::small_vector<int, 16>>(rounds);
+  std::cout
+      << "[----------------------------- std -----------------------------]\n";
+  small_push_back_perform<std::vector<int>>(rounds);
+  std::cout
+      << "[---------------------------------------------------------------]\n";
+}
+}  // namespace profiler
+}  // namespace toystl
+#endif  // TOYSTL_PERFORMANCE_PERFORM_VECTOR_H_
@@ -1,5 +1,7 @@
 #include "profiler.h"
 
+#include <iomanip>
+
 namespace toystl {
 namespace profiler {
 ProfilerInstance::DurationTime ProfilerInstance::duringTime_;
@@ -45,5 +47,34 @@ size_t ProfilerInstance::memory(MemoryUnit mu) {
 
   return memory;
 }
+
+void ProfilerInstance::dumpAllocStats(std::ostream& os) {
+  toystl::alloc::pool_stats s = toystl::alloc::stats();
+  os << "[alloc] chunks " << s.chunk_count << ", heap " << s.heap_bytes
+     << " bytes, free list " << s.free_list_bytes << " bytes, pool "
+     << s.pool_bytes << " bytes, handed out " << s.handed_out_bytes
+     << " bytes\n";
+  if (s.heap_bytes != 0) {
+    // 空闲但无法归还系统的内存占比，可用来观察碎片情况
+    os << "[alloc] idle ratio " << std::fixed << std::setprecision(2)
+       << 100.0 * (s.free_list_bytes + s.pool_bytes) / s.heap_bytes << "%\n";
+  }
+  os << "[alloc] malloc " << s.malloc_count << ", scavenge "
+     << s.scavenge_count << ", trim " << s.trim_count << "\n";
+  os << "|   size |  free blocks |         hits |       misses | hit rate |\n";
+  for (std::size_t i = 0; i != s.class_count; ++i) {
+    const toystl::alloc::class_stats& cs = s.classes[i];
+    if (cs.free_blocks == 0 && cs.hits == 0 && cs.misses == 0) {
+      continue;
+    }
+    std::size_t requests = cs.hits + cs.misses;
+    os << "| " << std::setw(6) << cs.size << " | " << std::setw(12)
+       << cs.free_blocks << " | " << std::setw(12) << cs.hits << " | "
+       << std::setw(12) << cs.misses << " | " << std::setw(7)
+       << std::fixed << std::setprecision(2)
+       << (requests == 0 ? 0.0 : 100.0 * cs.hits / requests) << "% |\n";
+  }
+  os << std::defaultfloat << std::flush;
+}
 }  // namespace profiler
 }  // namespace toystl
\ No newline at end of file
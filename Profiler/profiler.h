@@ -8,6 +8,8 @@
 #include <ctime>
 #include <iostream>
 
+#include "alloc.h"
+
 namespace toystl {
 namespace profiler {
 class ProfilerInstance {
@@ -41,6 +43,10 @@ class ProfilerInstance {
 
   static size_t memory(
       MemoryUnit mu = MemoryUnit::KB_);  // 查询当前程序的内存使用量
+
+  // 输出 toystl::alloc 内存池的统计信息，各 size class 的命中率需要以
+  // TOYSTL_ALLOC_STATS 编译
+  static void dumpAllocStats(std::ostream& os = std::cout);
 };
 }  // namespace profiler
 }  // namespace toystl
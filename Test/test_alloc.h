@@ -0,0 +1,192 @@
+#ifndef TOYSTL_TEST_TEST_ALLOC_H_
+#define TOYSTL_TEST_TEST_ALLOC_H_
+
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "alloc.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace toystl {
+namespace alloctest {
+// 每个区块写满自己的编号，释放前检查内容，若有两个线程拿到同一区块就会被发现
+void FillAndCheck(int id, int rounds) {
+  std::vector<void*> ptrs;
+  for (int r = 0; r != rounds; ++r) {
+    for (std::size_t bytes = 8; bytes <= 128; bytes += 8) {
+      void* p = toystl::alloc::allocate(bytes);
+      std::memset(p, id, bytes);
+      ptrs.push_back(p);
+    }
+    if (r % 3 == 2) {
+      for (std::size_t i = 0; i != ptrs.size(); ++i) {
+        std::size_t bytes = (i % 16 + 1) * 8;
+        const unsigned char* c = static_cast<const unsigned char*>(ptrs[i]);
+        for (std::size_t j = 0; j != bytes; ++j) {
+          ASSERT_EQ(c[j], static_cast<unsigned char>(id));
+        }
+        toystl::alloc::deallocate(ptrs[i], bytes);
+      }
+      ptrs.clear();
+    }
+  }
+  for (std::size_t i = 0; i != ptrs.size(); ++i) {
+    toystl::alloc::deallocate(ptrs[i], (i % 16 + 1) * 8);
+  }
+}
+
+TEST(TestAlloc, SingleThread) {
+  void* p = toystl::alloc::allocate(24);
+  void* q = toystl::alloc::allocate(24);
+  EXPECT_NE(p, q);
+  toystl::alloc::deallocate(q, 24);
+  toystl::alloc::deallocate(p, 24);
+  // 刚释放的区块会被优先复用
+  void* r = toystl::alloc::allocate(24);
+  EXPECT_EQ(r, p);
+  toystl::alloc::deallocate(r, 24);
+}
+
+TEST(TestAlloc, LargeSizeClasses) {
+  // 128 bytes 以上的请求同样由内存池提供，各区块互不重叠
+  std::vector<std::pair<unsigned char*, std::size_t>> blocks;
+  for (std::size_t bytes = 120; bytes <= TOYSTL_ALLOC_MAX_BYTES; bytes += 37) {
+    unsigned char* p =
+        static_cast<unsigned char*>(toystl::alloc::allocate(bytes));
+    std::memset(p, static_cast<int>(bytes & 0xff), bytes);
+    blocks.push_back(std::make_pair(p, bytes));
+  }
+  for (auto& b : blocks) {
+    for (std::size_t j = 0; j != b.second; ++j) {
+      ASSERT_EQ(b.first[j], static_cast<unsigned char>(b.second & 0xff));
+    }
+    toystl::alloc::deallocate(b.first, b.second);
+  }
+
+#if TOYSTL_ALLOC_MAX_BYTES >= 512
+  // 512 bytes 的 deque 缓冲区由内存池分配，释放后立即被复用
+  void* buf = toystl::alloc::allocate(512);
+  toystl::alloc::deallocate(buf, 512);
+  void* again = toystl::alloc::allocate(500);
+  EXPECT_EQ(again, buf);
+  toystl::alloc::deallocate(again, 500);
+#endif
+}
+
+TEST(TestAlloc, MultiThread) {
+  std::vector<std::thread> workers;
+  for (int id = 1; id <= 8; ++id) {
+    workers.emplace_back(FillAndCheck, id, 300);
+  }
+  for (auto& t : workers) {
+    t.join();
+  }
+}
+
+TEST(TestAlloc, CrossThreadRelease) {
+  // 一个线程分配，另一个线程释放
+  std::vector<void*> ptrs;
+  std::thread producer([&ptrs]() {
+    for (int i = 0; i != 1000; ++i) {
+      ptrs.push_back(toystl::alloc::allocate(32));
+    }
+  });
+  producer.join();
+  std::thread consumer([&ptrs]() {
+    for (void* p : ptrs) {
+      toystl::alloc::deallocate(p, 32);
+    }
+  });
+  consumer.join();
+  FillAndCheck(9, 30);
+}
+
+TEST(TestAlloc, WithoutThreadCache) {
+  toystl::alloc::set_thread_cache_enabled(false);
+  std::vector<std::thread> workers;
+  for (int id = 1; id <= 4; ++id) {
+    workers.emplace_back(FillAndCheck, id, 100);
+  }
+  for (auto& t : workers) {
+    t.join();
+  }
+  toystl::alloc::set_thread_cache_enabled(true);
+}
+// 在新线程中分配大量区块后全部释放，线程退出时 cache 归还给中央内存池
+void AllocateAndRelease(std::size_t count, std::size_t bytes) {
+  std::thread worker([count, bytes]() {
+    std::vector<void*> ptrs;
+    for (std::size_t i = 0; i != count; ++i) {
+      ptrs.push_back(toystl::alloc::allocate(bytes));
+    }
+    for (void* p : ptrs) {
+      toystl::alloc::deallocate(p, bytes);
+    }
+  });
+  worker.join();
+}
+
+void ExpectStatsConsistent() {
+  toystl::alloc::pool_stats s = toystl::alloc::stats();
+  EXPECT_EQ(s.heap_bytes,
+            s.free_list_bytes + s.pool_bytes + s.handed_out_bytes);
+  std::size_t free_bytes = 0;
+  for (std::size_t i = 0; i != s.class_count; ++i) {
+    free_bytes += s.classes[i].size * s.classes[i].free_blocks;
+  }
+  EXPECT_EQ(free_bytes, s.free_list_bytes);
+}
+
+TEST(TestAlloc, Trim) {
+  AllocateAndRelease(40000, 64);
+  toystl::alloc::pool_stats before = toystl::alloc::stats();
+  ExpectStatsConsistent();
+
+  std::size_t released = toystl::alloc::trim();
+  toystl::alloc::pool_stats after = toystl::alloc::stats();
+  ExpectStatsConsistent();
+  EXPECT_GT(released, 0u);
+  EXPECT_EQ(before.heap_bytes - released, after.heap_bytes);
+  EXPECT_LT(after.chunk_count, before.chunk_count);
+  EXPECT_EQ(toystl::alloc::trim(), 0u);
+
+  // trim 之后依然可以正常分配
+  FillAndCheck(10, 30);
+  ExpectStatsConsistent();
+}
+
+TEST(TestAlloc, Stats) {
+  AllocateAndRelease(1000, 48);
+  ExpectStatsConsistent();
+#ifdef TOYSTL_ALLOC_STATS
+  std::size_t index = 48 / 8 - 1;
+  toystl::alloc::pool_stats before = toystl::alloc::stats();
+  void* p = toystl::alloc::allocate(48);
+  toystl::alloc::deallocate(p, 48);
+  p = toystl::alloc::allocate(48);
+  toystl::alloc::deallocate(p, 48);
+  toystl::alloc::pool_stats after = toystl::alloc::stats();
+  EXPECT_EQ(after.classes[index].size, 48u);
+  EXPECT_EQ(after.classes[index].hits + after.classes[index].misses,
+            before.classes[index].hits + before.classes[index].misses + 2);
+  EXPECT_GT(after.malloc_count, 0u);
+#endif
+}
+
+TEST(TestAlloc, TrimThreshold) {
+  toystl::alloc::trim();
+  toystl::alloc::pool_stats before = toystl::alloc::stats();
+  toystl::alloc::set_trim_threshold(64 * 1024);
+  AllocateAndRelease(40000, 64);
+  toystl::alloc::set_trim_threshold(0);
+  toystl::alloc::pool_stats after = toystl::alloc::stats();
+  ExpectStatsConsistent();
+  // 峰值约 2.5MB，自动 trim 之后持有的内存应远小于峰值
+  EXPECT_LT(after.heap_bytes, before.heap_bytes + 40000 * 64 / 4);
+}
+}  // namespace alloctest
+}  // namespace toystl
+
+#endif  // TOYSTL_TEST_TEST_ALLOC_H_
@@ -0,0 +1,282 @@
+#ifndef TOYSTL_TEST_TEST_ARENA_H_
+#define TOYSTL_TEST_TEST_ARENA_H_
+
+#include <cstdint>
+#include <type_traits>
+
+#include "arena.h"
+#include "deque.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "list.h"
+#include "map.h"
+#include "set.h"
+#include "test_helper.h"
+#include "unordered_map.h"
+#include "vector.h"
+
+namespace toystl {
+namespace arenatest {
+typedef typename toystl::testhelper::nontrivial Kitten;
+
+template <class T>
+using arena_vector = toystl::vector<T, toystl::arena_allocator<T>>;
+
+TEST(TestArena, AllocateAndRelease) {
+  toystl::arena a(256);
+  void* p = a.allocate(10, 1);
+  void* q = a.allocate(16, 16);
+  EXPECT_NE(p, q);
+  EXPECT_EQ(reinterpret_cast<std::uintptr_t>(q) % 16, 0u);
+  // 超过块大小的请求单独成块
+  void* big = a.allocate(10000);
+  EXPECT_NE(big, nullptr);
+  EXPECT_EQ(a.bytes_allocated(), 10000u + 26u);
+  EXPECT_GE(a.bytes_reserved(), 10000u);
+
+  a.release();
+  EXPECT_EQ(a.bytes_allocated(), 0u);
+  EXPECT_EQ(a.bytes_reserved(), 0u);
+  // release 之后仍可继续使用
+  EXPECT_NE(a.allocate(8), nullptr);
+}
+
+TEST(TestArena, InitialBuffer) {
+  alignas(16) char buffer[512];
+  toystl::arena a(buffer, sizeof(buffer));
+  char* p = static_cast<char*>(a.allocate(100));
+  EXPECT_TRUE(p >= buffer && p < buffer + sizeof(buffer));
+  EXPECT_EQ(a.bytes_reserved(), 0u);
+  // 缓冲区用完后向系统申请
+  a.allocate(1000);
+  EXPECT_GT(a.bytes_reserved(), 0u);
+  a.release();
+  p = static_cast<char*>(a.allocate(100));
+  EXPECT_TRUE(p >= buffer && p < buffer + sizeof(buffer));
+}
+
+// 缓冲区几乎用满时再申请更严格的对齐：对齐后的位置越过了缓冲区末尾，
+// 必须改为向系统申请
+TEST(TestArena, InitialBufferOverAligned) {
+  alignas(16) char buffer[100];
+  toystl::arena a(buffer, sizeof(buffer));
+  a.allocate(97, 1);
+  char* p = static_cast<char*>(a.allocate(8, 16));
+  EXPECT_TRUE(p < buffer || p >= buffer + sizeof(buffer));
+  EXPECT_EQ(reinterpret_cast<std::size_t>(p) % 16, 0u);
+  EXPECT_GT(a.bytes_reserved(), 0u);
+  EXPECT_THROW(a.allocate(static_cast<std::size_t>(-1) - 8, 16),
+               std::bad_alloc);
+}
+
+TEST(TestArena, AllocatorEquality) {
+  toystl::arena a, b;
+  toystl::arena_allocator<int> ia(a);
+  toystl::arena_allocator<double> da(ia);  // rebind 后共享同一个 arena
+  EXPECT_TRUE(ia == da);
+  EXPECT_TRUE(ia != toystl::arena_allocator<int>(b));
+  EXPECT_TRUE(toystl::arena_allocator<int>() ==
+              toystl::arena_allocator<char>());
+}
+
+TEST(TestArena, DefaultAllocatorUsesPool) {
+  // 不绑定 arena 时由 toystl::alloc 分配和回收
+  arena_vector<Kitten> v;
+  for (int i = 0; i != 100; ++i) {
+    v.emplace_back(i);
+  }
+  EXPECT_EQ(v.get_allocator().get_arena(), nullptr);
+  EXPECT_EQ(v[99].Id(), 99);
+}
+
+TEST(TestArena, Vector) {
+  toystl::arena a;
+  toystl::arena_allocator<Kitten> alloc(a);
+  arena_vector<Kitten> v(alloc);
+  for (int i = 0; i != 1000; ++i) {
+    v.emplace_back(i);
+  }
+  EXPECT_GT(a.bytes_allocated(), 1000 * sizeof(Kitten));
+  EXPECT_EQ(v.get_allocator(), alloc);
+
+  // 拷贝构造、移动构造都沿用原来的 arena
+  arena_vector<Kitten> copy(v);
+  EXPECT_EQ(copy.get_allocator().get_arena(), &a);
+  EXPECT_EQ(copy.size(), 1000u);
+  EXPECT_EQ(copy[500].Id(), 500);
+  arena_vector<Kitten> moved(toystl::move(copy));
+  EXPECT_EQ(moved.get_allocator().get_arena(), &a);
+  EXPECT_EQ(moved[999].Id(), 999);
+  EXPECT_TRUE(copy.empty());
+}
+
+TEST(TestArena, VectorPropagation) {
+  toystl::arena a, b;
+  arena_vector<int> va((toystl::arena_allocator<int>(a)));
+  arena_vector<int> vb((toystl::arena_allocator<int>(b)));
+  for (int i = 0; i != 10; ++i) {
+    va.push_back(i);
+  }
+  vb.push_back(42);
+
+  // 拷贝赋值：分配器随之传播
+  arena_vector<int> vc((toystl::arena_allocator<int>(b)));
+  vc = va;
+  EXPECT_EQ(vc.get_allocator().get_arena(), &a);
+  EXPECT_EQ(vc.size(), 10u);
+  EXPECT_EQ(vc[9], 9);
+
+  // 交换：分配器随之交换
+  va.swap(vb);
+  EXPECT_EQ(va.get_allocator().get_arena(), &b);
+  EXPECT_EQ(vb.get_allocator().get_arena(), &a);
+  EXPECT_EQ(va.size(), 1u);
+  EXPECT_EQ(vb.size(), 10u);
+
+  // 移动赋值：分配器随内存一起转移
+  vc = toystl::move(va);
+  EXPECT_EQ(vc.get_allocator().get_arena(), &b);
+  EXPECT_EQ(vc[0], 42);
+
+  // assign 不改变分配器
+  vb.assign(5, 7);
+  EXPECT_EQ(vb.get_allocator().get_arena(), &a);
+  EXPECT_EQ(vb.size(), 5u);
+}
+
+// 移动赋值时不传播的 arena_allocator
+template <class T>
+class sticky_arena_allocator : public toystl::arena_allocator<T> {
+ public:
+  using propagate_on_container_move_assignment = toystl::false_type;
+
+  template <class U>
+  class rebind {
+   public:
+    using other = sticky_arena_allocator<U>;
+  };
+
+  sticky_arena_allocator() noexcept {}
+  explicit sticky_arena_allocator(toystl::arena& a) noexcept
+      : toystl::arena_allocator<T>(a) {}
+  template <class U>
+  sticky_arena_allocator(const sticky_arena_allocator<U>& other) noexcept
+      : toystl::arena_allocator<T>(other) {}
+
+  sticky_arena_allocator select_on_container_copy_construction() const {
+    return *this;
+  }
+};
+
+// 分配器不传播又可能不相等时，移动赋值要逐个搬移元素，不能是 noexcept
+TEST(TestArena, MoveAssignNoexcept) {
+  typedef sticky_arena_allocator<int> Sticky;
+  EXPECT_TRUE(std::is_nothrow_move_assignable<toystl::vector<int>>::value);
+  EXPECT_TRUE(std::is_nothrow_move_assignable<arena_vector<int>>::value);
+  EXPECT_FALSE(
+      (std::is_nothrow_move_assignable<toystl::vector<int, Sticky>>::value));
+  EXPECT_TRUE(std::is_nothrow_move_assignable<toystl::list<int>>::value);
+  EXPECT_FALSE(
+      (std::is_nothrow_move_assignable<toystl::list<int, Sticky>>::value));
+  EXPECT_TRUE((std::is_nothrow_move_assignable<
+               toystl::unordered_map<int, int>>::value));
+  EXPECT_FALSE((std::is_nothrow_move_assignable<toystl::unordered_map<
+                    int, int, toystl::hash<int>, toystl::equal_to<int>,
+                    sticky_arena_allocator<int>>>::value));
+
+  // 分配器不相等，元素逐个移动到本容器的 arena 中
+  toystl::arena a, b;
+  toystl::vector<int, Sticky> va((Sticky(a)));
+  toystl::vector<int, Sticky> vb((Sticky(b)));
+  for (int i = 0; i != 10; ++i) {
+    vb.push_back(i);
+  }
+  va = toystl::move(vb);
+  EXPECT_EQ(va.get_allocator().get_arena(), &a);
+  ASSERT_EQ(va.size(), 10u);
+  EXPECT_EQ(va[9], 9);
+  EXPECT_TRUE(vb.empty());
+}
+
+TEST(TestArena, List) {
+  toystl::arena a;
+  toystl::list<int, toystl::arena_allocator<int>> l(
+      (toystl::arena_allocator<int>(a)));
+  for (int i = 0; i != 100; ++i) {
+    l.push_back((i * 37) % 100);
+  }
+  l.sort();
+  int expect = 0;
+  for (int value : l) {
+    EXPECT_EQ(value, expect++);
+  }
+  EXPECT_EQ(expect, 100);
+  EXPECT_EQ(l.get_allocator().get_arena(), &a);
+
+  auto copy = l;
+  EXPECT_EQ(copy.get_allocator().get_arena(), &a);
+  EXPECT_EQ(copy.size(), 100u);
+}
+
+TEST(TestArena, Deque) {
+  toystl::arena a;
+  toystl::deque<Kitten, toystl::arena_allocator<Kitten>> d(
+      (toystl::arena_allocator<Kitten>(a)));
+  for (int i = 0; i != 1000; ++i) {
+    d.push_back(Kitten(i));
+    d.push_front(Kitten(-i));
+  }
+  EXPECT_EQ(d.size(), 2000u);
+  EXPECT_EQ(d.front().Id(), -999);
+  EXPECT_EQ(d.back().Id(), 999);
+  EXPECT_EQ(d.get_allocator().get_arena(), &a);
+
+  auto copy = d;
+  EXPECT_EQ(copy.get_allocator().get_arena(), &a);
+  EXPECT_EQ(copy[1000].Id(), 0);
+}
+
+TEST(TestArena, MapAndSet) {
+  toystl::arena a;
+  toystl::map<int, int, toystl::less<int>, toystl::arena_allocator<int>> m(
+      (toystl::arena_allocator<int>(a)));
+  toystl::set<int, toystl::less<int>, toystl::arena_allocator<int>> s(
+      (toystl::arena_allocator<int>(a)));
+  for (int i = 0; i != 500; ++i) {
+    m[i] = i * i;
+    s.insert(i);
+  }
+  EXPECT_EQ(m.size(), 500u);
+  EXPECT_EQ(m.find(20)->second, 400);
+  EXPECT_EQ(s.count(499), 1u);
+  for (int i = 0; i != 500; i += 2) {
+    m.erase(i);
+  }
+  EXPECT_EQ(m.size(), 250u);
+  EXPECT_EQ(m.get_allocator().get_arena(), &a);
+
+  auto copy = m;
+  EXPECT_EQ(copy.get_allocator().get_arena(), &a);
+  EXPECT_EQ(copy.size(), 250u);
+  EXPECT_EQ(copy.find(21)->second, 441);
+}
+
+TEST(TestArena, UnorderedMap) {
+  toystl::arena a;
+  toystl::unordered_map<int, int, toystl::hash<int>, toystl::equal_to<int>,
+                        toystl::arena_allocator<int>>
+      m((toystl::arena_allocator<int>(a)));
+  for (int i = 0; i != 1000; ++i) {
+    m[i] = -i;
+  }
+  EXPECT_EQ(m.size(), 1000u);
+  EXPECT_EQ(m.find(123)->second, -123);
+  EXPECT_EQ(m.get_allocator().get_arena(), &a);
+
+  auto moved = toystl::move(m);
+  EXPECT_EQ(moved.get_allocator().get_arena(), &a);
+  EXPECT_EQ(moved.find(999)->second, -999);
+}
+}  // namespace arenatest
+}  // namespace toystl
+#endif  // TOYSTL_TEST_TEST_ARENA_H_
@@ -0,0 +1,243 @@
+#ifndef TOYSTL_TEST_TEST_BTREE_H_
+#define TOYSTL_TEST_TEST_BTREE_H_
+
+#include <map>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "btree_map.h"
+#include "btree_set.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace toystl {
+namespace btreetest {
+// 节点只有 3 个元素的 B 树，少量元素就能触发多层的分裂、借位与合并
+typedef toystl::pair<const int, int> Value;
+typedef toystl::btree<int, Value, toystl::selectfirst<Value>,
+                      toystl::less<int>, toystl::allocator<Value>, 16>
+    SmallTree;
+
+// 正反两个方向遍历，逐个与 std::map 比较
+template <class Tree>
+::testing::AssertionResult SameAs(const Tree& tree,
+                                  const std::map<int, int>& expected) {
+  if (tree.size() != expected.size()) {
+    return ::testing::AssertionFailure()
+           << "size " << tree.size() << " vs " << expected.size();
+  }
+  auto it = tree.begin();
+  for (auto e = expected.begin(); e != expected.end(); ++e, ++it) {
+    if (it == tree.end() || it->first != e->first || it->second != e->second) {
+      return ::testing::AssertionFailure() << "forward mismatch at "
+                                           << e->first;
+    }
+  }
+  if (it != tree.end()) {
+    return ::testing::AssertionFailure() << "too many elements";
+  }
+  auto rit = tree.rbegin();
+  for (auto e = expected.rbegin(); e != expected.rend(); ++e, ++rit) {
+    if (rit->first != e->first) {
+      return ::testing::AssertionFailure() << "backward mismatch at "
+                                           << e->first;
+    }
+  }
+  return ::testing::AssertionSuccess();
+}
+
+TEST(TestBtree, RandomInsertErase) {
+  EXPECT_EQ(SmallTree::node_values, 3u);
+  SmallTree tree;
+  std::map<int, int> expected;
+  std::mt19937 rng(42);
+  for (int round = 0; round != 4000; ++round) {
+    const int k = static_cast<int>(rng() % 500);
+    if (rng() % 3 != 0) {
+      const bool inserted = tree.insert_unique(Value(k, round)).second;
+      EXPECT_EQ(inserted, expected.insert(std::make_pair(k, round)).second);
+    } else {
+      EXPECT_EQ(tree.erase(k), expected.erase(k));
+    }
+    if (round % 97 == 0) {
+      ASSERT_TRUE(SameAs(tree, expected)) << round;
+    }
+  }
+  ASSERT_TRUE(SameAs(tree, expected));
+
+  for (int k = -1; k != 502; ++k) {
+    auto lb = tree.lower_bound(k);
+    auto elb = expected.lower_bound(k);
+    ASSERT_EQ(lb == tree.end(), elb == expected.end()) << k;
+    if (elb != expected.end()) {
+      EXPECT_EQ(lb->first, elb->first);
+    }
+    auto ub = tree.upper_bound(k);
+    auto eub = expected.upper_bound(k);
+    ASSERT_EQ(ub == tree.end(), eub == expected.end()) << k;
+    if (eub != expected.end()) {
+      EXPECT_EQ(ub->first, eub->first);
+    }
+    EXPECT_EQ(tree.count(k), expected.count(k));
+  }
+
+  // 按随机顺序删空
+  std::vector<int> keys;
+  for (auto& kv : expected) {
+    keys.push_back(kv.first);
+  }
+  std::shuffle(keys.begin(), keys.end(), rng);
+  for (int k : keys) {
+    tree.erase(tree.find(k));
+    expected.erase(k);
+  }
+  ASSERT_TRUE(SameAs(tree, expected));
+  EXPECT_TRUE(tree.begin() == tree.end());
+}
+
+TEST(TestBtree, HintsAndRanges) {
+  // 顺序追加、逆序插入和插入在 hint 之前
+  SmallTree tree;
+  std::map<int, int> expected;
+  for (int i = 0; i < 300; i += 3) {
+    tree.insert_unique(tree.end(), Value(i, i));
+    expected[i] = i;
+  }
+  for (int i = -1; i != -100; --i) {
+    tree.insert_unique(tree.begin(), Value(i, i));
+    expected[i] = i;
+  }
+  for (int i = 1; i < 300; i += 3) {
+    auto it = tree.emplace_hint_unique(tree.find(i + 2), i, -i);
+    EXPECT_EQ(it->first, i);
+    expected[i] = -i;
+  }
+  // 错误的提示与重复的键
+  tree.insert_unique(tree.find(0), Value(1000, 0));
+  expected[1000] = 0;
+  EXPECT_EQ(tree.insert_unique(tree.find(3), Value(3, 99))->second, 3);
+  EXPECT_EQ(tree.insert_unique(tree.end(), Value(3, 99))->second, 3);
+  ASSERT_TRUE(SameAs(tree, expected));
+
+  // 删除区间
+  tree.erase(tree.lower_bound(10), tree.lower_bound(200));
+  expected.erase(expected.lower_bound(10), expected.lower_bound(200));
+  ASSERT_TRUE(SameAs(tree, expected));
+  tree.erase(tree.lower_bound(150), tree.end());
+  expected.erase(expected.lower_bound(150), expected.end());
+  ASSERT_TRUE(SameAs(tree, expected));
+
+  SmallTree copy(tree);
+  ASSERT_TRUE(SameAs(copy, expected));
+  EXPECT_TRUE(copy == tree);
+  copy.erase(copy.begin());
+  EXPECT_TRUE(tree < copy);
+  SmallTree moved(toystl::move(copy));
+  EXPECT_TRUE(copy.empty());
+  EXPECT_TRUE(copy.begin() == copy.end());
+  moved = tree;
+  ASSERT_TRUE(SameAs(moved, expected));
+  tree.erase(tree.begin(), tree.end());
+  EXPECT_TRUE(tree.empty());
+  tree.swap(moved);
+  ASSERT_TRUE(SameAs(tree, expected));
+}
+
+TEST(TestBtree, MapAndSetInterface) {
+  toystl::btree_map<std::string, int> map;
+  map["b"] = 2;
+  map["a"] = 1;
+  ++map["b"];
+  EXPECT_TRUE(map.emplace("c", 3).second);
+  EXPECT_FALSE(map.insert(toystl::pair<const std::string, int>("a", 9)).second);
+  EXPECT_EQ(map.size(), 3u);
+  EXPECT_EQ(map["b"], 3);
+  EXPECT_EQ(map.begin()->first, "a");
+  EXPECT_EQ(map.rbegin()->first, "c");
+  EXPECT_EQ(map.erase("a"), 1u);
+  EXPECT_TRUE(map.find("a") == map.end());
+
+  // 默认节点大小下的大量数据
+  toystl::btree_map<int, int> big;
+  std::map<int, int> expected;
+  for (int i = 0; i != 20000; ++i) {
+    const int k = (i * 7919) % 20011;
+    big[k] = i;
+    expected[k] = i;
+  }
+  for (int i = 0; i < 20011; i += 3) {
+    big.erase(i);
+    expected.erase(i);
+  }
+  ASSERT_TRUE(SameAs(big, expected));
+
+  const int values[] = {5, 1, 4, 1, 5, 9, 2, 6};
+  toystl::btree_set<int> set(values, values + 8);
+  EXPECT_EQ(set.size(), 6u);
+  EXPECT_EQ(*set.begin(), 1);
+  EXPECT_EQ(*set.lower_bound(3), 4);
+  EXPECT_EQ(*set.upper_bound(5), 6);
+  EXPECT_FALSE(set.emplace(9).second);
+  set.erase(set.find(9));
+  EXPECT_EQ(*set.rbegin(), 6);
+  EXPECT_EQ(set.count(9), 0u);
+}
+
+// 拷贝构造可以按需抛出异常，移动构造不抛出
+struct ThrowOnCopy {
+  static bool armed;
+  int v;
+  explicit ThrowOnCopy(int x) : v(x) {}
+  ThrowOnCopy(const ThrowOnCopy& rhs) : v(rhs.v) {
+    if (armed) {
+      throw std::runtime_error("copy");
+    }
+  }
+  ThrowOnCopy(ThrowOnCopy&& rhs) noexcept : v(rhs.v) {}
+};
+bool ThrowOnCopy::armed = false;
+
+TEST(TestBtree, ThrowingInsertLeavesTreeIntact) {
+  typedef toystl::pair<const int, ThrowOnCopy> TValue;
+  typedef toystl::btree<int, TValue, toystl::selectfirst<TValue>,
+                        toystl::less<int>, toystl::allocator<TValue>, 16>
+      Tree;
+  Tree tree;
+  std::map<int, int> expected;
+  for (int k = 10; k <= 200; k += 10) {
+    tree.insert_unique(TValue(k, ThrowOnCopy(k)));
+    expected[k] = k;
+  }
+  // 顺序插入后左边的叶子节点还各有一个空位，补满它们
+  for (int k = 15; k <= 205; k += 10) {
+    tree.insert_unique(TValue(k, ThrowOnCopy(k)));
+    expected[k] = k;
+  }
+  // 插入到各个叶子节点的各个位置，包括满节点的开头
+  ThrowOnCopy::armed = true;
+  for (int k = 1; k <= 209; ++k) {
+    if (k % 5 == 0) {
+      continue;
+    }
+    const TValue value(k, ThrowOnCopy(k));
+    EXPECT_THROW(tree.insert_unique(value), std::runtime_error);
+  }
+  ThrowOnCopy::armed = false;
+
+  ASSERT_EQ(tree.size(), expected.size());
+  auto e = expected.begin();
+  for (auto it = tree.begin(); it != tree.end(); ++it, ++e) {
+    EXPECT_EQ(it->first, e->first);
+    EXPECT_EQ(it->second.v, e->second);
+  }
+  auto re = expected.rbegin();
+  for (auto it = tree.rbegin(); it != tree.rend(); ++it, ++re) {
+    EXPECT_EQ(it->first, re->first);
+  }
+  EXPECT_TRUE(re == expected.rend());
+}
+}  // namespace btreetest
+}  // namespace toystl
+#endif  // TOYSTL_TEST_TEST_BTREE_H_
@@ -0,0 +1,105 @@
+#ifndef TOYSTL_TEST_TEST_CONCURRENT_MAP_H_
+#define TOYSTL_TEST_TEST_CONCURRENT_MAP_H_
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "concurrent_unordered_map.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace toystl {
+namespace concurrentmaptest {
+typedef toystl::concurrent_unordered_map<int, int> Map;
+
+TEST(TestConcurrentUnorderedMap, SingleThread) {
+  Map map(5);
+  EXPECT_EQ(map.shard_count(), 8u);
+  EXPECT_TRUE(map.empty());
+
+  for (int i = 0; i != 1000; ++i) {
+    EXPECT_TRUE(map.insert(Map::value_type(i, i)));
+  }
+  EXPECT_FALSE(map.insert(Map::value_type(1, 100)));
+  EXPECT_FALSE(map.emplace(2, 200));
+  EXPECT_TRUE(map.emplace(1000, 1000));
+  EXPECT_EQ(map.size(), 1001u);
+
+  int value = -1;
+  EXPECT_TRUE(map.find(1, value));
+  EXPECT_EQ(value, 1);
+  EXPECT_FALSE(map.find(5000, value));
+  EXPECT_EQ(value, 1);
+  EXPECT_TRUE(map.contains(999));
+
+  EXPECT_FALSE(map.insert_or_assign(3, 30));
+  EXPECT_TRUE(map.insert_or_assign(3000, 30));
+  EXPECT_TRUE(map.update(3, [](int& v) { v += 1; }));
+  EXPECT_FALSE(map.update(4000, [](int& v) { v += 1; }));
+  EXPECT_TRUE(map.visit(3, [&value](const int& v) { value = v; }));
+  EXPECT_EQ(value, 31);
+
+  EXPECT_FALSE(map.upsert(3, [](int& v) { v = 0; }, 7));
+  EXPECT_TRUE(map.upsert(4000, [](int& v) { v = 0; }, 7));
+  EXPECT_TRUE(map.find(3, value));
+  EXPECT_EQ(value, 0);
+  EXPECT_TRUE(map.find(4000, value));
+  EXPECT_EQ(value, 7);
+
+  EXPECT_EQ(map.erase(3), 1u);
+  EXPECT_EQ(map.erase(3), 0u);
+  size_t visited = 0;
+  map.for_each([&visited](const Map::value_type&) { ++visited; });
+  EXPECT_EQ(visited, map.size());
+  EXPECT_EQ(visited, 1002u);
+
+  map.clear();
+  EXPECT_TRUE(map.empty());
+  Map single(1);
+  EXPECT_EQ(single.shard_count(), 1u);
+  EXPECT_TRUE(single.insert(Map::value_type(1, 1)));
+  EXPECT_TRUE(single.contains(1));
+}
+
+// 多个线程同时对同一批键计数、插入和删除各自的键，最后核对结果
+TEST(TestConcurrentUnorderedMap, ManyThreads) {
+  const int thread_count = 8;
+  const int counters = 64;
+  const int rounds = 2048;
+  toystl::concurrent_unordered_map<std::string, int> map(4);
+  std::vector<std::thread> threads;
+  for (int t = 0; t != thread_count; ++t) {
+    threads.push_back(std::thread([&map, t]() {
+      for (int r = 0; r != rounds; ++r) {
+        const std::string counter = "counter" + std::to_string(r % counters);
+        map.upsert(counter, [](int& v) { ++v; }, 1);
+
+        const std::string own =
+            "thread" + std::to_string(t) + "/" + std::to_string(r);
+        map.insert(toystl::pair<const std::string, int>(own, r));
+        int value = 0;
+        if (!map.find(own, value) || value != r) {
+          ADD_FAILURE() << own;
+        }
+        if (r % 2 == 0) {
+          map.erase(own);
+        }
+      }
+    }));
+  }
+  for (std::thread& th : threads) {
+    th.join();
+  }
+
+  for (int i = 0; i != counters; ++i) {
+    int value = 0;
+    EXPECT_TRUE(map.find("counter" + std::to_string(i), value));
+    EXPECT_EQ(value, thread_count * rounds / counters);
+  }
+  EXPECT_EQ(map.size(),
+            static_cast<size_t>(counters + thread_count * rounds / 2));
+}
+}  // namespace concurrentmaptest
+}  // namespace toystl
+#endif  // TOYSTL_TEST_TEST_CONCURRENT_MAP_H_
@@ -0,0 +1,153 @@
+#ifndef TOYSTL_TEST_TEST_CONCURRENT_QUEUE_H_
+#define TOYSTL_TEST_TEST_CONCURRENT_QUEUE_H_
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "concurrent_queue.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace toystl {
+namespace concurrentqueuetest {
+// 单线程下的语义：容量、先进先出、绕圈、批量操作
+template <class Queue>
+void CheckSingleThread() {
+  Queue queue(5);
+  EXPECT_EQ(queue.capacity(), 8u);
+  std::string value;
+  EXPECT_FALSE(queue.try_pop(value));
+  for (int round = 0; round != 3; ++round) {
+    for (int i = 0; i != 8; ++i) {
+      EXPECT_TRUE(queue.try_push(std::to_string(round * 10 + i)));
+    }
+    EXPECT_FALSE(queue.try_emplace(3, 'x'));
+    EXPECT_EQ(queue.size_approx(), 8u);
+    for (int i = 0; i != 8; ++i) {
+      ASSERT_TRUE(queue.try_pop(value));
+      EXPECT_EQ(value, std::to_string(round * 10 + i));
+    }
+    EXPECT_FALSE(queue.try_pop(value));
+  }
+
+  const std::vector<std::string> in = {"a", "b", "c", "d", "e", "f"};
+  EXPECT_EQ(queue.try_push_n(in.begin(), 6), 6u);
+  EXPECT_EQ(queue.try_push_n(in.begin(), 6), 2u);
+  std::vector<std::string> out(10);
+  EXPECT_EQ(queue.try_pop_n(out.begin(), 3), 3u);
+  EXPECT_EQ(out[2], "c");
+  EXPECT_EQ(queue.try_pop_n(out.begin(), 10), 5u);
+  EXPECT_EQ(out[0], "d");
+  EXPECT_EQ(out[4], "b");
+  EXPECT_EQ(queue.try_pop_n(out.begin(), 10), 0u);
+  EXPECT_TRUE(queue.empty_approx());
+
+  // 析构时销毁队列中剩余的元素
+  queue.try_push(std::string(100, 'z'));
+}
+
+TEST(TestConcurrentQueue, SingleThread) {
+  CheckSingleThread<toystl::concurrent_queue<std::string>>();
+  CheckSingleThread<toystl::spsc_queue<std::string>>();
+}
+
+// 多个生产者、多个消费者，单个和批量操作混用：每个值恰好被取出一次，
+// 同一个生产者的值按写入的顺序被取出
+TEST(TestConcurrentQueue, MultiProducerMultiConsumer) {
+  const int producers = 4;
+  const int consumers = 4;
+  const int per_producer = 20000;
+  toystl::concurrent_queue<int> queue(64);
+  std::vector<std::atomic<int>> seen(producers * per_producer);
+  for (std::atomic<int>& s : seen) {
+    s.store(0);
+  }
+  std::atomic<int> remaining(producers * per_producer);
+  std::atomic<int> out_of_order(0);
+
+  std::vector<std::thread> threads;
+  for (int p = 0; p != producers; ++p) {
+    threads.push_back(std::thread([&queue, p, per_producer]() {
+      int next = p * per_producer;
+      const int last = next + per_producer;
+      while (next != last) {
+        if (next % 3 == 0) {
+          int batch[5];
+          int n = 0;
+          for (; n != 5 && next + n != last; ++n) {
+            batch[n] = next + n;
+          }
+          next += static_cast<int>(queue.try_push_n(batch, n));
+        } else if (queue.try_push(next)) {
+          ++next;
+        }
+        std::this_thread::yield();
+      }
+    }));
+  }
+  for (int c = 0; c != consumers; ++c) {
+    threads.push_back(std::thread([&, c]() {
+      std::vector<int> last(producers, -1);
+      int batch[7];
+      while (remaining.load() > 0) {
+        const size_t n =
+            c % 2 == 0 ? queue.try_pop_n(batch, 7) : queue.try_pop(batch[0]);
+        for (size_t i = 0; i != n; ++i) {
+          const int v = batch[i];
+          seen[v].fetch_add(1);
+          if (v <= last[v / per_producer]) {
+            out_of_order.fetch_add(1);
+          }
+          last[v / per_producer] = v;
+        }
+        remaining.fetch_sub(static_cast<int>(n));
+        if (n == 0) {
+          std::this_thread::yield();
+        }
+      }
+    }));
+  }
+  for (std::thread& t : threads) {
+    t.join();
+  }
+  EXPECT_EQ(out_of_order.load(), 0);
+  for (size_t i = 0; i != seen.size(); ++i) {
+    ASSERT_EQ(seen[i].load(), 1) << i;
+  }
+  EXPECT_TRUE(queue.empty_approx());
+}
+
+TEST(TestConcurrentQueue, SingleProducerSingleConsumer) {
+  const int count = 200000;
+  toystl::spsc_queue<int> queue(128);
+  std::thread producer([&queue, count]() {
+    int next = 0;
+    while (next != count) {
+      if (next % 2 == 0) {
+        int batch[3] = {next, next + 1, next + 2};
+        const size_t n = count - next < 3 ? count - next : 3;
+        next += static_cast<int>(queue.try_push_n(batch, n));
+      } else if (queue.try_push(next)) {
+        ++next;
+      }
+    }
+  });
+  int expected = 0;
+  int mismatches = 0;
+  int batch[4];
+  while (expected != count) {
+    const size_t n = expected % 2 == 0 ? queue.try_pop_n(batch, 4)
+                                       : queue.try_pop(batch[0]);
+    for (size_t i = 0; i != n; ++i, ++expected) {
+      mismatches += batch[i] != expected;
+    }
+  }
+  producer.join();
+  EXPECT_EQ(mismatches, 0);
+  EXPECT_TRUE(queue.empty_approx());
+}
+}  // namespace concurrentqueuetest
+}  // namespace toystl
+#endif  // TOYSTL_TEST_TEST_CONCURRENT_QUEUE_H_
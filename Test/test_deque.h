@@ -1,7 +1,11 @@
 #ifndef TOYSTL_TEST_TEST_DEQUE_H_
 #define TOYSTL_TEST_TEST_DEQUE_H_
 
+#include <algorithm>
 #include <deque>
+#include <numeric>
+#include <string>
+#include <vector>
 
 #include "deque.h"
 #include "gmock/gmock.h"
@@ -187,6 +191,237 @@ TEST_F(TestDeque, Clear) {
   b.clear();
   ExpectEqual();
 }
+
+// 记录缓冲区和 map 的分配次数
+struct CountingAllocations {
+  static int allocations;
+  static int deallocations;
+};
+int CountingAllocations::allocations = 0;
+int CountingAllocations::deallocations = 0;
+
+template <class T>
+class CountingAllocator : public toystl::allocator<T> {
+ public:
+  template <class U>
+  class rebind {
+   public:
+    using other = CountingAllocator<U>;
+  };
+
+  CountingAllocator() noexcept {}
+  template <class U>
+  CountingAllocator(const CountingAllocator<U>&) noexcept {}
+
+  static CountingAllocator select_on_container_copy_construction() {
+    return CountingAllocator();
+  }
+
+  static T* allocate(size_t n) {
+    ++CountingAllocations::allocations;
+    return toystl::allocator<T>::allocate(n);
+  }
+
+  static void deallocate(T* p, size_t n) {
+    ++CountingAllocations::deallocations;
+    toystl::allocator<T>::deallocate(p, n);
+  }
+};
+
+TEST(TestDequeQueue, SteadyStateDoesNotAllocate) {
+  CountingAllocations::allocations = 0;
+  CountingAllocations::deallocations = 0;
+  {
+    toystl::deque<int, CountingAllocator<int>> queue;
+    int next_in = 0;
+    int next_out = 0;
+    // 预热：队列长度在 0 到 1000 之间波动，map 长到足够大
+    for (int round = 0; round != 4; ++round) {
+      for (int i = 0; i != 1000; ++i) {
+        queue.push_back(next_in++);
+      }
+      for (int i = 0; i != 1000; ++i) {
+        ASSERT_EQ(queue.front(), next_out++);
+        queue.pop_front();
+      }
+    }
+    const int allocations = CountingAllocations::allocations;
+    const int deallocations = CountingAllocations::deallocations;
+    for (int i = 0; i != 100000; ++i) {
+      queue.push_back(next_in++);
+      if (i % 3 != 0) {
+        ASSERT_EQ(queue.front(), next_out++);
+        queue.pop_front();
+      }
+      if (queue.size() > 200) {
+        while (!queue.empty()) {
+          ASSERT_EQ(queue.front(), next_out++);
+          queue.pop_front();
+        }
+      }
+    }
+    EXPECT_EQ(CountingAllocations::allocations, allocations);
+    EXPECT_EQ(CountingAllocations::deallocations, deallocations);
+
+    // 备用缓冲区随容器一起移动和交换，最后全部归还
+    toystl::deque<int, CountingAllocator<int>> moved(toystl::move(queue));
+    toystl::deque<int, CountingAllocator<int>> other{1, 2, 3};
+    other.swap(moved);
+    moved.clear();
+    for (int i = 0; i != 3000; ++i) {
+      moved.push_front(i);
+    }
+    EXPECT_EQ(moved.back(), 0);
+  }
+  EXPECT_EQ(CountingAllocations::allocations,
+            CountingAllocations::deallocations);
+}
+// 大元素：默认按一个页面来分配缓冲区
+struct Large {
+  int value;
+  char padding[1020];
+};
+
+TEST(TestDequeBufferSize, Defaults) {
+  EXPECT_EQ(toystl::deque<int>::iterator::deque_buf_size(), 128u);
+  EXPECT_EQ(toystl::deque<Large>::iterator::deque_buf_size(), 4u);
+  EXPECT_EQ((toystl::deque<int, toystl::allocator<int>, 3>::iterator::
+                 deque_buf_size()),
+            3u);
+
+  toystl::deque<Large> large;
+  std::deque<int> expected;
+  for (int i = 0; i != 50; ++i) {
+    Large x;
+    x.value = i;
+    if (i % 2 == 0) {
+      large.push_back(x);
+      expected.push_back(i);
+    } else {
+      large.push_front(x);
+      expected.push_front(i);
+    }
+  }
+  ASSERT_EQ(large.size(), expected.size());
+  for (size_t i = 0; i != expected.size(); ++i) {
+    EXPECT_EQ(large[i].value, expected[i]);
+  }
+}
+
+// 每个缓冲区只有几个元素，迭代器频繁跨越缓冲区
+TEST(TestDequeBufferSize, SmallBuffers) {
+  toystl::deque<int, toystl::allocator<int>, 3> deque;
+  std::deque<int> expected;
+  for (int i = 0; i != 100; ++i) {
+    deque.push_back(i);
+    expected.push_back(i);
+    deque.push_front(-i);
+    expected.push_front(-i);
+  }
+  for (int i = 0; i != 30; ++i) {
+    deque.pop_front();
+    expected.pop_front();
+    deque.pop_back();
+    expected.pop_back();
+  }
+  ASSERT_EQ(deque.size(), expected.size());
+  auto it = deque.begin();
+  for (size_t i = 0; i != expected.size(); ++i, ++it) {
+    EXPECT_EQ(*it, expected[i]);
+    EXPECT_EQ(*(deque.begin() + i), expected[i]);
+    EXPECT_EQ(*(deque.end() - (expected.size() - i)), expected[i]);
+  }
+  EXPECT_TRUE(it == deque.end());
+  EXPECT_EQ(deque.end() - deque.begin(),
+            static_cast<std::ptrdiff_t>(expected.size()));
+
+  toystl::deque<int, toystl::allocator<int>, 3> copy(deque);
+  EXPECT_TRUE(copy == deque);
+
+  // 缓冲区放不下指针，不保留备用缓冲区
+  toystl::deque<char, toystl::allocator<char>, 1> chars;
+  for (int round = 0; round != 3; ++round) {
+    for (char c = 'a'; c != 'z'; ++c) {
+      chars.push_back(c);
+    }
+    for (char c = 'a'; c != 'z'; ++c) {
+      ASSERT_EQ(chars.front(), c);
+      chars.pop_front();
+    }
+  }
+  EXPECT_TRUE(chars.empty());
+}
+// 分段迭代器版本的算法：区间的起止落在缓冲区的各个位置
+TEST(TestDequeSegmented, Algorithms) {
+  typedef toystl::deque<int, toystl::allocator<int>, 4> SmallDeque;
+  SmallDeque deque;
+  std::deque<int> expected;
+  for (int i = 0; i != 40; ++i) {
+    deque.push_back(i % 7);
+    expected.push_back(i % 7);
+  }
+  deque.push_front(100);
+  expected.push_front(100);
+
+  const int n = static_cast<int>(expected.size());
+  for (int b = 0; b <= n; ++b) {
+    for (int e = b; e <= n; ++e) {
+      SmallDeque::const_iterator first = deque.cbegin() + b;
+      SmallDeque::const_iterator last = deque.cbegin() + e;
+      for (int v = 0; v != 8; ++v) {
+        EXPECT_EQ(toystl::find(first, last, v) - deque.cbegin(),
+                  std::find(expected.begin() + b, expected.begin() + e, v) -
+                      expected.begin());
+        EXPECT_EQ(toystl::count(first, last, v),
+                  static_cast<size_t>(std::count(
+                      expected.begin() + b, expected.begin() + e, v)));
+      }
+      int sum = 0;
+      toystl::for_each(first, last, [&sum](int x) { sum += x; });
+      EXPECT_EQ(sum, std::accumulate(expected.begin() + b,
+                                     expected.begin() + e, 0));
+
+      // 拷贝出去、拷贝回来，两端都是分段迭代器
+      std::vector<int> out(e - b);
+      EXPECT_TRUE(toystl::copy(first, last, out.data()) ==
+                  out.data() + (e - b));
+      EXPECT_TRUE(std::equal(out.begin(), out.end(), expected.begin() + b));
+      SmallDeque copy(deque);
+      SmallDeque::iterator pos = copy.begin() + (n - (e - b));
+      EXPECT_TRUE(toystl::copy(out.data(), out.data() + out.size(), pos) ==
+                  copy.end());
+      EXPECT_TRUE(std::equal(copy.end() - (e - b), copy.end(),
+                             expected.begin() + b));
+      EXPECT_TRUE(toystl::copy(first, last, copy.begin()) ==
+                  copy.begin() + (e - b));
+      EXPECT_TRUE(std::equal(copy.begin(), copy.begin() + (e - b),
+                             expected.begin() + b));
+
+      toystl::fill(copy.begin() + b, copy.begin() + e, -1);
+      for (int i = 0; i != n; ++i) {
+        if (i >= b && i < e) {
+          EXPECT_EQ(copy[i], -1);
+        }
+      }
+    }
+  }
+
+  // 重叠区间向前拷贝（erase 的做法）
+  std::deque<int> shifted(expected.begin() + 5, expected.end());
+  toystl::copy(deque.begin() + 5, deque.end(), deque.begin());
+  EXPECT_TRUE(std::equal(shifted.begin(), shifted.end(), deque.begin()));
+
+  // 元素不能 memmove 时逐个移动
+  toystl::deque<std::string, toystl::allocator<std::string>, 3> from;
+  toystl::deque<std::string, toystl::allocator<std::string>, 5> to(10);
+  for (int i = 0; i != 10; ++i) {
+    from.push_back(std::string(20, static_cast<char>('a' + i)));
+  }
+  toystl::move(from.begin(), from.end(), to.begin());
+  for (int i = 0; i != 10; ++i) {
+    EXPECT_EQ(to[i], std::string(20, static_cast<char>('a' + i)));
+  }
+}
 }  // namespace dequetest
 }  // namespace toystl
 
@@ -0,0 +1,224 @@
+#ifndef TOYSTL_TEST_TEST_FLAT_HASH_H_
+#define TOYSTL_TEST_TEST_FLAT_HASH_H_
+
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "flat_unordered_map.h"
+#include "flat_unordered_set.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "vector.h"
+
+namespace toystl {
+namespace flathashtest {
+class TestFlatUnorderedMap : public ::testing::Test {
+ protected:
+  typedef toystl::flat_unordered_map<int, int> Map;
+  std::unordered_map<int, int> std_map;
+  Map abc_map;
+
+  void ExpectEqual() const {
+    EXPECT_EQ(abc_map.empty(), std_map.empty());
+    ASSERT_EQ(abc_map.size(), std_map.size());
+    size_t visited = 0;
+    for (auto it = abc_map.begin(); it != abc_map.end(); ++it, ++visited) {
+      auto found = std_map.find(it->first);
+      ASSERT_TRUE(found != std_map.end()) << it->first;
+      EXPECT_EQ(it->second, found->second) << it->first;
+    }
+    EXPECT_EQ(visited, std_map.size());
+  }
+};
+
+TEST_F(TestFlatUnorderedMap, DefaultDoesNotAllocate) {
+  EXPECT_EQ(abc_map.bucket_count(), 0u);
+  EXPECT_TRUE(abc_map.begin() == abc_map.end());
+  EXPECT_TRUE(abc_map.find(1) == abc_map.end());
+  EXPECT_EQ(abc_map.erase(1), 0u);
+  ExpectEqual();
+}
+
+TEST_F(TestFlatUnorderedMap, InsertFindErase) {
+  for (int i = 0; i != 1000; ++i) {
+    EXPECT_TRUE(abc_map.insert(Map::value_type(i, i * 2)).second);
+    std_map.emplace(i, i * 2);
+  }
+  EXPECT_FALSE(abc_map.insert(Map::value_type(7, 0)).second);
+  EXPECT_EQ(abc_map.find(7)->second, 14);
+  ExpectEqual();
+  // 桶数始终是 2 的幂，负载不超过 7/8
+  size_t buckets = abc_map.bucket_count();
+  EXPECT_EQ(buckets & (buckets - 1), 0u);
+  EXPECT_LE(abc_map.load_factor(), 0.875f);
+
+  for (int i = 0; i < 1000; i += 3) {
+    EXPECT_EQ(abc_map.erase(i), 1u);
+    std_map.erase(i);
+  }
+  EXPECT_EQ(abc_map.erase(0), 0u);
+  EXPECT_EQ(abc_map.count(3), 0u);
+  EXPECT_EQ(abc_map.count(4), 1u);
+  ExpectEqual();
+
+  abc_map[5000] = 1;
+  std_map[5000] = 1;
+  abc_map[4] += 10;
+  std_map[4] += 10;
+  ExpectEqual();
+
+  auto range = abc_map.equal_range(4);
+  EXPECT_EQ(range.first->second, 18);
+  EXPECT_TRUE(++range.first == range.second);
+
+  abc_map.erase(abc_map.find(4));
+  std_map.erase(4);
+  ExpectEqual();
+  abc_map.erase(abc_map.begin(), abc_map.end());
+  std_map.clear();
+  ExpectEqual();
+}
+
+// 反复插入删除不会让墓碑占满整张表
+TEST_F(TestFlatUnorderedMap, ChurnReusesDeletedSlots) {
+  abc_map.resize(64);
+  size_t buckets = abc_map.bucket_count();
+  for (int round = 0; round != 200; ++round) {
+    for (int i = 0; i != 40; ++i) {
+      abc_map[round * 40 + i] = i;
+    }
+    for (int i = 0; i != 40; ++i) {
+      EXPECT_EQ(abc_map.erase(round * 40 + i), 1u);
+    }
+  }
+  EXPECT_TRUE(abc_map.empty());
+  EXPECT_EQ(abc_map.bucket_count(), buckets);
+  ExpectEqual();
+}
+
+TEST_F(TestFlatUnorderedMap, CopyMoveAndSwap) {
+  for (int i = 0; i != 100; ++i) {
+    abc_map[i] = -i;
+    std_map[i] = -i;
+  }
+  auto copy = abc_map;
+  EXPECT_TRUE(copy == abc_map);
+  copy[1] = 1;
+  EXPECT_TRUE(copy != abc_map);
+
+  Map moved(toystl::move(copy));
+  EXPECT_TRUE(copy.empty());
+  EXPECT_EQ(moved.size(), 100u);
+  copy = abc_map;
+  EXPECT_TRUE(copy == abc_map);
+
+  Map other;
+  other.swap(moved);
+  EXPECT_TRUE(moved.empty());
+  EXPECT_EQ(other[1], 1);
+  abc_map = toystl::move(other);
+  std_map[1] = 1;
+  ExpectEqual();
+}
+
+// 记录默认构造和移动次数的实值
+struct CountedValue {
+  static int constructed;
+  static int moved;
+  int value;
+  CountedValue() : value(0) { ++constructed; }
+  CountedValue(CountedValue&& other) : value(other.value) { ++moved; }
+};
+int CountedValue::constructed = 0;
+int CountedValue::moved = 0;
+
+// operator[] 只在键值不存在时构造实值，并且直接构造在槽中
+TEST(TestFlatUnorderedMapIndex, ConstructsValueOnlyOnMiss) {
+  toystl::flat_unordered_map<std::string, CountedValue, std::hash<std::string>>
+      map;
+  map.resize(200);  // 插入过程中不扩容，扩容会移动元素
+  CountedValue::constructed = 0;
+  CountedValue::moved = 0;
+  for (int i = 0; i != 100; ++i) {
+    map["key" + std::to_string(i)].value = i;
+  }
+  EXPECT_EQ(CountedValue::constructed, 100);
+  EXPECT_EQ(CountedValue::moved, 0);
+  for (int round = 0; round != 3; ++round) {
+    for (int i = 0; i != 100; ++i) {
+      ASSERT_EQ(map["key" + std::to_string(i)].value, i);
+    }
+  }
+  EXPECT_EQ(CountedValue::constructed, 100);
+  EXPECT_EQ(map.size(), 100u);
+
+  EXPECT_TRUE((std::is_nothrow_move_assignable<
+               toystl::flat_unordered_map<int, int>>::value));
+}
+
+// 分配器不传播的有状态分配器
+template <class T>
+class StickyAllocator : public toystl::allocator<T> {
+ public:
+  using propagate_on_container_move_assignment = toystl::false_type;
+
+  template <class U>
+  class rebind {
+   public:
+    using other = StickyAllocator<U>;
+  };
+
+  StickyAllocator() : id(0) {}
+  template <class U>
+  StickyAllocator(const StickyAllocator<U>& other) : id(other.id) {}
+
+  int id;
+};
+
+// 分配器可能不相等又不传播时，移动赋值要拷贝元素，不能是 noexcept
+TEST(TestFlatUnorderedMapIndex, MoveAssignNoexcept) {
+  EXPECT_FALSE((std::is_nothrow_move_assignable<toystl::flat_unordered_map<
+                    int, int, toystl::hash<int>, toystl::equal_to<int>,
+                    StickyAllocator<int>>>::value));
+  EXPECT_FALSE((std::is_nothrow_move_assignable<toystl::flat_unordered_set<
+                    int, toystl::hash<int>, toystl::equal_to<int>,
+                    StickyAllocator<int>>>::value));
+}
+
+TEST(TestFlatUnorderedSet, NontrivialKeys) {
+  typedef toystl::flat_unordered_set<std::string, std::hash<std::string>>
+      StringSet;
+  StringSet abc_set;
+  std::unordered_set<std::string> std_set;
+  toystl::vector<std::string> keys;
+  for (int i = 0; i != 300; ++i) {
+    std::string key = "key" + std::to_string(i);
+    abc_set.insert(key);
+    std_set.insert(key);
+    keys.push_back(key);
+  }
+  EXPECT_FALSE(abc_set.insert("key0").second);
+  for (int i = 0; i < 300; i += 2) {
+    std::string key = "key" + std::to_string(i);
+    abc_set.erase(key);
+    std_set.erase(key);
+  }
+  ASSERT_EQ(abc_set.size(), std_set.size());
+  for (auto& key : abc_set) {
+    EXPECT_EQ(std_set.count(key), 1u) << key;
+  }
+
+  StringSet rebuilt(keys.begin(), keys.end());
+  for (int i = 0; i < 300; i += 2) {
+    rebuilt.erase(keys[i]);
+  }
+  EXPECT_TRUE(rebuilt == abc_set);
+  rebuilt.clear();
+  EXPECT_TRUE(rebuilt.empty());
+  EXPECT_TRUE(rebuilt.find("key1") == rebuilt.end());
+}
+}  // namespace flathashtest
+}  // namespace toystl
+#endif  // TOYSTL_TEST_TEST_FLAT_HASH_H_
@@ -1,8 +1,18 @@
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 
+#include "test_alloc.h"
+#include "test_arena.h"
+#include "test_btree.h"
+#include "test_concurrent_map.h"
+#include "test_concurrent_queue.h"
 #include "test_deque.h"
+#include "test_flat_hash.h"
 #include "test_list.h"
+#include "test_map.h"
+#include "test_priority_queue.h"
+#include "test_small_vector.h"
+#include "test_unordered_map.h"
 #include "test_vector.h"
 
 int main(int argc, char** argv) {
@@ -0,0 +1,274 @@
+#ifndef TOYSTL_TEST_TEST_MAP_H_
+#define TOYSTL_TEST_TEST_MAP_H_
+
+#include <algorithm>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "map.h"
+#include "set.h"
+
+namespace toystl {
+namespace maptest {
+// 检查以 x 为根的子树：父指针是否正确、有没有相邻的红色节点，
+// 返回子树的黑高度。出错时返回 -1
+inline int CheckSubtree(toystl::rb_tree_node_base* x,
+                        toystl::rb_tree_node_base* parent) {
+  if (x == nullptr) {
+    return 1;
+  }
+  if (x->parent != parent) {
+    return -1;
+  }
+  if (x->color == toystl::rb_tree_red &&
+      ((x->left != nullptr && x->left->color == toystl::rb_tree_red) ||
+       (x->right != nullptr && x->right->color == toystl::rb_tree_red))) {
+    return -1;
+  }
+  const int left = CheckSubtree(x->left, x);
+  const int right = CheckSubtree(x->right, x);
+  if (left < 0 || left != right) {
+    return -1;
+  }
+#ifdef TOYSTL_RB_TREE_ORDER_STATISTICS
+  if (x->size != toystl::rb_tree_node_base::s_size(x->left) +
+                     toystl::rb_tree_node_base::s_size(x->right) + 1) {
+    return -1;
+  }
+#endif
+  return left + (x->color == toystl::rb_tree_black ? 1 : 0);
+}
+
+// 以 end() 取得 header，检查整棵树是否满足红黑树的性质
+template <class Tree>
+::testing::AssertionResult IsValidRbTree(const Tree& tree) {
+  toystl::rb_tree_node_base* header = tree.end().node;
+  toystl::rb_tree_node_base* root = header->parent;
+  if (root == nullptr) {
+    if (tree.size() != 0 || header->left != header) {
+      return ::testing::AssertionFailure() << "bad empty tree";
+    }
+    return ::testing::AssertionSuccess();
+  }
+  if (root->color != toystl::rb_tree_black) {
+    return ::testing::AssertionFailure() << "red root";
+  }
+  if (header->left != toystl::rb_tree_node_base::s_minimum(root) ||
+      header->right != toystl::rb_tree_node_base::s_maximum(root)) {
+    return ::testing::AssertionFailure() << "bad leftmost / rightmost";
+  }
+  if (CheckSubtree(root, header) < 0) {
+    return ::testing::AssertionFailure() << "red-black property violated";
+  }
+  const size_t n = static_cast<size_t>(
+      toystl::distance(tree.begin(), tree.end()));
+  if (n != tree.size()) {
+    return ::testing::AssertionFailure() << "size " << tree.size()
+                                         << " but " << n << " nodes";
+  }
+  return ::testing::AssertionSuccess();
+}
+
+TEST(TestMap, BuildFromSortedRange) {
+  for (int n = 0; n != 130; ++n) {
+    std::vector<toystl::pair<const int, int>> values;
+    for (int i = 0; i != n; ++i) {
+      values.push_back(toystl::pair<const int, int>(i * 2, i));
+    }
+    toystl::map<int, int> map(values.begin(), values.end());
+    ASSERT_TRUE(IsValidRbTree(map)) << n;
+    ASSERT_EQ(map.size(), static_cast<size_t>(n));
+    int expected = 0;
+    for (auto it = map.begin(); it != map.end(); ++it, ++expected) {
+      EXPECT_EQ(it->first, expected * 2);
+    }
+    // 建好的树照常支持插入和删除
+    map.insert(toystl::pair<const int, int>(-1, 0));
+    map.insert(toystl::pair<const int, int>(n, 0));
+    map.erase(0);
+    ASSERT_TRUE(IsValidRbTree(map)) << n;
+  }
+}
+
+TEST(TestMap, BuildSkipsDuplicatesAndFallsBack) {
+  // 有序但有重复：set 去重，multiset 全部保留
+  const int sorted[] = {1, 1, 2, 3, 3, 3, 5, 8, 8};
+  toystl::set<int> set(sorted, sorted + 9);
+  EXPECT_TRUE(IsValidRbTree(set));
+  EXPECT_EQ(set.size(), 5u);
+  toystl::multiset<int> multiset(sorted, sorted + 9);
+  EXPECT_TRUE(IsValidRbTree(multiset));
+  EXPECT_EQ(multiset.size(), 9u);
+  EXPECT_EQ(multiset.count(3), 3u);
+
+  // 中途乱序：有序的前缀直接建树，其余逐个插入
+  const int unsorted[] = {1, 4, 9, 16, 3, 25, 2, 9, 0};
+  toystl::set<int> mixed(unsorted, unsorted + 9);
+  EXPECT_TRUE(IsValidRbTree(mixed));
+  std::vector<int> expected(unsorted, unsorted + 9);
+  std::sort(expected.begin(), expected.end());
+  expected.erase(std::unique(expected.begin(), expected.end()),
+                 expected.end());
+  EXPECT_TRUE(std::equal(expected.begin(), expected.end(), mixed.begin()));
+  EXPECT_EQ(mixed.size(), expected.size());
+
+  // 只能遍历一次的输入迭代器
+  std::istringstream in("2 4 6 8 7 10");
+  toystl::set<int> streamed((std::istream_iterator<int>(in)),
+                            std::istream_iterator<int>());
+  EXPECT_TRUE(IsValidRbTree(streamed));
+  EXPECT_EQ(streamed.size(), 6u);
+  EXPECT_EQ(*streamed.begin(), 2);
+
+  // 非空的树上插入区间，仍然逐个插入
+  set.insert(sorted, sorted + 9);
+  EXPECT_TRUE(IsValidRbTree(set));
+  EXPECT_EQ(set.size(), 5u);
+}
+TEST(TestMap, HintedInsert) {
+  // 以 end() 为提示顺序追加
+  toystl::map<int, int> map;
+  for (int i = 0; i != 1000; i += 2) {
+    toystl::map<int, int>::iterator it =
+        map.insert(map.end(), toystl::pair<const int, int>(i, i));
+    EXPECT_EQ(it->first, i);
+  }
+  ASSERT_TRUE(IsValidRbTree(map));
+  // 提示为新值的后继
+  for (int i = 1; i < 1000; i += 2) {
+    toystl::map<int, int>::iterator it =
+        map.emplace_hint(map.find(i + 1), i, -i);
+    EXPECT_EQ(it->first, i);
+    EXPECT_EQ(it->second, -i);
+  }
+  ASSERT_TRUE(IsValidRbTree(map));
+  // 错误的提示同样能插入到正确的位置
+  for (int i = 1000; i != 1100; ++i) {
+    map.insert(map.begin(), toystl::pair<const int, int>(i, i));
+    map.emplace_hint(map.find(500), -i, i);
+  }
+  ASSERT_TRUE(IsValidRbTree(map));
+  EXPECT_EQ(map.size(), 1200u);
+  int expected = -1099;
+  for (auto it = map.begin(); it != map.end(); ++it) {
+    EXPECT_EQ(it->first, expected);
+    expected = expected == -1000 ? 0 : expected + 1;
+  }
+  // 重复的键值返回已有的元素
+  toystl::map<int, int>::iterator dup =
+      map.insert(map.find(10), toystl::pair<const int, int>(10, 99));
+  EXPECT_EQ(dup->second, 10);
+  EXPECT_EQ(map.emplace_hint(map.end(), 20, 99)->second, 20);
+  EXPECT_FALSE(map.emplace(30, 99).second);
+  EXPECT_TRUE(map.emplace(5000, 99).second);
+  EXPECT_EQ(map.size(), 1201u);
+  map[5001] = 1;
+  EXPECT_EQ(map[5001], 1);
+  ASSERT_TRUE(IsValidRbTree(map));
+
+  toystl::set<int> set;
+  for (int i = 0; i != 100; ++i) {
+    set.emplace_hint(set.end(), i);
+    set.insert(set.begin(), -i);
+  }
+  EXPECT_TRUE(IsValidRbTree(set));
+  EXPECT_EQ(set.size(), 199u);
+  EXPECT_FALSE(set.emplace(50).second);
+}
+
+TEST(TestMap, HintedInsertEqual) {
+  // 相等的键值插入在 hint 附近：hint 指向第一个 1 时插入在它之前
+  toystl::multimap<int, int> multimap;
+  multimap.emplace(1, 0);
+  multimap.emplace(1, 1);
+  multimap.emplace(3, 0);
+  multimap.emplace_hint(multimap.find(1), 1, -1);
+  multimap.insert(multimap.end(), toystl::pair<const int, int>(1, 2));
+  multimap.insert(multimap.end(), toystl::pair<const int, int>(3, 1));
+  EXPECT_TRUE(IsValidRbTree(multimap));
+  const int keys[] = {1, 1, 1, 1, 3, 3};
+  const int values[] = {-1, 0, 1, 2, 0, 1};
+  int i = 0;
+  for (auto it = multimap.begin(); it != multimap.end(); ++it, ++i) {
+    EXPECT_EQ(it->first, keys[i]);
+    EXPECT_EQ(it->second, values[i]);
+  }
+
+  toystl::multiset<int> multiset;
+  for (int k = 0; k != 300; ++k) {
+    multiset.insert(multiset.end(), k / 3);
+    multiset.emplace_hint(multiset.begin(), 150 - k / 3);
+  }
+  EXPECT_TRUE(IsValidRbTree(multiset));
+  EXPECT_EQ(multiset.size(), 600u);
+  EXPECT_EQ(multiset.count(60), 6u);
+}
+
+#ifdef TOYSTL_RB_TREE_ORDER_STATISTICS
+TEST(TestMap, OrderStatistics) {
+  // 随机插入和删除，每一步都与排好序的 vector 对照
+  toystl::multiset<int> multiset;
+  std::vector<int> expected;
+  unsigned x = 2463534242u;
+  for (int round = 0; round != 3000; ++round) {
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    const int k = static_cast<int>(x % 200);
+    if (x % 3 != 0 || expected.empty()) {
+      multiset.insert(k);
+      expected.insert(std::upper_bound(expected.begin(), expected.end(), k),
+                      k);
+    } else {
+      multiset.erase(multiset.select(x % expected.size()));
+      expected.erase(expected.begin() + x % expected.size());
+    }
+    if (round % 100 == 0) {
+      ASSERT_TRUE(IsValidRbTree(multiset)) << round;
+    }
+  }
+  ASSERT_TRUE(IsValidRbTree(multiset));
+  for (size_t i = 0; i != expected.size(); ++i) {
+    ASSERT_EQ(*multiset.select(i), expected[i]) << i;
+    EXPECT_EQ(multiset.index_of(multiset.select(i)), i);
+  }
+  EXPECT_TRUE(multiset.select(expected.size()) == multiset.end());
+  EXPECT_EQ(multiset.index_of(multiset.end()), expected.size());
+  for (int k = -1; k != 202; ++k) {
+    const size_t rank = static_cast<size_t>(
+        std::lower_bound(expected.begin(), expected.end(), k) -
+        expected.begin());
+    EXPECT_EQ(multiset.rank(k), rank) << k;
+    EXPECT_EQ(multiset.count(k),
+              static_cast<size_t>(std::count(expected.begin(), expected.end(),
+                                             k)));
+    EXPECT_EQ(toystl::distance(multiset.begin(), multiset.lower_bound(k)),
+              static_cast<ptrdiff_t>(rank));
+  }
+
+  // 有序区间建树、拷贝和 map 的接口
+  std::vector<toystl::pair<const int, int>> values;
+  for (int i = 0; i != 100; ++i) {
+    values.push_back(toystl::pair<const int, int>(i * 10, i));
+  }
+  toystl::map<int, int> map(values.begin(), values.end());
+  ASSERT_TRUE(IsValidRbTree(map));
+  toystl::map<int, int> copy(map);
+  ASSERT_TRUE(IsValidRbTree(copy));
+  EXPECT_EQ(copy.select(42)->first, 420);
+  EXPECT_EQ(copy.rank(425), 43u);
+  copy.select(7)->second = -7;
+  EXPECT_EQ(copy[70], -7);
+  toystl::map<int, int> empty;
+  EXPECT_TRUE(empty.select(0) == empty.end());
+  EXPECT_EQ(empty.rank(1), 0u);
+  EXPECT_EQ(empty.index_of(empty.end()), 0u);
+}
+#endif
+}  // namespace maptest
+}  // namespace toystl
+#endif  // TOYSTL_TEST_TEST_MAP_H_
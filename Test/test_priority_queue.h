@@ -0,0 +1,152 @@
+#ifndef TOYSTL_TEST_TEST_PRIORITY_QUEUE_H_
+#define TOYSTL_TEST_TEST_PRIORITY_QUEUE_H_
+
+#include <algorithm>
+#include <functional>
+#include <map>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "heap.h"
+#include "queue.h"
+
+namespace toystl {
+namespace priorityqueuetest {
+// 各种叉数的堆排序结果都与 std::sort 相同，pop 逐个取出最大值
+template <size_t D>
+void CheckDaryHeap(std::vector<int> values) {
+  std::vector<int> expected = values;
+  std::sort(expected.begin(), expected.end());
+
+  std::vector<int> heap;
+  for (int v : values) {
+    heap.push_back(v);
+    toystl::push_dary_heap<D>(heap.data(), heap.data() + heap.size());
+    ASSERT_EQ(heap.front(), *std::max_element(heap.begin(), heap.end()));
+  }
+  toystl::sort_dary_heap<D>(heap.data(), heap.data() + heap.size());
+  EXPECT_EQ(heap, expected);
+
+  int* first = values.data();
+  toystl::make_dary_heap<D>(first, first + values.size(),
+                            toystl::greater<int>());
+  for (size_t i = 0; i != expected.size(); ++i) {
+    ASSERT_EQ(values.front(), expected[i]);
+    toystl::pop_dary_heap<D>(first, first + values.size() - i,
+                             toystl::greater<int>());
+  }
+}
+
+TEST(TestPriorityQueue, DaryHeap) {
+  std::mt19937 rng(11);
+  for (size_t n : {0u, 1u, 2u, 5u, 9u, 64u, 1000u}) {
+    std::vector<int> values;
+    for (size_t i = 0; i != n; ++i) {
+      values.push_back(static_cast<int>(rng() % 100));
+    }
+    CheckDaryHeap<2>(values);
+    CheckDaryHeap<3>(values);
+    CheckDaryHeap<4>(values);
+    CheckDaryHeap<8>(values);
+  }
+}
+
+TEST(TestPriorityQueue, Arity) {
+  toystl::priority_queue<std::string, toystl::vector<std::string>,
+                         toystl::greater<std::string>, 4>
+      queue;
+  const char* words[] = {"pear", "fig", "apple", "kiwi", "date", "lime"};
+  for (const char* w : words) {
+    queue.push(w);
+  }
+  std::vector<std::string> out;
+  while (!queue.empty()) {
+    out.push_back(queue.top());
+    queue.pop();
+  }
+  EXPECT_THAT(out, ::testing::ElementsAre("apple", "date", "fig", "kiwi",
+                                          "lime", "pear"));
+
+  toystl::priority_queue<int> binary{3, 1, 4, 1, 5};
+  EXPECT_EQ(binary.top(), 5);
+}
+
+// 随机的 push / pop / update / decrease_key / erase，与 std::multimap 对照
+TEST(TestPriorityQueue, IndexedHeap) {
+  toystl::indexed_priority_queue<int, toystl::greater<int>, 4> queue;
+  std::map<size_t, int> live;  // handle -> 值
+  std::mt19937 rng(5);
+  for (int round = 0; round != 20000; ++round) {
+    const unsigned op = rng() % 10;
+    if (op < 4 || live.empty()) {
+      const int v = static_cast<int>(rng() % 1000);
+      const size_t h = queue.push(v);
+      ASSERT_TRUE(live.find(h) == live.end());
+      live[h] = v;
+    } else {
+      auto it = live.begin();
+      std::advance(it, rng() % live.size());
+      const size_t h = it->first;
+      ASSERT_TRUE(queue.contains(h));
+      ASSERT_EQ(queue.get(h), it->second);
+      if (op == 4) {
+        const int v = static_cast<int>(rng() % 1000);
+        queue.update(h, v);
+        it->second = v;
+      } else if (op == 5) {
+        const int v = it->second - static_cast<int>(rng() % 50);
+        queue.decrease_key(h, v);
+        it->second = v;
+      } else if (op == 6) {
+        queue.erase(h);
+        live.erase(it);
+        EXPECT_FALSE(queue.contains(h));
+      } else {
+        int min = live.begin()->second;
+        for (auto& kv : live) {
+          min = std::min(min, kv.second);
+        }
+        ASSERT_EQ(queue.top(), min);
+        ASSERT_EQ(live[queue.top_handle()], min);
+        live.erase(queue.top_handle());
+        queue.pop();
+      }
+    }
+    ASSERT_EQ(queue.size(), live.size());
+  }
+  std::vector<int> rest;
+  while (!queue.empty()) {
+    rest.push_back(queue.top());
+    queue.pop();
+  }
+  EXPECT_TRUE(std::is_sorted(rest.begin(), rest.end()));
+  EXPECT_EQ(rest.size(), live.size());
+}
+
+// 构造元素时抛出异常，handle 的分配不受影响
+TEST(TestPriorityQueue, IndexedHeapEmplaceThrows) {
+  toystl::indexed_priority_queue<std::string> queue;
+  const size_t too_long = std::string().max_size() + 1;
+  const size_t a = queue.push("a");
+  const size_t b = queue.push("b");
+  queue.erase(a);
+  EXPECT_THROW(queue.emplace(too_long, 'x'), std::length_error);
+  EXPECT_EQ(queue.size(), 1u);
+  EXPECT_FALSE(queue.contains(a));
+  // 释放的 handle 仍然可以复用
+  EXPECT_EQ(queue.push("c"), a);
+  const size_t d = queue.push("d");
+  EXPECT_NE(d, b);
+  EXPECT_THROW(queue.emplace(too_long, 'x'), std::length_error);
+  EXPECT_FALSE(queue.contains(d + 1));
+  EXPECT_EQ(queue.push("e"), d + 1);
+  EXPECT_EQ(queue.size(), 4u);
+  EXPECT_EQ(queue.top(), "e");
+}
+}  // namespace priorityqueuetest
+}  // namespace toystl
+#endif  // TOYSTL_TEST_TEST_PRIORITY_QUEUE_H_
@@ -0,0 +1,164 @@
+#ifndef TOYSTL_TEST_TEST_SMALL_VECTOR_H_
+#define TOYSTL_TEST_TEST_SMALL_VECTOR_H_
+
+#include <type_traits>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "small_vector.h"
+#include "test_helper.h"
+
+namespace toystl {
+namespace smallvectortest {
+class TestSmallVector : public ::testing::Test {
+ protected:
+  typedef typename toystl::testhelper::nontrivial Kitten;
+  std::vector<Kitten> std_vector_of_kitten;
+  toystl::small_vector<Kitten, 4> abc_vector_of_kitten;
+
+  void ExpectEqual() const {
+    EXPECT_EQ(abc_vector_of_kitten.empty(), std_vector_of_kitten.empty());
+    ASSERT_EQ(abc_vector_of_kitten.size(), std_vector_of_kitten.size());
+    for (int i = 0; i < static_cast<int>(abc_vector_of_kitten.size()); i++) {
+      EXPECT_EQ(abc_vector_of_kitten[i], std_vector_of_kitten[i]) << i;
+    }
+  }
+};
+
+TEST_F(TestSmallVector, InlineThenSpill) {
+  EXPECT_TRUE(abc_vector_of_kitten.is_inline());
+  EXPECT_EQ(abc_vector_of_kitten.capacity(), 4u);
+  for (int i = 0; i != 4; ++i) {
+    abc_vector_of_kitten.emplace_back(i);
+    std_vector_of_kitten.emplace_back(i);
+  }
+  EXPECT_TRUE(abc_vector_of_kitten.is_inline());
+  ExpectEqual();
+  // 超过 N 之后转移到堆上
+  abc_vector_of_kitten.push_back(abc_vector_of_kitten[0]);
+  std_vector_of_kitten.push_back(std_vector_of_kitten[0]);
+  EXPECT_FALSE(abc_vector_of_kitten.is_inline());
+  ExpectEqual();
+  for (int i = 5; i != 100; ++i) {
+    abc_vector_of_kitten.emplace_back(i);
+    std_vector_of_kitten.emplace_back(i);
+  }
+  ExpectEqual();
+  // 元素变少后可以搬回内联缓冲区
+  abc_vector_of_kitten.erase(abc_vector_of_kitten.begin() + 3,
+                             abc_vector_of_kitten.end());
+  std_vector_of_kitten.erase(std_vector_of_kitten.begin() + 3,
+                             std_vector_of_kitten.end());
+  abc_vector_of_kitten.shrink_to_fit();
+  EXPECT_TRUE(abc_vector_of_kitten.is_inline());
+  ExpectEqual();
+}
+
+TEST_F(TestSmallVector, InsertAndErase) {
+  auto list = {Kitten(1), Kitten(2), Kitten(3)};
+  abc_vector_of_kitten.insert(abc_vector_of_kitten.end(), list);
+  std_vector_of_kitten.insert(std_vector_of_kitten.end(), list);
+  abc_vector_of_kitten.insert(abc_vector_of_kitten.begin() + 1,
+                              abc_vector_of_kitten.back());
+  std_vector_of_kitten.insert(std_vector_of_kitten.begin() + 1,
+                              std_vector_of_kitten.back());
+  ExpectEqual();
+  abc_vector_of_kitten.insert(abc_vector_of_kitten.begin() + 2, 3,
+                              abc_vector_of_kitten.front());
+  std_vector_of_kitten.insert(std_vector_of_kitten.begin() + 2, 3,
+                              std_vector_of_kitten.front());
+  ExpectEqual();
+  abc_vector_of_kitten.insert(abc_vector_of_kitten.begin(), list);
+  std_vector_of_kitten.insert(std_vector_of_kitten.begin(), list);
+  ExpectEqual();
+  abc_vector_of_kitten.emplace(abc_vector_of_kitten.begin() + 4, 42);
+  std_vector_of_kitten.emplace(std_vector_of_kitten.begin() + 4, 42);
+  ExpectEqual();
+  abc_vector_of_kitten.erase(abc_vector_of_kitten.begin());
+  std_vector_of_kitten.erase(std_vector_of_kitten.begin());
+  abc_vector_of_kitten.erase(abc_vector_of_kitten.begin() + 2,
+                             abc_vector_of_kitten.begin() + 5);
+  std_vector_of_kitten.erase(std_vector_of_kitten.begin() + 2,
+                             std_vector_of_kitten.begin() + 5);
+  ExpectEqual();
+  abc_vector_of_kitten.resize(20, Kitten(7));
+  std_vector_of_kitten.resize(20, Kitten(7));
+  ExpectEqual();
+  abc_vector_of_kitten.resize(2);
+  std_vector_of_kitten.resize(2);
+  ExpectEqual();
+}
+
+TEST_F(TestSmallVector, CopyMoveAndSwap) {
+  toystl::small_vector<Kitten, 4> small{Kitten(1), Kitten(2)};
+  toystl::small_vector<Kitten, 4> big(10, Kitten(3));
+  EXPECT_TRUE(small.is_inline());
+  EXPECT_FALSE(big.is_inline());
+
+  auto small_copy = small;
+  auto big_copy = big;
+  EXPECT_TRUE(small_copy == small);
+  EXPECT_TRUE(big_copy == big);
+
+  // 堆上的元素直接接管，内联的元素逐个移动
+  const Kitten* big_data = big.data();
+  toystl::small_vector<Kitten, 4> moved_big(toystl::move(big));
+  EXPECT_EQ(moved_big.data(), big_data);
+  EXPECT_TRUE(big.empty());
+  EXPECT_TRUE(big.is_inline());
+  toystl::small_vector<Kitten, 4> moved_small(toystl::move(small));
+  EXPECT_TRUE(moved_small == small_copy);
+  EXPECT_TRUE(small.empty());
+
+  moved_small.swap(moved_big);
+  EXPECT_TRUE(moved_small == big_copy);
+  EXPECT_TRUE(moved_big == small_copy);
+  EXPECT_TRUE(moved_big.is_inline());
+
+  moved_small = small_copy;
+  EXPECT_TRUE(moved_small == small_copy);
+  moved_big = toystl::move(big_copy);
+  EXPECT_EQ(moved_big.size(), 10u);
+  EXPECT_TRUE(moved_small != moved_big);
+}
+
+TEST(TestSmallVectorPod, NoAllocationWhileInline) {
+  toystl::small_vector<int, 16> v;
+  for (int i = 0; i != 16; ++i) {
+    v.push_back(i);
+  }
+  EXPECT_TRUE(v.is_inline());
+  EXPECT_EQ(v.at(15), 15);
+  EXPECT_THROW(v.at(16), std::out_of_range);
+  v.push_back(16);
+  EXPECT_FALSE(v.is_inline());
+  EXPECT_EQ(v.capacity(), 32u);
+  for (int i = 0; i != 17; ++i) {
+    EXPECT_EQ(v[i], i);
+  }
+  v.assign(3, 9);
+  EXPECT_EQ(v.size(), 3u);
+  EXPECT_EQ(v.back(), 9);
+}
+
+// 移动构造可能抛异常的元素
+struct ThrowingMove {
+  ThrowingMove() {}
+  ThrowingMove(const ThrowingMove&) {}
+  ThrowingMove(ThrowingMove&&) noexcept(false) {}
+  ThrowingMove& operator=(const ThrowingMove&) { return *this; }
+};
+
+// 内联的元素要逐个移动，noexcept 取决于元素的移动构造
+TEST(TestSmallVectorPod, NoexceptMove) {
+  using ints = toystl::small_vector<int, 4>;
+  using throwing = toystl::small_vector<ThrowingMove, 4>;
+  EXPECT_TRUE(std::is_nothrow_move_constructible<ints>::value);
+  EXPECT_TRUE(std::is_nothrow_move_assignable<ints>::value);
+  EXPECT_FALSE(std::is_nothrow_move_constructible<throwing>::value);
+  EXPECT_FALSE(std::is_nothrow_move_assignable<throwing>::value);
+}
+}  // namespace smallvectortest
+}  // namespace toystl
+#endif  // TOYSTL_TEST_TEST_SMALL_VECTOR_H_
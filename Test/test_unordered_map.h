@@ -0,0 +1,533 @@
+#ifndef TOYSTL_TEST_TEST_UNORDERED_MAP_H_
+#define TOYSTL_TEST_TEST_UNORDERED_MAP_H_
+
+#include <algorithm>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "unordered_map.h"
+#include "unordered_set.h"
+
+namespace toystl {
+namespace unorderedmaptest {
+typedef toystl::unordered_map<int, int, toystl::hash<int>,
+                              toystl::equal_to<int>,
+                              toystl::allocator<toystl::pair<const int, int>>,
+                              toystl::hashtable_power2_policy>
+    Power2Map;
+
+// 每次插入只搬移一个旧 bucket，rehash 会持续很多次插入
+typedef toystl::hashtable_incremental_policy<toystl::hashtable_prime_policy, 1>
+    SlowRehash;
+typedef toystl::unordered_map<int, int, toystl::hash<int>,
+                              toystl::equal_to<int>,
+                              toystl::allocator<toystl::pair<const int, int>>,
+                              SlowRehash>
+    IncrementalMap;
+typedef toystl::unordered_multiset<int, toystl::hash<int>,
+                                   toystl::equal_to<int>,
+                                   toystl::allocator<int>, SlowRehash>
+    IncrementalMultiset;
+
+// 透明的字符串哈希：std::string 和 const char* 得到相同的哈希值。
+// string_hashes 统计以 std::string 求哈希的次数
+struct TransparentStringHash {
+  using is_transparent = void;
+  static size_t string_hashes;
+
+  size_t operator()(const std::string& s) const {
+    ++string_hashes;
+    return toystl::hash_string(s.c_str());
+  }
+  size_t operator()(const char* s) const { return toystl::hash_string(s); }
+};
+size_t TransparentStringHash::string_hashes = 0;
+
+typedef toystl::unordered_map<std::string, int, TransparentStringHash,
+                              toystl::equal_to<void>>
+    TransparentMap;
+
+template <class Map>
+void ExpectSameAs(const Map& map, const std::unordered_map<int, int>& expect) {
+  ASSERT_EQ(map.size(), expect.size());
+  size_t visited = 0;
+  for (auto it = map.begin(); it != map.end(); ++it, ++visited) {
+    auto found = expect.find(it->first);
+    ASSERT_TRUE(found != expect.end()) << it->first;
+    EXPECT_EQ(it->second, found->second);
+  }
+  EXPECT_EQ(visited, expect.size());
+  for (auto& kv : expect) {
+    ASSERT_EQ(map.count(kv.first), 1u) << kv.first;
+    EXPECT_EQ(map.find(kv.first)->second, kv.second);
+  }
+}
+
+TEST(TestUnorderedMapBucketPolicy, PrimeByDefault) {
+  toystl::unordered_map<int, int> map;
+  EXPECT_EQ(map.bucket_count(), 193u);
+  for (int i = 0; i != 1000; ++i) {
+    map[i] = i;
+  }
+  EXPECT_EQ(map.bucket_count(), 1543u);
+}
+
+TEST(TestUnorderedMapBucketPolicy, PowerOfTwoBuckets) {
+  Power2Map map;
+  std::unordered_map<int, int> std_map;
+  EXPECT_EQ(map.bucket_count(), 128u);
+  // 步长为 1024 的键在恒等哈希 + 掩码下会全部落进同一个 bucket
+  for (int i = 0; i != 5000; ++i) {
+    map.insert(Power2Map::value_type(i * 1024, i));
+    std_map[i * 1024] = i;
+  }
+  size_t buckets = map.bucket_count();
+  EXPECT_EQ(buckets & (buckets - 1), 0u);
+  EXPECT_GE(buckets, map.size());
+  size_t longest = 0;
+  for (size_t n = 0; n != buckets; ++n) {
+    longest = toystl::max(longest, map.elems_in_bucket(n));
+  }
+  EXPECT_LE(longest, 8u);
+
+  for (int i = 0; i < 5000; i += 2) {
+    EXPECT_EQ(map.erase(i * 1024), 1u);
+    std_map.erase(i * 1024);
+  }
+  ASSERT_EQ(map.size(), std_map.size());
+  for (auto& kv : std_map) {
+    auto it = map.find(kv.first);
+    ASSERT_TRUE(it != map.end()) << kv.first;
+    EXPECT_EQ(it->second, kv.second);
+  }
+  size_t visited = 0;
+  for (auto it = map.begin(); it != map.end(); ++it) {
+    ++visited;
+  }
+  EXPECT_EQ(visited, std_map.size());
+}
+
+TEST(TestUnorderedMapBucketPolicy, Power2Set) {
+  toystl::unordered_set<unsigned, toystl::hash<unsigned>,
+                        toystl::equal_to<unsigned>, toystl::allocator<unsigned>,
+                        toystl::hashtable_power2_policy>
+      set(3);
+  EXPECT_EQ(set.bucket_count(), 8u);
+  for (unsigned i = 0; i != 100; ++i) {
+    set.insert(i << 16);
+  }
+  EXPECT_EQ(set.size(), 100u);
+  EXPECT_EQ(set.count(5u << 16), 1u);
+  EXPECT_EQ(set.count(5u), 0u);
+  EXPECT_EQ(set.bucket_count(), 128u);
+}
+TEST(TestUnorderedMapIncrementalRehash, OperationsDuringRehash) {
+  IncrementalMap map;
+  std::unordered_map<int, int> std_map;
+  // 超过 193 之后开始渐进式 rehash，新旧两个数组同时存在
+  for (int i = 0; i != 200; ++i) {
+    map[i] = i;
+    std_map[i] = i;
+  }
+  EXPECT_EQ(map.bucket_count(), 389u);
+  ExpectSameAs(map, std_map);
+
+  IncrementalMap copy(map);
+  EXPECT_TRUE(copy == map);
+  ExpectSameAs(copy, std_map);
+
+  for (int i = 0; i < 200; i += 3) {
+    EXPECT_EQ(map.erase(i), 1u);
+    std_map.erase(i);
+  }
+  map.erase(map.find(1));
+  std_map.erase(1);
+  EXPECT_FALSE(copy == map);
+  ExpectSameAs(map, std_map);
+
+  auto first = map.begin();
+  auto last = first;
+  for (int i = 0; i != 20; ++i, ++last) {
+    std_map.erase(last->first);
+  }
+  map.erase(first, last);
+  ExpectSameAs(map, std_map);
+
+  // 继续插入直到搬移完成，然后开始下一轮
+  for (int i = 1000; i != 2000; ++i) {
+    map.insert(IncrementalMap::value_type(i, -i));
+    std_map[i] = -i;
+    if (i % 97 == 0) {
+      ExpectSameAs(map, std_map);
+    }
+  }
+  ExpectSameAs(map, std_map);
+
+  IncrementalMap moved(toystl::move(map));
+  ExpectSameAs(moved, std_map);
+  moved.clear();
+  EXPECT_TRUE(moved.empty());
+  EXPECT_TRUE(moved.begin() == moved.end());
+}
+
+TEST(TestUnorderedMapIncrementalRehash, EqualRangeDuringRehash) {
+  IncrementalMultiset set;
+  for (int i = 0; i != 100; ++i) {
+    set.insert(i);
+    set.insert(i);
+  }
+  // 200 个元素时正在从 193 个 bucket 搬移到 389 个 bucket
+  EXPECT_EQ(set.bucket_count(), 389u);
+  for (int i = 0; i != 100; ++i) {
+    auto range = set.equal_range(i);
+    ASSERT_TRUE(range.first != range.second) << i;
+    EXPECT_EQ(*range.first, i);
+    EXPECT_EQ(*++range.first, i);
+    EXPECT_TRUE(++range.first == range.second) << i;
+  }
+  EXPECT_EQ(set.erase(42), 2u);
+  EXPECT_EQ(set.count(42), 0u);
+  EXPECT_EQ(set.size(), 198u);
+}
+
+TEST(TestUnorderedMapEmplace, EmplaceAndTryEmplace) {
+  toystl::unordered_map<int, std::string> map;
+  auto r = map.emplace(1, "one");
+  EXPECT_TRUE(r.second);
+  EXPECT_EQ(r.first->second, "one");
+  r = map.emplace(1, "uno");
+  EXPECT_FALSE(r.second);
+  EXPECT_EQ(map[1], "one");
+
+  // 键值已存在时 try_emplace 不会移动参数
+  std::string value = "eins";
+  r = map.try_emplace(1, toystl::move(value));
+  EXPECT_FALSE(r.second);
+  EXPECT_EQ(value, "eins");
+  r = map.try_emplace(2, toystl::move(value));
+  EXPECT_TRUE(r.second);
+  EXPECT_EQ(r.first->second, "eins");
+  r = map.try_emplace(3, 3u, 'x');
+  EXPECT_EQ(r.first->second, "xxx");
+  r = map.try_emplace(4);
+  EXPECT_TRUE(r.second);
+  EXPECT_TRUE(r.first->second.empty());
+
+  r = map.insert_or_assign(1, "one!");
+  EXPECT_FALSE(r.second);
+  EXPECT_EQ(map[1], "one!");
+  r = map.insert_or_assign(5, "five");
+  EXPECT_TRUE(r.second);
+  EXPECT_EQ(map.size(), 5u);
+
+  toystl::unordered_map<std::string, int, std::hash<std::string>> by_name;
+  std::string key = "key";
+  by_name[toystl::move(key)] = 7;
+  EXPECT_EQ(by_name["key"], 7);
+  EXPECT_EQ(by_name.size(), 1u);
+}
+
+// 不能拷贝也不能移动的实值
+struct Pinned {
+  Pinned(int a, int b) : sum(a + b) {}
+  Pinned(const Pinned&) = delete;
+  Pinned(Pinned&&) = delete;
+  int sum;
+};
+
+// try_emplace 直接在节点中构造实值，不需要移动
+TEST(TestUnorderedMapEmplace, TryEmplaceNonMovable) {
+  toystl::unordered_map<int, Pinned> map;
+  EXPECT_TRUE(map.try_emplace(1, 2, 3).second);
+  EXPECT_FALSE(map.try_emplace(1, 4, 5).second);
+  EXPECT_TRUE(map.try_emplace(2, 10, 20).second);
+  EXPECT_EQ(map.find(1)->second.sum, 5);
+  EXPECT_EQ(map.find(2)->second.sum, 30);
+}
+
+TEST(TestUnorderedMapEmplace, MultiContainers) {
+  toystl::unordered_multimap<int, int> multimap;
+  multimap.emplace(1, 10);
+  multimap.emplace(2, 20);
+  multimap.emplace(1, 11);
+  EXPECT_EQ(multimap.count(1), 2u);
+  auto range = multimap.equal_range(1);
+  EXPECT_EQ(toystl::distance(range.first, range.second), 2);
+
+  toystl::unordered_set<std::string, std::hash<std::string>> set;
+  EXPECT_TRUE(set.emplace(3u, 'a').second);
+  EXPECT_FALSE(set.emplace("aaa").second);
+  IncrementalMultiset multiset;
+  for (int i = 0; i != 500; ++i) {
+    multiset.emplace(i % 50);
+  }
+  EXPECT_EQ(multiset.count(7), 10u);
+}
+
+TEST(TestUnorderedMapHeterogeneousLookup, FindWithoutKeyObject) {
+  TransparentMap map;
+  map.emplace("apple", 1);
+  map.emplace("banana", 2);
+  map["cherry"] = 3;
+
+  TransparentStringHash::string_hashes = 0;
+  const char* banana = "banana";
+  auto it = map.find(banana);
+  ASSERT_TRUE(it != map.end());
+  EXPECT_EQ(it->second, 2);
+  EXPECT_TRUE(map.find("durian") == map.end());
+  EXPECT_EQ(map.count("apple"), 1u);
+  EXPECT_EQ(map.count("apples"), 0u);
+  const TransparentMap& cmap = map;
+  EXPECT_EQ(cmap.find("apple")->second, 1);
+  // 上面的查找都没有构造 std::string
+  EXPECT_EQ(TransparentStringHash::string_hashes, 0u);
+
+  // 以 key_type 查找仍然可用
+  EXPECT_EQ(map.find(std::string("apple"))->second, 1);
+  EXPECT_EQ(TransparentStringHash::string_hashes, 1u);
+
+  auto range = map.equal_range("cherry");
+  ASSERT_TRUE(range.first != range.second);
+  EXPECT_EQ(range.first->second, 3);
+  EXPECT_TRUE(++range.first == range.second);
+
+  toystl::unordered_multiset<std::string, TransparentStringHash,
+                             toystl::equal_to<void>>
+      set;
+  set.emplace("pear");
+  set.emplace("pear");
+  EXPECT_EQ(set.count("pear"), 2u);
+  EXPECT_TRUE(set.find("plum") == set.end());
+}
+TEST(TestUnorderedMapNodeHandle, ExtractAndInsert) {
+  typedef toystl::unordered_map<int, std::string> Map;
+  Map hot;
+  Map cold;
+  hot.emplace(1, "one");
+  hot.emplace(2, "two");
+  hot.emplace(3, "three");
+  const std::string* address = &hot.find(2)->second;
+
+  Map::node_type nh = hot.extract(2);
+  ASSERT_FALSE(nh.empty());
+  EXPECT_EQ(nh.key(), 2);
+  EXPECT_EQ(nh.mapped(), "two");
+  EXPECT_EQ(hot.size(), 2u);
+  EXPECT_TRUE(hot.find(2) == hot.end());
+
+  // 节点原样转移，元素的地址不变
+  Map::insert_return_type r = cold.insert(toystl::move(nh));
+  EXPECT_TRUE(nh.empty());
+  EXPECT_TRUE(r.inserted);
+  EXPECT_TRUE(r.node.empty());
+  EXPECT_EQ(&r.position->second, address);
+  EXPECT_EQ(&cold.find(2)->second, address);
+
+  // 修改键值后再插入
+  nh = hot.extract(hot.find(1));
+  nh.key() = 4;
+  cold.insert(toystl::move(nh));
+  EXPECT_EQ(cold[4], "one");
+
+  // 键值已存在时节点留在返回值中
+  cold.emplace(3, "drei");
+  r = cold.insert(hot.extract(3));
+  EXPECT_FALSE(r.inserted);
+  ASSERT_FALSE(r.node.empty());
+  EXPECT_EQ(r.node.mapped(), "three");
+  EXPECT_EQ(r.position->second, "drei");
+  EXPECT_TRUE(hot.empty());
+
+  EXPECT_TRUE(hot.extract(42).empty());
+  EXPECT_FALSE(cold.insert(Map::node_type()).inserted);
+}
+
+// 修改键值后再插入，节点按新键值的哈希值放入对应的桶
+TEST(TestUnorderedMapNodeHandle, ChangeKeyAndReinsert) {
+  typedef toystl::unordered_map<std::string, int, std::hash<std::string>> Map;
+  typedef toystl::unordered_multimap<std::string, int, std::hash<std::string>>
+      MultiMap;
+  Map map;
+  MultiMap multimap;
+  for (int i = 0; i != 20; ++i) {
+    map.emplace(std::to_string(i), i);
+    multimap.emplace(std::to_string(i), i);
+  }
+
+  Map::node_type nh = map.extract("5");
+  nh.key() = "hello";
+  EXPECT_TRUE(map.insert(toystl::move(nh)).inserted);
+  ASSERT_TRUE(map.find("hello") != map.end());
+  EXPECT_EQ(map.find("hello")->second, 5);
+  EXPECT_EQ(map.count("hello"), 1u);
+  EXPECT_EQ(map.count("5"), 0u);
+
+  MultiMap::node_type mnh = multimap.extract("5");
+  mnh.key() = "hello";
+  multimap.insert(toystl::move(mnh));
+  multimap.emplace("hello", 50);
+  ASSERT_TRUE(multimap.find("hello") != multimap.end());
+  EXPECT_EQ(multimap.count("hello"), 2u);
+  EXPECT_EQ(multimap.count("5"), 0u);
+}
+
+TEST(TestUnorderedMapNodeHandle, Merge) {
+  toystl::unordered_set<int> set;
+  toystl::unordered_set<int> other;
+  for (int i = 0; i != 100; ++i) {
+    set.insert(i);
+    other.insert(i + 50);
+  }
+  const int* address = &*other.find(120);
+  set.merge(other);
+  EXPECT_EQ(set.size(), 150u);
+  // 键值重复的节点留在原容器中
+  EXPECT_EQ(other.size(), 50u);
+  for (int i = 50; i != 100; ++i) {
+    EXPECT_EQ(other.count(i), 1u);
+  }
+  EXPECT_EQ(&*set.find(120), address);
+
+  toystl::unordered_multiset<int> multiset;
+  multiset.insert(7);
+  multiset.merge(set);
+  multiset.merge(other);
+  EXPECT_TRUE(set.empty());
+  EXPECT_TRUE(other.empty());
+  EXPECT_EQ(multiset.size(), 201u);
+  EXPECT_EQ(multiset.count(7), 2u);
+  EXPECT_EQ(multiset.count(60), 2u);
+
+  toystl::unordered_multiset<int>::node_type nh = multiset.extract(60);
+  EXPECT_EQ(nh.value(), 60);
+  EXPECT_EQ(multiset.count(60), 1u);
+  multiset.insert(toystl::move(nh));
+  EXPECT_EQ(multiset.count(60), 2u);
+}
+
+TEST(TestUnorderedMapNodeHandle, MergeDuringRehash) {
+  IncrementalMap map;
+  IncrementalMap source;
+  std::unordered_map<int, int> std_map;
+  for (int i = 0; i != 1000; ++i) {
+    source.insert(IncrementalMap::value_type(i, i));
+    std_map[i] = i;
+  }
+  for (int i = 0; i != 180; ++i) {
+    map.insert(IncrementalMap::value_type(i * 10, -i));
+    std_map[i * 10] = -i;
+  }
+  map.merge(source);
+  ExpectSameAs(map, std_map);
+  EXPECT_EQ(source.size(), 100u);
+}
+// 统计调用次数的字符串哈希
+struct CountingStringHash {
+  static size_t calls;
+
+  size_t operator()(const std::string& s) const {
+    ++calls;
+    return toystl::hash_string(s.c_str());
+  }
+};
+size_t CountingStringHash::calls = 0;
+
+TEST(TestUnorderedMapCachedHash, RehashAndIterationReuseHash) {
+  static_assert(
+      !toystl::hashtable_cache_hash<int, toystl::hash<int>>::value,
+      "scalar keys do not cache hash codes");
+  static_assert(
+      toystl::hashtable_cache_hash<std::string, CountingStringHash>::value,
+      "string keys cache hash codes");
+
+  typedef toystl::unordered_multimap<std::string, int, CountingStringHash> Map;
+  Map map;
+  CountingStringHash::calls = 0;
+  for (int i = 0; i != 2000; ++i) {
+    map.insert(Map::value_type(std::to_string(i % 1000), i));
+  }
+  // 每次插入只求一次哈希，多次 rehash 都没有重新求哈希
+  EXPECT_EQ(CountingStringHash::calls, 2000u);
+  EXPECT_GT(map.bucket_count(), 1000u);
+
+  size_t visited = 0;
+  for (auto it = map.begin(); it != map.end(); ++it) {
+    ++visited;
+  }
+  auto range = map.equal_range("7");
+  EXPECT_EQ(toystl::distance(range.first, range.second), 2);
+  map.resize(50000);
+  EXPECT_EQ(visited, 2000u);
+  EXPECT_EQ(CountingStringHash::calls, 2001u);
+
+  // 拷贝沿用源节点中的哈希值
+  auto copy = map;
+  EXPECT_EQ(CountingStringHash::calls, 2001u);
+  EXPECT_EQ(copy.count("999"), 2u);
+  EXPECT_EQ(copy.erase("999"), 2u);
+  EXPECT_EQ(copy.size(), 1998u);
+}
+TEST(TestHashFun, Strings) {
+  const char* url = "https://example.com/api/v1/users/42/profile?tab=1";
+  std::string s(url);
+  EXPECT_EQ(toystl::hash<std::string>()(s), toystl::hash<const char*>()(url));
+  EXPECT_EQ(toystl::hash<std::string>()(s),
+            toystl::hash_bytes(s.data(), s.size()));
+  EXPECT_EQ(toystl::hash<std::string>()(std::string()),
+            toystl::hash_string(""));
+
+  // 每一种长度下改动任意一个字节，哈希值都会改变
+  std::vector<size_t> seen;
+  for (size_t len = 1; len <= s.size(); ++len) {
+    std::string key = s.substr(0, len);
+    const size_t h = toystl::hash<std::string>()(key);
+    seen.push_back(h);
+    for (size_t i = 0; i != len; ++i) {
+      std::string changed = key;
+      changed[i] ^= 1;
+      EXPECT_NE(toystl::hash<std::string>()(changed), h) << len << " " << i;
+    }
+  }
+  std::sort(seen.begin(), seen.end());
+  EXPECT_TRUE(std::unique(seen.begin(), seen.end()) == seen.end());
+
+  // string 的哈希是透明的，配合 equal_to<void> 可以用 const char* 查找
+  toystl::unordered_map<std::string, int, toystl::hash<std::string>,
+                        toystl::equal_to<void>>
+      map;
+  map[s] = 1;
+  EXPECT_EQ(map.find(url)->second, 1);
+}
+
+TEST(TestHashFun, ScalarsAndPairs) {
+  EXPECT_EQ(toystl::hash<double>()(0.0), toystl::hash<double>()(-0.0));
+  EXPECT_EQ(toystl::hash<float>()(0.0f), toystl::hash<float>()(-0.0f));
+  EXPECT_NE(toystl::hash<double>()(1.0), toystl::hash<double>()(2.0));
+  EXPECT_NE(toystl::hash<long long>()(1ll << 40),
+            toystl::hash<long long>()(1ll << 41));
+
+  int values[2];
+  EXPECT_NE(toystl::hash<int*>()(&values[0]), toystl::hash<int*>()(&values[1]));
+
+  typedef toystl::pair<int, int> Point;
+  toystl::hash<Point> point_hash;
+  EXPECT_NE(point_hash(Point(1, 2)), point_hash(Point(2, 1)));
+  EXPECT_EQ(point_hash(Point(3, 4)), point_hash(Point(3, 4)));
+
+  toystl::unordered_set<Point> points;
+  for (int x = 0; x != 30; ++x) {
+    for (int y = 0; y != 30; ++y) {
+      points.insert(Point(x, y));
+    }
+  }
+  EXPECT_EQ(points.size(), 900u);
+  EXPECT_EQ(points.count(Point(29, 0)), 1u);
+  EXPECT_EQ(points.count(Point(30, 0)), 0u);
+}
+}  // namespace unorderedmaptest
+}  // namespace toystl
+#endif  // TOYSTL_TEST_TEST_UNORDERED_MAP_H_
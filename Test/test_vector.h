@@ -1,6 +1,7 @@
 #ifndef TOYSTL_TEST_TEST_VECTOR_H_
 #define TOYSTL_TEST_TEST_VECTOR_H_
 
+#include <algorithm>
 #include <vector>
 
 #include "gmock/gmock.h"
@@ -202,6 +203,103 @@ TEST_F(TestVector, Swap) {
   EXPECT_EQ(b.back(), end_of_a);
 }
 
+// 在中间 emplace / insert，备用空间足够和不够两种情况
+TEST_F(TestVector, EmplaceAndInsertMiddle) {
+  abc_vector_of_kitten.reserve(16);
+  for (int i = 0; i != 4; ++i) {
+    abc_vector_of_kitten.emplace_back(i);
+    std_vector_of_kitten.emplace_back(i);
+  }
+  abc_vector_of_kitten.emplace(abc_vector_of_kitten.begin() + 1, 7);
+  std_vector_of_kitten.emplace(std_vector_of_kitten.begin() + 1, 7);
+  ExpectEqual();
+  abc_vector_of_kitten.insert(abc_vector_of_kitten.begin() + 2, 3,
+                              abc_vector_of_kitten[4]);
+  std_vector_of_kitten.insert(std_vector_of_kitten.begin() + 2, 3,
+                              std_vector_of_kitten[4]);
+  ExpectEqual();
+  while (abc_vector_of_kitten.size() != abc_vector_of_kitten.capacity()) {
+    abc_vector_of_kitten.emplace_back(9);
+    std_vector_of_kitten.emplace_back(9);
+  }
+  abc_vector_of_kitten.insert(abc_vector_of_kitten.begin(),
+                              abc_vector_of_kitten[3]);
+  std_vector_of_kitten.insert(std_vector_of_kitten.begin(),
+                              std_vector_of_kitten[3]);
+  ExpectEqual();
+}
+
+// int 满足 trivially copyable，扩容走 realloc 路径
+TEST(TestVectorRealloc, PushBackAndInsert) {
+  toystl::vector<int> v;
+  std::vector<int> expect;
+  for (int i = 0; i != 5000; ++i) {
+    v.push_back(i);
+    expect.push_back(i);
+  }
+  // 扩容时插入的值引用自身的元素
+  while (v.size() != v.capacity()) {
+    v.push_back(-1);
+    expect.push_back(-1);
+  }
+  v.push_back(v[0]);
+  expect.push_back(expect[0]);
+  while (v.size() != v.capacity()) {
+    v.emplace_back(-2);
+    expect.emplace_back(-2);
+  }
+  v.insert(v.begin() + 3, v[10]);
+  expect.insert(expect.begin() + 3, expect[10]);
+  ASSERT_EQ(v.size(), expect.size());
+  EXPECT_TRUE(std::equal(v.begin(), v.end(), expect.begin()));
+
+  v.reserve(v.capacity() * 4);
+  EXPECT_GE(v.capacity(), expect.size() * 4);
+  EXPECT_TRUE(std::equal(v.begin(), v.end(), expect.begin()));
+}
+
+TEST(TestVectorGrowth, Policies) {
+  toystl::vector<int> v2;
+  toystl::vector<int, toystl::allocator<int>, toystl::vector_growth_1_5x> v15;
+  toystl::vector<int, toystl::allocator<int>,
+                 toystl::vector_growth_page_aligned<>>
+      vpage;
+  size_t last2 = 0, last15 = 0;
+  for (int i = 0; i != 100000; ++i) {
+    v2.push_back(i);
+    v15.push_back(i);
+    vpage.push_back(i);
+    if (v2.capacity() != last2) {
+      // 2 倍扩容
+      EXPECT_TRUE(last2 == 0 || v2.capacity() == last2 * 2);
+      last2 = v2.capacity();
+    }
+    if (v15.capacity() != last15) {
+      // 1.5 倍扩容，容量很小时至少增加到需要的大小
+      EXPECT_EQ(v15.capacity(), toystl::max(last15 + last15 / 2, v15.size()));
+      last15 = v15.capacity();
+    }
+    if (vpage.capacity() * sizeof(int) >= 4096) {
+      EXPECT_EQ(vpage.capacity() * sizeof(int) % 4096, 0u);
+    }
+  }
+  EXPECT_LE(v15.capacity(), v15.size() + v15.size() / 2);
+  for (int i = 0; i != 100000; ++i) {
+    ASSERT_EQ(v15[i], i);
+    ASSERT_EQ(vpage[i], i);
+  }
+
+  // 插入一段区间时同样按策略扩容
+  typedef toystl::testhelper::nontrivial Kitten;
+  toystl::vector<Kitten, toystl::allocator<Kitten>, toystl::vector_growth_1_5x>
+      kittens(10, Kitten(1));
+  kittens.insert(kittens.begin(), 2, Kitten(2));
+  EXPECT_EQ(kittens.capacity(), 15u);
+  EXPECT_EQ(kittens.size(), 12u);
+  EXPECT_EQ(kittens.front(), Kitten(2));
+  EXPECT_EQ(kittens.back(), Kitten(1));
+}
+
 // TEST_F(TestVector, Performance) {
 // using clock = std::chrono::high_resolution_clock;
 // auto ticks = [](auto& vector) {
@@ -65,7 +65,11 @@ bool none_of(InputIter first, InputIter last, UnaryPredicate unary_pred) {
 // operator==，返回元素相等的个数
 /******************************************************************************/
 template <class InputIter, class T>
-size_t count(InputIter first, InputIter last, const T &value) {
+size_t count(InputIter first, InputIter last, const T &value);
+
+template <class InputIter, class T>
+size_t __count_segmented(InputIter first, InputIter last, const T &value,
+                         false_type) {
   size_t n = 0;
   for (; first != last; ++first) {
     if (*first == value) {
@@ -76,6 +80,30 @@ size_t count(InputIter first, InputIter last, const T &value) {
   return n;
 }
 
+// 分段迭代器逐段计数，每段是原生指针区间
+template <class InputIter, class T>
+size_t __count_segmented(InputIter first, InputIter last, const T &value,
+                         true_type) {
+  using traits = segmented_iterator_traits<InputIter>;
+  typename traits::segment_iterator sfirst = traits::segment(first);
+  typename traits::segment_iterator slast = traits::segment(last);
+  if (sfirst == slast) {
+    return toystl::count(traits::local(first), traits::local(last), value);
+  }
+  size_t n = toystl::count(traits::local(first), traits::end(sfirst), value);
+  for (++sfirst; sfirst != slast; ++sfirst) {
+    n += toystl::count(traits::begin(sfirst), traits::end(sfirst), value);
+  }
+  return n + toystl::count(traits::begin(slast), traits::local(last), value);
+}
+
+template <class InputIter, class T>
+size_t count(InputIter first, InputIter last, const T &value) {
+  return __count_segmented(
+      first, last, value,
+      typename segmented_iterator_traits<InputIter>::is_segmented_iterator());
+}
+
 /******************************************************************************/
 // count_if
 // 对[first, last)区间内的每个元素都进行一元 unary_pred 操作，返回结果为 true
@@ -98,7 +126,11 @@ bool count_if(InputIter first, InputIter last, const T &value, Compare comp) {
 // 在[first, last)区间内找到等于第一个 value 的元素，返回指向该元素的迭代器
 /******************************************************************************/
 template <class InputIter, class T>
-InputIter find(InputIter first, InputIter last, const T &value) {
+InputIter find(InputIter first, InputIter last, const T &value);
+
+template <class InputIter, class T>
+InputIter __find_segmented(InputIter first, InputIter last, const T &value,
+                           false_type) {
   while (first != last && *first != value) {
     first++;
   }
@@ -106,6 +138,41 @@ InputIter find(InputIter first, InputIter last, const T &value) {
   return first;
 }
 
+// 分段迭代器逐段查找，每段是原生指针区间
+template <class InputIter, class T>
+InputIter __find_segmented(InputIter first, InputIter last, const T &value,
+                           true_type) {
+  using traits = segmented_iterator_traits<InputIter>;
+  using local_iterator = typename traits::local_iterator;
+  typename traits::segment_iterator sfirst = traits::segment(first);
+  typename traits::segment_iterator slast = traits::segment(last);
+  if (sfirst == slast) {
+    local_iterator it =
+        toystl::find(traits::local(first), traits::local(last), value);
+    return it == traits::local(last) ? last : traits::compose(sfirst, it);
+  }
+  local_iterator it =
+      toystl::find(traits::local(first), traits::end(sfirst), value);
+  if (it != traits::end(sfirst)) {
+    return traits::compose(sfirst, it);
+  }
+  for (++sfirst; sfirst != slast; ++sfirst) {
+    it = toystl::find(traits::begin(sfirst), traits::end(sfirst), value);
+    if (it != traits::end(sfirst)) {
+      return traits::compose(sfirst, it);
+    }
+  }
+  it = toystl::find(traits::begin(slast), traits::local(last), value);
+  return it == traits::local(last) ? last : traits::compose(slast, it);
+}
+
+template <class InputIter, class T>
+InputIter find(InputIter first, InputIter last, const T &value) {
+  return __find_segmented(
+      first, last, value,
+      typename segmented_iterator_traits<InputIter>::is_segmented_iterator());
+}
+
 /******************************************************************************/
 // find_if
 // 在[first, last)区间内找到第一个令一元操作 unary_pred 为 true
@@ -126,7 +193,8 @@ InputIter find_if(InputIter first, InputIter last, UnaryPredicate unary_pred) {
 // 的元素并返回指向该元素的迭代器
 /******************************************************************************/
 template <class InputIter, class UnaryPredicate>
-InputIter find(InputIter first, InputIter last, UnaryPredicate unary_pred) {
+InputIter find_if_not(InputIter first, InputIter last,
+                      UnaryPredicate unary_pred) {
   while (first != last && unary_pred(*first)) {
     first++;
   }
@@ -427,7 +495,11 @@ InputIter find_first_of(InputIter first1, InputIter last1, ForwardIter first2,
 // f() 可返回一个值，但该值会被忽略
 /******************************************************************************/
 template <class InputIter, class Function>
-Function for_each(InputIter first, InputIter last, Function f) {
+Function for_each(InputIter first, InputIter last, Function f);
+
+template <class InputIter, class Function>
+Function __for_each_segmented(InputIter first, InputIter last, Function f,
+                              false_type) {
   for (; first != last; ++first) {
     f(*first);
   }
@@ -435,6 +507,40 @@ Function for_each(InputIter first, InputIter last, Function f) {
   return f;
 }
 
+// 函数对象以引用传入，lambda 之类的函数对象不能赋值
+template <class LocalIter, class Function>
+void __for_each_local(LocalIter first, LocalIter last, Function &f) {
+  for (; first != last; ++first) {
+    f(*first);
+  }
+}
+
+// 分段迭代器逐段处理，每段是原生指针区间
+template <class InputIter, class Function>
+Function __for_each_segmented(InputIter first, InputIter last, Function f,
+                              true_type) {
+  using traits = segmented_iterator_traits<InputIter>;
+  typename traits::segment_iterator sfirst = traits::segment(first);
+  typename traits::segment_iterator slast = traits::segment(last);
+  if (sfirst == slast) {
+    __for_each_local(traits::local(first), traits::local(last), f);
+    return f;
+  }
+  __for_each_local(traits::local(first), traits::end(sfirst), f);
+  for (++sfirst; sfirst != slast; ++sfirst) {
+    __for_each_local(traits::begin(sfirst), traits::end(sfirst), f);
+  }
+  __for_each_local(traits::begin(slast), traits::local(last), f);
+  return f;
+}
+
+template <class InputIter, class Function>
+Function for_each(InputIter first, InputIter last, Function f) {
+  return __for_each_segmented(
+      first, last, f,
+      typename segmented_iterator_traits<InputIter>::is_segmented_iterator());
+}
+
 /******************************************************************************/
 // adjacent_find
 // 找出第一对匹配的相邻元素，缺省使用 operator==
@@ -1496,7 +1602,7 @@ bool is_permutation_aux(ForwardIter1 first1, ForwardIter1 last1,
   }
 
   for (auto it = first1; it != last1; ++it) {
-    if (toystl::find(
+    if (toystl::find_if(
             first1, it,
             [it, pred](typename iterator_traits<ForwardIter1>::value_type x) {
               return pred(*it, x);
@@ -98,7 +98,9 @@ struct __copy_dispatch {
 // 以下版本适合于 "指针所指对象具备 trival assignment operator"
 template <class T>
 T* __copy_t(const T* first, const T* last, T* result, true_type) {
-  memmove(result, first, sizeof(T) * (last - first));
+  if (first != last) {
+    memmove(result, first, sizeof(T) * (last - first));
+  }
   return result + (last - first);
 }
 // 以下版本适合于 "指针所指对象具备 non-trival assignment operator"
@@ -140,10 +142,71 @@ inline wchar_t* copy(const wchar_t* first, const wchar_t* last,
   return result + (last - first);
 }
 
+// 4、分段迭代器版本：把每一段当作原生指针区间，交给上面的版本处理
+template <class InputIter, class OutputIter>
+OutputIter copy(InputIter first, InputIter last, OutputIter result);
+
+// 来源是分段迭代器：逐段拷贝
+template <class InputIter, class OutputIter, class OutputSegmented>
+OutputIter __copy_segmented(InputIter first, InputIter last, OutputIter result,
+                            true_type, OutputSegmented) {
+  using traits = segmented_iterator_traits<InputIter>;
+  typename traits::segment_iterator sfirst = traits::segment(first);
+  typename traits::segment_iterator slast = traits::segment(last);
+  if (sfirst == slast) {
+    return toystl::copy(traits::local(first), traits::local(last), result);
+  }
+  result = toystl::copy(traits::local(first), traits::end(sfirst), result);
+  for (++sfirst; sfirst != slast; ++sfirst) {
+    result = toystl::copy(traits::begin(sfirst), traits::end(sfirst), result);
+  }
+  return toystl::copy(traits::begin(slast), traits::local(last), result);
+}
+
+// 只有目的地是分段迭代器：来源能随机访问时，按目的地的段切分来源
+template <class InputIter, class OutputIter>
+OutputIter __copy_to_segmented(InputIter first, InputIter last,
+                               OutputIter result, input_iterator_tag) {
+  return __copy_dispatch<InputIter, OutputIter>()(first, last, result);
+}
+
+template <class RandomIter, class OutputIter>
+OutputIter __copy_to_segmented(RandomIter first, RandomIter last,
+                               OutputIter result, random_access_iterator_tag) {
+  using traits = segmented_iterator_traits<OutputIter>;
+  typename traits::segment_iterator s = traits::segment(result);
+  typename traits::local_iterator l = traits::local(result);
+  for (ptrdiff_t n = last - first; n > 0; ++s, l = traits::begin(s)) {
+    const ptrdiff_t len = toystl::min<ptrdiff_t>(n, traits::end(s) - l);
+    l = toystl::copy(first, first + len, l);
+    first += len;
+    n -= len;
+    if (n == 0) {
+      return traits::compose(s, l);
+    }
+  }
+  return result;
+}
+
+template <class InputIter, class OutputIter>
+OutputIter __copy_segmented(InputIter first, InputIter last, OutputIter result,
+                            false_type, true_type) {
+  return __copy_to_segmented(first, last, result, iterator_category(first));
+}
+
+template <class InputIter, class OutputIter>
+OutputIter __copy_segmented(InputIter first, InputIter last, OutputIter result,
+                            false_type, false_type) {
+  return __copy_dispatch<InputIter, OutputIter>()(first, last, result);
+}
+
 // 1、完全泛化版本
 template <class InputIter, class OutputIter>
 inline OutputIter copy(InputIter first, InputIter last, OutputIter result) {
-  return __copy_dispatch<InputIter, OutputIter>()(first, last, result);
+  return __copy_segmented(
+      first, last, result,
+      typename segmented_iterator_traits<InputIter>::is_segmented_iterator(),
+      typename segmented_iterator_traits<OutputIter>::is_segmented_iterator());
 }
 
 /******************************************************************************/
@@ -298,7 +361,7 @@ template <class RandomIter, class OutputIter, class Distance>
 OutputIter __move_d(RandomIter first, RandomIter last, OutputIter result,
                     Distance*) {
   for (Distance n = last - first; n > 0; --n, ++result, ++first) {
-    *result = *first;
+    *result = toystl::move(*first);
   }
 
   return result;
@@ -335,10 +398,71 @@ T* __move_t(const T* first, const T* last, T* result, false_type) {
   return __move_d(first, last, result, static_cast<ptrdiff_t*>(0));
 }
 
+// 分段迭代器版本，与 copy 相同
+template <class InputIterator, class OutputIterator>
+OutputIterator move(InputIterator first, InputIterator last,
+                    OutputIterator result);
+
+template <class InputIter, class OutputIter, class OutputSegmented>
+OutputIter __move_segmented(InputIter first, InputIter last, OutputIter result,
+                            true_type, OutputSegmented) {
+  using traits = segmented_iterator_traits<InputIter>;
+  typename traits::segment_iterator sfirst = traits::segment(first);
+  typename traits::segment_iterator slast = traits::segment(last);
+  if (sfirst == slast) {
+    return toystl::move(traits::local(first), traits::local(last), result);
+  }
+  result = toystl::move(traits::local(first), traits::end(sfirst), result);
+  for (++sfirst; sfirst != slast; ++sfirst) {
+    result = toystl::move(traits::begin(sfirst), traits::end(sfirst), result);
+  }
+  return toystl::move(traits::begin(slast), traits::local(last), result);
+}
+
+template <class InputIter, class OutputIter>
+OutputIter __move_to_segmented(InputIter first, InputIter last,
+                               OutputIter result, input_iterator_tag) {
+  return __move_dispatch<InputIter, OutputIter>()(first, last, result);
+}
+
+template <class RandomIter, class OutputIter>
+OutputIter __move_to_segmented(RandomIter first, RandomIter last,
+                               OutputIter result, random_access_iterator_tag) {
+  using traits = segmented_iterator_traits<OutputIter>;
+  typename traits::segment_iterator s = traits::segment(result);
+  typename traits::local_iterator l = traits::local(result);
+  for (ptrdiff_t n = last - first; n > 0; ++s, l = traits::begin(s)) {
+    const ptrdiff_t len = toystl::min<ptrdiff_t>(n, traits::end(s) - l);
+    l = toystl::move(first, first + len, l);
+    first += len;
+    n -= len;
+    if (n == 0) {
+      return traits::compose(s, l);
+    }
+  }
+  return result;
+}
+
+template <class InputIter, class OutputIter>
+OutputIter __move_segmented(InputIter first, InputIter last, OutputIter result,
+                            false_type, true_type) {
+  return __move_to_segmented(first, last, result, iterator_category(first));
+}
+
+template <class InputIter, class OutputIter>
+OutputIter __move_segmented(InputIter first, InputIter last, OutputIter result,
+                            false_type, false_type) {
+  return __move_dispatch<InputIter, OutputIter>()(first, last, result);
+}
+
 template <class InputIterator, class OutputIterator>
 OutputIterator move(InputIterator first, InputIterator last,
                     OutputIterator result) {
-  return __move_dispatch<InputIterator, OutputIterator>()(first, last, result);
+  return __move_segmented(
+      first, last, result,
+      typename segmented_iterator_traits<InputIterator>::is_segmented_iterator(),
+      typename segmented_iterator_traits<
+          OutputIterator>::is_segmented_iterator());
 }
 
 /******************************************************************************/
@@ -506,12 +630,41 @@ inline void fill(char* first, char* last, const char& c) {
 }
 
 template <class ForwardIter, class T>
-inline void fill(ForwardIter first, ForwardIter last, const T& value) {
+inline void fill(ForwardIter first, ForwardIter last, const T& value);
+
+template <class ForwardIter, class T>
+void __fill_segmented(ForwardIter first, ForwardIter last, const T& value,
+                      false_type) {
   for (; first != last; ++first) {
     *first = value;
   }
 }
 
+// 分段迭代器逐段填充，每段是原生指针区间
+template <class ForwardIter, class T>
+void __fill_segmented(ForwardIter first, ForwardIter last, const T& value,
+                      true_type) {
+  using traits = segmented_iterator_traits<ForwardIter>;
+  typename traits::segment_iterator sfirst = traits::segment(first);
+  typename traits::segment_iterator slast = traits::segment(last);
+  if (sfirst == slast) {
+    toystl::fill(traits::local(first), traits::local(last), value);
+    return;
+  }
+  toystl::fill(traits::local(first), traits::end(sfirst), value);
+  for (++sfirst; sfirst != slast; ++sfirst) {
+    toystl::fill(traits::begin(sfirst), traits::end(sfirst), value);
+  }
+  toystl::fill(traits::begin(slast), traits::local(last), value);
+}
+
+template <class ForwardIter, class T>
+inline void fill(ForwardIter first, ForwardIter last, const T& value) {
+  __fill_segmented(
+      first, last, value,
+      typename segmented_iterator_traits<ForwardIter>::is_segmented_iterator());
+}
+
 /******************************************************************************/
 // fill_n
 // 从 first 位置开始填充 n 个值
@@ -1,17 +1,45 @@
 #include <string.h>  // memcpy
+#include <atomic>
 #include <cstdlib>
+#include <mutex>
+#include <new>  // std::bad_alloc
 
 #include "alloc.h"
 
 namespace toystl {
+namespace {
+// 保护中央内存池（free_list、start_free、end_free、heap_size 以及 chunk 记录）
+std::mutex central_lock;
+std::atomic<bool> cache_enabled(true);
+}  // namespace
+
+struct alloc::thread_cache_guard {
+  ~thread_cache_guard() { alloc::release_thread_cache(); }
+};
+
 char *alloc::start_free = nullptr;
 char *alloc::end_free = nullptr;
 std::size_t alloc::heap_size = 0;
 
-alloc::obj *volatile alloc::free_list[alloc::_NFREELIST] = {
-    nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr,
-    nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr,
-};
+alloc::chunk_info *alloc::chunks = nullptr;
+std::size_t alloc::chunk_count = 0;
+std::size_t alloc::chunk_capacity = 0;
+std::size_t alloc::free_list_bytes = 0;
+std::size_t alloc::free_list_length[alloc::_NFREELIST] = {0};
+std::size_t alloc::trim_threshold = 0;
+std::size_t alloc::trim_trigger = 0;
+
+#ifdef TOYSTL_ALLOC_STATS
+std::size_t alloc::hit_count[alloc::_NFREELIST] = {0};
+std::size_t alloc::miss_count[alloc::_NFREELIST] = {0};
+std::size_t alloc::malloc_count = 0;
+std::size_t alloc::scavenge_count = 0;
+std::size_t alloc::trim_count = 0;
+#endif
+
+alloc::obj *volatile alloc::free_list[alloc::_NFREELIST] = {nullptr};
+
+thread_local alloc::thread_cache alloc::tls_cache;
 
 void *alloc::allocate(std::size_t bytes) {
   if (bytes > _MAX_BYTES) {
@@ -20,29 +48,76 @@ void *alloc::allocate(std::size_t bytes) {
   }
 
   std::size_t index = FREELIST_INDEX(bytes);
-  obj *my_free_list = free_list[index];
+  thread_cache &cache = tls_cache;
 
-  if (my_free_list == nullptr) {
-    void *r = refill(ROUND_UP(bytes));
-    return r;
+  if (!cache.released && cache_enabled.load(std::memory_order_relaxed)) {
+    obj *my_free_list = cache.free_list[index];
+    if (my_free_list == nullptr) {
+      void *r = refill(CLASS_SIZE(index));
+      return r;
+    }
+
+    cache.free_list[index] = my_free_list->free_list_next;
+    --cache.length[index];
+#ifdef TOYSTL_ALLOC_STATS
+    ++cache.hits[index];
+#endif
+    return my_free_list;
   }
 
-  free_list[index] = my_free_list->free_list_next;
-  return my_free_list;
+  // 不使用 thread cache，直接从中央内存池取一个区块
+  std::lock_guard<std::mutex> lock(central_lock);
+  std::size_t nobjs = 1;
+#ifdef TOYSTL_ALLOC_STATS
+  if (free_list[index] != nullptr) {
+    ++hit_count[index];
+  } else {
+    ++miss_count[index];
+  }
+#endif
+  return fetch_from_central(CLASS_SIZE(index), nobjs);
 }
 
 void alloc::deallocate(void *ptr, std::size_t bytes) {
   if (bytes > _MAX_BYTES) {
     // mallocAlloc::deallocate(ptr);
     free(ptr);
+    return;
   }
 
-  else {
-    std::size_t index = FREELIST_INDEX(bytes);
-    obj *node = static_cast<obj *>(ptr);
-    node->free_list_next = free_list[index];
-    free_list[index] = node;
+  std::size_t index = FREELIST_INDEX(bytes);
+  obj *node = static_cast<obj *>(ptr);
+  thread_cache &cache = tls_cache;
+
+  if (!cache.released && cache_enabled.load(std::memory_order_relaxed)) {
+    if (!cache.registered) {
+      // 本线程可能只释放其它线程分配的内存，同样需要在退出时归还
+      register_thread_cache();
+    }
+    node->free_list_next = cache.free_list[index];
+    cache.free_list[index] = node;
+
+    // cache 过长时把一批区块还给中央内存池，避免内存在线程间单向流动时
+    // 无限堆积在某个线程中
+    std::size_t batch = BATCH_SIZE(index);
+    if (++cache.length[index] > 2 * batch) {
+      obj *first = cache.free_list[index];
+      obj *last = first;
+      for (std::size_t i = 1; i < batch; ++i) {
+        last = last->free_list_next;
+      }
+      cache.free_list[index] = last->free_list_next;
+      cache.length[index] -= batch;
+
+      std::lock_guard<std::mutex> lock(central_lock);
+      merge_counters(cache);
+      release_to_central(index, first, last, batch);
+    }
+    return;
   }
+
+  std::lock_guard<std::mutex> lock(central_lock);
+  release_to_central(index, node, node, 1);
 }
 
 //该实现参考 SGI STL 源码
@@ -53,9 +128,9 @@ void *alloc::reallocate(void *ptr, std::size_t old_sz, std::size_t new_sz) {
     // return mallocAlloc::reallocate(ptr, new_sz);
     return realloc(ptr, new_sz);
   }
-  // 如果新旧值上调到 8
-  // 的倍数后，是同一个数，则不需要调整，直接返回原内存空间的指针即可
-  if (ROUND_UP(old_sz) == ROUND_UP(new_sz)) {
+  // 如果新旧值属于同一个 size class，则不需要调整，直接返回原内存空间的指针即可
+  if (old_sz <= maxBytes && new_sz <= maxBytes &&
+      FREELIST_INDEX(old_sz) == FREELIST_INDEX(new_sz)) {
     return ptr;
   }
 
@@ -66,44 +141,298 @@ void *alloc::reallocate(void *ptr, std::size_t old_sz, std::size_t new_sz) {
   return result;
 }
 
-// 返回一个大小为n的对象，并且有时候会为适当的freelist增加节点
+// 返回一个大小为n的对象，并且从中央内存池取一批区块放入本线程的 cache
 // 假设bytes已经上调为8的倍数
 void *alloc::refill(std::size_t bytes) {
+  thread_cache &cache = tls_cache;
+  if (!cache.registered) {
+    register_thread_cache();
+  }
+
+  std::size_t index = FREELIST_INDEX(bytes);
   // 记录获取的区块数量
-  std::size_t nobjs = _NOBJS;
+  std::size_t nobjs = BATCH_SIZE(index);
+  obj *result = nullptr;
+  {
+    std::lock_guard<std::mutex> lock(central_lock);
+#ifdef TOYSTL_ALLOC_STATS
+    ++miss_count[index];
+#endif
+    merge_counters(cache);
+    result = fetch_from_central(bytes, nobjs);
+  }
 
-  // 从内存池中取nobjs个区块作为freelist的新节点
-  char *chunk = chunk_alloc(bytes, nobjs);
-  obj *volatile *my_list = 0;
-  obj *result = 0;
-  obj *current_obj = 0, *next_obj = 0;
+  // 第一个区块返回给客户端，剩下的挂到本线程的 cache 上
+  cache.free_list[index] = result->free_list_next;
+  cache.length[index] += nobjs - 1;
+  return result;
+}
 
-  if (nobjs == 1) {
-    //只获取了一个区块
-    return chunk;
+// 从中央内存池取出至多 nobjs 个区块，以 nullptr 结尾的链表形式返回，
+// nobjs 被修改为实际取得的个数。中央 freelist 为空时从内存池切分
+alloc::obj *alloc::fetch_from_central(std::size_t bytes, std::size_t &nobjs) {
+  obj *volatile *my_list = free_list + FREELIST_INDEX(bytes);
+  obj *result = *my_list;
+
+  if (result != nullptr) {
+    obj *last = result;
+    std::size_t n = 1;
+    while (n < nobjs && last->free_list_next != nullptr) {
+      last = last->free_list_next;
+      ++n;
+    }
+    *my_list = last->free_list_next;
+    last->free_list_next = nullptr;
+    nobjs = n;
+    free_list_bytes -= n * bytes;
+    free_list_length[FREELIST_INDEX(bytes)] -= n;
+    return result;
   }
 
-  my_list = free_list + FREELIST_INDEX(bytes);
+  // 从内存池中取nobjs个区块
+  char *chunk = chunk_alloc(bytes, nobjs);
+  obj *current_obj = nullptr, *next_obj = nullptr;
 
   result = (obj *)(chunk);
-
-  // 剩下的空间分离出来
-  *my_list = next_obj = (obj *)(chunk + bytes);
-
-  for (size_t i = 1;; ++i) {
+  next_obj = result;
+  for (std::size_t i = 1;; ++i) {
     current_obj = next_obj;
-    next_obj = (obj *)((char *)next_obj + bytes);
-    if (nobjs - 1 == i) {
-      current_obj->free_list_next = 0;
+    if (nobjs == i) {
+      current_obj->free_list_next = nullptr;
       break;
     }
-
+    next_obj = (obj *)((char *)next_obj + bytes);
     current_obj->free_list_next = next_obj;
   }
 
   return result;
 }
 
+// 把 [first, last] 这一串共 n 个区块挂回中央 freelist
+void alloc::release_to_central(std::size_t index, obj *first, obj *last,
+                               std::size_t n) {
+  last->free_list_next = free_list[index];
+  free_list[index] = first;
+  free_list_bytes += n * CLASS_SIZE(index);
+  free_list_length[index] += n;
+
+  if (trim_threshold != 0 && free_list_bytes > trim_trigger) {
+    trim_locked();
+    // 剩下的空闲区块分散在仍有区块被使用的 chunk 中，等空闲字节再增长
+    // trim_threshold 之后才再次尝试，避免每次释放都扫描 freelist
+    trim_trigger = free_list_bytes + trim_threshold;
+  }
+}
+
+void alloc::register_thread_cache() {
+  // 函数内的 thread_local 对象在首次经过时构造，线程退出时析构
+  static thread_local thread_cache_guard guard;
+  (void)guard;
+  tls_cache.registered = true;
+}
+
+// 线程退出时调用，之后本线程的分配释放都直接访问中央内存池
+void alloc::release_thread_cache() {
+  flush_thread_cache();
+  tls_cache.released = true;
+}
+
+void alloc::flush_thread_cache() {
+  thread_cache &cache = tls_cache;
+  std::lock_guard<std::mutex> lock(central_lock);
+  merge_counters(cache);
+  for (std::size_t index = 0; index < _NFREELIST; ++index) {
+    obj *first = cache.free_list[index];
+    if (first == nullptr) {
+      continue;
+    }
+    obj *last = first;
+    while (last->free_list_next != nullptr) {
+      last = last->free_list_next;
+    }
+    release_to_central(index, first, last, cache.length[index]);
+    cache.free_list[index] = nullptr;
+    cache.length[index] = 0;
+  }
+}
+
+void alloc::set_thread_cache_enabled(bool enabled) {
+  cache_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+bool alloc::thread_cache_enabled() {
+  return cache_enabled.load(std::memory_order_relaxed);
+}
+
+std::size_t alloc::trim() {
+  flush_thread_cache();
+  std::lock_guard<std::mutex> lock(central_lock);
+  return trim_locked();
+}
+
+void alloc::set_trim_threshold(std::size_t bytes) {
+  std::lock_guard<std::mutex> lock(central_lock);
+  trim_threshold = bytes;
+  trim_trigger = bytes;
+}
+
+alloc::pool_stats alloc::stats() {
+  std::lock_guard<std::mutex> lock(central_lock);
+  pool_stats result;
+  result.chunk_count = chunk_count;
+  result.heap_bytes = heap_size;
+  result.free_list_bytes = free_list_bytes;
+  result.pool_bytes = end_free - start_free;
+  result.handed_out_bytes =
+      heap_size - free_list_bytes - (end_free - start_free);
+  result.malloc_count = 0;
+  result.scavenge_count = 0;
+  result.trim_count = 0;
+  result.class_count = _NFREELIST;
+  for (std::size_t index = 0; index < _NFREELIST; ++index) {
+    class_stats &cs = result.classes[index];
+    cs.size = CLASS_SIZE(index);
+    cs.free_blocks = free_list_length[index];
+    cs.hits = 0;
+    cs.misses = 0;
+  }
+
+#ifdef TOYSTL_ALLOC_STATS
+  result.malloc_count = malloc_count;
+  result.scavenge_count = scavenge_count;
+  result.trim_count = trim_count;
+  const thread_cache &cache = tls_cache;
+  for (std::size_t index = 0; index < _NFREELIST; ++index) {
+    result.classes[index].hits = hit_count[index] + cache.hits[index];
+    result.classes[index].misses = miss_count[index];
+  }
+#endif
+  return result;
+}
+
+// 把本线程记录的计数合并到中央计数中，调用前必须持有中央内存池的锁
+void alloc::merge_counters(thread_cache &cache) {
+#ifdef TOYSTL_ALLOC_STATS
+  for (std::size_t index = 0; index < _NFREELIST; ++index) {
+    hit_count[index] += cache.hits[index];
+    cache.hits[index] = 0;
+  }
+#else
+  (void)cache;
+#endif
+}
+
+// 记录一个新申请的 chunk，保持按地址升序
+bool alloc::add_chunk(char *addr, std::size_t size) {
+  if (chunk_count == chunk_capacity) {
+    std::size_t new_capacity = chunk_capacity == 0 ? 16 : chunk_capacity * 2;
+    chunk_info *new_chunks = static_cast<chunk_info *>(
+        realloc(chunks, new_capacity * sizeof(chunk_info)));
+    if (new_chunks == nullptr) {
+      return false;
+    }
+    chunks = new_chunks;
+    chunk_capacity = new_capacity;
+  }
+
+  std::size_t pos = chunk_count;
+  while (pos > 0 && chunks[pos - 1].addr > addr) {
+    chunks[pos] = chunks[pos - 1];
+    --pos;
+  }
+  chunks[pos].addr = addr;
+  chunks[pos].size = size;
+  ++chunk_count;
+  return true;
+}
+
+// 二分查找 p 所在的 chunk，返回其下标
+std::size_t alloc::find_chunk(const char *p) {
+  std::size_t first = 0, last = chunk_count;
+  while (last - first > 1) {
+    std::size_t mid = first + (last - first) / 2;
+    if (chunks[mid].addr <= p) {
+      first = mid;
+    } else {
+      last = mid;
+    }
+  }
+  return first;
+}
+
+// 统计每个 chunk 中空闲的字节数（中央 freelist 加上内存池的剩余部分），
+// 与 chunk 大小相等说明整个 chunk 都没有被使用，可以还给系统
+std::size_t alloc::trim_locked() {
+  if (chunk_count == 0) {
+    return 0;
+  }
+
+  std::size_t *idle =
+      static_cast<std::size_t *>(calloc(chunk_count, sizeof(std::size_t)));
+  if (idle == nullptr) {
+    return 0;
+  }
+
+  for (std::size_t index = 0; index < _NFREELIST; ++index) {
+    std::size_t bytes = CLASS_SIZE(index);
+    for (obj *p = free_list[index]; p != nullptr; p = p->free_list_next) {
+      idle[find_chunk((char *)p)] += bytes;
+    }
+  }
+  if (end_free != start_free) {
+    idle[find_chunk(start_free)] += end_free - start_free;
+  }
+
+  // 复用 idle 数组：非 0 表示该 chunk 需要释放
+  std::size_t released = 0;
+  for (std::size_t i = 0; i < chunk_count; ++i) {
+    if (idle[i] == chunks[i].size) {
+      released += chunks[i].size;
+    } else {
+      idle[i] = 0;
+    }
+  }
+  if (released == 0) {
+    free(idle);
+    return 0;
+  }
+
+  // 把属于待释放 chunk 的区块从 freelist 上摘下来
+  for (std::size_t index = 0; index < _NFREELIST; ++index) {
+    std::size_t bytes = CLASS_SIZE(index);
+    obj *volatile *link = free_list + index;
+    while (*link != nullptr) {
+      obj *p = *link;
+      if (idle[find_chunk((char *)p)] != 0) {
+        *link = p->free_list_next;
+        free_list_bytes -= bytes;
+        --free_list_length[index];
+      } else {
+        link = &p->free_list_next;
+      }
+    }
+  }
+  if (end_free != start_free && idle[find_chunk(start_free)] != 0) {
+    start_free = end_free = nullptr;
+  }
+
+  std::size_t kept = 0;
+  for (std::size_t i = 0; i < chunk_count; ++i) {
+    if (idle[i] != 0) {
+      free(chunks[i].addr);
+      heap_size -= chunks[i].size;
+    } else {
+      chunks[kept++] = chunks[i];
+    }
+  }
+  chunk_count = kept;
+  free(idle);
+#ifdef TOYSTL_ALLOC_STATS
+  ++trim_count;
+#endif
+  return released;
+}
+
 // 内存池(一大块空闲的空间) bytes已经上调为8的倍数
 char *alloc::chunk_alloc(std::size_t bytes, std::size_t &nobjs) {
   char *result = 0;
@@ -124,28 +453,54 @@ char *alloc::chunk_alloc(std::size_t bytes, std::size_t &nobjs) {
     // 每次申请两倍的新内存+
     std::size_t bytes_to_get = 2 * bytes_need + ROUND_UP(heap_size >> 4);
     // 试着让内存池中的残余零头还有利用价值
-    if (bytes_left > 0) {
-      obj *volatile *my_list = free_list + FREELIST_INDEX(bytes_left);
+    // 残余零头不一定恰好是某个 size class 的大小，按不超过它的最大
+    // size class 依次切分
+    std::size_t index = _NFREELIST;
+    while (bytes_left >= _ALIGN) {
+      while (CLASS_SIZE(index - 1) > bytes_left) {
+        --index;
+      }
+      std::size_t piece = CLASS_SIZE(index - 1);
+      obj *volatile *my_list = free_list + index - 1;
       ((obj *)start_free)->free_list_next = *my_list;
       *my_list = (obj *)start_free;
+      free_list_bytes += piece;
+      ++free_list_length[index - 1];
+      start_free += piece;
+      bytes_left -= piece;
     }
 
     start_free = (char *)malloc(bytes_to_get);
+#ifdef TOYSTL_ALLOC_STATS
+    ++malloc_count;
+#endif
+    if (nullptr != start_free && !add_chunk(start_free, bytes_to_get)) {
+      free(start_free);
+      start_free = nullptr;
+    }
     if (nullptr == start_free) {  // heap内存不足
       obj *volatile *my_list = 0, *p = 0;
 
-      // 在freelist上寻找未使用的大区块。
-      for (int i = 0; i <= _MAX_BYTES; i += _ALIGN) {
-        my_list = free_list + FREELIST_INDEX(i);
+      // 在freelist上寻找未使用且足够大的区块。
+      for (std::size_t index = FREELIST_INDEX(bytes); index < _NFREELIST;
+           ++index) {
+        std::size_t i = CLASS_SIZE(index);
+        my_list = free_list + index;
         p = *my_list;
         if (nullptr != p) {
           *my_list = p->free_list_next;
+          free_list_bytes -= i;
+          --free_list_length[index];
+#ifdef TOYSTL_ALLOC_STATS
+          ++scavenge_count;
+#endif
           start_free = (char *)p;
           end_free = start_free + i;
           return chunk_alloc(bytes, nobjs);
         }
       }
       end_free = nullptr;  // 没有内存可用
+      throw std::bad_alloc();
     }
 
     heap_size += bytes_to_get;
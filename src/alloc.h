@@ -65,41 +65,215 @@ namespace toystl {
 //     }
 // };
 
+// size class 的配置，alloc.cpp 与使用方必须以相同的取值编译。
+// 不超过 TOYSTL_ALLOC_MAX_BYTES（2 的幂，不小于 128）的请求由内存池负责
+#ifndef TOYSTL_ALLOC_MAX_BYTES
+#define TOYSTL_ALLOC_MAX_BYTES 4096
+#endif
+
+// thread cache 每次与中央内存池搬运的字节数上限，决定各 size class 的批量
+#ifndef TOYSTL_ALLOC_BATCH_BYTES
+#define TOYSTL_ALLOC_BATCH_BYTES 8192
+#endif
+
+// 定义 TOYSTL_ALLOC_STATS 后统计每个 size class 的命中 / refill 次数以及
+// chunk_alloc 的行为，计数先记在 thread cache 中，进入慢速路径时才合并
+// #define TOYSTL_ALLOC_STATS
+
+namespace detail {
+constexpr std::size_t alloc_log2(std::size_t n) {
+  return n <= 1 ? 0 : 1 + alloc_log2(n >> 1);
+}
+}  // namespace detail
+
 //第二级空间配置器
+// size class：128 bytes 以内按 8 bytes 递增，共 16 个；
+// 128 bytes 以上每翻一倍再等分为 4 个，例如 160、192、224、256、320 ...，
+// 内部碎片不超过 25%。
+// 多线程版本：每个线程持有一份 thread cache（每个 size class 一条 freelist），
+// allocate / deallocate 的快速路径只访问本线程的 cache，不加锁；
+// cache 为空时从中央内存池（即原先的 free_list + chunk_alloc）成批取回，
+// cache 过长时成批归还给中央内存池。只有中央内存池需要加锁。
 class alloc {
  private:
   enum { _ALIGN = 8 };
-  enum { _MAX_BYTES = 128 };
-  enum { _NFREELIST = _MAX_BYTES / _ALIGN };
+  enum { _SMALL_BYTES = 128 };  // 按 _ALIGN 递增的部分
+  enum { _NSMALL = _SMALL_BYTES / _ALIGN };
+  enum { _STEPS = 4 };  // 每翻一倍划分的 size class 个数
+  enum { _MAX_BYTES = TOYSTL_ALLOC_MAX_BYTES };
+  enum {
+    _NFREELIST =
+        _NSMALL + _STEPS * detail::alloc_log2(_MAX_BYTES / _SMALL_BYTES)
+  };
   enum { _NOBJS = 20 };
+  enum { _BATCH_BYTES = TOYSTL_ALLOC_BATCH_BYTES };
+
+  static_assert(static_cast<std::size_t>(_MAX_BYTES) >= _SMALL_BYTES &&
+                    (_MAX_BYTES & (_MAX_BYTES - 1)) == 0,
+                "TOYSTL_ALLOC_MAX_BYTES must be a power of two >= 128");
 
   union obj {
     union obj* free_list_next;
     char client_data[1];
   };
 
+  // 每个线程私有的缓存，只包含平凡类型的成员，线程退出时由 alloc.cpp
+  // 中的 guard 对象把缓存的区块归还给中央内存池
+  struct thread_cache {
+    obj* free_list[_NFREELIST];
+    std::size_t length[_NFREELIST];  // 每条 freelist 上的区块个数
+    bool registered;                 // 是否已经注册了线程退出时的回收
+    bool released;                   // 线程退出后不再使用 cache
+#ifdef TOYSTL_ALLOC_STATS
+    std::size_t hits[_NFREELIST];    // 尚未合并到中央计数的命中次数
+#endif
+  };
+
+  static thread_local thread_cache tls_cache;
+
+  // 线程退出时负责回收 tls_cache，定义在 alloc.cpp 中
+  struct thread_cache_guard;
+
+  // 每个向系统申请的 chunk 记录一项，按地址升序排列，用于 trim 时判断
+  // 某个 chunk 是否已经全部空闲
+  struct chunk_info {
+    char* addr;
+    std::size_t size;
+  };
+
+  // 中央内存池，由 central_lock 保护
   static obj* volatile free_list[_NFREELIST];
 
   static char* start_free;
   static char* end_free;
-  static std::size_t heap_size;
+  static std::size_t heap_size;  // 当前持有的 chunk 总字节数
 
+  static chunk_info* chunks;
+  static std::size_t chunk_count;
+  static std::size_t chunk_capacity;
+  static std::size_t free_list_bytes;  // 中央 freelist 上空闲区块的总字节数
+  static std::size_t free_list_length[_NFREELIST];
+  static std::size_t trim_threshold;   // 自动 trim 的高水位，0 表示关闭
+  static std::size_t trim_trigger;     // free_list_bytes 超过该值时自动 trim
+
+#ifdef TOYSTL_ALLOC_STATS
+  static std::size_t hit_count[_NFREELIST];
+  static std::size_t miss_count[_NFREELIST];
+  static std::size_t malloc_count;    // chunk_alloc 向系统申请的次数
+  static std::size_t scavenge_count;  // chunk_alloc 从 freelist 拆借的次数
+  static std::size_t trim_count;      // trim 释放 chunk 的次数
+#endif
+
+  // bytes 所属 size class 的下标，要求 0 < bytes <= _MAX_BYTES
   static std::size_t FREELIST_INDEX(std::size_t bytes) {
-    return ((bytes + _ALIGN - 1) / _ALIGN - 1);
+    if (bytes <= _SMALL_BYTES) {
+      return ((bytes + _ALIGN - 1) / _ALIGN - 1);
+    }
+    std::size_t b = bytes - 1;
+    std::size_t msb = detail::alloc_log2(_SMALL_BYTES);
+    while ((b >> (msb + 1)) != 0) {
+      ++msb;
+    }
+    // [2^msb, 2^(msb+1)) 被等分为 _STEPS 份
+    std::size_t shift = msb - detail::alloc_log2(_STEPS);
+    return _NSMALL + (msb - detail::alloc_log2(_SMALL_BYTES)) * _STEPS +
+           ((b >> shift) - _STEPS);
+  }
+
+  // 下标为 index 的 size class 的区块大小
+  static std::size_t CLASS_SIZE(std::size_t index) {
+    if (index < _NSMALL) {
+      return (index + 1) * _ALIGN;
+    }
+    std::size_t group = (index - _NSMALL) / _STEPS;
+    std::size_t step = (index - _NSMALL) % _STEPS;
+    std::size_t base = static_cast<std::size_t>(_SMALL_BYTES) << group;
+    return base + (step + 1) * (base / _STEPS);
   }
 
   static std::size_t ROUND_UP(std::size_t bytes) {
     return ((bytes + _ALIGN - 1) & ~(_ALIGN - 1));
   }
 
+  // thread cache 与中央内存池之间一次搬运的区块个数：
+  // 小区块沿用 _NOBJS，大区块按 _BATCH_BYTES 折算，至少 2 个
+  static std::size_t BATCH_SIZE(std::size_t index) {
+    std::size_t n = _BATCH_BYTES / CLASS_SIZE(index);
+    return n > _NOBJS ? static_cast<std::size_t>(_NOBJS) : (n < 2 ? 2 : n);
+  }
+
   static void* refill(std::size_t bytes);
 
+  // 以下函数调用前必须持有中央内存池的锁
   static char* chunk_alloc(std::size_t bytes, std::size_t& nobjs);
+  static obj* fetch_from_central(std::size_t bytes, std::size_t& nobjs);
+  static void release_to_central(std::size_t index, obj* first, obj* last,
+                                 std::size_t n);
+  static bool add_chunk(char* addr, std::size_t size);
+  static std::size_t find_chunk(const char* p);
+  static std::size_t trim_locked();
+  static void merge_counters(thread_cache& cache);
+
+  static void register_thread_cache();
+  static void release_thread_cache();
 
  public:
+  // 单个 size class 的统计信息，hits / misses 只在定义了
+  // TOYSTL_ALLOC_STATS 时计数，否则为 0
+  struct class_stats {
+    std::size_t size;         // 区块大小
+    std::size_t free_blocks;  // 中央 freelist 上的区块个数
+    std::size_t hits;         // 直接从 freelist 取得区块的次数
+    std::size_t misses;       // 需要 refill 的次数
+  };
+
+  // 内存池的统计信息
+  struct pool_stats {
+    std::size_t chunk_count;       // 持有的 chunk 个数
+    std::size_t heap_bytes;        // 持有的 chunk 总字节数
+    std::size_t free_list_bytes;   // 中央 freelist 上空闲区块的字节数
+    std::size_t pool_bytes;        // 内存池中尚未切分的字节数
+    std::size_t handed_out_bytes;  // 交给各线程的字节数（含 thread cache）
+    std::size_t malloc_count;      // chunk_alloc 向系统申请内存的次数
+    std::size_t scavenge_count;    // 系统内存不足时从 freelist 拆借的次数
+    std::size_t trim_count;        // trim 归还 chunk 的次数
+    std::size_t class_count;       // classes 中有效的项数
+    class_stats classes[_NFREELIST];
+  };
+
   static void* allocate(std::size_t bytes);
   static void deallocate(void* ptr, std::size_t bytes);
   static void* reallocate(void* ptr, std::size_t old_sz, std::size_t new_sz);
+
+  // 申请 bytes 字节时实际得到的区块大小：内存池内按 size class 上调，
+  // 超过 _MAX_BYTES 的请求交给 malloc，原样返回。
+  // 调用方可以据此把容量凑满整个区块
+  static std::size_t good_size(std::size_t bytes) {
+    if (bytes == 0 || bytes > _MAX_BYTES) {
+      return bytes;
+    }
+    return CLASS_SIZE(FREELIST_INDEX(bytes));
+  }
+
+  // 把当前线程 cache 中的区块全部归还给中央内存池，线程退出时会自动调用
+  static void flush_thread_cache();
+
+  // 关闭后所有线程都直接（加锁）访问中央内存池，相当于原先的单一内存池，
+  // 便于排查问题和做性能对比。默认开启
+  static void set_thread_cache_enabled(bool enabled);
+  static bool thread_cache_enabled();
+
+  // 把完全空闲的 chunk 归还给系统，返回归还的字节数。
+  // 调用前会先把当前线程的 cache 归还给中央内存池，其它线程 cache
+  // 中的区块仍视为在使用中
+  static std::size_t trim();
+
+  // 中央 freelist 上的空闲字节超过 bytes 时自动 trim，0 表示关闭（默认）
+  static void set_trim_threshold(std::size_t bytes);
+
+  // 返回统计信息的快照。其它线程的命中次数在其下一次访问中央内存池时
+  // 才会合并进来，因此可能略微滞后
+  static pool_stats stats();
 };
 }  // namespace toystl
 
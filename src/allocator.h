@@ -2,6 +2,8 @@
 #define TOYSTL_SRC_ALLOCATOR_H_
 
 #include <cstddef>
+#include <new>          // std::bad_alloc
+#include <type_traits>  // std::is_empty
 
 #include "alloc.h"
 #include "construct.h"
@@ -25,6 +27,21 @@ class allocator {
     using other = allocator<U>;
   };
 
+  // 无状态的分配器，容器在拷贝赋值和交换时不需要传播它，移动赋值时总是可以
+  // 直接接管对方的内存
+  using propagate_on_container_copy_assignment = false_type;
+  using propagate_on_container_move_assignment = true_type;
+  using propagate_on_container_swap = false_type;
+
+  allocator() noexcept {}
+
+  template <class U>
+  allocator(const allocator<U>&) noexcept {}
+
+  static allocator select_on_container_copy_construction() {
+    return allocator();
+  }
+
   static pointer allocate() {
     return static_cast<pointer>(alloc::allocate(sizeof(T)));
     // return static_cast<T*>(::operator new(sizeof(T)));
@@ -67,6 +84,25 @@ class allocator {
     // ::operator delete(p);
   }
 
+  // 把 p 指向的 old_n 个对象的空间调整为 new_n 个，内容按字节搬移。
+  // 大块内存交给 ::realloc，有机会就地扩展而不必复制；
+  // 只能用于 trivially copyable 的类型，失败时原空间保持不变。
+  static pointer reallocate(pointer p, size_type old_n, size_type new_n) {
+    if (p == nullptr || old_n == 0) {
+      return allocate(new_n);
+    }
+    if (new_n == 0) {
+      deallocate(p, old_n);
+      return nullptr;
+    }
+    void* tmp = alloc::reallocate(static_cast<void*>(p), sizeof(T) * old_n,
+                                  sizeof(T) * new_n);
+    if (tmp == nullptr) {
+      throw std::bad_alloc();
+    }
+    return static_cast<pointer>(tmp);
+  }
+
   static void construct(pointer ptr, const_reference value) {
     toystl::construct(ptr, value);
   }
@@ -84,12 +120,92 @@ class allocator {
 
   static void destroy(T* ptr) { toystl::destroy(ptr); }
 
-  static void destroy(T* first, T* last) {
-    while (first != last) {
-      toystl::destroy(first, last);
-      first++;
-    }
+  static void destroy(T* first, T* last) { toystl::destroy(first, last); }
+};
+
+template <class T, class U>
+bool operator==(const allocator<T>&, const allocator<U>&) noexcept {
+  return true;
+}
+
+template <class T, class U>
+bool operator!=(const allocator<T>&, const allocator<U>&) noexcept {
+  return false;
+}
+
+// 判断分配器是否提供 reallocate(p, old_n, new_n)
+template <class Alloc>
+class allocator_has_reallocate {
+  template <class A>
+  static auto test(int) -> decltype(
+      std::declval<A&>().reallocate(std::declval<typename A::pointer>(),
+                                    std::size_t(), std::size_t()),
+      true_type());
+  template <class A>
+  static false_type test(...);
+
+ public:
+  static constexpr bool value = decltype(test<Alloc>(0))::value;
+};
+
+// 判断分配器是否总是相等：定义了 is_always_equal 时以它为准，
+// 否则无状态的空类分配器总是相等
+template <class Alloc>
+class allocator_is_always_equal {
+  template <class A>
+  static typename A::is_always_equal test(int);
+  template <class A>
+  static m_bool_constant<std::is_empty<A>::value> test(...);
+
+ public:
+  static constexpr bool value = decltype(test<Alloc>(0))::value;
+};
+
+// 容器的移动赋值是否不会抛出异常：分配器随之传播或者总是相等时，
+// 直接接管对方的内存即可；否则分配器不相等时要逐个搬移元素，可能分配内存
+template <class Alloc>
+struct allocator_nothrow_move_assign
+    : m_bool_constant<
+          Alloc::propagate_on_container_move_assignment::value ||
+          allocator_is_always_equal<Alloc>::value> {};
+
+// 容器通过私有继承 allocator_holder 保存分配器对象。
+// 无状态的分配器（空类，如 toystl::allocator）借助空基类优化不增加容器的大小，
+// 有状态的分配器（如 arena_allocator）按值保存在容器中。
+// 容器统一通过 get_alloc() 取得分配器再调用 allocate / deallocate，
+// construct / destroy 仍然是静态函数。
+template <class Alloc, bool = std::is_empty<Alloc>::value>
+class allocator_holder {
+ protected:
+  allocator_holder() {}
+  explicit allocator_holder(const Alloc&) {}
+
+  Alloc get_alloc() const { return Alloc(); }
+  void set_alloc(const Alloc&) {}
+  void swap_alloc(allocator_holder&) {}
+};
+
+template <class Alloc>
+class allocator_holder<Alloc, false> {
+ protected:
+  allocator_holder() : alloc_() {}
+  explicit allocator_holder(const Alloc& a) : alloc_(a) {}
+
+  const Alloc& get_alloc() const { return alloc_; }
+  void set_alloc(const Alloc& a) { alloc_ = a; }
+  // 只有 propagate_on_container_swap 为 true_type 时才交换分配器
+  void swap_alloc(allocator_holder& other) {
+    swap_alloc_aux(other,
+                   typename Alloc::propagate_on_container_swap());
   }
+
+ private:
+  void swap_alloc_aux(allocator_holder& other, true_type) {
+    toystl::swap(alloc_, other.alloc_);
+  }
+  void swap_alloc_aux(allocator_holder&, false_type) {}
+
+  Alloc alloc_;
 };
 }  // namespace toystl
 
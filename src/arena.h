@@ -0,0 +1,231 @@
+#ifndef TOYSTL_SRC_ARENA_H_
+#define TOYSTL_SRC_ARENA_H_
+
+#include <stdlib.h>  // malloc, free
+#include <cstddef>
+#include <new>  // std::bad_alloc
+
+#include "alloc.h"
+#include "construct.h"
+#include "type_traits.h"
+
+namespace toystl {
+// 单调增长的内存池（monotonic arena）
+// 内存按块向系统申请，块内用一个指针顺序切分；单个对象的释放什么也不做，
+// 所有内存在 release() 或 arena 析构时一次性归还。
+// 适合“一个请求内创建大量对象，请求结束时整体丢弃”的场景。
+// arena 本身不可拷贝，也不是线程安全的。
+class arena {
+ public:
+  static const std::size_t kDefaultBlockSize = 4096;
+
+  explicit arena(std::size_t block_size = kDefaultBlockSize)
+      : blocks_(nullptr),
+        cur_(nullptr),
+        end_(nullptr),
+        next_block_size_(block_size < kMinBlockSize ? kMinBlockSize
+                                                    : block_size),
+        initial_block_size_(next_block_size_),
+        initial_buffer_(nullptr),
+        initial_buffer_size_(0),
+        bytes_allocated_(0),
+        bytes_reserved_(0) {}
+
+  // 先使用调用方提供的缓冲区（例如栈上的数组），用完后再向系统申请
+  arena(void* buffer, std::size_t size,
+        std::size_t block_size = kDefaultBlockSize)
+      : arena(block_size) {
+    initial_buffer_ = static_cast<char*>(buffer);
+    initial_buffer_size_ = size;
+    cur_ = initial_buffer_;
+    end_ = initial_buffer_ + size;
+  }
+
+  arena(const arena&) = delete;
+  arena& operator=(const arena&) = delete;
+
+  ~arena() { release(); }
+
+  void* allocate(std::size_t bytes,
+                 std::size_t align = alignof(std::max_align_t)) {
+    char* p = align_up(cur_, align);
+    // 对齐之后 p 可能已经越过 end_，必须先比较再相减
+    if (p == nullptr || p > end_ ||
+        bytes > static_cast<std::size_t>(end_ - p)) {
+      if (bytes > static_cast<std::size_t>(-1) - align - sizeof(block)) {
+        throw std::bad_alloc();
+      }
+      new_block(bytes + align);
+      p = align_up(cur_, align);
+    }
+    cur_ = p + bytes;
+    bytes_allocated_ += bytes;
+    return p;
+  }
+
+  // 单个对象的释放是空操作
+  void deallocate(void*, std::size_t) noexcept {}
+
+  // 把所有块还给系统，arena 回到初始状态，可以继续使用
+  void release() noexcept {
+    while (blocks_ != nullptr) {
+      block* next = blocks_->next;
+      ::free(blocks_);
+      blocks_ = next;
+    }
+    cur_ = initial_buffer_;
+    end_ = initial_buffer_ + initial_buffer_size_;
+    next_block_size_ = initial_block_size_;
+    bytes_allocated_ = 0;
+    bytes_reserved_ = 0;
+  }
+
+  // 已经切分给使用者的字节数
+  std::size_t bytes_allocated() const noexcept { return bytes_allocated_; }
+  // 向系统申请的字节数（不含初始缓冲区）
+  std::size_t bytes_reserved() const noexcept { return bytes_reserved_; }
+
+ private:
+  static const std::size_t kMinBlockSize = 256;
+  static const std::size_t kMaxBlockSize = 1 << 20;
+
+  // 块头，块内数据紧跟在块头之后
+  struct block {
+    block* next;
+    std::size_t size;
+  };
+
+  static char* align_up(char* p, std::size_t align) {
+    if (p == nullptr) {
+      return nullptr;
+    }
+    std::size_t addr = reinterpret_cast<std::size_t>(p);
+    return reinterpret_cast<char*>((addr + align - 1) & ~(align - 1));
+  }
+
+  // 申请新块，块大小按 2 倍增长直到 kMaxBlockSize，超大请求单独成块
+  void new_block(std::size_t min_bytes) {
+    std::size_t size = next_block_size_;
+    while (size < min_bytes + sizeof(block)) {
+      size *= 2;
+    }
+    block* b = static_cast<block*>(::malloc(size));
+    if (b == nullptr) {
+      throw std::bad_alloc();
+    }
+    b->next = blocks_;
+    b->size = size;
+    blocks_ = b;
+    bytes_reserved_ += size;
+    cur_ = reinterpret_cast<char*>(b) + sizeof(block);
+    end_ = reinterpret_cast<char*>(b) + size;
+    if (next_block_size_ < kMaxBlockSize) {
+      next_block_size_ *= 2;
+    }
+  }
+
+  block* blocks_;
+  char* cur_;
+  char* end_;
+  std::size_t next_block_size_;
+  std::size_t initial_block_size_;
+  char* initial_buffer_;
+  std::size_t initial_buffer_size_;
+  std::size_t bytes_allocated_;
+  std::size_t bytes_reserved_;
+};
+
+// 从 arena 分配内存的有状态分配器
+// 分配器只保存 arena 指针，拷贝和 rebind 得到的分配器共享同一个 arena；
+// 两个分配器相等当且仅当它们指向同一个 arena。
+// 默认构造的分配器不绑定 arena，退化为使用 toystl::alloc。
+// 容器在拷贝、移动和交换时都会传播分配器，保证元素始终由创建它的 arena 持有。
+template <class T>
+class arena_allocator {
+ public:
+  using value_type = T;
+  using pointer = T*;
+  using const_pointer = const T*;
+  using reference = T&;
+  using const_reference = const T&;
+  using size_type = std::size_t;
+  using difference_type = std::ptrdiff_t;
+
+  template <class U>
+  class rebind {
+   public:
+    using other = arena_allocator<U>;
+  };
+
+  using propagate_on_container_copy_assignment = true_type;
+  using propagate_on_container_move_assignment = true_type;
+  using propagate_on_container_swap = true_type;
+
+  arena_allocator() noexcept : arena_(nullptr) {}
+  explicit arena_allocator(arena& a) noexcept : arena_(&a) {}
+
+  template <class U>
+  arena_allocator(const arena_allocator<U>& other) noexcept
+      : arena_(other.get_arena()) {}
+
+  arena_allocator select_on_container_copy_construction() const {
+    return *this;
+  }
+
+  arena* get_arena() const noexcept { return arena_; }
+
+  pointer allocate() const { return allocate(1); }
+
+  pointer allocate(size_type n) const {
+    if (n == 0) {
+      return nullptr;
+    }
+    if (arena_ == nullptr) {
+      return static_cast<pointer>(toystl::alloc::allocate(n * sizeof(T)));
+    }
+    return static_cast<pointer>(arena_->allocate(n * sizeof(T), alignof(T)));
+  }
+
+  void deallocate(pointer p) const { deallocate(p, 1); }
+
+  void deallocate(pointer p, size_type n) const {
+    if (p == nullptr || arena_ != nullptr) {
+      return;
+    }
+    toystl::alloc::deallocate(p, n * sizeof(T));
+  }
+
+  static void construct(T* p) { toystl::construct(p); }
+
+  static void construct(T* p, const T& value) { toystl::construct(p, value); }
+
+  static void construct(T* p, T&& value) {
+    toystl::construct(p, toystl::move(value));
+  }
+
+  template <class... Args>
+  static void construct(T* p, Args&&... args) {
+    toystl::construct(p, toystl::forward<Args>(args)...);
+  }
+
+  static void destroy(T* p) { toystl::destroy(p); }
+
+  static void destroy(T* first, T* last) { toystl::destroy(first, last); }
+
+ private:
+  arena* arena_;
+};
+
+template <class T, class U>
+bool operator==(const arena_allocator<T>& lhs,
+                const arena_allocator<U>& rhs) noexcept {
+  return lhs.get_arena() == rhs.get_arena();
+}
+
+template <class T, class U>
+bool operator!=(const arena_allocator<T>& lhs,
+                const arena_allocator<U>& rhs) noexcept {
+  return !(lhs == rhs);
+}
+}  // namespace toystl
+#endif  // TOYSTL_SRC_ARENA_H_
@@ -0,0 +1,1048 @@
+#ifndef TOYSTL_SRC_BTREE_H_
+#define TOYSTL_SRC_BTREE_H_
+
+#include <type_traits>  // std::aligned_storage
+
+#include "allocator.h"
+#include "functional.h"
+#include "iterator.h"
+#include "iterator_base.h"
+#include "utility.h"
+
+namespace toystl {
+/******************************************************************************/
+// B 树：每个节点在一块连续的内存中存放多个元素，节点内以二分查找定位。
+// 与 rb_tree 每个元素一个节点（外加父、左、右指针和颜色）相比，
+// 每个元素的额外开销只有几个字节，查找时访问的 cache line 也少得多。
+// 内部节点与叶子节点同样存放元素，另外再存放 count + 1 个子节点指针。
+// 所有叶子节点的深度相同。
+// 注意：插入和删除会在节点之间搬移元素，任何修改都会使所有迭代器失效
+/******************************************************************************/
+
+// 每个节点的元素个数：让一个叶子节点大约占 TargetNodeSize 个字节，至少 3 个
+template <class Value, size_t TargetNodeSize>
+struct btree_node_capacity {
+  static const size_t header_size = 2 * sizeof(void*);
+  static const size_t fit =
+      TargetNodeSize > header_size
+          ? (TargetNodeSize - header_size) / sizeof(Value)
+          : 0;
+  static const size_t value = fit < 3 ? 3 : (fit > 65535 ? 65535 : fit);
+};
+
+template <class Value, size_t Capacity>
+struct btree_internal_node;
+
+// 叶子节点。元素只提供存储，[0, count) 之间的元素由 btree 构造和析构
+template <class Value, size_t Capacity>
+struct btree_node {
+  btree_node* parent;
+  unsigned short position;  // 在父节点 children 中的下标
+  unsigned short count;     // 元素个数
+  bool leaf;
+  typename std::aligned_storage<sizeof(Value) * Capacity, alignof(Value)>::type
+      storage;
+
+  Value* value(size_t i) { return reinterpret_cast<Value*>(&storage) + i; }
+  const Value* value(size_t i) const {
+    return reinterpret_cast<const Value*>(&storage) + i;
+  }
+
+  // 只能在内部节点上调用
+  btree_node*& child(size_t i);
+  btree_node* child(size_t i) const;
+};
+
+// 内部节点，多出 Capacity + 1 个子节点指针
+template <class Value, size_t Capacity>
+struct btree_internal_node : public btree_node<Value, Capacity> {
+  btree_node<Value, Capacity>* children[Capacity + 1];
+};
+
+template <class Value, size_t Capacity>
+inline btree_node<Value, Capacity>*& btree_node<Value, Capacity>::child(
+    size_t i) {
+  return static_cast<btree_internal_node<Value, Capacity>*>(this)
+      ->children[i];
+}
+
+template <class Value, size_t Capacity>
+inline btree_node<Value, Capacity>* btree_node<Value, Capacity>::child(
+    size_t i) const {
+  return static_cast<const btree_internal_node<Value, Capacity>*>(this)
+      ->children[i];
+}
+
+// 迭代器：节点加上节点内的下标。end() 指向最右叶子节点的 count 位置
+template <class Node, class Value, class Ref, class Ptr>
+struct btree_iterator {
+  using iterator_category = bidirectional_iterator_tag;
+  using value_type = Value;
+  using difference_type = ptrdiff_t;
+  using pointer = Ptr;
+  using reference = Ref;
+  using iterator = btree_iterator<Node, Value, Value&, Value*>;
+  using const_iterator =
+      btree_iterator<Node, Value, const Value&, const Value*>;
+  using self = btree_iterator<Node, Value, Ref, Ptr>;
+
+  Node* node;
+  size_t position;
+
+  btree_iterator() : node(nullptr), position(0) {}
+  btree_iterator(Node* n, size_t pos) : node(n), position(pos) {}
+  btree_iterator(const iterator& it) : node(it.node), position(it.position) {}
+  // 对 iterator 而言上面的构造函数就是拷贝构造函数，需要显式声明拷贝赋值
+  self& operator=(const self&) = default;
+
+  reference operator*() const { return *node->value(position); }
+  pointer operator->() const { return &(operator*()); }
+
+  self& operator++() {
+    increment();
+    return *this;
+  }
+  self operator++(int) {
+    self tmp = *this;
+    increment();
+    return tmp;
+  }
+
+  self& operator--() {
+    decrement();
+    return *this;
+  }
+  self operator--(int) {
+    self tmp = *this;
+    decrement();
+    return tmp;
+  }
+
+ private:
+  // 内部节点的后继是右侧子树中最左的元素；叶子节点走到末尾时往上找，
+  // 第一个 "自己不是最后一个子节点" 的祖先处的元素就是后继
+  void increment() {
+    if (!node->leaf) {
+      node = node->child(position + 1);
+      while (!node->leaf) {
+        node = node->child(0);
+      }
+      position = 0;
+      return;
+    }
+    if (++position < node->count) {
+      return;
+    }
+    Node* save_node = node;
+    size_t save_position = position;
+    while (position == node->count && node->parent != nullptr) {
+      position = node->position;
+      node = node->parent;
+    }
+    if (position == node->count) {  // 已经是最后一个元素，停在 end()
+      node = save_node;
+      position = save_position;
+    }
+  }
+
+  void decrement() {
+    if (!node->leaf) {
+      node = node->child(position);
+      while (!node->leaf) {
+        node = node->child(node->count);
+      }
+      position = node->count - 1;
+      return;
+    }
+    if (position > 0) {
+      --position;
+      return;
+    }
+    Node* save_node = node;
+    size_t save_position = position;
+    while (position == 0 && node->parent != nullptr) {
+      position = node->position;
+      node = node->parent;
+    }
+    if (position == 0) {  // begin() 之前，不移动
+      node = save_node;
+      position = save_position;
+    } else {
+      --position;
+    }
+  }
+};
+
+template <class Node, class Value, class Ref1, class Ptr1, class Ref2,
+          class Ptr2>
+inline bool operator==(const btree_iterator<Node, Value, Ref1, Ptr1>& x,
+                       const btree_iterator<Node, Value, Ref2, Ptr2>& y) {
+  return x.node == y.node && x.position == y.position;
+}
+
+template <class Node, class Value, class Ref1, class Ptr1, class Ref2,
+          class Ptr2>
+inline bool operator!=(const btree_iterator<Node, Value, Ref1, Ptr1>& x,
+                       const btree_iterator<Node, Value, Ref2, Ptr2>& y) {
+  return !(x == y);
+}
+
+// btree，键值不允许重复
+// 模板参数与 rb_tree 相同，另外 TargetNodeSize 为一个叶子节点的目标大小
+template <class Key, class Value, class KeyOfValue, class Compare,
+          class Allocator = toystl::allocator<Value>,
+          size_t TargetNodeSize = 256>
+class btree : private allocator_holder<Allocator> {
+ public:
+  // 每个节点最多存放的元素个数
+  static const size_t node_values =
+      btree_node_capacity<Value, TargetNodeSize>::value;
+
+ private:
+  using node_type = btree_node<Value, node_values>;
+  using internal_node_type = btree_internal_node<Value, node_values>;
+  using leaf_allocator =
+      typename Allocator::template rebind<node_type>::other;
+  using internal_allocator =
+      typename Allocator::template rebind<internal_node_type>::other;
+  using alloc_base = allocator_holder<Allocator>;
+
+  // 删除后元素个数少于它的节点会向兄弟节点借一个元素，或者与兄弟节点合并。
+  // 合并时两个节点加上父节点中的分隔元素不超过 2 * min_values 个，放得下
+  static const size_t min_values = node_values / 2;
+
+ public:
+  using key_type = Key;
+  using value_type = Value;
+  using pointer = value_type*;
+  using const_pointer = const value_type*;
+  using reference = value_type&;
+  using const_reference = const value_type&;
+  using size_type = size_t;
+  using difference_type = ptrdiff_t;
+  using allocator_type = Allocator;
+
+  using iterator = btree_iterator<node_type, value_type, reference, pointer>;
+  using const_iterator =
+      btree_iterator<node_type, value_type, const_reference, const_pointer>;
+  using reverse_iterator = toystl::reverse_iterator<iterator>;
+  using const_reverse_iterator = toystl::reverse_iterator<const_iterator>;
+
+ private:
+  node_type* root_;
+  node_type* leftmost_;   // 最左的叶子节点，begin() 所在
+  node_type* rightmost_;  // 最右的叶子节点，end() 所在
+  size_type size_;
+  Compare key_compare_;
+
+ public:
+  // 构造、赋值、析构函数
+  btree(const Compare& comp = Compare(),
+        const allocator_type& a = allocator_type())
+      : alloc_base(a),
+        root_(nullptr),
+        leftmost_(nullptr),
+        rightmost_(nullptr),
+        size_(0),
+        key_compare_(comp) {}
+
+  btree(const btree& rhs)
+      : alloc_base(rhs.get_alloc().select_on_container_copy_construction()),
+        root_(nullptr),
+        leftmost_(nullptr),
+        rightmost_(nullptr),
+        size_(0),
+        key_compare_(rhs.key_compare_) {
+    copy_from(rhs);
+  }
+
+  btree(const btree& rhs, const allocator_type& a)
+      : alloc_base(a),
+        root_(nullptr),
+        leftmost_(nullptr),
+        rightmost_(nullptr),
+        size_(0),
+        key_compare_(rhs.key_compare_) {
+    copy_from(rhs);
+  }
+
+  btree(btree&& rhs) noexcept
+      : alloc_base(rhs.get_alloc()),
+        root_(rhs.root_),
+        leftmost_(rhs.leftmost_),
+        rightmost_(rhs.rightmost_),
+        size_(rhs.size_),
+        key_compare_(rhs.key_compare_) {
+    rhs.reset();
+  }
+
+  btree& operator=(const btree& rhs) {
+    if (this != &rhs) {
+      clear();
+      copy_assign_alloc(
+          rhs,
+          typename allocator_type::propagate_on_container_copy_assignment());
+      key_compare_ = rhs.key_compare_;
+      copy_from(rhs);
+    }
+    return *this;
+  }
+
+  btree& operator=(btree&& rhs) {
+    if (this != &rhs) {
+      move_assign(
+          rhs,
+          typename allocator_type::propagate_on_container_move_assignment());
+    }
+    return *this;
+  }
+
+  ~btree() { clear(); }
+
+  allocator_type get_allocator() const { return this->get_alloc(); }
+  Compare key_comp() const { return key_compare_; }
+
+ public:
+  // 迭代器相关操作
+  iterator begin() {
+    return root_ == nullptr ? iterator() : iterator(leftmost_, 0);
+  }
+  const_iterator begin() const {
+    return root_ == nullptr ? const_iterator() : const_iterator(leftmost_, 0);
+  }
+  iterator end() {
+    return root_ == nullptr ? iterator()
+                            : iterator(rightmost_, rightmost_->count);
+  }
+  const_iterator end() const {
+    return root_ == nullptr ? const_iterator()
+                            : const_iterator(rightmost_, rightmost_->count);
+  }
+
+  reverse_iterator rbegin() { return reverse_iterator(end()); }
+  const_reverse_iterator rbegin() const {
+    return const_reverse_iterator(end());
+  }
+  reverse_iterator rend() { return reverse_iterator(begin()); }
+  const_reverse_iterator rend() const {
+    return const_reverse_iterator(begin());
+  }
+
+  const_iterator cbegin() const { return begin(); }
+  const_iterator cend() const { return end(); }
+
+  // 容量相关操作
+  bool empty() const { return size_ == 0; }
+  size_type size() const { return size_; }
+  size_type max_size() const { return static_cast<size_type>(-1); }
+
+  void swap(btree& rhs) {
+    if (this != &rhs) {
+      this->swap_alloc(rhs);
+      toystl::swap(root_, rhs.root_);
+      toystl::swap(leftmost_, rhs.leftmost_);
+      toystl::swap(rightmost_, rhs.rightmost_);
+      toystl::swap(size_, rhs.size_);
+      toystl::swap(key_compare_, rhs.key_compare_);
+    }
+  }
+
+ public:
+  // 插入，键值不允许重复，若重复则插入无效
+  pair<iterator, bool> insert_unique(const value_type& v) {
+    return insert_unique_value(KeyOfValue()(v), v);
+  }
+  // 新值恰好位于 hint 之前时直接插入，不必从根节点往下找
+  iterator insert_unique(const_iterator hint, const value_type& v) {
+    return insert_hint_unique_value(hint, KeyOfValue()(v), v);
+  }
+  template <class InputIterator>
+  void insert_unique(InputIterator first, InputIterator last) {
+    // 以 end() 作为提示，有序的输入只需在最右的叶子节点末尾追加
+    for (; first != last; ++first) {
+      insert_unique(end(), *first);
+    }
+  }
+
+  // 需要先构造出元素才能取得键值，构造好之后再移动到节点中
+  template <class... Args>
+  pair<iterator, bool> emplace_unique(Args&&... args) {
+    value_type tmp(toystl::forward<Args>(args)...);
+    return insert_unique_value(KeyOfValue()(tmp), toystl::move(tmp));
+  }
+  template <class... Args>
+  iterator emplace_hint_unique(const_iterator hint, Args&&... args) {
+    value_type tmp(toystl::forward<Args>(args)...);
+    return insert_hint_unique_value(hint, KeyOfValue()(tmp),
+                                    toystl::move(tmp));
+  }
+
+  // 删除
+  void erase(const_iterator position);
+  size_type erase(const key_type& k);
+  void erase(const_iterator first, const_iterator last);
+  void clear();
+
+  // 查找
+  iterator find(const key_type& k) {
+    const_iterator it = static_cast<const btree&>(*this).find(k);
+    return iterator(it.node, it.position);
+  }
+  const_iterator find(const key_type& k) const;
+  size_type count(const key_type& k) const { return find(k) != end(); }
+
+  iterator lower_bound(const key_type& k) {
+    const_iterator it = static_cast<const btree&>(*this).lower_bound(k);
+    return iterator(it.node, it.position);
+  }
+  const_iterator lower_bound(const key_type& k) const;
+  iterator upper_bound(const key_type& k) {
+    const_iterator it = static_cast<const btree&>(*this).upper_bound(k);
+    return iterator(it.node, it.position);
+  }
+  const_iterator upper_bound(const key_type& k) const;
+
+  pair<iterator, iterator> equal_range(const key_type& k) {
+    return pair<iterator, iterator>(lower_bound(k), upper_bound(k));
+  }
+  pair<const_iterator, const_iterator> equal_range(const key_type& k) const {
+    return pair<const_iterator, const_iterator>(lower_bound(k),
+                                                upper_bound(k));
+  }
+
+ private:
+  // 节点的分配与释放。节点中的元素由调用者构造和析构
+  node_type* new_leaf(node_type* parent) {
+    node_type* n = leaf_allocator(this->get_alloc()).allocate(1);
+    n->parent = parent;
+    n->position = 0;
+    n->count = 0;
+    n->leaf = true;
+    return n;
+  }
+  node_type* new_internal(node_type* parent) {
+    internal_node_type* n =
+        internal_allocator(this->get_alloc()).allocate(1);
+    n->parent = parent;
+    n->position = 0;
+    n->count = 0;
+    n->leaf = false;
+    return n;
+  }
+  void delete_node(node_type* n) {
+    if (n->leaf) {
+      leaf_allocator(this->get_alloc()).deallocate(n);
+    } else {
+      internal_allocator(this->get_alloc())
+          .deallocate(static_cast<internal_node_type*>(n));
+    }
+  }
+
+  static const key_type& key(const node_type* n, size_type i) {
+    return KeyOfValue()(*n->value(i));
+  }
+
+  // 把 src 节点的第 j 个元素移动到 dst 节点的第 i 个位置（未构造的存储）
+  static void move_value(node_type* dst, size_type i, node_type* src,
+                         size_type j) {
+    construct(dst->value(i), toystl::move(*src->value(j)));
+    destroy(src->value(j));
+  }
+
+  // 设置内部节点的第 i 个子节点
+  static void set_child(node_type* n, size_type i, node_type* c) {
+    n->child(i) = c;
+    c->parent = n;
+    c->position = static_cast<unsigned short>(i);
+  }
+
+  // 节点内的二分查找
+  size_type lower_bound_in_node(const node_type* n, const key_type& k) const;
+  size_type upper_bound_in_node(const node_type* n, const key_type& k) const;
+
+  template <class Arg>
+  pair<iterator, bool> insert_unique_value(const key_type& k, Arg&& v);
+  template <class Arg>
+  iterator insert_hint_unique_value(const_iterator hint, const key_type& k,
+                                    Arg&& v);
+  template <class Arg>
+  iterator insert_at(node_type* n, size_type pos, Arg&& v);
+  void make_room(node_type*& n, size_type& pos);
+  node_type* split_node(node_type* n, size_type left_count);
+
+  void rebalance_after_erase(node_type* n);
+  void rotate_right(node_type* left, node_type* n);
+  void rotate_left(node_type* n, node_type* right);
+  void merge_nodes(node_type* left, node_type* right);
+
+  void destroy_subtree(node_type* n);
+  void copy_from(const btree& rhs);
+  void reset() {
+    root_ = leftmost_ = rightmost_ = nullptr;
+    size_ = 0;
+  }
+
+  void copy_assign_alloc(const btree& rhs, true_type) {
+    this->set_alloc(rhs.get_alloc());
+  }
+  void copy_assign_alloc(const btree&, false_type) {}
+
+  // 分配器随节点一起转移
+  void move_assign(btree& rhs, true_type) {
+    clear();
+    this->set_alloc(rhs.get_alloc());
+    root_ = rhs.root_;
+    leftmost_ = rhs.leftmost_;
+    rightmost_ = rhs.rightmost_;
+    size_ = rhs.size_;
+    key_compare_ = rhs.key_compare_;
+    rhs.reset();
+  }
+
+  // 分配器不传播：分配器相等时仍然可以直接接管节点，否则只能逐个拷贝元素
+  void move_assign(btree& rhs, false_type) {
+    if (this->get_alloc() == rhs.get_alloc()) {
+      move_assign(rhs, true_type());
+    } else {
+      clear();
+      key_compare_ = rhs.key_compare_;
+      copy_from(rhs);
+      rhs.clear();
+    }
+  }
+};
+
+template <class Key, class Value, class KeyOfValue, class Compare,
+          class Allocator, size_t TargetNodeSize>
+const size_t btree<Key, Value, KeyOfValue, Compare, Allocator,
+                   TargetNodeSize>::node_values;
+
+template <class Key, class Value, class KeyOfValue, class Compare,
+          class Allocator, size_t TargetNodeSize>
+const size_t btree<Key, Value, KeyOfValue, Compare, Allocator,
+                   TargetNodeSize>::min_values;
+
+/*****************************************************************************************/
+// 查找
+
+template <class Key, class Value, class KeyOfValue, class Compare,
+          class Allocator, size_t TargetNodeSize>
+typename btree<Key, Value, KeyOfValue, Compare, Allocator,
+               TargetNodeSize>::size_type
+btree<Key, Value, KeyOfValue, Compare, Allocator, TargetNodeSize>::
+    lower_bound_in_node(const node_type* n, const key_type& k) const {
+  size_type lo = 0;
+  size_type hi = n->count;
+  while (lo < hi) {
+    const size_type mid = (lo + hi) / 2;
+    if (key_compare_(key(n, mid), k)) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  return lo;
+}
+
+template <class Key, class Value, class KeyOfValue, class Compare,
+          class Allocator, size_t TargetNodeSize>
+typename btree<Key, Value, KeyOfValue, Compare, Allocator,
+               TargetNodeSize>::size_type
+btree<Key, Value, KeyOfValue, Compare, Allocator, TargetNodeSize>::
+    upper_bound_in_node(const node_type* n, const key_type& k) const {
+  size_type lo = 0;
+  size_type hi = n->count;
+  while (lo < hi) {
+    const size_type mid = (lo + hi) / 2;
+    if (key_compare_(k, key(n, mid))) {
+      hi = mid;
+    } else {
+      lo = mid + 1;
+    }
+  }
+  return lo;
+}
+
+template <class Key, class Value, class KeyOfValue, class Compare,
+          class Allocator, size_t TargetNodeSize>
+typename btree<Key, Value, KeyOfValue, Compare, Allocator,
+               TargetNodeSize>::const_iterator
+btree<Key, Value, KeyOfValue, Compare, Allocator, TargetNodeSize>::find(
+    const key_type& k) const {
+  node_type* n = root_;
+  while (n != nullptr) {
+    const size_type pos = lower_bound_in_node(n, k);
+    if (pos < n->count && !key_compare_(k, key(n, pos))) {
+      return const_iterator(n, pos);
+    }
+    if (n->leaf) {
+      break;
+    }
+    n = n->child(pos);
+  }
+  return end();
+}
+
+// 一路往下记录最后一个满足条件的位置，越深的位置越靠近 k
+template <class Key, class Value, class KeyOfValue, class Compare,
+          class Allocator, size_t TargetNodeSize>
+typename btree<Key, Value, KeyOfValue, Compare, Allocator,
+               TargetNodeSize>::const_iterator
+btree<Key, Value, KeyOfValue, Compare, Allocator, TargetNodeSize>::lower_bound(
+    const key_type& k) const {
+  const_iterator result = end();
+  node_type* n = root_;
+  while (n != nullptr) {
+    const size_type pos = lower_bound_in_node(n, k);
+    if (pos < n->count) {
+      result = const_iterator(n, pos);
+    }
+    if (n->leaf) {
+      break;
+    }
+    n = n->child(pos);
+  }
+  return result;
+}
+
+template <class Key, class Value, class KeyOfValue, class Compare,
+          class Allocator, size_t TargetNodeSize>
+typename btree<Key, Value, KeyOfValue, Compare, Allocator,
+               TargetNodeSize>::const_iterator
+btree<Key, Value, KeyOfValue, Compare, Allocator, TargetNodeSize>::upper_bound(
+    const key_type& k) const {
+  const_iterator result = end();
+  node_type* n = root_;
+  while (n != nullptr) {
+    const size_type pos = upper_bound_in_node(n, k);
+    if (pos < n->count) {
+      result = const_iterator(n, pos);
+    }
+    if (n->leaf) {
+      break;
+    }
+    n = n->child(pos);
+  }
+  return result;
+}
+
+/*****************************************************************************************/
+// 插入
+
+template <class Key, class Value, class KeyOfValue, class Compare,
+          class Allocator, size_t TargetNodeSize>
+template <class Arg>
+pair<typename btree<Key, Value, KeyOfValue, Compare, Allocator,
+                    TargetNodeSize>::iterator,
+     bool>
+btree<Key, Value, KeyOfValue, Compare, Allocator, TargetNodeSize>::
+    insert_unique_value(const key_type& k, Arg&& v) {
+  if (root_ == nullptr) {
+    root_ = leftmost_ = rightmost_ = new_leaf(nullptr);
+    return pair<iterator, bool>(insert_at(root_, 0, toystl::forward<Arg>(v)),
+                                true);
+  }
+  node_type* n = root_;
+  size_type pos = 0;
+  for (;;) {
+    pos = lower_bound_in_node(n, k);
+    if (pos < n->count && !key_compare_(k, key(n, pos))) {
+      return pair<iterator, bool>(iterator(n, pos), false);
+    }
+    if (n->leaf) {
+      break;
+    }
+    n = n->child(pos);
+  }
+  // 新元素总是插入到叶子节点中
+  return pair<iterator, bool>(insert_at(n, pos, toystl::forward<Arg>(v)),
+                              true);
+}
+
+// 相邻的两个元素之中至少有一个位于叶子节点：hint 在叶子节点中就插入在
+// hint 处，否则 hint 的前驱是左子树中最大的元素，插入在前驱之后
+template <class Key, class Value, class KeyOfValue, class Compare,
+          class Allocator, size_t TargetNodeSize>
+template <class Arg>
+typename btree<Key, Value, KeyOfValue, Compare, Allocator,
+               TargetNodeSize>::iterator
+btree<Key, Value, KeyOfValue, Compare, Allocator, TargetNodeSize>::
+    insert_hint_unique_value(const_iterator hint, const key_type& k,
+                             Arg&& v) {
+  if (root_ == nullptr) {
+    return insert_unique_value(k, toystl::forward<Arg>(v)).first;
+  }
+  const bool before_hint = hint == end() || key_compare_(k, key(hint.node,
+                                                               hint.position));
+  if (before_hint) {
+    const_iterator prev = hint;
+    if (hint == begin() || key_compare_(KeyOfValue()(*--prev), k)) {
+      if (hint.node->leaf) {
+        return insert_at(hint.node, hint.position, toystl::forward<Arg>(v));
+      }
+      return insert_at(prev.node, prev.position + 1, toystl::forward<Arg>(v));
+    }
+  } else if (!key_compare_(key(hint.node, hint.position), k)) {
+    return iterator(hint.node, hint.position);  // 与 hint 的键值相同
+  }
+  return insert_unique_value(k, toystl::forward<Arg>(v)).first;
+}
+
+// 在叶子节点 n 的 pos 处构造新元素
+template <class Key, class Value, class KeyOfValue, class Compare,
+          class Allocator, size_t TargetNodeSize>
+template <class Arg>
+typename btree<Key, Value, KeyOfValue, Compare, Allocator,
+               TargetNodeSize>::iterator
+btree<Key, Value, KeyOfValue, Compare, Allocator, TargetNodeSize>::insert_at(
+    node_type* n, size_type pos, Arg&& v) {
+  if (n->count == node_values) {
+    // 节点已满：先在节点外构造出新元素再分裂，构造失败时树保持不变，
+    // 否则 pos == 0 的分裂会在树中留下一个空的叶子节点
+    value_type tmp(toystl::forward<Arg>(v));
+    make_room(n, pos);
+    return insert_at(n, pos, toystl::move(tmp));
+  }
+  for (size_type i = n->count; i > pos; --i) {
+    move_value(n, i, n, i - 1);
+  }
+  try {
+    construct(n->value(pos), toystl::forward<Arg>(v));
+  } catch (...) {
+    for (size_type i = pos; i < n->count; ++i) {
+      move_value(n, i, n, i + 1);
+    }
+    throw;
+  }
+  ++n->count;
+  ++size_;
+  return iterator(n, pos);
+}
+
+// 保证节点 n 有空位插入一个元素。n 已满时先保证父节点有空位，
+// 再把 n 分裂成两个节点，中间的元素上移到父节点。
+// pos 为即将插入的位置，返回时 n、pos 指向分裂后应当插入的节点和位置。
+// 插入位置在节点末尾（顺序追加）时，左边的节点保留尽可能多的元素，
+// 在节点开头时反过来，这样单调插入得到的节点几乎都是满的
+template <class Key, class Value, class KeyOfValue, class Compare,
+          class Allocator, size_t TargetNodeSize>
+void btree<Key, Value, KeyOfValue, Compare, Allocator,
+           TargetNodeSize>::make_room(node_type*& n, size_type& pos) {
+  if (n->count < node_values) {
+    return;
+  }
+  if (n == root_) {  // 树长高一层
+    node_type* new_root = new_internal(nullptr);
+    set_child(new_root, 0, n);
+    root_ = new_root;
+  } else {
+    node_type* parent = n->parent;
+    size_type parent_pos = n->position;
+    make_room(parent, parent_pos);  // 父节点分裂时会更新 n 的 parent 和 position
+  }
+
+  size_type left_count = node_values / 2;
+  if (pos == 0) {
+    left_count = 0;
+  } else if (pos == node_values) {
+    left_count = node_values - 1;
+  }
+  node_type* right = split_node(n, left_count);
+  if (pos > left_count) {
+    n = right;
+    pos -= left_count + 1;
+  }
+}
+
+// n 保留前 left_count 个元素，第 left_count 个元素上移到父节点，
+// 其后的元素（内部节点还有对应的子节点）移到新的右兄弟节点中
+template <class Key, class Value, class KeyOfValue, class Compare,
+          class Allocator, size_t TargetNodeSize>
+typename btree<Key, Value, KeyOfValue, Compare, Allocator,
+               TargetNodeSize>::node_type*
+btree<Key, Value, KeyOfValue, Compare, Allocator, TargetNodeSize>::split_node(
+    node_type* n, size_type left_count) {
+  node_type* parent = n->parent;
+  node_type* right = n->leaf ? new_leaf(parent) : new_internal(parent);
+  const size_type right_count = n->count - left_count - 1;
+  for (size_type i = 0; i != right_count; ++i) {
+    move_value(right, i, n, left_count + 1 + i);
+  }
+  if (!n->leaf) {
+    for (size_type i = 0; i <= right_count; ++i) {
+      set_child(right, i, n->child(left_count + 1 + i));
+    }
+  }
+  right->count = static_cast<unsigned short>(right_count);
+
+  // 在父节点中为上移的元素和新的子节点腾出位置
+  const size_type p = n->position;
+  for (size_type i = parent->count; i > p; --i) {
+    move_value(parent, i, parent, i - 1);
+  }
+  for (size_type i = parent->count + 1; i > p + 1; --i) {
+    set_child(parent, i, parent->child(i - 1));
+  }
+  move_value(parent, p, n, left_count);
+  set_child(parent, p + 1, right);
+  ++parent->count;
+  n->count = static_cast<unsigned short>(left_count);
+
+  if (n == rightmost_) {
+    rightmost_ = right;
+  }
+  return right;
+}
+
+/*****************************************************************************************/
+// 删除
+
+// 内部节点中的元素先与前驱（左子树中最大的元素，必然在叶子节点中）交换，
+// 变成删除叶子节点中的元素
+template <class Key, class Value, class KeyOfValue, class Compare,
+          class Allocator, size_t TargetNodeSize>
+void btree<Key, Value, KeyOfValue, Compare, Allocator, TargetNodeSize>::erase(
+    const_iterator position) {
+  node_type* n = position.node;
+  size_type pos = position.position;
+  destroy(n->value(pos));
+  if (!n->leaf) {
+    node_type* leaf = n->child(pos);
+    while (!leaf->leaf) {
+      leaf = leaf->child(leaf->count);
+    }
+    move_value(n, pos, leaf, leaf->count - 1);
+    n = leaf;
+  } else {
+    for (size_type i = pos + 1; i < n->count; ++i) {
+      move_value(n, i - 1, n, i);
+    }
+  }
+  --n->count;
+  --size_;
+  rebalance_after_erase(n);
+}
+
+template <class Key, class Value, class KeyOfValue, class Compare,
+          class Allocator, size_t TargetNodeSize>
+typename btree<Key, Value, KeyOfValue, Compare, Allocator,
+               TargetNodeSize>::size_type
+btree<Key, Value, KeyOfValue, Compare, Allocator, TargetNodeSize>::erase(
+    const key_type& k) {
+  const_iterator it = find(k);
+  if (it == end()) {
+    return 0;
+  }
+  erase(it);
+  return 1;
+}
+
+// 每次删除都会使迭代器失效，所以记下 last 的键值，每次重新定位 last 的前驱
+template <class Key, class Value, class KeyOfValue, class Compare,
+          class Allocator, size_t TargetNodeSize>
+void btree<Key, Value, KeyOfValue, Compare, Allocator, TargetNodeSize>::erase(
+    const_iterator first, const_iterator last) {
+  if (first == begin() && last == end()) {
+    clear();
+    return;
+  }
+  size_type n = toystl::distance(first, last);
+  if (last == end()) {
+    for (; n != 0; --n) {
+      erase(--end());
+    }
+  } else {
+    const key_type k = KeyOfValue()(*last);
+    for (; n != 0; --n) {
+      erase(--lower_bound(k));
+    }
+  }
+}
+
+template <class Key, class Value, class KeyOfValue, class Compare,
+          class Allocator, size_t TargetNodeSize>
+void btree<Key, Value, KeyOfValue, Compare, Allocator,
+           TargetNodeSize>::clear() {
+  if (root_ != nullptr) {
+    destroy_subtree(root_);
+    reset();
+  }
+}
+
+// 节点 n 刚刚少了一个元素。元素太少时先尝试向左右兄弟借一个，
+// 兄弟也不富余就与兄弟合并，父节点因此少了一个元素，继续往上调整
+template <class Key, class Value, class KeyOfValue, class Compare,
+          class Allocator, size_t TargetNodeSize>
+void btree<Key, Value, KeyOfValue, Compare, Allocator,
+           TargetNodeSize>::rebalance_after_erase(node_type* n) {
+  while (n != root_) {
+    if (n->count >= min_values) {
+      return;
+    }
+    node_type* parent = n->parent;
+    const size_type p = n->position;
+    node_type* left = p > 0 ? parent->child(p - 1) : nullptr;
+    node_type* right = p < parent->count ? parent->child(p + 1) : nullptr;
+    if (left != nullptr && left->count > min_values) {
+      rotate_right(left, n);
+      return;
+    }
+    if (right != nullptr && right->count > min_values) {
+      rotate_left(n, right);
+      return;
+    }
+    if (left != nullptr) {
+      merge_nodes(left, n);
+    } else {
+      merge_nodes(n, right);
+    }
+    n = parent;
+  }
+
+  if (root_->count == 0) {
+    node_type* old_root = root_;
+    if (old_root->leaf) {
+      reset();
+    } else {  // 树降低一层
+      root_ = old_root->child(0);
+      root_->parent = nullptr;
+      root_->position = 0;
+    }
+    delete_node(old_root);
+  }
+}
+
+// 左兄弟的最后一个元素上移到父节点，父节点中的分隔元素下移到 n 的开头
+template <class Key, class Value, class KeyOfValue, class Compare,
+          class Allocator, size_t TargetNodeSize>
+void btree<Key, Value, KeyOfValue, Compare, Allocator,
+           TargetNodeSize>::rotate_right(node_type* left, node_type* n) {
+  node_type* parent = n->parent;
+  const size_type p = n->position - 1;  // 分隔元素的位置
+  for (size_type i = n->count; i > 0; --i) {
+    move_value(n, i, n, i - 1);
+  }
+  move_value(n, 0, parent, p);
+  move_value(parent, p, left, left->count - 1);
+  if (!n->leaf) {
+    for (size_type i = n->count + 1; i > 0; --i) {
+      set_child(n, i, n->child(i - 1));
+    }
+    set_child(n, 0, left->child(left->count));
+  }
+  --left->count;
+  ++n->count;
+}
+
+// 右兄弟的第一个元素上移到父节点，父节点中的分隔元素下移到 n 的末尾
+template <class Key, class Value, class KeyOfValue, class Compare,
+          class Allocator, size_t TargetNodeSize>
+void btree<Key, Value, KeyOfValue, Compare, Allocator,
+           TargetNodeSize>::rotate_left(node_type* n, node_type* right) {
+  node_type* parent = n->parent;
+  const size_type p = n->position;
+  move_value(n, n->count, parent, p);
+  move_value(parent, p, right, 0);
+  for (size_type i = 1; i < right->count; ++i) {
+    move_value(right, i - 1, right, i);
+  }
+  if (!n->leaf) {
+    set_child(n, n->count + 1, right->child(0));
+    for (size_type i = 1; i <= right->count; ++i) {
+      set_child(right, i - 1, right->child(i));
+    }
+  }
+  ++n->count;
+  --right->count;
+}
+
+// 把分隔元素和 right 的全部内容并入 left，释放 right
+template <class Key, class Value, class KeyOfValue, class Compare,
+          class Allocator, size_t TargetNodeSize>
+void btree<Key, Value, KeyOfValue, Compare, Allocator,
+           TargetNodeSize>::merge_nodes(node_type* left, node_type* right) {
+  node_type* parent = left->parent;
+  const size_type p = left->position;
+  const size_type base = left->count + 1;
+  move_value(left, left->count, parent, p);
+  for (size_type i = 0; i != right->count; ++i) {
+    move_value(left, base + i, right, i);
+  }
+  if (!left->leaf) {
+    for (size_type i = 0; i <= right->count; ++i) {
+      set_child(left, base + i, right->child(i));
+    }
+  }
+  left->count = static_cast<unsigned short>(base + right->count);
+
+  for (size_type i = p + 1; i < parent->count; ++i) {
+    move_value(parent, i - 1, parent, i);
+  }
+  for (size_type i = p + 2; i <= parent->count; ++i) {
+    set_child(parent, i - 1, parent->child(i));
+  }
+  --parent->count;
+
+  if (right == rightmost_) {
+    rightmost_ = left;
+  }
+  delete_node(right);
+}
+
+/*****************************************************************************************/
+// 复制与销毁
+
+template <class Key, class Value, class KeyOfValue, class Compare,
+          class Allocator, size_t TargetNodeSize>
+void btree<Key, Value, KeyOfValue, Compare, Allocator,
+           TargetNodeSize>::destroy_subtree(node_type* n) {
+  for (size_type i = 0; i != n->count; ++i) {
+    destroy(n->value(i));
+  }
+  if (!n->leaf) {
+    for (size_type i = 0; i <= n->count; ++i) {
+      destroy_subtree(n->child(i));
+    }
+  }
+  delete_node(n);
+}
+
+// 按顺序在末尾追加，得到的节点几乎都是满的。要求当前树为空
+template <class Key, class Value, class KeyOfValue, class Compare,
+          class Allocator, size_t TargetNodeSize>
+void btree<Key, Value, KeyOfValue, Compare, Allocator,
+           TargetNodeSize>::copy_from(const btree& rhs) {
+  try {
+    for (const_iterator it = rhs.begin(); it != rhs.end(); ++it) {
+      if (root_ == nullptr) {
+        root_ = leftmost_ = rightmost_ = new_leaf(nullptr);
+      }
+      insert_at(rightmost_, rightmost_->count, *it);
+    }
+  } catch (...) {
+    clear();
+    throw;
+  }
+}
+
+template <class Key, class Value, class KeyOfValue, class Compare,
+          class Allocator, size_t TargetNodeSize>
+inline bool operator==(
+    const btree<Key, Value, KeyOfValue, Compare, Allocator, TargetNodeSize>& x,
+    const btree<Key, Value, KeyOfValue, Compare, Allocator, TargetNodeSize>&
+        y) {
+  return x.size() == y.size() && toystl::equal(x.begin(), x.end(), y.begin());
+}
+
+template <class Key, class Value, class KeyOfValue, class Compare,
+          class Allocator, size_t TargetNodeSize>
+inline bool operator<(
+    const btree<Key, Value, KeyOfValue, Compare, Allocator, TargetNodeSize>& x,
+    const btree<Key, Value, KeyOfValue, Compare, Allocator, TargetNodeSize>&
+        y) {
+  return toystl::lexicographical_compare(x.begin(), x.end(), y.begin(),
+                                         y.end());
+}
+}  // namespace toystl
+
+#endif  // TOYSTL_SRC_BTREE_H_
@@ -0,0 +1,188 @@
+#ifndef TOYSTL_SRC_BTREE_MAP_H_
+#define TOYSTL_SRC_BTREE_MAP_H_
+
+#include "algobase.h"
+#include "allocator.h"
+#include "btree.h"
+#include "functional.h"
+#include "utility.h"
+
+namespace toystl {
+// btree_map：接口与 map 相同，底层采用 B 树，每个节点存放多个元素，
+// 占用的内存更少，查找和遍历对 cache 更友好。
+// 与 map 不同的是，插入和删除会使所有迭代器失效
+template <class Key, class T, class Compare = toystl::less<Key>,
+          class Allocator = toystl::allocator<Key>>
+class btree_map {
+ public:
+  using key_type = Key;
+  using data_type = T;
+  using mapped_type = T;
+  using value_type = pair<const Key, T>;
+  using key_compare = Compare;
+  using value_compare = Compare;
+  using allocator_type = Allocator;
+
+ private:
+  using btree_type =
+      toystl::btree<key_type, value_type, toystl::selectfirst<value_type>,
+                    Compare, Allocator>;
+  btree_type tree_;  // 采用 B 树来实现
+
+ public:
+  using size_type = typename btree_type::size_type;
+  using difference_type = typename btree_type::difference_type;
+  using reference = typename btree_type::reference;
+  using const_reference = typename btree_type::const_reference;
+  using pointer = typename btree_type::pointer;
+  using const_pointer = typename btree_type::const_pointer;
+  using iterator = typename btree_type::iterator;
+  using const_iterator = typename btree_type::const_iterator;
+  using reverse_iterator = typename btree_type::reverse_iterator;
+  using const_reverse_iterator = typename btree_type::const_reverse_iterator;
+
+ public:
+  btree_map() {}
+
+  explicit btree_map(const Compare& comp,
+                     const allocator_type& a = allocator_type())
+      : tree_(comp, a) {}
+
+  explicit btree_map(const allocator_type& a) : tree_(Compare(), a) {}
+
+  btree_map(const btree_map& x) : tree_(x.tree_) {}
+
+  btree_map(const btree_map& x, const allocator_type& a)
+      : tree_(x.tree_, a) {}
+
+  btree_map(btree_map&& x) : tree_(toystl::move(x.tree_)) {}
+
+  btree_map& operator=(const btree_map& s) {
+    tree_ = s.tree_;
+    return *this;
+  }
+
+  btree_map& operator=(btree_map&& s) {
+    tree_ = toystl::move(s.tree_);
+    return *this;
+  }
+
+  template <class InputIterator>
+  btree_map(InputIterator first, InputIterator last,
+            const Compare& comp = Compare(),
+            const allocator_type& a = allocator_type())
+      : tree_(comp, a) {
+    tree_.insert_unique(first, last);
+  }
+
+  allocator_type get_allocator() const { return tree_.get_allocator(); }
+  key_compare key_comp() const { return tree_.key_comp(); }
+
+  iterator begin() noexcept { return tree_.begin(); }
+  const_iterator begin() const noexcept { return tree_.begin(); }
+  iterator end() noexcept { return tree_.end(); }
+  const_iterator end() const noexcept { return tree_.end(); }
+
+  reverse_iterator rbegin() noexcept { return reverse_iterator(end()); }
+  const_reverse_iterator rbegin() const noexcept {
+    return const_reverse_iterator(end());
+  }
+  reverse_iterator rend() noexcept { return reverse_iterator(begin()); }
+  const_reverse_iterator rend() const noexcept {
+    return const_reverse_iterator(begin());
+  }
+
+  const_iterator cbegin() const noexcept { return begin(); }
+  const_iterator cend() const noexcept { return end(); }
+  const_reverse_iterator crbegin() const noexcept { return rbegin(); }
+  const_reverse_iterator crend() const noexcept { return rend(); }
+
+  bool empty() const { return tree_.empty(); }
+  size_type size() const { return tree_.size(); }
+  void swap(btree_map& x) { tree_.swap(x.tree_); }
+
+  // 键不存在时插入一个值初始化的元素
+  mapped_type& operator[](const key_type& k) {
+    iterator it = lower_bound(k);
+    if (it == end() || key_comp()(k, it->first)) {
+      it = tree_.insert_unique(it, value_type(k, mapped_type()));
+    }
+    return it->second;
+  }
+
+  pair<iterator, bool> insert(const value_type& x) {
+    return tree_.insert_unique(x);
+  }
+
+  pair<iterator, bool> insert(value_type&& x) {
+    return tree_.emplace_unique(toystl::move(x));
+  }
+
+  // 新值恰好位于 hint 之前时直接插入到叶子节点中，以 end() 顺序追加最快
+  iterator insert(const_iterator hint, const value_type& x) {
+    return tree_.insert_unique(hint, x);
+  }
+
+  template <class... Args>
+  pair<iterator, bool> emplace(Args&&... args) {
+    return tree_.emplace_unique(toystl::forward<Args>(args)...);
+  }
+
+  template <class... Args>
+  iterator emplace_hint(const_iterator hint, Args&&... args) {
+    return tree_.emplace_hint_unique(hint, toystl::forward<Args>(args)...);
+  }
+
+  template <class InputIterator>
+  void insert(InputIterator first, InputIterator last) {
+    tree_.insert_unique(first, last);
+  }
+
+  void erase(iterator position) { tree_.erase(position); }
+
+  size_type erase(const key_type& x) { return tree_.erase(x); }
+
+  void erase(iterator first, iterator last) { tree_.erase(first, last); }
+
+  void clear() { tree_.clear(); }
+
+  iterator find(const key_type& x) { return tree_.find(x); }
+  const_iterator find(const key_type& x) const { return tree_.find(x); }
+  size_type count(const key_type& x) const { return tree_.count(x); }
+  iterator lower_bound(const key_type& x) { return tree_.lower_bound(x); }
+  const_iterator lower_bound(const key_type& x) const {
+    return tree_.lower_bound(x);
+  }
+  iterator upper_bound(const key_type& x) { return tree_.upper_bound(x); }
+  const_iterator upper_bound(const key_type& x) const {
+    return tree_.upper_bound(x);
+  }
+  pair<iterator, iterator> equal_range(const key_type& x) {
+    return tree_.equal_range(x);
+  }
+  pair<const_iterator, const_iterator> equal_range(const key_type& x) const {
+    return tree_.equal_range(x);
+  }
+
+  template <class K1, class T1, class C1, class A1>
+  friend bool operator==(const btree_map&, const btree_map&);
+  template <class K1, class T1, class C1, class A1>
+  friend bool operator<(const btree_map&, const btree_map&);
+};
+
+template <class K1, class T1, class C1, class A1>
+bool operator==(const btree_map<K1, T1, C1, A1>& lhs,
+                const btree_map<K1, T1, C1, A1>& rhs) {
+  return lhs.size() == rhs.size() &&
+         toystl::equal(lhs.cbegin(), lhs.cend(), rhs.cbegin());
+}
+
+template <class K1, class T1, class C1, class A1>
+bool operator<(const btree_map<K1, T1, C1, A1>& lhs,
+               const btree_map<K1, T1, C1, A1>& rhs) {
+  return toystl::lexicographical_compare(lhs.cbegin(), lhs.cend(), rhs.cbegin(),
+                                         rhs.cend());
+}
+}  // namespace toystl
+
+#endif  // TOYSTL_SRC_BTREE_MAP_H_
@@ -0,0 +1,159 @@
+#ifndef TOYSTL_SRC_BTREE_SET_H_
+#define TOYSTL_SRC_BTREE_SET_H_
+
+#include "algobase.h"
+#include "allocator.h"
+#include "btree.h"
+#include "functional.h"
+#include "utility.h"
+
+namespace toystl {
+// btree_set：接口与 set 相同，底层采用 B 树。
+// 与 set 不同的是，插入和删除会使所有迭代器失效
+template <class Key, class Compare = toystl::less<Key>,
+          class Allocator = toystl::allocator<Key>>
+class btree_set {
+ public:
+  using key_type = Key;
+  using value_type = Key;
+  using key_compare = Compare;
+  using value_compare = Compare;
+  using allocator_type = Allocator;
+
+ private:
+  using btree_type =
+      toystl::btree<value_type, key_type, toystl::identity<value_type>,
+                    Compare, Allocator>;
+  btree_type tree_;  // 采用 B 树来实现
+
+ public:
+  using size_type = typename btree_type::size_type;
+  using difference_type = typename btree_type::difference_type;
+  using reference = typename btree_type::const_reference;
+  using const_reference = typename btree_type::const_reference;
+  using pointer = typename btree_type::const_pointer;
+  using const_pointer = typename btree_type::const_pointer;
+  // 与 set 一样，不允许通过迭代器修改元素
+  using iterator = typename btree_type::const_iterator;
+  using const_iterator = typename btree_type::const_iterator;
+  using reverse_iterator = typename btree_type::const_reverse_iterator;
+  using const_reverse_iterator = typename btree_type::const_reverse_iterator;
+
+ public:
+  btree_set() {}
+
+  explicit btree_set(const Compare& comp,
+                     const allocator_type& a = allocator_type())
+      : tree_(comp, a) {}
+
+  explicit btree_set(const allocator_type& a) : tree_(Compare(), a) {}
+
+  btree_set(const btree_set& x) : tree_(x.tree_) {}
+
+  btree_set(const btree_set& x, const allocator_type& a)
+      : tree_(x.tree_, a) {}
+
+  btree_set(btree_set&& x) : tree_(toystl::move(x.tree_)) {}
+
+  btree_set& operator=(const btree_set& s) {
+    tree_ = s.tree_;
+    return *this;
+  }
+
+  btree_set& operator=(btree_set&& s) {
+    tree_ = toystl::move(s.tree_);
+    return *this;
+  }
+
+  template <class InputIterator>
+  btree_set(InputIterator first, InputIterator last,
+            const Compare& comp = Compare(),
+            const allocator_type& a = allocator_type())
+      : tree_(comp, a) {
+    tree_.insert_unique(first, last);
+  }
+
+  allocator_type get_allocator() const { return tree_.get_allocator(); }
+  key_compare key_comp() const { return tree_.key_comp(); }
+
+  iterator begin() const noexcept { return tree_.begin(); }
+  iterator end() const noexcept { return tree_.end(); }
+
+  reverse_iterator rbegin() const noexcept { return reverse_iterator(end()); }
+  reverse_iterator rend() const noexcept { return reverse_iterator(begin()); }
+
+  const_iterator cbegin() const noexcept { return begin(); }
+  const_iterator cend() const noexcept { return end(); }
+  const_reverse_iterator crbegin() const noexcept { return rbegin(); }
+  const_reverse_iterator crend() const noexcept { return rend(); }
+
+  bool empty() const { return tree_.empty(); }
+  size_type size() const { return tree_.size(); }
+  void swap(btree_set& x) { tree_.swap(x.tree_); }
+
+  pair<iterator, bool> insert(const value_type& x) {
+    toystl::pair<typename btree_type::iterator, bool> p =
+        tree_.insert_unique(x);
+    return toystl::pair<iterator, bool>(p.first, p.second);
+  }
+
+  // 新值恰好位于 hint 之前时直接插入到叶子节点中，以 end() 顺序追加最快
+  iterator insert(const_iterator hint, const value_type& x) {
+    return tree_.insert_unique(hint, x);
+  }
+
+  template <class... Args>
+  pair<iterator, bool> emplace(Args&&... args) {
+    toystl::pair<typename btree_type::iterator, bool> p =
+        tree_.emplace_unique(toystl::forward<Args>(args)...);
+    return toystl::pair<iterator, bool>(p.first, p.second);
+  }
+
+  template <class... Args>
+  iterator emplace_hint(const_iterator hint, Args&&... args) {
+    return tree_.emplace_hint_unique(hint, toystl::forward<Args>(args)...);
+  }
+
+  template <class InputIterator>
+  void insert(InputIterator first, InputIterator last) {
+    tree_.insert_unique(first, last);
+  }
+
+  void erase(iterator position) { tree_.erase(position); }
+
+  size_type erase(const key_type& x) { return tree_.erase(x); }
+
+  void erase(iterator first, iterator last) { tree_.erase(first, last); }
+
+  void clear() { tree_.clear(); }
+
+  iterator find(const key_type& x) const { return tree_.find(x); }
+  size_type count(const key_type& x) const { return tree_.count(x); }
+  iterator lower_bound(const key_type& x) const { return tree_.lower_bound(x); }
+  iterator upper_bound(const key_type& x) const { return tree_.upper_bound(x); }
+  pair<iterator, iterator> equal_range(const key_type& x) const {
+    return tree_.equal_range(x);
+  }
+
+  template <class K1, class C1, class A1>
+  friend bool operator==(const btree_set&, const btree_set&);
+  template <class K1, class C1, class A1>
+  friend bool operator<(const btree_set&, const btree_set&);
+};
+
+template <class K1, class C1, class A1>
+bool operator==(const btree_set<K1, C1, A1>& lhs,
+                const btree_set<K1, C1, A1>& rhs) {
+  return lhs.size() == rhs.size() &&
+         toystl::equal(lhs.cbegin(), lhs.cend(), rhs.cbegin());
+}
+
+template <class K1, class C1, class A1>
+bool operator<(const btree_set<K1, C1, A1>& lhs,
+               const btree_set<K1, C1, A1>& rhs) {
+  return toystl::lexicographical_compare(lhs.cbegin(), lhs.cend(), rhs.cbegin(),
+                                         rhs.cend());
+}
+}  // namespace toystl
+
+#endif  // TOYSTL_SRC_BTREE_SET_H_
@@ -0,0 +1,352 @@
+#ifndef TOYSTL_SRC_CONCURRENT_QUEUE_H_
+#define TOYSTL_SRC_CONCURRENT_QUEUE_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+#include "allocator.h"
+#include "construct.h"
+#include "utility.h"
+
+namespace toystl {
+namespace detail {
+// 假定的 cache line 大小，生产者和消费者各自修改的变量之间至少隔开这么多字节
+const size_t concurrent_cache_line = 64;
+
+// 容量向上取整为 2 的幂（至少为 2），下标可以用位与代替取模
+inline size_t concurrent_queue_capacity(size_t n) {
+  size_t capacity = 2;
+  while (capacity < n) {
+    capacity <<= 1;
+  }
+  return capacity;
+}
+}  // namespace detail
+
+/******************************************************************************/
+// 模板类 concurrent_queue，容量固定、无锁的多生产者多消费者队列
+// 参考 Dmitry Vyukov 的 bounded MPMC queue：环形数组的每个 cell 带一个
+// 序号 sequence，生产者和消费者各自用 CAS 推进 enqueue_pos_ / dequeue_pos_
+// 认领 cell，再以 sequence 的 release / acquire 交接元素。
+//   sequence == pos      cell 空闲，可以写入第 pos 个元素
+//   sequence == pos + 1  第 pos 个元素已写好，可以取出
+// 取出后 sequence 置为 pos + capacity，留给下一圈的生产者。
+// 队列满 / 空时 try_ 系列函数直接返回 false（或 0），不等待。
+// 认领 cell 之后元素的构造、移动不能抛出异常，否则这个 cell 永远不会交出
+/******************************************************************************/
+template <class T, class Allocator = toystl::allocator<T>>
+class concurrent_queue : private allocator_holder<Allocator> {
+ public:
+  using value_type = T;
+  using size_type = size_t;
+  using allocator_type = Allocator;
+
+ private:
+  struct cell {
+    std::atomic<size_t> sequence;
+    typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+
+    T* value() { return reinterpret_cast<T*>(&storage); }
+  };
+
+  using cell_allocator = typename Allocator::template rebind<cell>::other;
+  using alloc_base = allocator_holder<Allocator>;
+
+ public:
+  explicit concurrent_queue(size_type capacity,
+                            const allocator_type& a = allocator_type())
+      : alloc_base(a),
+        mask_(detail::concurrent_queue_capacity(capacity) - 1),
+        enqueue_pos_(0),
+        dequeue_pos_(0) {
+    buffer_ = cell_allocator(this->get_alloc()).allocate(mask_ + 1);
+    for (size_t i = 0; i <= mask_; ++i) {
+      ::new (static_cast<void*>(&buffer_[i].sequence)) std::atomic<size_t>(i);
+    }
+  }
+
+  concurrent_queue(const concurrent_queue&) = delete;
+  concurrent_queue& operator=(const concurrent_queue&) = delete;
+
+  // 析构时不能有其他线程在访问队列
+  ~concurrent_queue() {
+    const size_t last = enqueue_pos_.load(std::memory_order_relaxed);
+    for (size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+         pos != last; ++pos) {
+      toystl::destroy(buffer_[pos & mask_].value());
+    }
+    cell_allocator(this->get_alloc()).deallocate(buffer_, mask_ + 1);
+  }
+
+  allocator_type get_allocator() const { return this->get_alloc(); }
+  size_type capacity() const { return mask_ + 1; }
+
+  // 其他线程同时在读写时只是一个近似值
+  size_type size_approx() const {
+    const size_t tail = dequeue_pos_.load(std::memory_order_relaxed);
+    const size_t head = enqueue_pos_.load(std::memory_order_relaxed);
+    return head > tail ? head - tail : 0;
+  }
+  bool empty_approx() const { return size_approx() == 0; }
+
+  bool try_push(const value_type& value) { return try_emplace(value); }
+  bool try_push(value_type&& value) { return try_emplace(toystl::move(value)); }
+
+  template <class... Args>
+  bool try_emplace(Args&&... args) {
+    size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+    cell* c;
+    for (;;) {
+      c = &buffer_[pos & mask_];
+      const size_t seq = c->sequence.load(std::memory_order_acquire);
+      const intptr_t diff =
+          static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+      if (diff == 0) {
+        if (enqueue_pos_.compare_exchange_weak(pos, pos + 1,
+                                               std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (diff < 0) {
+        return false;  // 上一圈的元素还没有被取走，队列已满
+      } else {
+        pos = enqueue_pos_.load(std::memory_order_relaxed);
+      }
+    }
+    toystl::construct(c->value(), toystl::forward<Args>(args)...);
+    c->sequence.store(pos + 1, std::memory_order_release);
+    return true;
+  }
+
+  bool try_pop(value_type& value) {
+    size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+    cell* c;
+    for (;;) {
+      c = &buffer_[pos & mask_];
+      const size_t seq = c->sequence.load(std::memory_order_acquire);
+      const intptr_t diff =
+          static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+      if (diff == 0) {
+        if (dequeue_pos_.compare_exchange_weak(pos, pos + 1,
+                                               std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (diff < 0) {
+        return false;  // 队列为空
+      } else {
+        pos = dequeue_pos_.load(std::memory_order_relaxed);
+      }
+    }
+    value = toystl::move(*c->value());
+    toystl::destroy(c->value());
+    c->sequence.store(pos + mask_ + 1, std::memory_order_release);
+    return true;
+  }
+
+  // 批量写入 [first, first + n) 的前若干个元素，返回写入的个数。
+  // 先找出从 enqueue_pos_ 开始连续空闲的 cell，再用一次 CAS 全部认领
+  template <class InputIter>
+  size_type try_push_n(InputIter first, size_type n) {
+    size_t pos;
+    size_t count = claim(enqueue_pos_, n, 0, pos);
+    for (size_t i = 0; i != count; ++i, ++first) {
+      cell& c = buffer_[(pos + i) & mask_];
+      toystl::construct(c.value(), *first);
+      c.sequence.store(pos + i + 1, std::memory_order_release);
+    }
+    return count;
+  }
+
+  // 批量取出至多 n 个元素写到 result，返回取出的个数
+  template <class OutputIter>
+  size_type try_pop_n(OutputIter result, size_type n) {
+    size_t pos;
+    size_t count = claim(dequeue_pos_, n, 1, pos);
+    for (size_t i = 0; i != count; ++i, ++result) {
+      cell& c = buffer_[(pos + i) & mask_];
+      *result = toystl::move(*c.value());
+      toystl::destroy(c.value());
+      c.sequence.store(pos + i + mask_ + 1, std::memory_order_release);
+    }
+    return count;
+  }
+
+ private:
+  // 从 position 开始认领至多 n 个连续的 cell，sequence 等于 pos + offset 的
+  // cell 可以认领（生产者 offset 为 0，消费者为 1）。
+  // 扫描到的 cell 在 CAS 成功之前不会被别人认领，因为别人认领同样要推进 position
+  size_t claim(std::atomic<size_t>& position, size_t n, size_t offset,
+               size_t& pos) {
+    pos = position.load(std::memory_order_relaxed);
+    for (;;) {
+      size_t count = 0;
+      intptr_t diff = 0;
+      while (count != n) {
+        const size_t seq =
+            buffer_[(pos + count) & mask_].sequence.load(
+                std::memory_order_acquire);
+        diff = static_cast<intptr_t>(seq) -
+               static_cast<intptr_t>(pos + count + offset);
+        if (diff != 0) {
+          break;
+        }
+        ++count;
+      }
+      if (count == 0) {
+        if (diff < 0 || n == 0) {
+          return 0;  // 满（生产者）或空（消费者）
+        }
+        pos = position.load(std::memory_order_relaxed);
+      } else if (position.compare_exchange_weak(pos, pos + count,
+                                                std::memory_order_relaxed)) {
+        return count;
+      }
+    }
+  }
+
+  cell* buffer_;
+  const size_t mask_;
+  // 生产者与消费者修改的位置分别独占 cache line
+  char padding0_[detail::concurrent_cache_line];
+  std::atomic<size_t> enqueue_pos_;
+  char padding1_[detail::concurrent_cache_line];
+  std::atomic<size_t> dequeue_pos_;
+  char padding2_[detail::concurrent_cache_line];
+};
+
+/******************************************************************************/
+// 模板类 spsc_queue，只有一个生产者和一个消费者时使用的无锁环形队列
+// 只有生产者写 tail_、只有消费者写 head_，不需要 CAS，一次 release store
+// 就能交出元素。双方各自缓存对方的位置，只有看起来满 / 空时才去读对方的
+// cache line。批量操作一次交出或取走多个元素，只同步一次
+/******************************************************************************/
+template <class T, class Allocator = toystl::allocator<T>>
+class spsc_queue : private allocator_holder<Allocator> {
+ public:
+  using value_type = T;
+  using size_type = size_t;
+  using allocator_type = Allocator;
+
+ private:
+  using alloc_base = allocator_holder<Allocator>;
+
+ public:
+  explicit spsc_queue(size_type capacity,
+                      const allocator_type& a = allocator_type())
+      : alloc_base(a),
+        mask_(detail::concurrent_queue_capacity(capacity) - 1),
+        buffer_(this->get_alloc().allocate(mask_ + 1)),
+        head_(0),
+        cached_tail_(0),
+        tail_(0),
+        cached_head_(0) {}
+
+  spsc_queue(const spsc_queue&) = delete;
+  spsc_queue& operator=(const spsc_queue&) = delete;
+
+  ~spsc_queue() {
+    const size_t tail = tail_.load(std::memory_order_relaxed);
+    for (size_t pos = head_.load(std::memory_order_relaxed); pos != tail;
+         ++pos) {
+      toystl::destroy(buffer_ + (pos & mask_));
+    }
+    this->get_alloc().deallocate(buffer_, mask_ + 1);
+  }
+
+  allocator_type get_allocator() const { return this->get_alloc(); }
+  size_type capacity() const { return mask_ + 1; }
+
+  size_type size_approx() const {
+    const size_t head = head_.load(std::memory_order_relaxed);
+    const size_t tail = tail_.load(std::memory_order_relaxed);
+    return tail > head ? tail - head : 0;
+  }
+  bool empty_approx() const { return size_approx() == 0; }
+
+  /* 以下只能由生产者调用 */
+  bool try_push(const value_type& value) { return try_emplace(value); }
+  bool try_push(value_type&& value) { return try_emplace(toystl::move(value)); }
+
+  template <class... Args>
+  bool try_emplace(Args&&... args) {
+    const size_t tail = tail_.load(std::memory_order_relaxed);
+    if (tail - cached_head_ > mask_) {
+      cached_head_ = head_.load(std::memory_order_acquire);
+      if (tail - cached_head_ > mask_) {
+        return false;
+      }
+    }
+    toystl::construct(buffer_ + (tail & mask_), toystl::forward<Args>(args)...);
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  template <class InputIter>
+  size_type try_push_n(InputIter first, size_type n) {
+    const size_t tail = tail_.load(std::memory_order_relaxed);
+    if (mask_ + 1 - (tail - cached_head_) < n) {
+      cached_head_ = head_.load(std::memory_order_acquire);
+    }
+    const size_t room = mask_ + 1 - (tail - cached_head_);
+    const size_t count = n < room ? n : room;
+    for (size_t i = 0; i != count; ++i, ++first) {
+      toystl::construct(buffer_ + ((tail + i) & mask_), *first);
+    }
+    if (count != 0) {
+      tail_.store(tail + count, std::memory_order_release);
+    }
+    return count;
+  }
+
+  /* 以下只能由消费者调用 */
+  bool try_pop(value_type& value) {
+    const size_t head = head_.load(std::memory_order_relaxed);
+    if (head == cached_tail_) {
+      cached_tail_ = tail_.load(std::memory_order_acquire);
+      if (head == cached_tail_) {
+        return false;
+      }
+    }
+    T* p = buffer_ + (head & mask_);
+    value = toystl::move(*p);
+    toystl::destroy(p);
+    head_.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  template <class OutputIter>
+  size_type try_pop_n(OutputIter result, size_type n) {
+    const size_t head = head_.load(std::memory_order_relaxed);
+    if (cached_tail_ - head < n) {
+      cached_tail_ = tail_.load(std::memory_order_acquire);
+    }
+    const size_t available = cached_tail_ - head;
+    const size_t count = n < available ? n : available;
+    for (size_t i = 0; i != count; ++i, ++result) {
+      T* p = buffer_ + ((head + i) & mask_);
+      *result = toystl::move(*p);
+      toystl::destroy(p);
+    }
+    if (count != 0) {
+      head_.store(head + count, std::memory_order_release);
+    }
+    return count;
+  }
+
+ private:
+  const size_t mask_;
+  T* buffer_;
+  char padding0_[detail::concurrent_cache_line];
+  // 消费者的 cache line
+  std::atomic<size_t> head_;
+  size_t cached_tail_;
+  char padding1_[detail::concurrent_cache_line];
+  // 生产者的 cache line
+  std::atomic<size_t> tail_;
+  size_t cached_head_;
+  char padding2_[detail::concurrent_cache_line];
+};
+}  // namespace toystl
+
+#endif  // TOYSTL_SRC_CONCURRENT_QUEUE_H_
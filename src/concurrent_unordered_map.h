@@ -0,0 +1,378 @@
+#ifndef TOYSTL_SRC_CONCURRENT_UNORDERED_MAP_H_
+#define TOYSTL_SRC_CONCURRENT_UNORDERED_MAP_H_
+
+#include <atomic>
+#include <new>
+#include <thread>
+
+#include "functional.h"
+#include "hashtable.h"
+
+namespace toystl {
+/******************************************************************************/
+// 读写自旋锁。C++11 没有 shared_mutex，这里以一个原子整数实现：
+// state_ 为正数时表示持有读锁的线程数，等于 kWriter 时表示被写者占有。
+// 有写者在等待时新的读者主动让路，避免读多写少时写者一直拿不到锁。
+// 临界区都很短（一次哈希表操作），所以争用时只 yield 而不睡眠
+/******************************************************************************/
+class concurrent_rwlock {
+ public:
+  concurrent_rwlock() : state_(0), waiting_writers_(0) {}
+
+  concurrent_rwlock(const concurrent_rwlock&) = delete;
+  concurrent_rwlock& operator=(const concurrent_rwlock&) = delete;
+
+  void lock() {
+    waiting_writers_.fetch_add(1, std::memory_order_relaxed);
+    int expected = 0;
+    while (!state_.compare_exchange_weak(expected, kWriter,
+                                         std::memory_order_acquire,
+                                         std::memory_order_relaxed)) {
+      expected = 0;
+      std::this_thread::yield();
+    }
+    waiting_writers_.fetch_sub(1, std::memory_order_relaxed);
+  }
+
+  void unlock() { state_.store(0, std::memory_order_release); }
+
+  void lock_shared() {
+    for (;;) {
+      if (waiting_writers_.load(std::memory_order_relaxed) == 0) {
+        int expected = state_.load(std::memory_order_relaxed);
+        if (expected != kWriter &&
+            state_.compare_exchange_weak(expected, expected + 1,
+                                         std::memory_order_acquire,
+                                         std::memory_order_relaxed)) {
+          return;
+        }
+      }
+      std::this_thread::yield();
+    }
+  }
+
+  void unlock_shared() { state_.fetch_sub(1, std::memory_order_release); }
+
+ private:
+  static const int kWriter = -1;
+
+  std::atomic<int> state_;
+  std::atomic<int> waiting_writers_;
+};
+
+// 在作用域内持有读锁 / 写锁
+class concurrent_shared_guard {
+ public:
+  explicit concurrent_shared_guard(concurrent_rwlock& lock) : lock_(lock) {
+    lock_.lock_shared();
+  }
+  ~concurrent_shared_guard() { lock_.unlock_shared(); }
+
+  concurrent_shared_guard(const concurrent_shared_guard&) = delete;
+  concurrent_shared_guard& operator=(const concurrent_shared_guard&) = delete;
+
+ private:
+  concurrent_rwlock& lock_;
+};
+
+class concurrent_unique_guard {
+ public:
+  explicit concurrent_unique_guard(concurrent_rwlock& lock) : lock_(lock) {
+    lock_.lock();
+  }
+  ~concurrent_unique_guard() { lock_.unlock(); }
+
+  concurrent_unique_guard(const concurrent_unique_guard&) = delete;
+  concurrent_unique_guard& operator=(const concurrent_unique_guard&) = delete;
+
+ private:
+  concurrent_rwlock& lock_;
+};
+
+/******************************************************************************/
+// 模板类 concurrent_unordered_map，可以被多个线程同时读写的 unordered_map
+// 把键值按哈希值分到若干个 shard 中，每个 shard 是一个独立的 hashtable，
+// 各自带一把读写锁，不同 shard 上的操作互不阻塞。
+// shard 由混合后哈希值的高位选出，hashtable 内部定位 bucket 用的是低位
+// （或取模），两者互不相关，每个 shard 的 bucket 都能用满。
+// 因为元素随时可能被其他线程删除，接口不返回迭代器和引用：
+// 查找把实值拷贝出来，修改通过回调函数在锁内完成
+/******************************************************************************/
+template <class Key, class Value, class HashFcn = toystl::hash<Key>,
+          class EqualKey = toystl::equal_to<Key>,
+          class Allocator = toystl::allocator<Value>,
+          class BucketPolicy = hashtable_prime_policy>
+class concurrent_unordered_map {
+ private:
+  using hashtable_type =
+      hashtable<Key, toystl::pair<const Key, Value>, HashFcn,
+                selectfirst<pair<const Key, Value>>, EqualKey, Allocator,
+                BucketPolicy>;
+
+  // 锁与 hashtable 放在一起，尾部补齐一个 cache line，
+  // 避免相邻 shard 的锁落在同一个 cache line 上互相干扰
+  struct shard {
+    mutable concurrent_rwlock lock;
+    hashtable_type table;
+    char padding[64];
+
+    shard(size_t n, const HashFcn& hf, const EqualKey& eq, const Allocator& a)
+        : table(n, hf, eq, a) {}
+  };
+
+ public:
+  using key_type = typename hashtable_type::key_type;
+  using mapped_type = Value;
+  using value_type = typename hashtable_type::value_type;
+  using hasher = typename hashtable_type::hasher;
+  using key_equal = typename hashtable_type::key_equal;
+  using size_type = typename hashtable_type::size_type;
+  using allocator_type = typename hashtable_type::allocator_type;
+
+ private:
+  shard* shards_;
+  size_type shard_count_;  // 2 的幂
+  size_type shard_shift_;  // 取混合后哈希值的高 log2(shard_count_) 位
+  hasher hash_;
+
+ public:
+  // 构造、析构函数。shard 个数向上取为 2 的幂，bucket_size 为所有 shard 的
+  // bucket 总数。容器本身不可复制、不可移动
+  explicit concurrent_unordered_map(size_type shard_count = 32,
+                                    size_type bucket_size = 100,
+                                    const hasher& hf = hasher(),
+                                    const key_equal& equal = key_equal(),
+                                    const allocator_type& a = allocator_type());
+
+  ~concurrent_unordered_map();
+
+  concurrent_unordered_map(const concurrent_unordered_map&) = delete;
+  concurrent_unordered_map& operator=(const concurrent_unordered_map&) =
+      delete;
+
+ public:
+  // 容量相关。其他线程可能同时在修改，结果只是某一时刻的近似值
+  bool empty() const { return size() == 0; }
+  size_type size() const;
+
+  size_type shard_count() const { return shard_count_; }
+
+ public:
+  // 插入成功返回 true，键值已经存在时什么也不做，返回 false
+  bool insert(const value_type& value) {
+    shard& s = shard_of(value.first);
+    concurrent_unique_guard guard(s.lock);
+    return s.table.insert_unique(value).second;
+  }
+
+  template <class... Args>
+  bool emplace(Args&&... args) {
+    // 先构造出元素才能知道键值属于哪个 shard
+    value_type value(toystl::forward<Args>(args)...);
+    shard& s = shard_of(value.first);
+    concurrent_unique_guard guard(s.lock);
+    return s.table.emplace_unique(toystl::move(value)).second;
+  }
+
+  // 键值已经存在时覆盖实值。插入了新元素返回 true
+  template <class M>
+  bool insert_or_assign(const key_type& key, M&& obj) {
+    shard& s = shard_of(key);
+    concurrent_unique_guard guard(s.lock);
+    pair<typename hashtable_type::iterator, bool> res =
+        s.table.try_emplace_unique(key, toystl::forward<M>(obj));
+    if (!res.second) {
+      res.first->second = toystl::forward<M>(obj);
+    }
+    return res.second;
+  }
+
+  size_type erase(const key_type& key) {
+    shard& s = shard_of(key);
+    concurrent_unique_guard guard(s.lock);
+    return s.table.erase(key);
+  }
+
+  void clear();
+
+ public:
+  // 查找成功时把实值拷贝到 value 中并返回 true
+  bool find(const key_type& key, mapped_type& value) const {
+    const shard& s = shard_of(key);
+    concurrent_shared_guard guard(s.lock);
+    typename hashtable_type::const_iterator it = s.table.find(key);
+    if (it == s.table.end()) {
+      return false;
+    }
+    value = it->second;
+    return true;
+  }
+
+  size_type count(const key_type& key) const {
+    const shard& s = shard_of(key);
+    concurrent_shared_guard guard(s.lock);
+    return s.table.count(key);
+  }
+
+  bool contains(const key_type& key) const { return count(key) != 0; }
+
+  // 在读锁内以 f(const mapped_type&) 访问实值，键值不存在返回 false。
+  // f 执行期间同一 shard 的写操作会被阻塞，f 中不能再访问本容器
+  template <class Function>
+  bool visit(const key_type& key, Function f) const {
+    const shard& s = shard_of(key);
+    concurrent_shared_guard guard(s.lock);
+    typename hashtable_type::const_iterator it = s.table.find(key);
+    if (it == s.table.end()) {
+      return false;
+    }
+    f(it->second);
+    return true;
+  }
+
+  // 在写锁内以 f(mapped_type&) 原地修改实值，键值不存在返回 false
+  template <class Function>
+  bool update(const key_type& key, Function f) {
+    shard& s = shard_of(key);
+    concurrent_unique_guard guard(s.lock);
+    typename hashtable_type::iterator it = s.table.find(key);
+    if (it == s.table.end()) {
+      return false;
+    }
+    f(it->second);
+    return true;
+  }
+
+  // 键值存在时以 f(mapped_type&) 修改实值，否则以 args 构造实值插入，
+  // 整个过程是原子的。插入了新元素返回 true
+  template <class Function, class... Args>
+  bool upsert(const key_type& key, Function f, Args&&... args) {
+    shard& s = shard_of(key);
+    concurrent_unique_guard guard(s.lock);
+    pair<typename hashtable_type::iterator, bool> res =
+        s.table.try_emplace_unique(key, toystl::forward<Args>(args)...);
+    if (!res.second) {
+      f(res.first->second);
+    }
+    return res.second;
+  }
+
+  // 依次持有每个 shard 的读锁，以 f(const value_type&) 访问其中的元素。
+  // 不是整个容器的快照：已经访问过的 shard 可能又被修改
+  template <class Function>
+  void for_each(Function f) const;
+
+ public:
+  // 按总元素个数 n 预留 bucket，平均分给每个 shard
+  void reserve(size_type n);
+
+  hasher hash_fcn() const { return hash_; }
+
+ private:
+  size_type shard_index(const key_type& key) const {
+    // shard_count_ 为 1 时右移位数等于字长，是未定义行为
+    return shard_count_ == 1 ? 0 : hash_mix(hash_(key)) >> shard_shift_;
+  }
+
+  shard& shard_of(const key_type& key) { return shards_[shard_index(key)]; }
+
+  const shard& shard_of(const key_type& key) const {
+    return shards_[shard_index(key)];
+  }
+};
+
+// 构造、析构函数
+template <class Key, class Value, class HashFcn, class EqualKey,
+          class Allocator, class BucketPolicy>
+concurrent_unordered_map<Key, Value, HashFcn, EqualKey, Allocator,
+                         BucketPolicy>::
+    concurrent_unordered_map(size_type shard_count, size_type bucket_size,
+                             const hasher& hf, const key_equal& equal,
+                             const allocator_type& a)
+    : shards_(nullptr), shard_count_(1), shard_shift_(0), hash_(hf) {
+  const size_type bits = sizeof(size_type) * 8;
+  size_type log2 = 0;
+  while (shard_count_ < shard_count && log2 + 1 < bits) {
+    shard_count_ <<= 1;
+    ++log2;
+  }
+  shard_shift_ = bits - log2;
+
+  // hashtable 没有缺省构造函数，先分配内存再逐个构造
+  shards_ = static_cast<shard*>(::operator new(shard_count_ * sizeof(shard)));
+  size_type i = 0;
+  try {
+    for (; i != shard_count_; ++i) {
+      new (shards_ + i) shard(bucket_size / shard_count_ + 1, hf, equal, a);
+    }
+  } catch (...) {
+    while (i != 0) {
+      shards_[--i].~shard();
+    }
+    ::operator delete(shards_);
+    throw;
+  }
+}
+
+template <class Key, class Value, class HashFcn, class EqualKey,
+          class Allocator, class BucketPolicy>
+concurrent_unordered_map<Key, Value, HashFcn, EqualKey, Allocator,
+                         BucketPolicy>::~concurrent_unordered_map() {
+  for (size_type i = 0; i != shard_count_; ++i) {
+    shards_[i].~shard();
+  }
+  ::operator delete(shards_);
+}
+
+// 容量、修改与遍历
+template <class Key, class Value, class HashFcn, class EqualKey,
+          class Allocator, class BucketPolicy>
+typename concurrent_unordered_map<Key, Value, HashFcn, EqualKey, Allocator,
+                                  BucketPolicy>::size_type
+concurrent_unordered_map<Key, Value, HashFcn, EqualKey, Allocator,
+                         BucketPolicy>::size() const {
+  size_type n = 0;
+  for (size_type i = 0; i != shard_count_; ++i) {
+    concurrent_shared_guard guard(shards_[i].lock);
+    n += shards_[i].table.size();
+  }
+  return n;
+}
+
+template <class Key, class Value, class HashFcn, class EqualKey,
+          class Allocator, class BucketPolicy>
+void concurrent_unordered_map<Key, Value, HashFcn, EqualKey, Allocator,
+                              BucketPolicy>::clear() {
+  for (size_type i = 0; i != shard_count_; ++i) {
+    concurrent_unique_guard guard(shards_[i].lock);
+    shards_[i].table.clear();
+  }
+}
+
+template <class Key, class Value, class HashFcn, class EqualKey,
+          class Allocator, class BucketPolicy>
+template <class Function>
+void concurrent_unordered_map<Key, Value, HashFcn, EqualKey, Allocator,
+                              BucketPolicy>::for_each(Function f) const {
+  for (size_type i = 0; i != shard_count_; ++i) {
+    concurrent_shared_guard guard(shards_[i].lock);
+    for (typename hashtable_type::const_iterator it =
+             shards_[i].table.begin();
+         it != shards_[i].table.end(); ++it) {
+      f(*it);
+    }
+  }
+}
+
+template <class Key, class Value, class HashFcn, class EqualKey,
+          class Allocator, class BucketPolicy>
+void concurrent_unordered_map<Key, Value, HashFcn, EqualKey, Allocator,
+                              BucketPolicy>::reserve(size_type n) {
+  for (size_type i = 0; i != shard_count_; ++i) {
+    concurrent_unique_guard guard(shards_[i].lock);
+    shards_[i].table.resize(n / shard_count_ + 1);
+  }
+}
+}  // namespace toystl
+
+#endif  // TOYSTL_SRC_CONCURRENT_UNORDERED_MAP_H_
@@ -1,7 +1,10 @@
 #ifndef TOYSTL_SRC_DEQUE_H_
 #define TOYSTL_SRC_DEQUE_H_
 
+#include <algorithm>  // std::copy
+#include <cstring>    // std::memcpy
 #include <initializer_list>
+#include <stdexcept>  // std::out_of_range
 
 #include "algo.h"
 #include "algobase.h"
@@ -16,13 +19,18 @@
 namespace toystl {
 namespace detail {
 constexpr std::size_t min_map_size_ = 8;  // deque map 初始化的大小
-
-inline size_t __deque_buf_size(size_t T_size) {
-  return (T_size < 512) ? static_cast<size_t>(512 / T_size)
-                        : static_cast<size_t>(1);
+constexpr std::size_t max_spare_nodes_ = 4;  // deque 最多保留的空闲缓冲区个数
+
+// 一个缓冲区能容纳的元素个数。n 不为 0 时即由使用者指定（deque 的 BufSiz
+// 参数）；否则小于 512 字节的元素凑满 512 字节，更大的元素凑满一个
+// 4096 字节的页面，免得每个元素单独占一个缓冲区，超过一页的元素每个缓冲区一个
+constexpr size_t __deque_buf_size(size_t n, size_t T_size) {
+  return n != 0 ? n
+                : (T_size < 512 ? 512 / T_size
+                                : (T_size < 4096 ? 4096 / T_size : 1));
 }
 
-template <class T, class Reference, class Pointer>
+template <class T, class Reference, class Pointer, size_t BufSiz>
 struct deque_iterator {
   using iterator_category = random_access_iterator_tag;
   using value_type = T;
@@ -32,12 +40,14 @@ struct deque_iterator {
   using map_pointer = T**;
   using size_type = size_t;
 
-  using iterator = deque_iterator<T, T&, T*>;
-  using const_iterator = deque_iterator<T, const T&, const T*>;
+  using iterator = deque_iterator<T, T&, T*, BufSiz>;
+  using const_iterator = deque_iterator<T, const T&, const T*, BufSiz>;
   using self = deque_iterator;
 
   // 一个缓冲区中的容量
-  static size_t deque_buf_size() { return __deque_buf_size(sizeof(T)); }
+  static constexpr size_t deque_buf_size() {
+    return __deque_buf_size(BufSiz, sizeof(T));
+  }
 
   // sizeof(deque_iterator) = 4 * 8 = 32;
   // 保持与容器的联结
@@ -198,9 +208,39 @@ struct deque_iterator {
 };
 }  // namespace detail
 
-template <class T, class Allocator = allocator<T>>
-class deque {
+// deque 的迭代器是分段迭代器，每个缓冲区是一段
+template <class T, class Ref, class Ptr, size_t BufSiz>
+struct segmented_iterator_traits<detail::deque_iterator<T, Ref, Ptr, BufSiz>> {
+  using iterator = detail::deque_iterator<T, Ref, Ptr, BufSiz>;
+  using is_segmented_iterator = true_type;
+  using segment_iterator = typename iterator::map_pointer;
+  using local_iterator = Ptr;
+
+  static segment_iterator segment(const iterator& it) { return it.node_; }
+  static local_iterator local(const iterator& it) { return it.current_; }
+  static local_iterator begin(segment_iterator s) { return *s; }
+  static local_iterator end(segment_iterator s) {
+    return *s + iterator::deque_buf_size();
+  }
+
+  // 位于段尾时转到下一个缓冲区的开头，与 operator+= 的结果一致
+  static iterator compose(segment_iterator s, local_iterator l) {
+    iterator it;
+    it.set_node(s);
+    it.current_ = const_cast<T*>(l);
+    if (l == it.last_) {
+      it.set_node(s + 1);
+      it.current_ = it.first_;
+    }
+    return it;
+  }
+};
+
+// BufSiz 为每个缓冲区的元素个数，为 0 时按元素大小自动选择
+template <class T, class Allocator = allocator<T>, size_t BufSiz = 0>
+class deque : private allocator_holder<Allocator> {
  public:
+  using allocator_type = Allocator;
   using value_type = T;
   using pointer = T*;
   using const_pointer = const T*;
@@ -209,8 +249,8 @@ class deque {
   using size_type = std::size_t;
   using difference_type = std::ptrdiff_t;
 
-  using iterator = detail::deque_iterator<T, T&, T*>;
-  using const_iterator = detail::deque_iterator<T, const T&, const T*>;
+  using iterator = detail::deque_iterator<T, T&, T*, BufSiz>;
+  using const_iterator = detail::deque_iterator<T, const T&, const T*, BufSiz>;
   using reverse_iterator = toystl::reverse_iterator<iterator>;
   using const_reverse_iterator = toystl::reverse_iterator<const_iterator>;
 
@@ -218,16 +258,19 @@ class deque {
   using map_pointer = T**;  // add
 
   // 一个缓冲区中的容量
-  static size_t deque_buf_size() { return detail::__deque_buf_size(sizeof(T)); }
+  static constexpr size_t deque_buf_size() {
+    return detail::__deque_buf_size(BufSiz, sizeof(T));
+  }
 
  private:
-  using allocator_type = Allocator;
   using node_allocator = Allocator;
   using map_allocator = typename Allocator::template rebind<T*>::other;
 
   // 这样的话，多了两个成员变量。删除
   // node_allocator nodeAllocator;   // 缓冲区元素的空间配置器
   // map_allocator mapAllocator;     // 中控 map 的空间配置器
+  // 分配器保存在基类 allocator_holder 中，map 用 rebind 后的分配器分配
+  using alloc_base = allocator_holder<Allocator>;
 
   // [start_, finish_)
   iterator start_;   // 指向第一个节点
@@ -238,60 +281,85 @@ class deque {
                        // 是块连续区间，其中每个元素都是一个指针，指向一个节点(缓冲区)
   size_type mapSize_;  // map 内指针的数目
 
+  // 备用缓冲区：pop、erase、clear 腾出的缓冲区先留下来，push 需要新缓冲区时
+  // 优先取用。当作队列使用（push_back + pop_front）时，头部腾出的缓冲区
+  // 正好补到尾部，稳定之后不再向分配器申请和归还内存。
+  // 空闲缓冲区不存放元素，用开头的位置存放下一个空闲缓冲区的指针，串成单链表，
+  // 最多保留 detail::max_spare_nodes_ 个。缓冲区小到放不下一个指针时不保留
+  T* spare_ = nullptr;
+  size_type spareCount_ = 0;
+
  public:
   /* 构造函数 */
   deque() {
     empty_initialize();  // TO DO
   }
 
-  explicit deque(size_type count) {
+  explicit deque(const allocator_type& a) : alloc_base(a) {
+    empty_initialize();
+  }
+
+  explicit deque(size_type count, const allocator_type& a = allocator_type())
+      : alloc_base(a) {
     fill_initialize(count, T());  // TO DO
   }
 
-  deque(size_type count, const_reference value) {
+  deque(size_type count, const_reference value,
+        const allocator_type& a = allocator_type())
+      : alloc_base(a) {
     fill_initialize(count, value);
   }
 
   template <class InputIterator,
             typename std::enable_if<
                 toystl::is_input_iterator<InputIterator>::value, int>::type = 0>
-  deque(InputIterator first, InputIterator last) {
+  deque(InputIterator first, InputIterator last,
+        const allocator_type& a = allocator_type())
+      : alloc_base(a) {
     copy_initialize(first, last, iterator_category(first));
   }
 
-  deque(const deque& other) {
+  // 新容器的分配器由 select_on_container_copy_construction 决定
+  deque(const deque& other)
+      : alloc_base(other.get_alloc().select_on_container_copy_construction()) {
+    copy_initialize(other.begin(), other.end(), toystl::forward_iterator_tag());
+  }
+
+  deque(const deque& other, const allocator_type& a) : alloc_base(a) {
     copy_initialize(other.begin(), other.end(), toystl::forward_iterator_tag());
   }
 
   // TO DO : 为什么这边用完 move,不需要再把 other.start_ 置为 nullptr ？
   // fixed : 这边调用的是 iterator 的 移动构造函数，直接移动
-  deque(deque&& other) noexcept : start_(toystl::move(other.start_)),
+  // 分配器随 map 和缓冲区一起移动过来
+  deque(deque&& other) noexcept : alloc_base(other.get_alloc()),
+                                  start_(toystl::move(other.start_)),
                                   finish_(toystl::move(other.finish_)),
                                   map_(other.map_),
-                                  mapSize_(other.mapSize_) {
+                                  mapSize_(other.mapSize_),
+                                  spare_(other.spare_),
+                                  spareCount_(other.spareCount_) {
     other.map_ = nullptr;
     other.mapSize_ = 0;
+    other.spare_ = nullptr;
+    other.spareCount_ = 0;
   }
 
-  deque(std::initializer_list<T> ilist) {
+  deque(std::initializer_list<T> ilist,
+        const allocator_type& a = allocator_type())
+      : alloc_base(a) {
     copy_initialize(ilist.begin(), ilist.end(), toystl::forward_iterator_tag());
   }
 
   /* 析构函数 */
-  ~deque() {
-    if (map_ == nullptr) {
-      return;
-    }
-    clear();
-    deallocate_node(*start_.node_);
-    *start_.node_ = nullptr;
-    deallocate_map();
-    map_ = nullptr;
-  }
+  ~deque() { deallocate_all(); }
 
   /* 赋值运算符 */
   deque& operator=(const deque& other) {
     if (this != &other) {
+      copy_assign_alloc(
+          other,
+          typename allocator_type::propagate_on_container_copy_assignment());
       const size_type length = size();
       if (length >= other.size()) {
         // 当前 deque 比 other 大，则将 other 的元素拷贝到 当前 deque，然后
@@ -313,20 +381,16 @@ class deque {
 
   deque& operator=(deque&& other) {
     if (this != &other) {
-      clear();
-      start_ = toystl::move(other.start_);
-      finish_ = toystl::move(other.finish_);
-      map_ = other.map_;
-      mapSize_ = other.mapSize_;
-      other.map_ = nullptr;
-      other.mapSize_ = 0;
+      move_assign(
+          other,
+          typename allocator_type::propagate_on_container_move_assignment());
     }
 
     return *this;
   }
 
   deque& operator=(std::initializer_list<T> ilist) {
-    deque tmp(ilist);
+    deque tmp(ilist, this->get_alloc());
     swap(tmp);
 
     return *this;
@@ -347,7 +411,7 @@ class deque {
     copy_assign(ilist.begin(), ilist.end(), toystl::forward_iterator_tag());
   }
 
-  allocator_type get_allocator() { return allocator_type(); }
+  allocator_type get_allocator() const { return this->get_alloc(); }
 
   /* 元素访问相关操作 */
 
@@ -530,17 +594,77 @@ class deque {
 
   void resize(size_type count) { resize(count, T()); }
 
+  // 分配器按 propagate_on_container_swap 决定是否交换
   void swap(deque& other) {
+    this->swap_alloc(other);
     toystl::swap(start_, other.start_);
     toystl::swap(finish_, other.finish_);
     toystl::swap(map_, other.map_);
     toystl::swap(mapSize_, other.mapSize_);
+    toystl::swap(spare_, other.spare_);
+    toystl::swap(spareCount_, other.spareCount_);
   }
 
  private:
   // 初始化一个空的 deque
   void empty_initialize() { create_map_and_nodes(); }
 
+  // 释放全部元素、缓冲区和 map
+  void deallocate_all() {
+    if (map_ == nullptr) {
+      return;
+    }
+    clear();
+    deallocate_node(*start_.node_);
+    *start_.node_ = nullptr;
+    release_spare_nodes();
+    deallocate_map();
+    map_ = nullptr;
+    mapSize_ = 0;
+  }
+
+  // 分配器需要传播时，如果两个分配器不相等，原有内存必须由原分配器释放
+  void copy_assign_alloc(const deque& other, true_type) {
+    if (this->get_alloc() != other.get_alloc()) {
+      deallocate_all();
+      this->set_alloc(other.get_alloc());
+      empty_initialize();
+    } else {
+      this->set_alloc(other.get_alloc());
+    }
+  }
+
+  void copy_assign_alloc(const deque&, false_type) {}
+
+  // 分配器随 map 和缓冲区一起转移
+  void move_assign(deque& other, true_type) {
+    deallocate_all();
+    this->set_alloc(other.get_alloc());
+    start_ = toystl::move(other.start_);
+    finish_ = toystl::move(other.finish_);
+    map_ = other.map_;
+    mapSize_ = other.mapSize_;
+    spare_ = other.spare_;
+    spareCount_ = other.spareCount_;
+    other.map_ = nullptr;
+    other.mapSize_ = 0;
+    other.spare_ = nullptr;
+    other.spareCount_ = 0;
+  }
+
+  // 分配器不传播：分配器相等时仍然可以直接接管内存，否则只能逐个移动元素
+  void move_assign(deque& other, false_type) {
+    if (this->get_alloc() == other.get_alloc()) {
+      move_assign(other, true_type());
+    } else {
+      clear();
+      for (auto& value : other) {
+        emplace_back(toystl::move(value));
+      }
+      other.clear();
+    }
+  }
+
   void fill_initialize(size_type count, const_reference value);
 
   template <class InputIterator>
@@ -568,14 +692,46 @@ class deque {
   T** allocate_map();
 
   /* 回收 map 的内存空间  */
-  void deallocate_map() { map_allocator::deallocate(map_, mapSize_); }
+  void deallocate_map() {
+    map_allocator(this->get_alloc()).deallocate(map_, mapSize_);
+  }
 
-  /* 分配缓冲区的内存空间 */
-  T* allocate_node() { return node_allocator::allocate(deque_buf_size()); }
+  /* 分配缓冲区的内存空间，有备用缓冲区时直接取用 */
+  T* allocate_node() {
+    if (spare_ != nullptr) {
+      pointer node = spare_;
+      std::memcpy(&spare_, static_cast<void*>(node), sizeof(pointer));
+      --spareCount_;
+      return node;
+    }
+    return this->get_alloc().allocate(deque_buf_size());
+  }
 
-  /* 回收缓冲区的内存空间 */
+  /* 回收缓冲区的内存空间，备用缓冲区未满时留作备用 */
   void deallocate_node(pointer ptr) {
-    node_allocator::deallocate(ptr, deque_buf_size());
+    if (sizeof(T) * deque_buf_size() >= sizeof(pointer) &&
+        spareCount_ < detail::max_spare_nodes_) {
+      std::memcpy(static_cast<void*>(ptr), &spare_, sizeof(pointer));
+      spare_ = ptr;
+      ++spareCount_;
+    } else {
+      release_node(ptr);
+    }
+  }
+
+  /* 把缓冲区归还给分配器 */
+  void release_node(pointer ptr) {
+    this->get_alloc().deallocate(ptr, deque_buf_size());
+  }
+
+  void release_spare_nodes() {
+    while (spare_ != nullptr) {
+      pointer next;
+      std::memcpy(&next, static_cast<void*>(spare_), sizeof(pointer));
+      release_node(spare_);
+      spare_ = next;
+    }
+    spareCount_ = 0;
   }
 
   /* 在前面预留 n 个元素的位置 */
@@ -631,8 +787,8 @@ class deque {
 
 };  // class deque
 
-template <class T, class Allocator>
-void deque<T, Allocator>::clear() {
+template <class T, class Allocator, size_t BufSiz>
+void deque<T, Allocator, BufSiz>::clear() {
   // 以下针对头尾之外的每一个缓冲区（他们一定是饱满的）。析构中间缓冲区中的对象
   for (map_pointer node = start_.node_ + 1; node < finish_.node_; ++node) {
     node_allocator::destroy(*node, *node + deque_buf_size());
@@ -656,8 +812,8 @@ void deque<T, Allocator>::clear() {
   finish_ = start_;
 }
 
-template <class T, class Allocator>
-typename deque<T, Allocator>::iterator deque<T, Allocator>::insert(
+template <class T, class Allocator, size_t BufSiz>
+typename deque<T, Allocator, BufSiz>::iterator deque<T, Allocator, BufSiz>::insert(
     iterator position, const_reference value) {
   if (position.current_ == begin().current_) {
     push_front(value);  // TO DO
@@ -670,9 +826,9 @@ typename deque<T, Allocator>::iterator deque<T, Allocator>::insert(
   }
 }
 
-template <class T, class Allocator>
+template <class T, class Allocator, size_t BufSiz>
 template <class... Args>
-typename deque<T, Allocator>::iterator deque<T, Allocator>::emplace(
+typename deque<T, Allocator, BufSiz>::iterator deque<T, Allocator, BufSiz>::emplace(
     iterator position, Args&&... args) {
   if (position.current_ == start_.current_) {
     emplace_front(toystl::forward<Args>(args)...);
@@ -684,8 +840,8 @@ typename deque<T, Allocator>::iterator deque<T, Allocator>::emplace(
   return insert_aux(position, toystl::forward<Args>(args)...);
 }
 
-template <class T, class Allocator>
-typename deque<T, Allocator>::iterator deque<T, Allocator>::erase(
+template <class T, class Allocator, size_t BufSiz>
+typename deque<T, Allocator, BufSiz>::iterator deque<T, Allocator, BufSiz>::erase(
     iterator position) {
   iterator next = position;
   ++next;
@@ -703,8 +859,8 @@ typename deque<T, Allocator>::iterator deque<T, Allocator>::erase(
   return start_ + elems_before;
 }
 
-template <class T, class Allocator>
-typename deque<T, Allocator>::iterator deque<T, Allocator>::erase(
+template <class T, class Allocator, size_t BufSiz>
+typename deque<T, Allocator, BufSiz>::iterator deque<T, Allocator, BufSiz>::erase(
     iterator first, iterator last) {
   if (first == begin() && last == end()) {  // 如果清除区间就是整个 deque
     clear();                                // 直接调用 clear 就行
@@ -738,8 +894,8 @@ typename deque<T, Allocator>::iterator deque<T, Allocator>::erase(
   }
 }
 
-template <class T, class Allocator>
-void deque<T, Allocator>::push_back(const value_type& value) {
+template <class T, class Allocator, size_t BufSiz>
+void deque<T, Allocator, BufSiz>::push_back(const value_type& value) {
   if (finish_.current_ != finish_.last_ - 1) {
     // 最后缓冲区中尚有两个（含）以上的元素备用空间
     // 如果最后就剩下一个一个元素备用空间，那么就会引发新缓冲区的配置
@@ -755,9 +911,9 @@ void deque<T, Allocator>::push_back(const value_type& value) {
   }
 }
 
-template <class T, class Allocator>
+template <class T, class Allocator, size_t BufSiz>
 template <class... Args>
-void deque<T, Allocator>::emplace_back(Args&&... args) {
+void deque<T, Allocator, BufSiz>::emplace_back(Args&&... args) {
   if (finish_.current_ != finish_.last_ - 1) {
     node_allocator::construct(finish_.current_, toystl::forward<Args>(args)...);
     ++finish_.current_;
@@ -771,8 +927,8 @@ void deque<T, Allocator>::emplace_back(Args&&... args) {
   }
 }
 
-template <class T, class Allocator>
-void deque<T, Allocator>::pop_back() {
+template <class T, class Allocator, size_t BufSiz>
+void deque<T, Allocator, BufSiz>::pop_back() {
   if (finish_.current_ != finish_.first_) {
     // 最后缓冲区有一个或更多元素
     --finish_.current_;
@@ -786,8 +942,8 @@ void deque<T, Allocator>::pop_back() {
   }
 }
 
-template <class T, class Allocator>
-void deque<T, Allocator>::push_front(const_reference value) {
+template <class T, class Allocator, size_t BufSiz>
+void deque<T, Allocator, BufSiz>::push_front(const_reference value) {
   if (start_.current_ != start_.first_) {
     // 第一缓冲区中尚有备用空间
     node_allocator::construct(start_.current_ - 1, value);
@@ -802,9 +958,9 @@ void deque<T, Allocator>::push_front(const_reference value) {
   }
 }
 
-template <class T, class Allocator>
+template <class T, class Allocator, size_t BufSiz>
 template <class... Args>
-void deque<T, Allocator>::emplace_front(Args&&... args) {
+void deque<T, Allocator, BufSiz>::emplace_front(Args&&... args) {
   if (start_.current_ != start_.first_) {
     node_allocator::construct(start_.current_ - 1,
                               toystl::forward<Args>(args)...);
@@ -818,8 +974,8 @@ void deque<T, Allocator>::emplace_front(Args&&... args) {
   }
 }
 
-template <class T, class Allocator>
-void deque<T, Allocator>::pop_front() {
+template <class T, class Allocator, size_t BufSiz>
+void deque<T, Allocator, BufSiz>::pop_front() {
   if (start_.current_ != start_.last_ - 1) {
     // 第一缓冲区有两个（或更多）元素
     node_allocator::destroy(start_.current_);
@@ -835,8 +991,8 @@ void deque<T, Allocator>::pop_front() {
   }
 }
 
-template <class T, class Allocator>
-void deque<T, Allocator>::resize(size_type count, const_reference value) {
+template <class T, class Allocator, size_t BufSiz>
+void deque<T, Allocator, BufSiz>::resize(size_type count, const_reference value) {
   const auto len = size();
   if (count < len) {
     erase(begin() + count, end());
@@ -845,8 +1001,8 @@ void deque<T, Allocator>::resize(size_type count, const_reference value) {
   }
 }
 
-template <class T, class Allocator>
-void deque<T, Allocator>::fill_initialize(size_type count,
+template <class T, class Allocator, size_t BufSiz>
+void deque<T, Allocator, BufSiz>::fill_initialize(size_type count,
                                           const_reference value) {
   create_map_and_nodes(count);
   // 为每个节点的缓冲区设定初值
@@ -857,21 +1013,20 @@ void deque<T, Allocator>::fill_initialize(size_type count,
   toystl::uninitialized_fill(finish_.first_, finish_.current_, value);
 }
 
-template <class T, class Allocator>
+template <class T, class Allocator, size_t BufSiz>
 template <class InputIterator>
-void deque<T, Allocator>::copy_initialize(InputIterator first,
+void deque<T, Allocator, BufSiz>::copy_initialize(InputIterator first,
                                           InputIterator last,
                                           input_iterator_tag) {
-  const size_type n = toystl::distance(first, last);
-  create_map_and_nodes(n);
+  create_map_and_nodes();
   for (; first != last; ++first) {
     emplace_back(*first);
   }
 }
 
-template <class T, class Allocator>
+template <class T, class Allocator, size_t BufSiz>
 template <class ForwardIterator>
-void deque<T, Allocator>::copy_initialize(ForwardIterator first,
+void deque<T, Allocator, BufSiz>::copy_initialize(ForwardIterator first,
                                           ForwardIterator last,
                                           forward_iterator_tag) {
   size_type n = distance(first, last);
@@ -887,8 +1042,8 @@ void deque<T, Allocator>::copy_initialize(ForwardIterator first,
   toystl::uninitialized_copy(first, last, finish_.first_);
 }
 
-template <class T, class Allocator>
-void deque<T, Allocator>::fill_assign(size_type n, const value_type& value) {
+template <class T, class Allocator, size_t BufSiz>
+void deque<T, Allocator, BufSiz>::fill_assign(size_type n, const value_type& value) {
   if (n > size()) {
     // 如果赋值的 deque 的大小大于原 deque 的大小
     toystl::fill(begin(), end(), value);  // TO DO
@@ -899,9 +1054,9 @@ void deque<T, Allocator>::fill_assign(size_type n, const value_type& value) {
   }
 }
 
-template <class T, class Allocator>
+template <class T, class Allocator, size_t BufSiz>
 template <class InputIterator>
-void deque<T, Allocator>::copy_assign(InputIterator first, InputIterator last,
+void deque<T, Allocator, BufSiz>::copy_assign(InputIterator first, InputIterator last,
                                       input_iterator_tag) {
   auto first1 = begin();
   auto last1 = end();
@@ -915,9 +1070,9 @@ void deque<T, Allocator>::copy_assign(InputIterator first, InputIterator last,
   }
 }
 
-template <class T, class Allocator>
+template <class T, class Allocator, size_t BufSiz>
 template <class ForwardIterator>
-void deque<T, Allocator>::copy_assign(ForwardIterator first,
+void deque<T, Allocator, BufSiz>::copy_assign(ForwardIterator first,
                                       ForwardIterator last,
                                       forward_iterator_tag) {
   const size_type len1 = size();
@@ -932,8 +1087,8 @@ void deque<T, Allocator>::copy_assign(ForwardIterator first,
   }
 }
 
-template <class T, class Allocator>
-void deque<T, Allocator>::fill_insert(iterator pos, size_type n,
+template <class T, class Allocator, size_t BufSiz>
+void deque<T, Allocator, BufSiz>::fill_insert(iterator pos, size_type n,
                                       const_reference value) {
   if (pos.current_ == start_.current_) {
     iterator new_start = reserve_elements_at_front(n);
@@ -948,8 +1103,8 @@ void deque<T, Allocator>::fill_insert(iterator pos, size_type n,
   }
 }
 
-template <class T, class Allocator>
-void deque<T, Allocator>::create_map_and_nodes(size_type numElements) {
+template <class T, class Allocator, size_t BufSiz>
+void deque<T, Allocator, BufSiz>::create_map_and_nodes(size_type numElements) {
   // 缓冲区个数 = (元素个数 / 每个缓冲区的容量) + 1
   size_type numNodes = numElements / deque_buf_size() + 1;
   // 一个 map 最多要管理几个节点。最少是 8 个，最多是 会多配置两个缓冲区
@@ -977,12 +1132,13 @@ void deque<T, Allocator>::create_map_and_nodes(size_type numElements) {
   map_pointer cur;
   try {
     for (cur = nStart; cur <= nFinish; ++cur) {
-      *cur = node_allocator::allocate(deque_buf_size());
+      *cur = allocate_node();
     }
   } catch (...) {
+    // 可能在构造函数中，析构函数不会运行，直接归还给分配器
     while (cur != nStart) {
       --cur;
-      node_allocator::deallocate(*cur, deque_buf_size());
+      release_node(*cur);
       *cur = nullptr;
     }
     throw;
@@ -997,13 +1153,13 @@ void deque<T, Allocator>::create_map_and_nodes(size_type numElements) {
   finish_.current_ = finish_.first_ + numElements % deque_buf_size();
 }
 
-template <class T, class Allocator>
-T** deque<T, Allocator>::allocate_map() {
+template <class T, class Allocator, size_t BufSiz>
+T** deque<T, Allocator, BufSiz>::allocate_map() {
   // 在此基础上将各个指针置为 nullptr
   // return map_allocator::allocate(mapSize_);
 
   map_pointer mp = nullptr;
-  mp = map_allocator::allocate(mapSize_);
+  mp = map_allocator(this->get_alloc()).allocate(mapSize_);
   for (size_type i = 0; i < mapSize_; ++i) {
     *(mp + i) = nullptr;
   }
@@ -1011,9 +1167,9 @@ T** deque<T, Allocator>::allocate_map() {
   return mp;
 }
 
-template <class T, class Allocator>
-typename deque<T, Allocator>::iterator
-deque<T, Allocator>::reserve_elements_at_front(size_type n) {
+template <class T, class Allocator, size_t BufSiz>
+typename deque<T, Allocator, BufSiz>::iterator
+deque<T, Allocator, BufSiz>::reserve_elements_at_front(size_type n) {
   // 当前缓冲区剩下的位置个数
   size_type nBefore = start_.current_ - start_.first_;
   if (n > nBefore) {
@@ -1024,9 +1180,9 @@ deque<T, Allocator>::reserve_elements_at_front(size_type n) {
   return start_ - difference_type(n);
 }
 
-template <class T, class Allocator>
-typename deque<T, Allocator>::iterator
-deque<T, Allocator>::reserve_elements_at_back(size_type n) {
+template <class T, class Allocator, size_t BufSiz>
+typename deque<T, Allocator, BufSiz>::iterator
+deque<T, Allocator, BufSiz>::reserve_elements_at_back(size_type n) {
   size_type nAfter = finish_.last_ - finish_.current_ - 1;
   if (n > nAfter) {
     // 空间不够，需要分配新的缓冲区
@@ -1036,8 +1192,8 @@ deque<T, Allocator>::reserve_elements_at_back(size_type n) {
   return finish_ + difference_type(n);
 }
 
-template <class T, class Allocator>
-void deque<T, Allocator>::reserve_map_at_front(size_type n) {
+template <class T, class Allocator, size_t BufSiz>
+void deque<T, Allocator, BufSiz>::reserve_map_at_front(size_type n) {
   // 如果 map 前端的节点备用空间不足
   if (n > static_cast<size_type>(start_.node_ - map_)) {
     // 符合以上条件则必须重换一个 map（配置更大的，拷贝原来的，释放原来的）
@@ -1045,8 +1201,8 @@ void deque<T, Allocator>::reserve_map_at_front(size_type n) {
   }
 }
 
-template <class T, class Allocator>
-void deque<T, Allocator>::reserve_map_at_back(size_type n) {
+template <class T, class Allocator, size_t BufSiz>
+void deque<T, Allocator, BufSiz>::reserve_map_at_back(size_type n) {
   // 如果 map 后端的节点备用空间不足
   if (n > mapSize_ - (finish_.node_ - map_ + 1)) {
     // 符合以上条件则必须重换一个 map（配置更大的，拷贝原来的，释放原来的）
@@ -1054,8 +1210,8 @@ void deque<T, Allocator>::reserve_map_at_back(size_type n) {
   }
 }
 
-template <class T, class Allocator>
-void deque<T, Allocator>::reallocate_map(size_type nodesToAdd,
+template <class T, class Allocator, size_t BufSiz>
+void deque<T, Allocator, BufSiz>::reallocate_map(size_type nodesToAdd,
                                          bool addToFront) {
   size_type oldNumNodes = finish_.node_ - start_.node_ + 1;  // 原缓冲区的个数
   size_type newNumNodes = oldNumNodes + nodesToAdd;  // 新缓冲区的个数
@@ -1075,13 +1231,14 @@ void deque<T, Allocator>::reallocate_map(size_type nodesToAdd,
     }
   } else {  // 如果增加缓冲区后的个数的 2 倍大于等于
             // mapSize_，则需要重新配置空间。此时，会导致所有迭代器失效。
-    size_type newMapSize_ = mapSize_ + toystl::max(mapSize_, nodesToAdd) + 2;
-    mapSize_ = newMapSize_;
+    // 旧 map 必须按原来的大小归还
+    const size_type oldMapSize = mapSize_;
+    mapSize_ = mapSize_ + toystl::max(mapSize_, nodesToAdd) + 2;
     auto newMap = allocate_map();
     newStart =
         newMap + (mapSize_ - newNumNodes) / 2 + (addToFront ? nodesToAdd : 0);
     toystl::copy(start_.node_, finish_.node_ + 1, newStart);
-    deallocate_map();
+    map_allocator(this->get_alloc()).deallocate(map_, oldMapSize);
     map_ = newMap;
   }
 
@@ -1090,9 +1247,9 @@ void deque<T, Allocator>::reallocate_map(size_type nodesToAdd,
   finish_.set_node(newStart + oldNumNodes - 1);
 }
 
-template <class T, class Allocator>
+template <class T, class Allocator, size_t BufSiz>
 template <class... Args>
-typename deque<T, Allocator>::iterator deque<T, Allocator>::insert_aux(
+typename deque<T, Allocator, BufSiz>::iterator deque<T, Allocator, BufSiz>::insert_aux(
     iterator position, Args&&... args) {
   const size_type elems_before = position - start_;
   value_type value_copy = value_type(toystl::forward<Args>(args)...);
@@ -1121,8 +1278,8 @@ typename deque<T, Allocator>::iterator deque<T, Allocator>::insert_aux(
   return position;
 }
 
-template <class T, class Allocator>
-void deque<T, Allocator>::insert_aux(iterator position, size_type count,
+template <class T, class Allocator, size_t BufSiz>
+void deque<T, Allocator, BufSiz>::insert_aux(iterator position, size_type count,
                                      const value_type& value) {
   const difference_type elems_before = position - start_;
   size_type len = size();
@@ -1169,8 +1326,8 @@ void deque<T, Allocator>::insert_aux(iterator position, size_type count,
   }
 }
 
-template <class T, class Allocator>
-void deque<T, Allocator>::insert_aux(iterator position, iterator first,
+template <class T, class Allocator, size_t BufSiz>
+void deque<T, Allocator, BufSiz>::insert_aux(iterator position, iterator first,
                                      iterator last, size_type n) {
   const difference_type elems_before = position - start_;
   size_type len = size();
@@ -1216,9 +1373,9 @@ void deque<T, Allocator>::insert_aux(iterator position, iterator first,
   }
 }
 
-template <class T, class Allocator>
+template <class T, class Allocator, size_t BufSiz>
 template <class FIter>
-void deque<T, Allocator>::insert_dispatch(iterator position, FIter first,
+void deque<T, Allocator, BufSiz>::insert_dispatch(iterator position, FIter first,
                                           FIter last, forward_iterator_tag) {
   size_type n = static_cast<size_type>(toystl::distance(first, last));
   if (position.current_ == start_.current_) {
@@ -1246,8 +1403,8 @@ void deque<T, Allocator>::insert_dispatch(iterator position, FIter first,
 //     insert(position, first, last, iterator_category(first));
 // }
 
-template <class T, class Allocator>
-void deque<T, Allocator>::new_elements_at_front(size_type new_elems) {
+template <class T, class Allocator, size_t BufSiz>
+void deque<T, Allocator, BufSiz>::new_elements_at_front(size_type new_elems) {
   size_type new_nodes = (new_elems + deque_buf_size() - 1) / deque_buf_size();
   reserve_map_at_front(new_nodes);
   size_type i;
@@ -1263,8 +1420,8 @@ void deque<T, Allocator>::new_elements_at_front(size_type new_elems) {
   }
 }
 
-template <class T, class Allocator>
-void deque<T, Allocator>::new_elements_at_back(size_type new_elems) {
+template <class T, class Allocator, size_t BufSiz>
+void deque<T, Allocator, BufSiz>::new_elements_at_back(size_type new_elems) {
   size_type new_nodes = (new_elems + deque_buf_size() - 1) / deque_buf_size();
   reserve_map_at_back(new_nodes);
   size_type i;
@@ -1280,47 +1437,48 @@ void deque<T, Allocator>::new_elements_at_back(size_type new_elems) {
   }
 }
 
-template <class T, class Allocator>
-bool operator==(const deque<T, Allocator>& left,
-                const deque<T, Allocator>& right) {
+template <class T, class Allocator, size_t BufSiz>
+bool operator==(const deque<T, Allocator, BufSiz>& left,
+                const deque<T, Allocator, BufSiz>& right) {
   return left.size() == right.size() &&
          toystl::equal(left.cbegin(), left.cend(), right.cbegin());
 }
 
-template <class T, class Allocator>
-bool operator!=(const deque<T, Allocator>& left,
-                const deque<T, Allocator>& right) {
+template <class T, class Allocator, size_t BufSiz>
+bool operator!=(const deque<T, Allocator, BufSiz>& left,
+                const deque<T, Allocator, BufSiz>& right) {
   return !(left == right);
 }
 
-template <class T, class Allocator>
-bool operator<(const deque<T, Allocator>& left,
-               const deque<T, Allocator>& right) {
+template <class T, class Allocator, size_t BufSiz>
+bool operator<(const deque<T, Allocator, BufSiz>& left,
+               const deque<T, Allocator, BufSiz>& right) {
   return toystl::lexicographical_compare(left.cbegin(), left.cend(),
                                          right.cbegin(), right.cend());
 }
 
-template <class T, class Allocator>
-bool operator<=(const deque<T, Allocator>& left,
-                const deque<T, Allocator>& right) {
+template <class T, class Allocator, size_t BufSiz>
+bool operator<=(const deque<T, Allocator, BufSiz>& left,
+                const deque<T, Allocator, BufSiz>& right) {
   return !(right < left);
 }
 
-template <class T, class Allocator>
-bool operator>(const deque<T, Allocator>& left,
-               const deque<T, Allocator>& right) {
+template <class T, class Allocator, size_t BufSiz>
+bool operator>(const deque<T, Allocator, BufSiz>& left,
+               const deque<T, Allocator, BufSiz>& right) {
   return right < left;
 }
 
-template <class T, class Allocator>
-bool operator>=(const deque<T, Allocator>& left,
-                const deque<T, Allocator>& right) {
+template <class T, class Allocator, size_t BufSiz>
+bool operator>=(const deque<T, Allocator, BufSiz>& left,
+                const deque<T, Allocator, BufSiz>& right) {
   return !(right > left);
 }
 
 /* 特化 std::swap 算法 */
-template <class T, class Allocator>
-void swap(const deque<T, Allocator>& left, const deque<T, Allocator>& right) {
+template <class T, class Allocator, size_t BufSiz>
+void swap(deque<T, Allocator, BufSiz>& left,
+          deque<T, Allocator, BufSiz>& right) {
   left.swap(right);
 }
 }  // namespace toystl
@@ -0,0 +1,809 @@
+#ifndef TOYSTL_SRC_FLAT_HASHTABLE_H_
+#define TOYSTL_SRC_FLAT_HASHTABLE_H_
+
+#include <stdint.h>
+#include <string.h>  // memset, memcpy
+
+#include <tuple>  // std::forward_as_tuple
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "allocator.h"
+#include "construct.h"
+#include "hash_fun.h"
+#include "iterator_base.h"
+#include "utility.h"
+
+namespace toystl {
+namespace flat_detail {
+// 每个槽对应一个控制字节：
+//   kEmpty    空槽，探测到这里即可停止
+//   kDeleted  墓碑，被删除的元素留下的，探测需要越过它继续
+//   kSentinel 控制字节数组末尾的哨兵，迭代器遍历到这里停止
+//   0 ~ 127   槽已被占用，值为元素哈希值的低 7 位（H2）
+using ctrl_t = signed char;
+
+const ctrl_t kEmpty = -128;
+const ctrl_t kDeleted = -2;
+const ctrl_t kSentinel = -1;
+
+// 一次比较一组控制字节
+const std::size_t kGroupWidth = 16;
+
+// 容量为 0 的表共用的控制字节，只有一个哨兵
+inline ctrl_t* empty_ctrl() {
+  static ctrl_t sentinel = kSentinel;
+  return &sentinel;
+}
+
+// 最低位的 1 的下标，mask 不能为 0
+inline unsigned lowest_bit(uint32_t mask) {
+#if defined(__GNUC__)
+  return static_cast<unsigned>(__builtin_ctz(mask));
+#else
+  unsigned n = 0;
+  while ((mask & 1) == 0) {
+    mask >>= 1;
+    ++n;
+  }
+  return n;
+#endif
+}
+
+// 一组 kGroupWidth 个控制字节，match 系列函数返回位掩码，
+// 第 i 位为 1 表示组内第 i 个槽满足条件。
+// 有 SSE2 时一条指令比较 16 个字节，否则逐字节比较
+class group {
+ public:
+#if defined(__SSE2__)
+  explicit group(const ctrl_t* pos)
+      : ctrl_(_mm_loadu_si128(reinterpret_cast<const __m128i*>(pos))) {}
+
+  uint32_t match(ctrl_t h2) const {
+    return static_cast<uint32_t>(
+        _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(h2), ctrl_)));
+  }
+
+  // kEmpty 和 kDeleted 都小于 kSentinel，被占用的槽都大于它
+  uint32_t match_empty_or_deleted() const {
+    return static_cast<uint32_t>(
+        _mm_movemask_epi8(_mm_cmpgt_epi8(_mm_set1_epi8(kSentinel), ctrl_)));
+  }
+
+ private:
+  __m128i ctrl_;
+#else
+  explicit group(const ctrl_t* pos) { memcpy(ctrl_, pos, kGroupWidth); }
+
+  uint32_t match(ctrl_t h2) const {
+    uint32_t mask = 0;
+    for (std::size_t i = 0; i != kGroupWidth; ++i) {
+      if (ctrl_[i] == h2) {
+        mask |= 1u << i;
+      }
+    }
+    return mask;
+  }
+
+  uint32_t match_empty_or_deleted() const {
+    uint32_t mask = 0;
+    for (std::size_t i = 0; i != kGroupWidth; ++i) {
+      if (ctrl_[i] < kSentinel) {
+        mask |= 1u << i;
+      }
+    }
+    return mask;
+  }
+
+ private:
+  ctrl_t ctrl_[kGroupWidth];
+#endif
+
+ public:
+  uint32_t match_empty() const { return match(kEmpty); }
+};
+
+// toystl::hash 对整数是恒等映射，低位和高位都需要足够随机：
+// 用乘法散列把各位的信息混合到一起
+inline std::size_t mix_hash(std::size_t h) {
+  uint64_t x = static_cast<uint64_t>(h) * 0x9E3779B97F4A7C15ull;
+  return static_cast<std::size_t>(x ^ (x >> 32));
+}
+
+// 高位决定从哪一组开始探测，低 7 位存进控制字节
+inline std::size_t h1(std::size_t hash) { return hash >> 7; }
+inline ctrl_t h2(std::size_t hash) { return static_cast<ctrl_t>(hash & 0x7F); }
+}  // namespace flat_detail
+
+template <class Value, class Ref, class Ptr>
+struct flat_hashtable_iterator {
+  using iterator_category = forward_iterator_tag;
+  using value_type = Value;
+  using pointer = Ptr;
+  using reference = Ref;
+  using difference_type = std::ptrdiff_t;
+
+  using iterator = flat_hashtable_iterator<Value, Value&, Value*>;
+  using const_iterator =
+      flat_hashtable_iterator<Value, const Value&, const Value*>;
+  using self = flat_hashtable_iterator<Value, Ref, Ptr>;
+
+  const flat_detail::ctrl_t* ctrl_;  // 当前槽的控制字节
+  Value* slot_;                      // 当前槽
+
+  flat_hashtable_iterator() : ctrl_(nullptr), slot_(nullptr) {}
+
+  flat_hashtable_iterator(const flat_detail::ctrl_t* ctrl, Value* slot)
+      : ctrl_(ctrl), slot_(slot) {}
+
+  flat_hashtable_iterator(const iterator& it)
+      : ctrl_(it.ctrl_), slot_(it.slot_) {}
+
+  reference operator*() const { return *slot_; }
+
+  pointer operator->() const { return &(operator*()); }
+
+  self& operator++() {
+    ++ctrl_;
+    ++slot_;
+    skip_empty_slots();
+    return *this;
+  }
+
+  self operator++(int) {
+    self tmp = *this;
+    ++*this;
+    return tmp;
+  }
+
+  // 跳过空槽和墓碑，末尾的哨兵保证循环会停下
+  void skip_empty_slots() {
+    while (*ctrl_ < flat_detail::kSentinel) {
+      ++ctrl_;
+      ++slot_;
+    }
+  }
+
+  bool operator==(const self& rhs) const { return ctrl_ == rhs.ctrl_; }
+
+  bool operator!=(const self& rhs) const { return ctrl_ != rhs.ctrl_; }
+};
+
+// 开放寻址的哈希表，键值不允许重复
+// 元素直接存放在一块连续的槽数组中，另有一个控制字节数组记录每个槽的状态和
+// 哈希值的低 7 位。查找时按组（16 个槽）探测，先用控制字节一次筛出候选槽，
+// 再比较键值；组内有空槽就说明键值不存在。容量总是 2 的幂，
+// 组之间按三角数序列探测，负载因子不超过 7/8。
+// 与 hashtable 不同，插入导致扩容时所有的迭代器、指针和引用都会失效。
+// 模板参数的含义与 hashtable 相同
+template <class Key, class Value, class HashFcn, class ExtractKey,
+          class EqualKey, class Allocator = toystl::allocator<Value>>
+class flat_hashtable : private allocator_holder<Allocator> {
+ public:
+  using key_type = Key;
+  using value_type = Value;
+  using hasher = HashFcn;
+  using key_equal = EqualKey;
+
+  using size_type = std::size_t;
+  using difference_type = std::ptrdiff_t;
+  using reference = value_type&;
+  using const_reference = const value_type&;
+  using pointer = value_type*;
+  using const_pointer = const value_type*;
+
+  using iterator = flat_hashtable_iterator<Value, Value&, Value*>;
+  using const_iterator =
+      flat_hashtable_iterator<Value, const Value&, const Value*>;
+
+  using allocator_type = Allocator;
+  using data_allocator = Allocator;
+
+  allocator_type get_allocator() const { return this->get_alloc(); }
+
+ private:
+  using ctrl_t = flat_detail::ctrl_t;
+  using ctrl_allocator = typename Allocator::template rebind<ctrl_t>::other;
+  using slot_allocator = typename Allocator::template rebind<Value>::other;
+  using alloc_base = allocator_holder<Allocator>;
+
+  hasher hash_;
+  key_equal equals_;
+  ExtractKey getkey_;
+  ctrl_t* ctrl_;           // capacity_ + 1 个控制字节，最后一个是哨兵
+  value_type* slots_;      // capacity_ 个槽
+  size_type capacity_;     // 0 或者不小于 kGroupWidth 的 2 的幂
+  size_type size_;         // 元素个数
+  size_type growth_left_;  // 不扩容时还能占用的空槽个数
+
+ public:
+  // 构造、赋值、移动、析构函数
+  flat_hashtable(size_type n, const HashFcn& hash, const EqualKey& equals,
+                 const ExtractKey& getkey,
+                 const allocator_type& a = allocator_type())
+      : alloc_base(a), hash_(hash), equals_(equals), getkey_(getkey) {
+    reset_empty();
+    resize(n);
+  }
+
+  flat_hashtable(size_type n, const HashFcn& hash, const EqualKey& equals,
+                 const allocator_type& a = allocator_type())
+      : flat_hashtable(n, hash, equals, ExtractKey(), a) {}
+
+  flat_hashtable(const flat_hashtable& other)
+      : flat_hashtable(
+            other, other.get_alloc().select_on_container_copy_construction()) {
+  }
+
+  flat_hashtable(const flat_hashtable& other, const allocator_type& a)
+      : alloc_base(a),
+        hash_(other.hash_),
+        equals_(other.equals_),
+        getkey_(other.getkey_) {
+    reset_empty();
+    copy_from(other);
+  }
+
+  flat_hashtable(flat_hashtable&& other) noexcept
+      : alloc_base(other.get_alloc()),
+        hash_(other.hash_),
+        equals_(other.equals_),
+        getkey_(other.getkey_),
+        ctrl_(other.ctrl_),
+        slots_(other.slots_),
+        capacity_(other.capacity_),
+        size_(other.size_),
+        growth_left_(other.growth_left_) {
+    other.reset_empty();
+  }
+
+  flat_hashtable& operator=(const flat_hashtable& other) {
+    if (&other != this) {
+      clear();
+      copy_assign_alloc(
+          other,
+          typename allocator_type::propagate_on_container_copy_assignment());
+      hash_ = other.hash_;
+      equals_ = other.equals_;
+      getkey_ = other.getkey_;
+      copy_from(other);
+    }
+    return *this;
+  }
+
+  flat_hashtable& operator=(flat_hashtable&& other) noexcept(
+      allocator_nothrow_move_assign<Allocator>::value) {
+    if (&other != this) {
+      move_assign(
+          other,
+          typename allocator_type::propagate_on_container_move_assignment());
+    }
+    return *this;
+  }
+
+  ~flat_hashtable() { destroy_and_deallocate(); }
+
+  // 迭代器相关操作
+  iterator begin() {
+    iterator it(ctrl_, slots_);
+    it.skip_empty_slots();
+    return it;
+  }
+
+  const_iterator begin() const { return cbegin(); }
+
+  iterator end() { return iterator(ctrl_ + capacity_, slots_ + capacity_); }
+
+  const_iterator end() const { return cend(); }
+
+  const_iterator cbegin() const {
+    return const_cast<flat_hashtable*>(this)->begin();
+  }
+
+  const_iterator cend() const {
+    return const_cast<flat_hashtable*>(this)->end();
+  }
+
+  // 容量相关操作
+  bool empty() const { return size_ == 0; }
+  size_type size() const { return size_; }
+  size_type max_size() const { return size_type(-1) / sizeof(value_type); }
+
+  // 修改容器相关操作
+  toystl::pair<iterator, bool> insert_unique(const value_type& value);
+
+  template <class InputIterator>
+  void insert_unique(InputIterator first, InputIterator last) {
+    insert_unique(first, last, iterator_category(first));
+  }
+
+  template <class InputIterator>
+  void insert_unique(InputIterator first, InputIterator last,
+                     input_iterator_tag) {
+    for (; first != last; ++first) {
+      insert_unique(*first);
+    }
+  }
+
+  template <class ForwardIterator>
+  void insert_unique(ForwardIterator first, ForwardIterator last,
+                     forward_iterator_tag) {
+    resize(size_ + static_cast<size_type>(toystl::distance(first, last)));
+    for (; first != last; ++first) {
+      insert_unique(*first);
+    }
+  }
+
+  // 不存在时插入 obj，返回键值对应的元素
+  reference find_or_insert(const value_type& obj) {
+    return *insert_unique(obj).first;
+  }
+
+  // 只用于 flat_unordered_map：先以 key 查找，键值不存在时才构造元素，
+  // 实值由 args 构造。键值已存在时 args 不会被移动
+  template <class K, class... Args>
+  toystl::pair<iterator, bool> try_emplace_unique(K&& key, Args&&... args);
+
+  size_type erase(const key_type& key);
+  void erase(const iterator& it) { erase_at(it.slot_ - slots_); }
+  void erase(const const_iterator& it) { erase_at(it.slot_ - slots_); }
+  void erase(iterator first, iterator last);
+  void erase(const_iterator first, const_iterator last) {
+    erase(iterator(first.ctrl_, const_cast<value_type*>(first.slot_)),
+          iterator(last.ctrl_, const_cast<value_type*>(last.slot_)));
+  }
+
+  void clear();
+
+  void swap(flat_hashtable& other);
+
+  // 保证容纳 num_elements_hint 个元素时不需要扩容
+  void resize(size_type num_elements_hint);
+
+  // 查找相关操作
+  iterator find(const key_type& key) {
+    const size_type i = find_index(key);
+    return iterator(ctrl_ + i, slots_ + i);
+  }
+
+  const_iterator find(const key_type& key) const {
+    return const_cast<flat_hashtable*>(this)->find(key);
+  }
+
+  size_type count(const key_type& key) const {
+    return find_index(key) != capacity_ ? 1 : 0;
+  }
+
+  pair<iterator, iterator> equal_range(const key_type& key) {
+    iterator first = find(key);
+    iterator last = first;
+    if (first != end()) {
+      ++last;
+    }
+    return pair<iterator, iterator>(first, last);
+  }
+
+  pair<const_iterator, const_iterator> equal_range(const key_type& key) const {
+    auto range = const_cast<flat_hashtable*>(this)->equal_range(key);
+    return pair<const_iterator, const_iterator>(range.first, range.second);
+  }
+
+  // 槽相关操作，每个槽最多保存一个元素
+  size_type bucket_count() const { return capacity_; }
+
+  size_type max_bucket_count() const {
+    return size_type(-1) / sizeof(value_type);
+  }
+
+  size_type elems_in_bucket(size_type n) const {
+    return ctrl_[n] >= 0 ? 1 : 0;
+  }
+
+  float load_factor() const {
+    return capacity_ == 0 ? 0.0f : static_cast<float>(size_) / capacity_;
+  }
+
+  hasher hash_fcn() const { return hash_; }
+  key_equal key_eq() const { return equals_; }
+
+  template <class K, class V, class H, class Ex, class Eq, class A>
+  friend bool operator==(const flat_hashtable<K, V, H, Ex, Eq, A>&,
+                         const flat_hashtable<K, V, H, Ex, Eq, A>&);
+
+ private:
+  // 容量为 cap 时最多容纳的元素个数
+  static size_type max_load(size_type cap) { return cap - cap / 8; }
+
+  size_type hash_key(const key_type& key) const {
+    return flat_detail::mix_hash(hash_(key));
+  }
+
+  void reset_empty() {
+    ctrl_ = flat_detail::empty_ctrl();
+    slots_ = nullptr;
+    capacity_ = 0;
+    size_ = 0;
+    growth_left_ = 0;
+  }
+
+  void set_ctrl(size_type i, ctrl_t c) { ctrl_[i] = c; }
+
+  // 返回 key 所在槽的下标，不存在时返回 capacity_
+  size_type find_index(const key_type& key) const;
+
+  // 返回探测序列上第一个空槽或墓碑的下标，调用前必须保证存在空槽
+  size_type find_first_non_full(size_type hash) const;
+
+  // 为哈希值为 hash 的新元素找到一个槽并设置控制字节，必要时先扩容
+  size_type prepare_insert(size_type hash);
+
+  // 把所有元素搬到容量为 new_capacity 的新数组中，同时清除墓碑
+  void rehash(size_type new_capacity);
+
+  void erase_at(size_type i);
+
+  void destroy_and_deallocate();
+
+  void copy_from(const flat_hashtable& other);
+
+  // 分配器需要传播时，如果两个分配器不相等，旧数组必须由原分配器释放
+  void copy_assign_alloc(const flat_hashtable& other, true_type) {
+    if (this->get_alloc() != other.get_alloc()) {
+      destroy_and_deallocate();
+      reset_empty();
+    }
+    this->set_alloc(other.get_alloc());
+  }
+
+  void copy_assign_alloc(const flat_hashtable&, false_type) {}
+
+  void move_assign(flat_hashtable& other, true_type) {
+    destroy_and_deallocate();
+    this->set_alloc(other.get_alloc());
+    hash_ = other.hash_;
+    equals_ = other.equals_;
+    getkey_ = other.getkey_;
+    ctrl_ = other.ctrl_;
+    slots_ = other.slots_;
+    capacity_ = other.capacity_;
+    size_ = other.size_;
+    growth_left_ = other.growth_left_;
+    other.reset_empty();
+  }
+
+  void move_assign(flat_hashtable& other, false_type) {
+    if (this->get_alloc() == other.get_alloc()) {
+      move_assign(other, true_type());
+    } else {
+      *this = other;
+      other.clear();
+    }
+  }
+};
+
+template <class Key, class Value, class HashFcn, class ExtractKey,
+          class EqualKey, class Allocator>
+bool operator==(
+    const flat_hashtable<Key, Value, HashFcn, ExtractKey, EqualKey, Allocator>&
+        ht1,
+    const flat_hashtable<Key, Value, HashFcn, ExtractKey, EqualKey, Allocator>&
+        ht2) {
+  if (ht1.size() != ht2.size()) {
+    return false;
+  }
+  for (auto it = ht1.begin(); it != ht1.end(); ++it) {
+    auto other = ht2.find(ht1.getkey_(*it));
+    if (other == ht2.end() || !(*other == *it)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+template <class Key, class Value, class HashFcn, class ExtractKey,
+          class EqualKey, class Allocator>
+void swap(
+    flat_hashtable<Key, Value, HashFcn, ExtractKey, EqualKey, Allocator>& ht1,
+    flat_hashtable<Key, Value, HashFcn, ExtractKey, EqualKey, Allocator>&
+        ht2) {
+  ht1.swap(ht2);
+}
+
+template <class Key, class Value, class HashFcn, class ExtractKey,
+          class EqualKey, class Allocator>
+typename flat_hashtable<Key, Value, HashFcn, ExtractKey, EqualKey,
+                        Allocator>::size_type
+flat_hashtable<Key, Value, HashFcn, ExtractKey, EqualKey,
+               Allocator>::find_index(const key_type& key) const {
+  if (capacity_ == 0) {
+    return 0;
+  }
+  const size_type hash = hash_key(key);
+  const ctrl_t tag = flat_detail::h2(hash);
+  const size_type mask = capacity_ / flat_detail::kGroupWidth - 1;
+  size_type g = flat_detail::h1(hash) & mask;
+  for (size_type step = 1;; ++step) {
+    const size_type base = g * flat_detail::kGroupWidth;
+    flat_detail::group grp(ctrl_ + base);
+    for (uint32_t m = grp.match(tag); m != 0; m &= m - 1) {
+      const size_type i = base + flat_detail::lowest_bit(m);
+      if (equals_(getkey_(slots_[i]), key)) {
+        return i;
+      }
+    }
+    if (grp.match_empty() != 0) {
+      return capacity_;
+    }
+    // 三角数序列，组数为 2 的幂时可以遍历所有的组
+    g = (g + step) & mask;
+  }
+}
+
+template <class Key, class Value, class HashFcn, class ExtractKey,
+          class EqualKey, class Allocator>
+typename flat_hashtable<Key, Value, HashFcn, ExtractKey, EqualKey,
+                        Allocator>::size_type
+flat_hashtable<Key, Value, HashFcn, ExtractKey, EqualKey,
+               Allocator>::find_first_non_full(size_type hash) const {
+  const size_type mask = capacity_ / flat_detail::kGroupWidth - 1;
+  size_type g = flat_detail::h1(hash) & mask;
+  for (size_type step = 1;; ++step) {
+    const size_type base = g * flat_detail::kGroupWidth;
+    uint32_t m = flat_detail::group(ctrl_ + base).match_empty_or_deleted();
+    if (m != 0) {
+      return base + flat_detail::lowest_bit(m);
+    }
+    g = (g + step) & mask;
+  }
+}
+
+template <class Key, class Value, class HashFcn, class ExtractKey,
+          class EqualKey, class Allocator>
+typename flat_hashtable<Key, Value, HashFcn, ExtractKey, EqualKey,
+                        Allocator>::size_type
+flat_hashtable<Key, Value, HashFcn, ExtractKey, EqualKey,
+               Allocator>::prepare_insert(size_type hash) {
+  if (growth_left_ == 0) {
+    if (capacity_ == 0) {
+      rehash(flat_detail::kGroupWidth);
+    } else if (size_ < max_load(capacity_) / 2) {
+      // 墓碑太多，原地重建即可
+      rehash(capacity_);
+    } else {
+      rehash(capacity_ * 2);
+    }
+  }
+  const size_type i = find_first_non_full(hash);
+  // 复用墓碑不会减少空槽
+  if (ctrl_[i] == flat_detail::kEmpty) {
+    --growth_left_;
+  }
+  set_ctrl(i, flat_detail::h2(hash));
+  return i;
+}
+
+template <class Key, class Value, class HashFcn, class ExtractKey,
+          class EqualKey, class Allocator>
+toystl::pair<typename flat_hashtable<Key, Value, HashFcn, ExtractKey,
+                                     EqualKey, Allocator>::iterator,
+             bool>
+flat_hashtable<Key, Value, HashFcn, ExtractKey, EqualKey,
+               Allocator>::insert_unique(const value_type& value) {
+  const key_type& key = getkey_(value);
+  size_type i = find_index(key);
+  if (i != capacity_) {
+    return toystl::pair<iterator, bool>(iterator(ctrl_ + i, slots_ + i),
+                                        false);
+  }
+  i = prepare_insert(hash_key(key));
+  try {
+    slot_allocator::construct(slots_ + i, value);
+  } catch (...) {
+    set_ctrl(i, flat_detail::kDeleted);
+    throw;
+  }
+  ++size_;
+  return toystl::pair<iterator, bool>(iterator(ctrl_ + i, slots_ + i), true);
+}
+
+template <class Key, class Value, class HashFcn, class ExtractKey,
+          class EqualKey, class Allocator>
+template <class K, class... Args>
+toystl::pair<typename flat_hashtable<Key, Value, HashFcn, ExtractKey,
+                                     EqualKey, Allocator>::iterator,
+             bool>
+flat_hashtable<Key, Value, HashFcn, ExtractKey, EqualKey,
+               Allocator>::try_emplace_unique(K&& key, Args&&... args) {
+  size_type i = find_index(key);
+  if (i != capacity_) {
+    return toystl::pair<iterator, bool>(iterator(ctrl_ + i, slots_ + i),
+                                        false);
+  }
+  i = prepare_insert(hash_key(key));
+  try {
+    slot_allocator::construct(
+        slots_ + i, piecewise_construct,
+        std::forward_as_tuple(toystl::forward<K>(key)),
+        std::forward_as_tuple(toystl::forward<Args>(args)...));
+  } catch (...) {
+    set_ctrl(i, flat_detail::kDeleted);
+    throw;
+  }
+  ++size_;
+  return toystl::pair<iterator, bool>(iterator(ctrl_ + i, slots_ + i), true);
+}
+
+template <class Key, class Value, class HashFcn, class ExtractKey,
+          class EqualKey, class Allocator>
+void flat_hashtable<Key, Value, HashFcn, ExtractKey, EqualKey,
+                    Allocator>::rehash(size_type new_capacity) {
+  ctrl_t* old_ctrl = ctrl_;
+  value_type* old_slots = slots_;
+  const size_type old_capacity = capacity_;
+
+  ctrl_t* new_ctrl = ctrl_allocator(this->get_alloc()).allocate(new_capacity +
+                                                                1);
+  value_type* new_slots = nullptr;
+  try {
+    new_slots = slot_allocator(this->get_alloc()).allocate(new_capacity);
+  } catch (...) {
+    ctrl_allocator(this->get_alloc()).deallocate(new_ctrl, new_capacity + 1);
+    throw;
+  }
+  memset(new_ctrl, flat_detail::kEmpty, new_capacity);
+  new_ctrl[new_capacity] = flat_detail::kSentinel;
+
+  ctrl_ = new_ctrl;
+  slots_ = new_slots;
+  capacity_ = new_capacity;
+  growth_left_ = max_load(new_capacity) - size_;
+
+  // 元素的键值互不相同，直接放到探测序列上的第一个空槽
+  for (size_type i = 0; i != old_capacity; ++i) {
+    if (old_ctrl[i] >= 0) {
+      const size_type hash = hash_key(getkey_(old_slots[i]));
+      const size_type j = find_first_non_full(hash);
+      set_ctrl(j, flat_detail::h2(hash));
+      slot_allocator::construct(slots_ + j, toystl::move(old_slots[i]));
+      slot_allocator::destroy(old_slots + i);
+    }
+  }
+
+  if (old_capacity != 0) {
+    ctrl_allocator(this->get_alloc()).deallocate(old_ctrl, old_capacity + 1);
+    slot_allocator(this->get_alloc()).deallocate(old_slots, old_capacity);
+  }
+}
+
+template <class Key, class Value, class HashFcn, class ExtractKey,
+          class EqualKey, class Allocator>
+void flat_hashtable<Key, Value, HashFcn, ExtractKey, EqualKey,
+                    Allocator>::erase_at(size_type i) {
+  slot_allocator::destroy(slots_ + i);
+  --size_;
+  // 所在的组里还有空槽时，经过这一组的探测本来就会停在这里，可以直接
+  // 置为空槽；否则必须留下墓碑，让探测继续往后走
+  const size_type base = i & ~(flat_detail::kGroupWidth - 1);
+  if (flat_detail::group(ctrl_ + base).match_empty() != 0) {
+    set_ctrl(i, flat_detail::kEmpty);
+    ++growth_left_;
+  } else {
+    set_ctrl(i, flat_detail::kDeleted);
+  }
+}
+
+template <class Key, class Value, class HashFcn, class ExtractKey,
+          class EqualKey, class Allocator>
+typename flat_hashtable<Key, Value, HashFcn, ExtractKey, EqualKey,
+                        Allocator>::size_type
+flat_hashtable<Key, Value, HashFcn, ExtractKey, EqualKey, Allocator>::erase(
+    const key_type& key) {
+  const size_type i = find_index(key);
+  if (i == capacity_) {
+    return 0;
+  }
+  erase_at(i);
+  return 1;
+}
+
+template <class Key, class Value, class HashFcn, class ExtractKey,
+          class EqualKey, class Allocator>
+void flat_hashtable<Key, Value, HashFcn, ExtractKey, EqualKey,
+                    Allocator>::erase(iterator first, iterator last) {
+  while (first != last) {
+    const size_type i = first.slot_ - slots_;
+    ++first;
+    erase_at(i);
+  }
+}
+
+template <class Key, class Value, class HashFcn, class ExtractKey,
+          class EqualKey, class Allocator>
+void flat_hashtable<Key, Value, HashFcn, ExtractKey, EqualKey,
+                    Allocator>::clear() {
+  if (capacity_ == 0) {
+    return;
+  }
+  for (size_type i = 0; i != capacity_; ++i) {
+    if (ctrl_[i] >= 0) {
+      slot_allocator::destroy(slots_ + i);
+    }
+  }
+  memset(ctrl_, flat_detail::kEmpty, capacity_);
+  size_ = 0;
+  growth_left_ = max_load(capacity_);
+}
+
+template <class Key, class Value, class HashFcn, class ExtractKey,
+          class EqualKey, class Allocator>
+void flat_hashtable<Key, Value, HashFcn, ExtractKey, EqualKey,
+                    Allocator>::swap(flat_hashtable& other) {
+  this->swap_alloc(other);
+  toystl::swap(hash_, other.hash_);
+  toystl::swap(equals_, other.equals_);
+  toystl::swap(getkey_, other.getkey_);
+  toystl::swap(ctrl_, other.ctrl_);
+  toystl::swap(slots_, other.slots_);
+  toystl::swap(capacity_, other.capacity_);
+  toystl::swap(size_, other.size_);
+  toystl::swap(growth_left_, other.growth_left_);
+}
+
+template <class Key, class Value, class HashFcn, class ExtractKey,
+          class EqualKey, class Allocator>
+void flat_hashtable<Key, Value, HashFcn, ExtractKey, EqualKey,
+                    Allocator>::resize(size_type num_elements_hint) {
+  if (num_elements_hint <= size_ + growth_left_) {
+    return;
+  }
+  size_type new_capacity =
+      capacity_ == 0 ? flat_detail::kGroupWidth : capacity_;
+  while (max_load(new_capacity) < num_elements_hint) {
+    new_capacity *= 2;
+  }
+  rehash(new_capacity);
+}
+
+template <class Key, class Value, class HashFcn, class ExtractKey,
+          class EqualKey, class Allocator>
+void flat_hashtable<Key, Value, HashFcn, ExtractKey, EqualKey,
+                    Allocator>::destroy_and_deallocate() {
+  if (capacity_ == 0) {
+    return;
+  }
+  for (size_type i = 0; i != capacity_; ++i) {
+    if (ctrl_[i] >= 0) {
+      slot_allocator::destroy(slots_ + i);
+    }
+  }
+  ctrl_allocator(this->get_alloc()).deallocate(ctrl_, capacity_ + 1);
+  slot_allocator(this->get_alloc()).deallocate(slots_, capacity_);
+  reset_empty();
+}
+
+template <class Key, class Value, class HashFcn, class ExtractKey,
+          class EqualKey, class Allocator>
+void flat_hashtable<Key, Value, HashFcn, ExtractKey, EqualKey,
+                    Allocator>::copy_from(const flat_hashtable& other) {
+  resize(other.size_);
+  try {
+    for (auto it = other.begin(); it != other.end(); ++it) {
+      const size_type i = prepare_insert(hash_key(getkey_(*it)));
+      try {
+        slot_allocator::construct(slots_ + i, *it);
+      } catch (...) {
+        set_ctrl(i, flat_detail::kDeleted);
+        throw;
+      }
+      ++size_;
+    }
+  } catch (...) {
+    clear();
+    throw;
+  }
+}
+}  // namespace toystl
+
+#endif  // TOYSTL_SRC_FLAT_HASHTABLE_H_
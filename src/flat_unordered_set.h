@@ -0,0 +1,191 @@
+#ifndef TOYSTL_SRC_FLAT_UNORDERED_SET_H_
+#define TOYSTL_SRC_FLAT_UNORDERED_SET_H_
+
+#include "allocator.h"
+#include "flat_hashtable.h"
+#include "functional.h"
+#include "hash_fun.h"
+
+namespace toystl {
+/******************************************************************************/
+// 模板类 flat_unordered_set，键值不允许重复
+// 接口与 unordered_set 相同，底层以开放寻址的 flat_hashtable 完成
+/******************************************************************************/
+template <class Value, class HashFcn = toystl::hash<Value>,
+          class EqualKey = toystl::equal_to<Value>,
+          class Allocator = toystl::allocator<Value>>
+class flat_unordered_set;
+
+template <class Value, class HashFcn, class EqualKey, class Allocator>
+inline bool operator==(
+    const flat_unordered_set<Value, HashFcn, EqualKey, Allocator>& us1,
+    const flat_unordered_set<Value, HashFcn, EqualKey, Allocator>& us2);
+
+template <class Value, class HashFcn, class EqualKey, class Allocator>
+class flat_unordered_set {
+ private:
+  using hashtable_type = flat_hashtable<Value, Value, HashFcn, identity<Value>,
+                                        EqualKey, Allocator>;
+  hashtable_type ht_;  // 底层以 flat_hashtable 完成
+
+ public:
+  using key_type = typename hashtable_type::key_type;
+  using value_type = typename hashtable_type::value_type;
+  using hasher = typename hashtable_type::hasher;
+  using key_equal = typename hashtable_type::key_equal;
+
+  using size_type = typename hashtable_type::size_type;
+  using difference_type = typename hashtable_type::difference_type;
+  using pointer = typename hashtable_type::const_pointer;
+  using const_pointer = typename hashtable_type::const_pointer;
+  using reference = typename hashtable_type::const_reference;
+  using const_reference = typename hashtable_type::const_reference;
+
+  using iterator = typename hashtable_type::const_iterator;
+  using const_iterator = typename hashtable_type::const_iterator;
+
+  using allocator_type = typename hashtable_type::allocator_type;
+
+  hasher hash_fcn() const { return ht_.hash_fcn(); }
+  key_equal key_eq() const { return ht_.key_eq(); }
+  allocator_type get_allocator() const { return ht_.get_allocator(); }
+
+ public:
+  // 构造、赋值、移动、析构函数
+  // 默认构造不分配内存，第一次插入时才分配
+  flat_unordered_set() : ht_(0, hasher(), key_equal()) {}
+
+  explicit flat_unordered_set(size_type bucket_size,
+                              const allocator_type& a = allocator_type())
+      : ht_(bucket_size, hasher(), key_equal(), a) {}
+
+  flat_unordered_set(size_type bucket_size, const hasher& hf,
+                     const allocator_type& a = allocator_type())
+      : ht_(bucket_size, hf, key_equal(), a) {}
+
+  flat_unordered_set(size_type bucket_size, const hasher& hf,
+                     const key_equal& equal, const allocator_type& a)
+      : ht_(bucket_size, hf, equal, a) {}
+
+  explicit flat_unordered_set(const allocator_type& a)
+      : ht_(0, hasher(), key_equal(), a) {}
+
+  template <class InputIterator>
+  flat_unordered_set(InputIterator first, InputIterator last,
+                     const size_type bucket_size = 0,
+                     const hasher& hf = hasher(),
+                     const EqualKey& equal = key_equal())
+      : ht_(bucket_size, hf, equal) {
+    ht_.insert_unique(first, last);
+  }
+
+  flat_unordered_set(const flat_unordered_set& rhs) : ht_(rhs.ht_) {}
+
+  flat_unordered_set(const flat_unordered_set& rhs, const allocator_type& a)
+      : ht_(rhs.ht_, a) {}
+
+  flat_unordered_set(flat_unordered_set&& rhs) noexcept
+      : ht_(toystl::move(rhs.ht_)) {}
+
+  flat_unordered_set& operator=(const flat_unordered_set& rhs) {
+    if (this != &rhs) {
+      ht_ = rhs.ht_;
+    }
+
+    return *this;
+  }
+
+  flat_unordered_set& operator=(flat_unordered_set&& rhs) noexcept(
+      std::is_nothrow_move_assignable<hashtable_type>::value) {
+    if (this != &rhs) {
+      ht_ = toystl::move(rhs.ht_);
+    }
+
+    return *this;
+  }
+
+  ~flat_unordered_set() = default;
+
+  // 迭代器相关
+
+  iterator begin() const { return ht_.begin(); }
+  iterator end() const { return ht_.end(); }
+
+  const_iterator cbegin() const { return ht_.cbegin(); }
+  const_iterator cend() const { return ht_.cend(); }
+
+  // 容量相关
+
+  size_type size() const { return ht_.size(); }
+  size_type max_size() const { return ht_.max_size(); }
+  bool empty() const { return ht_.empty(); }
+  void swap(flat_unordered_set& us) { ht_.swap(us.ht_); }
+
+  // 修改容器操作
+
+  pair<iterator, bool> insert(const value_type& value) {
+    pair<typename hashtable_type::iterator, bool> p = ht_.insert_unique(value);
+    return pair<iterator, bool>(p.first, p.second);
+  }
+
+  template <class InputIterator>
+  void insert(InputIterator first, InputIterator last) {
+    ht_.insert_unique(first, last);
+  }
+
+  iterator find(const key_type& key) const { return ht_.find(key); }
+
+  size_type count(const key_type& key) const { return ht_.count(key); }
+
+  pair<iterator, iterator> equal_range(const key_type& key) const {
+    return ht_.equal_range(key);
+  }
+
+  size_type erase(const key_type& key) { return ht_.erase(key); }
+
+  void erase(iterator it) { return ht_.erase(it); }
+
+  void erase(iterator f, iterator l) { return ht_.erase(f, l); }
+
+  void clear() { ht_.clear(); }
+
+ public:
+  void resize(size_type hint) { return ht_.resize(hint); }
+
+  size_type bucket_count() const { return ht_.bucket_count(); }
+
+  size_type max_bucket_count() const { return ht_.max_bucket_count(); }
+
+  size_type elems_in_bucket(size_type n) const {
+    return ht_.elems_in_bucket(n);
+  }
+
+  float load_factor() const { return ht_.load_factor(); }
+
+  template <class V1, class H1, class E1, class A1>
+  friend bool operator==(const flat_unordered_set<V1, H1, E1, A1>&,
+                         const flat_unordered_set<V1, H1, E1, A1>&);
+};
+
+template <class Value, class HashFcn, class EqualKey, class Allocator>
+inline bool operator==(
+    const flat_unordered_set<Value, HashFcn, EqualKey, Allocator>& us1,
+    const flat_unordered_set<Value, HashFcn, EqualKey, Allocator>& us2) {
+  return us1.ht_ == us2.ht_;
+}
+
+template <class Value, class HashFcn, class EqualKey, class Allocator>
+inline bool operator!=(
+    const flat_unordered_set<Value, HashFcn, EqualKey, Allocator>& us1,
+    const flat_unordered_set<Value, HashFcn, EqualKey, Allocator>& us2) {
+  return !(us1 == us2);
+}
+
+template <class Value, class HashFcn, class EqualKey, class Allocator>
+void swap(flat_unordered_set<Value, HashFcn, EqualKey, Allocator>& us1,
+          flat_unordered_set<Value, HashFcn, EqualKey, Allocator>& us2) {
+  us1.swap(us2);
+}
+}  // namespace toystl
+
+#endif  // TOYSTL_SRC_FLAT_UNORDERED_SET_H_
@@ -71,6 +71,17 @@ struct equal_to : public binary_funciton<T, T, bool> {
   bool operator()(const T& x, const T& y) const { return x == y; }
 };
 
+// 透明版本：两侧可以是不同的型别，供哈希容器的异构查找使用
+template <>
+struct equal_to<void> {
+  using is_transparent = void;
+
+  template <class T, class U>
+  bool operator()(const T& x, const U& y) const {
+    return x == y;
+  }
+};
+
 // 函数对象：不等于
 template <class T>
 struct not_equal_to : public binary_funciton<T, T, bool> {
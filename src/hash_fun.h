@@ -1,23 +1,150 @@
 #ifndef TOYSTL_SRC_HASH_FUN_H_
 #define TOYSTL_SRC_HASH_FUN_H_
 
+#include <stdint.h>
+#include <string.h>  // memcpy, strlen
+
 #include <cstddef>
+#include <string>
+
+#include "utility.h"
 
 namespace toystl {
 // 对于大部分类型，hash function 什么也不做，直接返回原值
 template <class Key>
 struct hash {};
 
-// 对于字符字符串，设计了一个转换函数
-inline size_t hash_string(const char* s) {
-  unsigned long h = 0;
-  for (; *s; ++s) {
-    h = 5 * h + *s;
+// 整数哈希的混合函数（MurmurHash3 的 fmix64）
+// 下面的整数 hash 都是恒等函数，只有低位参与定位时分布很差，
+// 经过混合之后每个输入位都会影响所有输出位
+inline size_t hash_mix(size_t h) {
+  uint64_t x = static_cast<uint64_t>(h);
+  x ^= x >> 33;
+  x *= 0xff51afd7ed558ccdull;
+  x ^= x >> 33;
+  x *= 0xc4ceb9fe1a85ec53ull;
+  x ^= x >> 33;
+
+  return static_cast<size_t>(x);
+}
+
+// 把哈希值 h 合并到 seed 中，用于 pair 等组合类型。合并的顺序会影响结果
+inline size_t hash_combine(size_t seed, size_t h) {
+  return hash_mix(seed ^ (h + 0x9e3779b97f4a7c15ull + (seed << 6) +
+                          (seed >> 2)));
+}
+
+/******************************************************************************/
+// 字节串哈希，算法同 wyhash：每次读入 8 个字节，用 64 x 64 -> 128 位乘法
+// 把两个字交叉混合，长度不超过 16 的键只需要一次乘法。
+// 原先的 h = 5 * h + c 每次只处理一个字节，而且长前缀相同的键
+// （比如 URL）冲突很多
+/******************************************************************************/
+namespace hash_detail {
+static const uint64_t kSecret[4] = {
+    0x2d358dccaa6c78a5ull, 0x8bb84b93962eacc9ull, 0x4b33a62ed433d4a3ull,
+    0x4d5a2da51de1aa47ull};
+
+// 以本机字节序读入，不要求地址对齐
+inline uint64_t read64(const unsigned char* p) {
+  uint64_t v;
+  memcpy(&v, p, 8);
+  return v;
+}
+
+inline uint64_t read32(const unsigned char* p) {
+  uint32_t v;
+  memcpy(&v, p, 4);
+  return v;
+}
+
+// 1 到 3 个字节：取首、中、尾三个字节
+inline uint64_t read_small(const unsigned char* p, size_t k) {
+  return (static_cast<uint64_t>(p[0]) << 16) |
+         (static_cast<uint64_t>(p[k >> 1]) << 8) | p[k - 1];
+}
+
+// 128 位乘积，低 64 位存入 *a，高 64 位存入 *b
+inline void mum(uint64_t* a, uint64_t* b) {
+#if defined(__SIZEOF_INT128__)
+  __extension__ typedef unsigned __int128 uint128;
+  uint128 r = *a;
+  r *= *b;
+  *a = static_cast<uint64_t>(r);
+  *b = static_cast<uint64_t>(r >> 64);
+#else
+  const uint64_t ha = *a >> 32, hb = *b >> 32;
+  const uint64_t la = static_cast<uint32_t>(*a);
+  const uint64_t lb = static_cast<uint32_t>(*b);
+  const uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+  const uint64_t t = rl + (rm0 << 32);
+  uint64_t c = t < rl;
+  const uint64_t lo = t + (rm1 << 32);
+  c += lo < t;
+  *a = lo;
+  *b = rh + (rm0 >> 32) + (rm1 >> 32) + c;
+#endif
+}
+
+inline uint64_t mix(uint64_t a, uint64_t b) {
+  mum(&a, &b);
+  return a ^ b;
+}
+}  // namespace hash_detail
+
+// 计算 [key, key + len) 这段字节的哈希值
+inline size_t hash_bytes(const void* key, size_t len, uint64_t seed = 0) {
+  using namespace hash_detail;
+  const unsigned char* p = static_cast<const unsigned char*>(key);
+  seed ^= mix(seed ^ kSecret[0], kSecret[1]);
+  uint64_t a;
+  uint64_t b;
+  if (len <= 16) {
+    if (len >= 4) {
+      // 4 到 16 个字节：首尾各读两个 4 字节，可能有重叠
+      const size_t mid = (len >> 3) << 2;
+      a = (read32(p) << 32) | read32(p + mid);
+      b = (read32(p + len - 4) << 32) | read32(p + len - 4 - mid);
+    } else if (len > 0) {
+      a = read_small(p, len);
+      b = 0;
+    } else {
+      a = b = 0;
+    }
+  } else {
+    size_t i = len;
+    if (i > 48) {
+      // 三路并行，每轮处理 48 个字节
+      uint64_t see1 = seed;
+      uint64_t see2 = seed;
+      do {
+        seed = mix(read64(p) ^ kSecret[1], read64(p + 8) ^ seed);
+        see1 = mix(read64(p + 16) ^ kSecret[2], read64(p + 24) ^ see1);
+        see2 = mix(read64(p + 32) ^ kSecret[3], read64(p + 40) ^ see2);
+        p += 48;
+        i -= 48;
+      } while (i > 48);
+      seed ^= see1 ^ see2;
+    }
+    while (i > 16) {
+      seed = mix(read64(p) ^ kSecret[1], read64(p + 8) ^ seed);
+      i -= 16;
+      p += 16;
+    }
+    // 最后 16 个字节，可能与上一轮重叠
+    a = read64(p + i - 16);
+    b = read64(p + i - 8);
   }
+  a ^= kSecret[1];
+  b ^= seed;
+  mum(&a, &b);
 
-  return size_t(h);
+  return static_cast<size_t>(mix(a ^ kSecret[0] ^ len, b ^ kSecret[1]));
 }
 
+// 对于字符字符串，设计了一个转换函数
+inline size_t hash_string(const char* s) { return hash_bytes(s, strlen(s)); }
+
 template <>
 struct hash<char*> {
   size_t operator()(const char* s) const { return hash_string(s); }
@@ -28,6 +155,23 @@ struct hash<const char*> {
   size_t operator()(const char* s) const { return hash_string(s); }
 };
 
+// 与 const char* 的哈希值一致，所以声明为透明的，
+// 配合 equal_to<void> 可以直接以 const char* 查找 string 键值
+template <>
+struct hash<std::string> {
+  using is_transparent = void;
+
+  size_t operator()(const std::string& s) const {
+    return hash_bytes(s.data(), s.size());
+  }
+  size_t operator()(const char* s) const { return hash_string(s); }
+};
+
+template <>
+struct hash<bool> {
+  size_t operator()(bool x) const { return x; }
+};
+
 template <>
 struct hash<char> {
   size_t operator()(char x) const { return x; }
@@ -43,6 +187,11 @@ struct hash<signed char> {
   size_t operator()(signed char x) const { return x; }
 };
 
+template <>
+struct hash<wchar_t> {
+  size_t operator()(wchar_t x) const { return x; }
+};
+
 template <>
 struct hash<short> {
   size_t operator()(short x) const { return x; }
@@ -72,6 +221,68 @@ template <>
 struct hash<unsigned long> {
   size_t operator()(unsigned long x) const { return x; }
 };
+
+// 64 位整数。size_t 只有 32 位时把高 32 位折叠进来
+template <>
+struct hash<unsigned long long> {
+  size_t operator()(unsigned long long x) const {
+    return sizeof(size_t) < sizeof(x) ? static_cast<size_t>(x ^ (x >> 32))
+                                      : static_cast<size_t>(x);
+  }
+};
+
+template <>
+struct hash<long long> {
+  size_t operator()(long long x) const {
+    return hash<unsigned long long>()(static_cast<unsigned long long>(x));
+  }
+};
+
+// 浮点数：对位模式做混合。+0.0 与 -0.0 相等，哈希值也必须相同
+template <>
+struct hash<float> {
+  size_t operator()(float x) const {
+    if (x == 0.0f) {
+      return 0;
+    }
+    uint32_t bits;
+    memcpy(&bits, &x, sizeof(bits));
+    return hash_mix(bits);
+  }
+};
+
+template <>
+struct hash<double> {
+  size_t operator()(double x) const {
+    if (x == 0.0) {
+      return 0;
+    }
+    uint64_t bits;
+    memcpy(&bits, &x, sizeof(bits));
+    return hash_mix(hash<unsigned long long>()(bits));
+  }
+};
+
+template <>
+struct hash<long double> {
+  size_t operator()(long double x) const {
+    // long double 的位模式中可能有未定义的填充字节，先转成 double
+    return hash<double>()(static_cast<double>(x));
+  }
+};
+
+// 指针：与整数一样直接返回地址，由 bucket 策略决定是否再混合
+template <class T>
+struct hash<T*> {
+  size_t operator()(T* p) const { return reinterpret_cast<size_t>(p); }
+};
+
+template <class T1, class T2>
+struct hash<pair<T1, T2>> {
+  size_t operator()(const pair<T1, T2>& p) const {
+    return hash_combine(hash<T1>()(p.first), hash<T2>()(p.second));
+  }
+};
 }  // namespace toystl
 
-#endif  // TOYSTL_SRC_HASH_FUN_H_
\ No newline at end of file
+#endif  // TOYSTL_SRC_HASH_FUN_H_
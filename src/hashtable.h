@@ -1,6 +1,9 @@
 #ifndef TOYSTL_SRC_HASHTABLE_H_
 #define TOYSTL_SRC_HASHTABLE_H_
 
+#include <tuple>        // std::forward_as_tuple
+#include <type_traits>  // std::remove_const, std::is_scalar
+
 #include "algo.h"
 #include "allocator.h"
 #include "construct.h"
@@ -10,26 +13,120 @@
 #include "vector.h"
 
 namespace toystl {
-template <class T>
+// CacheHash 为 true 时节点额外保存键值的完整哈希值：rehash 和迭代器跨
+// bucket 时直接使用，不必重新求哈希；查找时先比较哈希值，不相等就不必
+// 调用 equals_
+template <class T, bool CacheHash = false>
 struct hashtable_node {
   hashtable_node* next;
   T value;
 };
 
+template <class T>
+struct hashtable_node<T, true> {
+  hashtable_node* next;
+  size_t hash;
+  T value;
+};
+
+// 是否在节点中缓存哈希值。整数、指针等标量的哈希几乎没有代价，缓存只会
+// 让节点变大；其它键值（比如字符串）求一次哈希要走完整个键，默认缓存。
+// 可以针对某个 hasher 特化这个模板来改变默认的选择
+template <class Key, class HashFcn>
+struct hashtable_cache_hash
+    : m_bool_constant<!std::is_scalar<Key>::value> {};
+
+// 虽然开链法并不要求表格大小必须为质数，但是仍然以质数来设计表格的大小
+// 并且先将29个质数（逐渐呈现大约两倍的关系）计算好，以被随时访问
+// 同时提供一个函数，用来查询这29个质数之中，“最接近某数并大于某数”的质数
+enum { num_primes = 29 };
+
+static const unsigned long prime_list[num_primes] = {
+    5ul,         53ul,         97ul,         193ul,       389ul,
+    769ul,       1543ul,       3079ul,       6151ul,      12289ul,
+    24593ul,     49157ul,      98317ul,      196613ul,    393241ul,
+    786433ul,    1572869ul,    3145739ul,    6291469ul,   12582917ul,
+    25165843ul,  50331653ul,   100663319ul,  201326611ul, 402653189ul,
+    805306457ul, 1610612741ul, 3221225473ul, 4294967291ul};
+
+inline unsigned long next_prime(unsigned long n) {
+  const unsigned long* first = prime_list;
+  const unsigned long* last = prime_list + num_primes;
+  const unsigned long* pos = toystl::lower_bound(first, last, n);
+
+  return pos == last ? *(last - 1) : *pos;
+}
+
+/******************************************************************************/
+// bucket 策略：决定 bucket 的个数以及键值落在哪一个 bucket
+// next_size(n)         不小于 n 的 bucket 个数
+// bucket_index(h, n)   哈希值 h 在 n 个 bucket 中的位置
+// max_bucket_count()   bucket 个数的上限
+// incremental_rehash   扩容时是否渐进式地搬移节点
+// rehash_step          渐进式 rehash 时每次插入搬移的旧 bucket 个数
+/******************************************************************************/
+
+// 默认策略：bucket 个数取质数，以取模定位。对恒等哈希也能分布均匀，
+// 但每次定位都需要一次整数除法
+struct hashtable_prime_policy {
+  static size_t next_size(size_t n) { return next_prime(n); }
+
+  static size_t bucket_index(size_t hash, size_t n) { return hash % n; }
+
+  static size_t max_bucket_count() { return prime_list[num_primes - 1]; }
+
+  static const bool incremental_rehash = false;
+  static const size_t rehash_step = 0;
+};
+
+// bucket 个数取 2 的幂，以掩码定位，省去除法。
+// 掩码只保留哈希值的低位，而 hash<int> 等是恒等函数，所以先用 hash_mix
+// 把高位的信息混入低位，否则步长为 2 的幂的键会全部挤进少数几个 bucket
+struct hashtable_power2_policy {
+  static size_t next_size(size_t n) {
+    size_t size = 8;
+    while (size < n && size < max_bucket_count()) {
+      size <<= 1;
+    }
+    return size;
+  }
+
+  static size_t bucket_index(size_t hash, size_t n) {
+    return hash_mix(hash) & (n - 1);
+  }
+
+  static size_t max_bucket_count() { return (size_t(-1) >> 1) + 1; }
+
+  static const bool incremental_rehash = false;
+  static const size_t rehash_step = 0;
+};
+
+// 渐进式 rehash：扩容时只分配新的 bucket 数组，新旧两个数组同时存在，
+// 之后每次插入顺带搬移 Step 个旧 bucket，把一次性重建整张表的停顿
+// 分摊到后续的插入上。bucket 个数和定位方式沿用 Base。
+// 新数组约为旧数组的两倍，下一次扩容前至少还有旧 bucket 个数那么多次插入，
+// 每次搬 1 个恰好够用，默认的 2 个留出一倍余量
+template <class Base = hashtable_prime_policy, size_t Step = 2>
+struct hashtable_incremental_policy : Base {
+  static const bool incremental_rehash = true;
+  static const size_t rehash_step = Step;
+};
+
 template <class Key, class Value, class HashFcn, class ExtractKey,
-          class EqualKey, class Allocator = toystl::allocator<Value>>
+          class EqualKey, class Allocator = toystl::allocator<Value>,
+          class BucketPolicy = hashtable_prime_policy>
 class hashtable;
 
 template <class Key, class Value, class HashFcn, class ExtractKey,
-          class EqualKey, class Allocator>
+          class EqualKey, class Allocator, class BucketPolicy>
 class hashtable_iterator;
 
 template <class Key, class Value, class HashFcn, class ExtractKey,
-          class EqualKey, class Allocator>
+          class EqualKey, class Allocator, class BucketPolicy>
 struct hashtable_const_iterator;
 
 template <class Key, class Value, class HashFcn, class ExtractKey,
-          class EqualKey, class Allocator>
+          class EqualKey, class Allocator, class BucketPolicy>
 struct hashtable_iterator {
   using value_type = Value;
   using reference = Value&;
@@ -39,15 +136,18 @@ struct hashtable_iterator {
   using size_type = size_t;
 
   using iterator =
-      hashtable_iterator<Key, Value, HashFcn, ExtractKey, EqualKey, Allocator>;
+      hashtable_iterator<Key, Value, HashFcn, ExtractKey, EqualKey, Allocator,
+                         BucketPolicy>;
   using const_iterator =
       hashtable_const_iterator<Key, Value, HashFcn, ExtractKey, EqualKey,
-                               Allocator>;
+                               Allocator, BucketPolicy>;
 
   using hashtable_type =
-      hashtable<Key, Value, HashFcn, ExtractKey, EqualKey, Allocator>;
+      hashtable<Key, Value, HashFcn, ExtractKey, EqualKey, Allocator,
+                BucketPolicy>;
 
-  using Node = hashtable_node<Value>;
+  using Node =
+      hashtable_node<Value, hashtable_cache_hash<Key, HashFcn>::value>;
 
   Node* cur_;  // 迭代器目前所指之节点
   hashtable_type*
@@ -66,10 +166,7 @@ struct hashtable_iterator {
     const Node* old = cur_;
     cur_ = cur_->next;
     if (!cur_) {
-      size_type bucket = ht_->bkt_num(old->value);
-      while (!cur_ && ++bucket < ht_->buckets_.size()) {
-        cur_ = ht_->buckets_[bucket];
-      }
+      cur_ = ht_->next_bucket_node(old);
     }
 
     return *this;
@@ -89,7 +186,7 @@ struct hashtable_iterator {
 };
 
 template <class Key, class Value, class HashFcn, class ExtractKey,
-          class EqualKey, class Allocator>
+          class EqualKey, class Allocator, class BucketPolicy>
 struct hashtable_const_iterator {
   using value_type = Value;
   using reference = const Value&;
@@ -99,15 +196,18 @@ struct hashtable_const_iterator {
   using size_type = size_t;
 
   using iterator =
-      hashtable_iterator<Key, Value, HashFcn, ExtractKey, EqualKey, Allocator>;
+      hashtable_iterator<Key, Value, HashFcn, ExtractKey, EqualKey, Allocator,
+                         BucketPolicy>;
   using const_iterator =
       hashtable_const_iterator<Key, Value, HashFcn, ExtractKey, EqualKey,
-                               Allocator>;
+                               Allocator, BucketPolicy>;
 
   using hashtable_type =
-      hashtable<Key, Value, HashFcn, ExtractKey, EqualKey, Allocator>;
+      hashtable<Key, Value, HashFcn, ExtractKey, EqualKey, Allocator,
+                BucketPolicy>;
 
-  using Node = hashtable_node<Value>;
+  using Node =
+      hashtable_node<Value, hashtable_cache_hash<Key, HashFcn>::value>;
 
   const Node* cur_;  // 迭代器目前所指之节点
   const hashtable_type*
@@ -116,6 +216,8 @@ struct hashtable_const_iterator {
   hashtable_const_iterator(const Node* n, const hashtable_type* tab)
       : cur_(n), ht_(tab) {}
 
+  hashtable_const_iterator(const iterator& it) : cur_(it.cur_), ht_(it.ht_) {}
+
   hashtable_const_iterator() {}
 
   reference operator*() const { return cur_->value; }
@@ -128,10 +230,7 @@ struct hashtable_const_iterator {
     const Node* old = cur_;
     cur_ = cur_->next;
     if (!cur_) {
-      size_type bucket = ht_->bkt_num(old->value);
-      while (!cur_ && ++bucket < ht_->buckets_.size()) {
-        cur_ = ht_->buckets_[bucket];
-      }
+      cur_ = ht_->next_bucket_node(old);
     }
 
     return *this;
@@ -139,7 +238,7 @@ struct hashtable_const_iterator {
 
   // 后置 ++
   const_iterator operator++(int) {
-    iterator tmp = *this;
+    const_iterator tmp = *this;
     ++*this;  // 调用 operator++
 
     return tmp;
@@ -154,37 +253,119 @@ struct hashtable_const_iterator {
   }
 };
 
-// 虽然开链法并不要求表格大小必须为质数，但是仍然以质数来设计表格的大小
-// 并且先将29个质数（逐渐呈现大约两倍的关系）计算好，以被随时访问
-// 同时提供一个函数，用来查询这29个质数之中，“最接近某数并大于某数”的质数
-enum { num_primes = 29 };
+// 前置声明
+template <class Key, class Value, class HashFcn, class ExtractKey,
+          class EqualKey, class Allocator, class BucketPolicy>
+class hashtable;
 
-static const unsigned long prime_list[num_primes] = {
-    5ul,         53ul,         97ul,         193ul,       389ul,
-    769ul,       1543ul,       3079ul,       6151ul,      12289ul,
-    24593ul,     49157ul,      98317ul,      196613ul,    393241ul,
-    786433ul,    1572869ul,    3145739ul,    6291469ul,   12582917ul,
-    25165843ul,  50331653ul,   100663319ul,  201326611ul, 402653189ul,
-    805306457ul, 1610612741ul, 3221225473ul, 4294967291ul};
+// 节点句柄：extract 从容器中摘下的节点。节点连同其中的元素一起在容器之间
+// 转移，既不经过分配器也不复制元素。句柄析构时如果仍持有节点，就销毁它。
+// 节点只能插入到分配器与原容器相等的容器中
+template <class Value, class Allocator, bool CacheHash = false>
+class hashtable_node_handle : private allocator_holder<Allocator> {
+  template <class Key, class Value1, class HashFcn, class ExtractKey,
+            class EqualKey, class Allocator1, class BucketPolicy>
+  friend class hashtable;
 
-inline unsigned long next_prime(unsigned long n) {
-  const unsigned long* first = prime_list;
-  const unsigned long* last = prime_list + num_primes;
-  const unsigned long* pos = toystl::lower_bound(first, last, n);
+ public:
+  using value_type = Value;
+  using allocator_type = Allocator;
 
-  return pos == last ? *(last - 1) : *pos;
-}
+ private:
+  using node_type = hashtable_node<Value, CacheHash>;
+  using node_allocator =
+      typename Allocator::template rebind<node_type>::other;
+  using alloc_base = allocator_holder<Allocator>;
 
-// 前置声明
-template <class Key, class Value, class HashFcn, class ExtractKey,
-          class EqualKey, class Allocator>
-class hashtable;
+ public:
+  hashtable_node_handle() noexcept : node_(nullptr) {}
+
+  hashtable_node_handle(hashtable_node_handle&& other) noexcept
+      : alloc_base(other.get_alloc()), node_(other.node_) {
+    other.node_ = nullptr;
+  }
+
+  hashtable_node_handle& operator=(hashtable_node_handle&& other) noexcept {
+    if (this != &other) {
+      reset();
+      this->set_alloc(other.get_alloc());
+      node_ = other.node_;
+      other.node_ = nullptr;
+    }
+
+    return *this;
+  }
+
+  hashtable_node_handle(const hashtable_node_handle&) = delete;
+  hashtable_node_handle& operator=(const hashtable_node_handle&) = delete;
+
+  ~hashtable_node_handle() { reset(); }
+
+  bool empty() const noexcept { return node_ == nullptr; }
+  explicit operator bool() const noexcept { return node_ != nullptr; }
+
+  allocator_type get_allocator() const { return this->get_alloc(); }
+
+  // unordered_set 的节点
+  value_type& value() const { return node_->value; }
+
+  // unordered_map 的节点。键值可以修改之后再插入
+  template <class V = Value>
+  typename std::remove_const<typename V::first_type>::type& key() const {
+    using key_type = typename std::remove_const<typename V::first_type>::type;
+    return const_cast<key_type&>(node_->value.first);
+  }
+
+  template <class V = Value>
+  typename V::second_type& mapped() const {
+    return node_->value.second;
+  }
+
+  void swap(hashtable_node_handle& other) noexcept {
+    Allocator tmp = this->get_alloc();
+    this->set_alloc(other.get_alloc());
+    other.set_alloc(tmp);
+    toystl::swap(node_, other.node_);
+  }
+
+ private:
+  hashtable_node_handle(node_type* n, const Allocator& a)
+      : alloc_base(a), node_(n) {}
+
+  // 把节点交还给容器
+  node_type* release() {
+    node_type* n = node_;
+    node_ = nullptr;
+    return n;
+  }
+
+  void reset() {
+    if (node_) {
+      toystl::destroy(&node_->value);
+      node_allocator(this->get_alloc()).deallocate(node_, 1);
+      node_ = nullptr;
+    }
+  }
+
+  node_type* node_;
+};
+
+// 键值不允许重复的容器 insert(node_handle&&) 的返回值：
+// 插入失败时节点留在 node 中，position 指向已有的元素
+template <class Iterator, class NodeHandle>
+struct hashtable_insert_return {
+  Iterator position;
+  bool inserted;
+  NodeHandle node;
+};
 
 template <class Key, class Value, class HashFcn, class ExtractKey,
-          class EqualKey, class Allocator>
+          class EqualKey, class Allocator, class BucketPolicy>
 bool operator==(
-    const hashtable<Key, Value, HashFcn, ExtractKey, EqualKey, Allocator>& ht1,
-    const hashtable<Key, Value, HashFcn, ExtractKey, EqualKey, Allocator>& ht2);
+    const hashtable<Key, Value, HashFcn, ExtractKey, EqualKey, Allocator,
+                    BucketPolicy>& ht1,
+    const hashtable<Key, Value, HashFcn, ExtractKey, EqualKey, Allocator,
+                    BucketPolicy>& ht2);
 
 // 模板参数的含义
 // Key          节点的实值型别
@@ -195,15 +376,16 @@ bool operator==(
 // Allocator    空间配置器
 template <class Key, class Value, class HashFcn, class ExtractKey,
           class EqualKey,
-          class Allocator>  // 前置声明时，已经给了 Allocator 默认值
-class hashtable {
+          class Allocator,
+          class BucketPolicy>  // 前置声明时，已经给了默认值
+class hashtable : private allocator_holder<Allocator> {
  public:
   // 声明为 友元类，因为 hashtable_iterator 和 hashtable_const_iterator 需要用到
   // hashtable 的私有成员
   friend struct hashtable_iterator<Key, Value, HashFcn, ExtractKey, EqualKey,
-                                   Allocator>;
+                                   Allocator, BucketPolicy>;
   friend struct hashtable_const_iterator<Key, Value, HashFcn, ExtractKey,
-                                         EqualKey, Allocator>;
+                                         EqualKey, Allocator, BucketPolicy>;
 
  public:
   using key_type = Key;
@@ -219,24 +401,38 @@ class hashtable {
   using const_pointer = const value_type*;
 
   using iterator =
-      hashtable_iterator<Key, Value, HashFcn, ExtractKey, EqualKey, Allocator>;
+      hashtable_iterator<Key, Value, HashFcn, ExtractKey, EqualKey, Allocator,
+                         BucketPolicy>;
   using const_iterator =
       hashtable_const_iterator<Key, Value, HashFcn, ExtractKey, EqualKey,
-                               Allocator>;
+                               Allocator, BucketPolicy>;
 
   using allocator_type = Allocator;
   using data_allocator = Allocator;
 
-  allocator_type get_allocator() const { return allocator_type(); }
+  // 节点中是否缓存哈希值
+  using cache_hash = hashtable_cache_hash<Key, HashFcn>;
+
+  using node_handle =
+      hashtable_node_handle<Value, Allocator, cache_hash::value>;
+  using insert_return_type = hashtable_insert_return<iterator, node_handle>;
+
+  allocator_type get_allocator() const { return this->get_alloc(); }
 
  private:
-  using node_type = hashtable_node<Value>;
+  using node_type = hashtable_node<Value, cache_hash::value>;
   using node_ptr = node_type*;
 
   using hashtable_node_allocator =
       typename Allocator::template rebind<node_type>::other;
   using hashtable_node_pointer_allocator =
       typename Allocator::template rebind<node_ptr>::other;
+  using bucket_type =
+      toystl::vector<node_ptr, hashtable_node_pointer_allocator>;
+
+  // 分配器保存在基类 allocator_holder 中，节点和 buckets 用 rebind
+  // 后的分配器分配
+  using alloc_base = allocator_holder<Allocator>;
 
  private:
   // hashtable 的成员变量
@@ -244,34 +440,56 @@ class hashtable {
   hasher hash_;
   key_equal equals_;
   ExtractKey getkey_;
-  toystl::vector<node_ptr, hashtable_node_pointer_allocator>
-      buckets_;  // 以 vector 来完成，动态扩充能力
+  bucket_type buckets_;  // 以 vector 来完成，动态扩充能力
   size_t numElements_;
+  // 渐进式 rehash 期间的旧 bucket 数组，其中 [rehash_pos_, size) 还没有搬移。
+  // 不处于 rehash 时为空
+  bucket_type old_buckets_;
+  size_type rehash_pos_;
 
  public:
   // 构造、赋值、移动、析构函数
   hashtable(size_type n, const HashFcn& hash, const EqualKey& equals,
-            const ExtractKey& getkey)
-      : hash_(hash), equals_(equals), getkey_(getkey), numElements_(0) {
+            const ExtractKey& getkey,
+            const allocator_type& a = allocator_type())
+      : alloc_base(a),
+        hash_(hash),
+        equals_(equals),
+        getkey_(getkey),
+        buckets_(hashtable_node_pointer_allocator(a)),
+        numElements_(0),
+        old_buckets_(hashtable_node_pointer_allocator(a)),
+        rehash_pos_(0) {
     initialize_buckets(n);
   }
 
-  hashtable(size_type n, const HashFcn& hash, const EqualKey& equals)
-      : hash_(hash), equals_(equals), getkey_(ExtractKey()), numElements_(0) {
-    initialize_buckets(n);
-  }
+  hashtable(size_type n, const HashFcn& hash, const EqualKey& equals,
+            const allocator_type& a = allocator_type())
+      : hashtable(n, hash, equals, ExtractKey(), a) {}
 
+  // 新容器的分配器由 select_on_container_copy_construction 决定
   hashtable(const hashtable& other)
-      : hash_(other.hash_),
+      : hashtable(other,
+                  other.get_alloc().select_on_container_copy_construction()) {}
+
+  hashtable(const hashtable& other, const allocator_type& a)
+      : alloc_base(a),
+        hash_(other.hash_),
         equals_(other.equals_),
         getkey_(other.getkey_),
-        numElements_(0) {
+        buckets_(hashtable_node_pointer_allocator(a)),
+        numElements_(0),
+        old_buckets_(hashtable_node_pointer_allocator(a)),
+        rehash_pos_(0) {
     copy_init(other);
   }
 
   hashtable& operator=(const hashtable& other) {
     if (&other != this) {
       clear();
+      copy_assign_alloc(
+          other,
+          typename allocator_type::propagate_on_container_copy_assignment());
       hash_ = other.hash_;
       equals_ = other.equals_;
       getkey_ = other.getkey_;
@@ -281,16 +499,27 @@ class hashtable {
     return *this;
   }
 
-  hashtable(hashtable&& other) noexcept : hash_(other.hash_),
-                                          equals_(other.equals_),
-                                          getkey_(other.getkey_),
-                                          numElements_(other.numElements_) {
-    buckets_ = toystl::move(other.buckets_);
+  // 分配器随节点一起移动过来
+  hashtable(hashtable&& other) noexcept
+      : alloc_base(other.get_alloc()),
+        hash_(other.hash_),
+        equals_(other.equals_),
+        getkey_(other.getkey_),
+        buckets_(toystl::move(other.buckets_)),
+        numElements_(other.numElements_),
+        old_buckets_(toystl::move(other.old_buckets_)),
+        rehash_pos_(other.rehash_pos_) {
+    other.numElements_ = 0;
+    other.rehash_pos_ = 0;
   }
 
-  hashtable& operator=(hashtable&& other) noexcept {
-    hashtable tmp(toystl::move(other));
-    swap(tmp);
+  hashtable& operator=(hashtable&& other) noexcept(
+      allocator_nothrow_move_assign<Allocator>::value) {
+    if (&other != this) {
+      move_assign(
+          other,
+          typename allocator_type::propagate_on_container_move_assignment());
+    }
 
     return *this;
   }
@@ -298,40 +527,27 @@ class hashtable {
   ~hashtable() { clear(); }
 
   // 迭代器相关操作
-  iterator begin() {
-    for (size_type n = 0; n < buckets_.size(); ++n) {
-      if (buckets_[n] != nullptr) {
-        return iterator(buckets_[n], this);
-      }
-    }
+  iterator begin() { return iterator(scan_buckets(0, false), this); }
 
-    return end();
-  }
-
-  iterator begin() const { return cbegin(); }
+  const_iterator begin() const { return cbegin(); }
 
   iterator end() { return iterator(nullptr, this); }
 
-  iterator end() const { return cend(); }
+  const_iterator end() const { return cend(); }
 
   const_iterator cbegin() const {
-    for (size_type n = 0; n < buckets_.size(); ++n) {
-      if (buckets_[n] != nullptr) {
-        return const_iterator(buckets_[n], this);
-      }
-    }
-
-    return cend();
+    return const_iterator(scan_buckets(0, false), this);
   }
 
   const_iterator cend() const { return const_iterator(nullptr, this); }
 
   template <class Key1, class Value1, class HashFcn1, class ExtractKey1,
-            class EqualKey1, class Allocator1>
-  friend bool operator==(const hashtable<Key1, Value1, HashFcn1, ExtractKey1,
-                                         EqualKey1, Allocator1>& ht1,
-                         const hashtable<Key1, Value1, HashFcn1, ExtractKey1,
-                                         EqualKey1, Allocator1>& ht2);
+            class EqualKey1, class Allocator1, class BucketPolicy1>
+  friend bool operator==(
+      const hashtable<Key1, Value1, HashFcn1, ExtractKey1, EqualKey1,
+                      Allocator1, BucketPolicy1>& ht1,
+      const hashtable<Key1, Value1, HashFcn1, ExtractKey1, EqualKey1,
+                      Allocator1, BucketPolicy1>& ht2);
 
   // 容器相关操作
   bool empty() const { return size() == 0; }
@@ -340,7 +556,19 @@ class hashtable {
 
   // 修改容器相关操作
 
-  // emplace / emplace_hint
+  // emplace
+  // 直接在新节点中构造元素，不经过 value_type 临时对象。
+  // 键值要从构造好的元素中取出，所以键值已存在时节点会被构造后再销毁
+  template <class... Args>
+  toystl::pair<iterator, bool> emplace_unique(Args&&... args);
+
+  template <class... Args>
+  iterator emplace_equal(Args&&... args);
+
+  // 只用于 unordered_map：先以 key 查找，键值不存在时才构造节点，
+  // value 由 args 构造。键值已存在时 args 不会被移动
+  template <class K, class... Args>
+  toystl::pair<iterator, bool> try_emplace_unique(K&& key, Args&&... args);
 
   // insert 相关
 
@@ -348,15 +576,21 @@ class hashtable {
   toystl::pair<iterator, bool> insert_unique_noresize(const value_type& value);
 
   // 在不需要重建表格的情况下插入新节点。键值允许重复
-  iterator insert_equal_noresize(const value_type& value);
+  iterator insert_equal_noresize(const value_type& value) {
+    node_ptr tmp = new_node(value);
+    set_node_hash(tmp, hash_(getkey_(value)));
+    return insert_equal_node(tmp);
+  }
 
   toystl::pair<iterator, bool> insert_unique(const value_type& value) {
     resize(numElements_ + 1);
+    rehash_step();
     return insert_unique_noresize(value);
   }
 
   iterator insert_equal(const value_type& value) {
     resize(numElements_ + 1);
+    rehash_step();
     return insert_equal_noresize(value);
   }
 
@@ -406,6 +640,26 @@ class hashtable {
     }
   }
 
+  // 节点操作：extract 摘下节点，insert 把摘下的节点链入，merge 把 src 的节点
+  // 转移过来。都只是改动链表指针，不会分配或释放节点，也不会复制元素
+  node_handle extract(const_iterator pos) {
+    node_ptr p = const_cast<node_ptr>(pos.cur_);
+    return node_handle(unlink_node(p), this->get_alloc());
+  }
+
+  // 摘下第一个键值为 key 的节点，找不到时返回空的句柄
+  node_handle extract(const key_type& key) {
+    node_ptr p = find_node(key);
+    return p ? node_handle(unlink_node(p), this->get_alloc()) : node_handle();
+  }
+
+  insert_return_type insert_unique(node_handle&& nh);
+  iterator insert_equal(node_handle&& nh);
+
+  // 键值不允许重复：src 中键值已经存在的节点留在 src 中
+  void merge_unique(hashtable& src);
+  void merge_equal(hashtable& src);
+
   // erase / clear / swap / resize
   // 删除键值为 key 的所有节点
   size_type erase(const key_type& key);
@@ -427,24 +681,76 @@ class hashtable {
   reference find_or_insert(const value_type& obj);
 
   // 搜索键值为 key 的元素
-  iterator find(const key_type& key);
-  const_iterator find(const key_type& key) const;
+  iterator find(const key_type& key) { return iterator(find_node(key), this); }
+  const_iterator find(const key_type& key) const {
+    return const_iterator(find_node(key), this);
+  }
   // 计算键值为 key 的元素个数
-  size_type count(const key_type& key) const;
+  size_type count(const key_type& key) const { return count_key(key); }
+
+  pair<iterator, iterator> equal_range(const key_type& key) {
+    const pair<node_ptr, node_ptr> p = equal_range_node(key);
+    return pair<iterator, iterator>(iterator(p.first, this),
+                                    iterator(p.second, this));
+  }
+
+  pair<const_iterator, const_iterator> equal_range(const key_type& key) const {
+    const pair<node_ptr, node_ptr> p = equal_range_node(key);
+    return pair<const_iterator, const_iterator>(const_iterator(p.first, this),
+                                                const_iterator(p.second, this));
+  }
+
+  // 异构查找：hasher 和 key_equal 都声明了 is_transparent 时，可以直接用
+  // 能与键值比较的其它型别查找（比如以 const char* 查找 string 键值），
+  // 不必先构造一个 key_type 对象。两者对同一个键的哈希值必须一致
+  template <class K, class H = HashFcn, class E = EqualKey,
+            class = typename H::is_transparent,
+            class = typename E::is_transparent>
+  iterator find(const K& key) {
+    return iterator(find_node(key), this);
+  }
+
+  template <class K, class H = HashFcn, class E = EqualKey,
+            class = typename H::is_transparent,
+            class = typename E::is_transparent>
+  const_iterator find(const K& key) const {
+    return const_iterator(find_node(key), this);
+  }
 
-  pair<iterator, iterator> equal_range(const key_type& key);
+  template <class K, class H = HashFcn, class E = EqualKey,
+            class = typename H::is_transparent,
+            class = typename E::is_transparent>
+  size_type count(const K& key) const {
+    return count_key(key);
+  }
 
-  pair<const_iterator, const_iterator> euqal_range(const key_type& key) const;
+  template <class K, class H = HashFcn, class E = EqualKey,
+            class = typename H::is_transparent,
+            class = typename E::is_transparent>
+  pair<iterator, iterator> equal_range(const K& key) {
+    const pair<node_ptr, node_ptr> p = equal_range_node(key);
+    return pair<iterator, iterator>(iterator(p.first, this),
+                                    iterator(p.second, this));
+  }
+
+  template <class K, class H = HashFcn, class E = EqualKey,
+            class = typename H::is_transparent,
+            class = typename E::is_transparent>
+  pair<const_iterator, const_iterator> equal_range(const K& key) const {
+    const pair<node_ptr, node_ptr> p = equal_range_node(key);
+    return pair<const_iterator, const_iterator>(const_iterator(p.first, this),
+                                                const_iterator(p.second, this));
+  }
 
   // bucket interface
 
   size_type bucket_count() const { return buckets_.size(); }
 
   size_type max_bucket_count() const {
-    return prime_list[static_cast<int>(num_primes - 1)];
+    return BucketPolicy::max_bucket_count();
   }
 
-  // 在某个 bucket 中节点的个数
+  // 在某个 bucket 中节点的个数，渐进式 rehash 期间只统计新数组
   size_type elems_in_bucket(size_type n) const {
     size_type result = 0;
     for (node_ptr cur = buckets_[n]; cur; cur = cur->next) {
@@ -473,23 +779,143 @@ class hashtable {
  private:
   // helper function
 
+  // 分配器需要传播时，如果两个分配器不相等，buckets 必须由原分配器释放
+  // 调用前节点已经全部释放
+  void copy_assign_alloc(const hashtable& other, true_type) {
+    if (this->get_alloc() != other.get_alloc()) {
+      buckets_ =
+          bucket_type(hashtable_node_pointer_allocator(other.get_alloc()));
+      old_buckets_ =
+          bucket_type(hashtable_node_pointer_allocator(other.get_alloc()));
+    }
+    this->set_alloc(other.get_alloc());
+  }
+
+  void copy_assign_alloc(const hashtable&, false_type) {}
+
+  // 分配器随节点一起转移
+  void move_assign(hashtable& other, true_type) {
+    clear();
+    this->set_alloc(other.get_alloc());
+    hash_ = other.hash_;
+    equals_ = other.equals_;
+    getkey_ = other.getkey_;
+    buckets_ = toystl::move(other.buckets_);
+    numElements_ = other.numElements_;
+    old_buckets_ = toystl::move(other.old_buckets_);
+    rehash_pos_ = other.rehash_pos_;
+    other.numElements_ = 0;
+    other.rehash_pos_ = 0;
+  }
+
+  // 分配器不传播：分配器相等时仍然可以直接接管节点，否则只能逐个拷贝元素
+  void move_assign(hashtable& other, false_type) {
+    if (this->get_alloc() == other.get_alloc()) {
+      move_assign(other, true_type());
+    } else {
+      *this = other;
+      other.clear();
+    }
+  }
+
   // initialize_buckets
   void initialize_buckets(size_type n);
   void copy_init(const hashtable& ht);
 
   // node
-  node_ptr new_node(const value_type& obj);
+  template <class... Args>
+  node_ptr new_node(Args&&... args);
   void destroy_node(node_ptr n);
 
   // hash
   size_type next_size(size_type n) const;
+
+  // 渐进式 rehash
+  bool rehashing() const {
+    return BucketPolicy::incremental_rehash && !old_buckets_.empty();
+  }
+  // 分配新的 bucket 数组，旧数组留待之后逐步搬移
+  void start_rehash(size_type n);
+  // 搬移旧数组中的第 n 个 bucket
+  void migrate_bucket(size_type n);
+  // 搬移至多 rehash_step 个旧 bucket，搬完后释放旧数组
+  void rehash_step();
+  void finish_rehash();
+
+  // 哈希值为 h 的键值所在的 bucket：还没有搬移的旧 bucket，
+  // 或者新数组中的 bucket
+  node_ptr& bucket_of_hash(size_type h) {
+    if (rehashing()) {
+      const size_type n = BucketPolicy::bucket_index(h, old_buckets_.size());
+      if (n >= rehash_pos_) {
+        return old_buckets_[n];
+      }
+    }
+    return buckets_[BucketPolicy::bucket_index(h, buckets_.size())];
+  }
+
+  node_ptr bucket_of_hash(size_type h) const {
+    return const_cast<hashtable*>(this)->bucket_of_hash(h);
+  }
+
+  // 缓存哈希值时直接读取节点中保存的值，否则重新计算
+  size_type node_hash(const node_type* n) const {
+    return node_hash(n, cache_hash());
+  }
+  size_type node_hash(const node_type* n, true_type) const { return n->hash; }
+  size_type node_hash(const node_type* n, false_type) const {
+    return hash_(getkey_(n->value));
+  }
+
+  void set_node_hash(node_ptr n, size_type h) {
+    set_node_hash(n, h, cache_hash());
+  }
+  void set_node_hash(node_ptr n, size_type h, true_type) { n->hash = h; }
+  void set_node_hash(node_ptr, size_type, false_type) {}
+
+  // 节点的键值是否等于 key，h 是 key 的哈希值。
+  // 缓存哈希值时先比较哈希值，哈希值不同的节点不必调用 equals_
+  template <class K>
+  bool node_equals(const node_type* n, size_type h, const K& key) const {
+    return same_hash(n, h, cache_hash()) && equals_(getkey_(n->value), key);
+  }
+  bool same_hash(const node_type* n, size_type h, true_type) const {
+    return n->hash == h;
+  }
+  bool same_hash(const node_type*, size_type, false_type) const {
+    return true;
+  }
+
+  // 迭代顺序：先是新数组的各个 bucket，然后是旧数组中还没有搬移的 bucket
+  // 从新数组（in_old 为 false）或旧数组的第 n 个 bucket 开始找第一个节点
+  node_ptr scan_buckets(size_type n, bool in_old) const;
+  // 节点 n 所在 bucket 之后的第一个节点
+  node_ptr next_bucket_node(const node_type* n) const;
   // size_type hash(const key_type& key, size_type n) const;
   // size_type hash(const key_type& key);
   // void rehash_if_need(size_type n);
 
   // insert node
-  // pair<iterator, bool> insert_node_unique(node_ptr np);
-  // iterator insert_node_multi(node_ptr np);
+  // 把已经构造好的节点 np 链入表格，调用前表格大小已经调整好。
+  // 键值不允许重复的版本在键值已存在时不链入 np，返回已有的节点
+  pair<iterator, bool> insert_unique_node(node_ptr np);
+  iterator insert_equal_node(node_ptr np);
+  // 把节点 np 从所在的链表中摘下，但不销毁
+  node_ptr unlink_node(node_ptr np);
+
+  // 查找的实现，K 为 key_type 或者异构查找的参数型别
+  template <class K>
+  node_ptr find_node(const K& key) const {
+    return find_node(key, hash_(key));
+  }
+  // h 为 key 的哈希值
+  template <class K>
+  node_ptr find_node(const K& key, size_type h) const;
+  template <class K>
+  size_type count_key(const K& key) const;
+  // 键值等于 key 的节点区间 [first, last)
+  template <class K>
+  pair<node_ptr, node_ptr> equal_range_node(const K& key) const;
 
   // bucket operator
   // 在第 n 个 bucket 内，删除 [first, last) 的节点
@@ -497,41 +923,62 @@ class hashtable {
   // 在第 n 个 bucket 内，删除 [buckets_[n], last) 的节点
   void erase_bucket(size_type n, node_ptr last);
 
-  // 判断元素的落脚处 bkt_num
-  // 版本一：接受实值 和 buckets 个数
-  size_type bkt_num(const value_type& obj, size_t n) const {
-    return bkt_num_key(getkey_(obj), n);
-  }
-
-  // 版本二：只接受实值
-  size_type bkt_num(const value_type& obj) const {
-    return bkt_num_key(getkey_(obj));
-  }
-
-  // 版本三：只接受键值
-  size_type bkt_num_key(const key_type& key) const {
-    return bkt_num_key(key, buckets_.size());
+  // 判断节点的落脚处 bkt_num
+  // 版本一：接受节点 和 buckets 个数
+  size_type bkt_num(const node_type* node, size_t n) const {
+    return BucketPolicy::bucket_index(node_hash(node), n);
   }
 
-  // 版本四：接受键值 和 buckets 个数
-  size_type bkt_num_key(const key_type& key, size_t n) const {
-    return hash_(key) % n;
+  // 版本二：只接受节点
+  size_type bkt_num(const node_type* node) const {
+    return bkt_num(node, buckets_.size());
   }
 };
 
 template <class Key, class Value, class HashFcn, class ExtractKey,
-          class EqualKey, class Allocator>
+          class EqualKey, class Allocator, class BucketPolicy>
 bool operator==(
-    const hashtable<Key, Value, HashFcn, ExtractKey, EqualKey, Allocator>& ht1,
-    const hashtable<Key, Value, HashFcn, ExtractKey, EqualKey, Allocator>&
-        ht2) {
+    const hashtable<Key, Value, HashFcn, ExtractKey, EqualKey, Allocator,
+                    BucketPolicy>& ht1,
+    const hashtable<Key, Value, HashFcn, ExtractKey, EqualKey, Allocator,
+                    BucketPolicy>& ht2) {
   using Node = typename hashtable<Key, Value, HashFcn, ExtractKey, EqualKey,
-                                  Allocator>::Node;
+                                  Allocator, BucketPolicy>::node_type;
   if (ht1.size() != ht2.size()) {
     return false;
   }
 
-  for (int n = 0; n < ht1.buckets_.size(); ++n) {
+  // 节点分布不一致时（bucket 个数不同或处于渐进式 rehash 中），
+  // 逐个比较键值相同的区间
+  if (ht1.rehashing() || ht2.rehashing() ||
+      ht1.buckets_.size() != ht2.buckets_.size()) {
+    for (auto it = ht1.begin(); it != ht1.end();) {
+      auto r1 = ht1.equal_range(ht1.getkey_(*it));
+      auto r2 = ht2.equal_range(ht1.getkey_(*it));
+      if (toystl::distance(r1.first, r1.second) !=
+          toystl::distance(r2.first, r2.second)) {
+        return false;
+      }
+      // 两个区间互为排列：每个值在两边出现的次数相同
+      for (auto i = r1.first; i != r1.second; ++i) {
+        size_t count1 = 0;
+        size_t count2 = 0;
+        for (auto j = r1.first; j != r1.second; ++j) {
+          count1 += *j == *i;
+        }
+        for (auto j = r2.first; j != r2.second; ++j) {
+          count2 += *j == *i;
+        }
+        if (count1 != count2) {
+          return false;
+        }
+      }
+      it = r1.second;
+    }
+    return true;
+  }
+
+  for (size_t n = 0; n < ht1.buckets_.size(); ++n) {
     Node* cur1 = ht1.buckets_[n];
     Node* cur2 = ht2.buckets_[n];
     for (; cur1 && cur2 && cur1->value == cur2->value;
@@ -547,53 +994,224 @@ bool operator==(
 
 // 重载 toystl 的 swap
 template <class Key, class Value, class HashFcn, class ExtractKey,
-          class EqualKey, class Allocator>
+          class EqualKey, class Allocator, class BucketPolicy>
 void swap(
-    hashtable<Key, Value, HashFcn, ExtractKey, EqualKey, Allocator>& ht1,
-    hashtable<Key, Value, HashFcn, ExtractKey, EqualKey, Allocator>& ht2) {
+    hashtable<Key, Value, HashFcn, ExtractKey, EqualKey, Allocator,
+              BucketPolicy>& ht1,
+    hashtable<Key, Value, HashFcn, ExtractKey, EqualKey, Allocator,
+              BucketPolicy>& ht2) {
   ht1.swap(ht2);
 }
 
 template <class Key, class Value, class HashFcn, class ExtractKey,
-          class EqualKey, class Allocator>
+          class EqualKey, class Allocator, class BucketPolicy>
 toystl::pair<typename hashtable<Key, Value, HashFcn, ExtractKey, EqualKey,
-                                Allocator>::iterator,
+                                Allocator, BucketPolicy>::iterator,
              bool>
-hashtable<Key, Value, HashFcn, ExtractKey, EqualKey,
-          Allocator>::insert_unique_noresize(const value_type& value) {
-  const size_type n = bkt_num(value);
-  node_type* first = buckets_[n];
+hashtable<Key, Value, HashFcn, ExtractKey, EqualKey, Allocator,
+          BucketPolicy>::insert_unique_noresize(const value_type& value) {
+  const size_type h = hash_(getkey_(value));
+  node_ptr& head = bucket_of_hash(h);
+  node_type* first = head;
 
-  // 如果 buckets_[n] 已经被占用，此时 first 不为 0，于是进入以下循环
+  // 如果 bucket 已经被占用，此时 first 不为 0，于是进入以下循环
   // 走过 bucket 所对应的整个链表
   for (node_type* cur = first; cur; cur = cur->next) {
-    if (equals_(getkey_(cur->value), getkey_(value))) {
+    if (node_equals(cur, h, getkey_(value))) {
       // 如果发现与链表中的某键值相同，就不插入，立刻返回
       return pair<iterator, bool>(iterator(cur, this), false);
     }
   }
 
   node_type* tmp = new_node(value);
+  set_node_hash(tmp, h);
   tmp->next = first;
-  buckets_[n] = tmp;
+  head = tmp;
   ++numElements_;
   return toystl::pair<iterator, bool>(iterator(tmp, this), true);
 }
 
-// 在不需要重建表格的情况下插入新节点。键值允许重复
 template <class Key, class Value, class HashFcn, class ExtractKey,
-          class EqualKey, class Allocator>
+          class EqualKey, class Allocator, class BucketPolicy>
+template <class... Args>
+toystl::pair<typename hashtable<Key, Value, HashFcn, ExtractKey, EqualKey,
+                                Allocator, BucketPolicy>::iterator,
+             bool>
+hashtable<Key, Value, HashFcn, ExtractKey, EqualKey, Allocator,
+          BucketPolicy>::emplace_unique(Args&&... args) {
+  node_ptr tmp = new_node(toystl::forward<Args>(args)...);
+  try {
+    set_node_hash(tmp, hash_(getkey_(tmp->value)));
+    resize(numElements_ + 1);
+  } catch (...) {
+    destroy_node(tmp);
+    throw;
+  }
+  rehash_step();
+
+  pair<iterator, bool> result = insert_unique_node(tmp);
+  if (!result.second) {
+    // 键值已经存在，放弃刚构造的节点
+    destroy_node(tmp);
+  }
+  return result;
+}
+
+template <class Key, class Value, class HashFcn, class ExtractKey,
+          class EqualKey, class Allocator, class BucketPolicy>
+template <class... Args>
+typename hashtable<Key, Value, HashFcn, ExtractKey, EqualKey,
+                   Allocator, BucketPolicy>::iterator
+hashtable<Key, Value, HashFcn, ExtractKey, EqualKey, Allocator,
+          BucketPolicy>::emplace_equal(Args&&... args) {
+  node_ptr tmp = new_node(toystl::forward<Args>(args)...);
+  try {
+    set_node_hash(tmp, hash_(getkey_(tmp->value)));
+    resize(numElements_ + 1);
+  } catch (...) {
+    destroy_node(tmp);
+    throw;
+  }
+  rehash_step();
+  return insert_equal_node(tmp);
+}
+
+template <class Key, class Value, class HashFcn, class ExtractKey,
+          class EqualKey, class Allocator, class BucketPolicy>
+template <class K, class... Args>
+toystl::pair<typename hashtable<Key, Value, HashFcn, ExtractKey, EqualKey,
+                                Allocator, BucketPolicy>::iterator,
+             bool>
+hashtable<Key, Value, HashFcn, ExtractKey, EqualKey, Allocator,
+          BucketPolicy>::try_emplace_unique(K&& key, Args&&... args) {
+  resize(numElements_ + 1);
+  rehash_step();
+
+  const size_type h = hash_(key);
+  node_ptr& head = bucket_of_hash(h);
+  for (node_type* cur = head; cur; cur = cur->next) {
+    if (node_equals(cur, h, key)) {
+      return pair<iterator, bool>(iterator(cur, this), false);
+    }
+  }
+
+  // 键值和实值直接在节点中构造，不经过临时的实值
+  node_type* tmp = new_node(
+      piecewise_construct, std::forward_as_tuple(toystl::forward<K>(key)),
+      std::forward_as_tuple(toystl::forward<Args>(args)...));
+  set_node_hash(tmp, h);
+  tmp->next = head;
+  head = tmp;
+  ++numElements_;
+  return toystl::pair<iterator, bool>(iterator(tmp, this), true);
+}
+
+template <class Key, class Value, class HashFcn, class ExtractKey,
+          class EqualKey, class Allocator, class BucketPolicy>
+typename hashtable<Key, Value, HashFcn, ExtractKey, EqualKey,
+                   Allocator, BucketPolicy>::insert_return_type
+hashtable<Key, Value, HashFcn, ExtractKey, EqualKey, Allocator,
+          BucketPolicy>::insert_unique(node_handle&& nh) {
+  if (nh.empty()) {
+    return insert_return_type{end(), false, node_handle()};
+  }
+  resize(numElements_ + 1);
+  rehash_step();
+
+  // 节点的键值可能已经通过 key() 修改过，保存的哈希值不能再用
+  set_node_hash(nh.node_, hash_(getkey_(nh.node_->value)));
+  pair<iterator, bool> result = insert_unique_node(nh.node_);
+  if (!result.second) {
+    return insert_return_type{result.first, false, toystl::move(nh)};
+  }
+  nh.release();
+  return insert_return_type{result.first, true, node_handle()};
+}
+
+template <class Key, class Value, class HashFcn, class ExtractKey,
+          class EqualKey, class Allocator, class BucketPolicy>
 typename hashtable<Key, Value, HashFcn, ExtractKey, EqualKey,
-                   Allocator>::iterator
-hashtable<Key, Value, HashFcn, ExtractKey, EqualKey,
-          Allocator>::insert_equal_noresize(const value_type& value) {
-  const size_type n = bkt_num(value);
-  node_type* first = buckets_[n];
+                   Allocator, BucketPolicy>::iterator
+hashtable<Key, Value, HashFcn, ExtractKey, EqualKey, Allocator,
+          BucketPolicy>::insert_equal(node_handle&& nh) {
+  if (nh.empty()) {
+    return end();
+  }
+  resize(numElements_ + 1);
+  rehash_step();
+  // 同 insert_unique(node_handle&&)，键值可能已经修改过
+  set_node_hash(nh.node_, hash_(getkey_(nh.node_->value)));
+  return insert_equal_node(nh.release());
+}
+
+template <class Key, class Value, class HashFcn, class ExtractKey,
+          class EqualKey, class Allocator, class BucketPolicy>
+void hashtable<Key, Value, HashFcn, ExtractKey, EqualKey, Allocator,
+               BucketPolicy>::merge_unique(hashtable& src) {
+  if (&src == this) {
+    return;
+  }
+  for (iterator it = src.begin(); it != src.end();) {
+    // 先走到下一个节点，当前节点被摘下后 it 仍然有效
+    node_ptr np = (it++).cur_;
+    resize(numElements_ + 1);
+    rehash_step();
+    if (!find_node(getkey_(np->value), src.node_hash(np))) {
+      insert_unique_node(src.unlink_node(np));
+    }
+  }
+}
+
+template <class Key, class Value, class HashFcn, class ExtractKey,
+          class EqualKey, class Allocator, class BucketPolicy>
+void hashtable<Key, Value, HashFcn, ExtractKey, EqualKey, Allocator,
+               BucketPolicy>::merge_equal(hashtable& src) {
+  if (&src == this) {
+    return;
+  }
+  for (iterator it = src.begin(); it != src.end();) {
+    node_ptr np = (it++).cur_;
+    resize(numElements_ + 1);
+    rehash_step();
+    insert_equal_node(src.unlink_node(np));
+  }
+}
+
+template <class Key, class Value, class HashFcn, class ExtractKey,
+          class EqualKey, class Allocator, class BucketPolicy>
+toystl::pair<typename hashtable<Key, Value, HashFcn, ExtractKey, EqualKey,
+                                Allocator, BucketPolicy>::iterator,
+             bool>
+hashtable<Key, Value, HashFcn, ExtractKey, EqualKey, Allocator,
+          BucketPolicy>::insert_unique_node(node_ptr np) {
+  const size_type h = node_hash(np);
+  node_ptr& head = bucket_of_hash(h);
+  for (node_type* cur = head; cur; cur = cur->next) {
+    if (node_equals(cur, h, getkey_(np->value))) {
+      return pair<iterator, bool>(iterator(cur, this), false);
+    }
+  }
+
+  np->next = head;
+  head = np;
+  ++numElements_;
+  return toystl::pair<iterator, bool>(iterator(np, this), true);
+}
+
+// 把构造好的节点链入表格，与键值相同的节点相邻。键值允许重复
+template <class Key, class Value, class HashFcn, class ExtractKey,
+          class EqualKey, class Allocator, class BucketPolicy>
+typename hashtable<Key, Value, HashFcn, ExtractKey, EqualKey,
+                   Allocator, BucketPolicy>::iterator
+hashtable<Key, Value, HashFcn, ExtractKey, EqualKey, Allocator,
+          BucketPolicy>::insert_equal_node(node_ptr tmp) {
+  const size_type h = node_hash(tmp);
+  node_ptr& head = bucket_of_hash(h);
+  node_type* first = head;
 
   for (node_type* cur = first; cur; cur = cur->next) {
     // 如果发现与链表中的某键值相同，就马上插入，然后返回
-    if (equals_(getkey_(cur->value), getkey_(value))) {
-      node_type* tmp = new_node(value);
+    if (node_equals(cur, h, getkey_(tmp->value))) {
       tmp->next = cur->next;
       cur->next = tmp;
       ++numElements_;
@@ -602,21 +1220,21 @@ hashtable<Key, Value, HashFcn, ExtractKey, EqualKey,
   }
 
   // 进行至此，没有发现重复的键值
-  node_type* tmp = new_node(value);
   tmp->next = first;
-  buckets_[n] = tmp;
+  head = tmp;
   ++numElements_;
   return iterator(tmp, this);
 }
 
 template <class Key, class Value, class HashFcn, class ExtractKey,
-          class EqualKey, class Allocator>
+          class EqualKey, class Allocator, class BucketPolicy>
 typename hashtable<Key, Value, HashFcn, ExtractKey, EqualKey,
-                   Allocator>::size_type
-hashtable<Key, Value, HashFcn, ExtractKey, EqualKey, Allocator>::erase(
-    const key_type& key) {
-  const size_type n = bkt_num_key(key);
-  node_type* first = buckets_[n];
+                   Allocator, BucketPolicy>::size_type
+hashtable<Key, Value, HashFcn, ExtractKey, EqualKey, Allocator,
+          BucketPolicy>::erase(const key_type& key) {
+  const size_type h = hash_(key);
+  node_ptr& head = bucket_of_hash(h);
+  node_type* first = head;
   size_type erased = 0;
 
   if (first) {
@@ -624,7 +1242,7 @@ hashtable<Key, Value, HashFcn, ExtractKey, EqualKey, Allocator>::erase(
     node_type* cur = first;
     node_type* cur_next = cur->next;
     while (cur_next) {
-      if (equals_(getkey_(cur_next->value), key)) {
+      if (node_equals(cur_next, h, key)) {
         cur->next = cur_next->next;
         destroy_node(cur_next);
         cur_next = cur->next;
@@ -636,8 +1254,8 @@ hashtable<Key, Value, HashFcn, ExtractKey, EqualKey, Allocator>::erase(
       }
     }
 
-    if (equals_(getkey_(first->value), key)) {
-      buckets_[n] = first->next;
+    if (node_equals(first, h, key)) {
+      head = first->next;
       destroy_node(first);
       ++erased;
       --numElements_;
@@ -648,42 +1266,29 @@ hashtable<Key, Value, HashFcn, ExtractKey, EqualKey, Allocator>::erase(
 }
 
 template <class Key, class Value, class HashFcn, class ExtractKey,
-          class EqualKey, class Allocator>
-void hashtable<Key, Value, HashFcn, ExtractKey, EqualKey, Allocator>::erase(
-    const iterator& it) {
-  node_type* p = it.cur_;
-  if (p) {
-    const size_type n = bkt_num(p->value);
-    node_type* cur = buckets_[n];
-
-    if (cur == p) {  // 如果要删除的节点就在 buckets_[n] 的头部，直接删除
-      buckets_[n] = cur->next;
-      destroy_node(cur);
-      --numElements_;
-    } else {  // 否则，需要找到这个节点，然后删除
-      node_type* next = cur->next;
-      while (next) {
-        if (next == p) {
-          cur->next = next->next;
-          destroy_node(next);
-          --numElements_;
-          break;
-        } else {
-          cur = next;
-          next = cur->next;
-        }
-      }
-    }
+          class EqualKey, class Allocator, class BucketPolicy>
+void hashtable<Key, Value, HashFcn, ExtractKey, EqualKey, Allocator,
+               BucketPolicy>::erase(const iterator& it) {
+  if (it.cur_) {
+    destroy_node(unlink_node(it.cur_));
   }
 }
 
 template <class Key, class Value, class HashFcn, class ExtractKey,
-          class EqualKey, class Allocator>
-void hashtable<Key, Value, HashFcn, ExtractKey, EqualKey, Allocator>::erase(
-    iterator first, iterator last) {
+          class EqualKey, class Allocator, class BucketPolicy>
+void hashtable<Key, Value, HashFcn, ExtractKey, EqualKey, Allocator,
+               BucketPolicy>::erase(iterator first, iterator last) {
+  // 渐进式 rehash 期间节点分布在两个数组中，逐个删除
+  if (rehashing()) {
+    while (first != last) {
+      erase(first++);
+    }
+    return;
+  }
+
   size_type f_bucket =
-      first.cur_ ? bkt_num(first.cur_->value) : buckets_.size();
-  size_type l_bucket = last.cur_ ? bkt_num(last.cur_->value) : buckets_.size();
+      first.cur_ ? bkt_num(first.cur_) : buckets_.size();
+  size_type l_bucket = last.cur_ ? bkt_num(last.cur_) : buckets_.size();
 
   if (first.cur_ == last.cur_) {
     return;
@@ -702,17 +1307,17 @@ void hashtable<Key, Value, HashFcn, ExtractKey, EqualKey, Allocator>::erase(
 }
 
 template <class Key, class Value, class HashFcn, class ExtractKey,
-          class EqualKey, class Allocator>
-void hashtable<Key, Value, HashFcn, ExtractKey, EqualKey, Allocator>::erase(
-    const const_iterator& it) {
+          class EqualKey, class Allocator, class BucketPolicy>
+void hashtable<Key, Value, HashFcn, ExtractKey, EqualKey, Allocator,
+               BucketPolicy>::erase(const const_iterator& it) {
   erase(iterator(const_cast<node_type*>(it.cur_),
-                 const_cast<node_type*>(it.ht_)));
+                 const_cast<hashtable*>(it.ht_)));
 }
 
 template <class Key, class Value, class HashFcn, class ExtractKey,
-          class EqualKey, class Allocator>
-void hashtable<Key, Value, HashFcn, ExtractKey, EqualKey, Allocator>::erase(
-    const_iterator first, const_iterator last) {
+          class EqualKey, class Allocator, class BucketPolicy>
+void hashtable<Key, Value, HashFcn, ExtractKey, EqualKey, Allocator,
+               BucketPolicy>::erase(const_iterator first, const_iterator last) {
   erase(iterator(const_cast<node_type*>(first.cur_),
                  const_cast<hashtable*>(first.ht_)),
         iterator(const_cast<node_type*>(last.cur_),
@@ -720,8 +1325,9 @@ void hashtable<Key, Value, HashFcn, ExtractKey, EqualKey, Allocator>::erase(
 }
 
 template <class Key, class Value, class HashFcn, class ExtractKey,
-          class EqualKey, class Allocator>
-void hashtable<Key, Value, HashFcn, ExtractKey, EqualKey, Allocator>::clear() {
+          class EqualKey, class Allocator, class BucketPolicy>
+void hashtable<Key, Value, HashFcn, ExtractKey, EqualKey, Allocator,
+               BucketPolicy>::clear() {
   for (size_type i = 0; i < buckets_.size(); ++i) {
     node_ptr cur = buckets_[i];
     while (cur != nullptr) {
@@ -732,6 +1338,17 @@ void hashtable<Key, Value, HashFcn, ExtractKey, EqualKey, Allocator>::clear() {
     }
     buckets_[i] = nullptr;  // 令 bucket 内容为 空
   }
+  for (size_type i = rehash_pos_; i < old_buckets_.size(); ++i) {
+    node_ptr cur = old_buckets_[i];
+    while (cur != nullptr) {
+      node_ptr next = cur->next;
+      destroy_node(cur);
+      cur = next;
+    }
+  }
+  // 旧数组不再需要，直接释放
+  bucket_type(old_buckets_.get_allocator()).swap(old_buckets_);
+  rehash_pos_ = 0;
 
   numElements_ = 0;  // 令总节点个数为0
 
@@ -739,29 +1356,38 @@ void hashtable<Key, Value, HashFcn, ExtractKey, EqualKey, Allocator>::clear() {
 }
 
 template <class Key, class Value, class HashFcn, class ExtractKey,
-          class EqualKey, class Allocator>
-void hashtable<Key, Value, HashFcn, ExtractKey, EqualKey, Allocator>::swap(
-    hashtable& ht) {
+          class EqualKey, class Allocator, class BucketPolicy>
+void hashtable<Key, Value, HashFcn, ExtractKey, EqualKey, Allocator,
+               BucketPolicy>::swap(hashtable& ht) {
+  // 分配器按 propagate_on_container_swap 决定是否交换，buckets 同理
+  this->swap_alloc(ht);
   toystl::swap(hash_, ht.hash_);
   toystl::swap(equals_, ht.equals_);
   toystl::swap(getkey_, ht.getkey_);
   buckets_.swap(ht.buckets_);
   toystl::swap(numElements_, ht.numElements_);
+  old_buckets_.swap(ht.old_buckets_);
+  toystl::swap(rehash_pos_, ht.rehash_pos_);
 }
 
 template <class Key, class Value, class HashFcn, class ExtractKey,
-          class EqualKey, class Allocator>
-void hashtable<Key, Value, HashFcn, ExtractKey, EqualKey, Allocator>::resize(
-    size_type num_elements_hint) {
+          class EqualKey, class Allocator, class BucketPolicy>
+void hashtable<Key, Value, HashFcn, ExtractKey, EqualKey, Allocator,
+               BucketPolicy>::resize(size_type num_elements_hint) {
   // 表格重建与否的判断原则，拿元素个数（将新增元素计入后）和 bucket vector
   // 的大小来比，如果前者大于后者，就重建表格
   // 由此可以判知，每个 bucket 最多放 buckets_.size() 个节点
   const size_type old_n = buckets_.size();
-  if (numElements_ > old_n) {
+  if (num_elements_hint > old_n) {
     const size_type n = next_size(num_elements_hint);
     if (n > old_n) {
-      vector<node_type*, hashtable_node_pointer_allocator> tmp(
-          n, static_cast<node_type*>(0));  // 设立新的 buckets
+      // 渐进式 rehash 只分配新数组，节点留到之后的插入中搬移
+      if (BucketPolicy::incremental_rehash) {
+        start_rehash(n);
+        return;
+      }
+      bucket_type tmp(n, static_cast<node_type*>(0),
+                      buckets_.get_allocator());  // 设立新的 buckets
       try {
         for (size_type bucket = 0; bucket < old_n; ++bucket) {
           node_type* first =
@@ -769,7 +1395,7 @@ void hashtable<Key, Value, HashFcn, ExtractKey, EqualKey, Allocator>::resize(
           // 以下处理每一个旧的 bucket 所含的每一个节点
           while (first) {
             // 以下找出节点落在哪一个新的 bucket 内
-            size_type new_bucket = bkt_num(first->value, n);
+            size_type new_bucket = bkt_num(first, n);
             // (1) 令旧的 bucket 指向其所对应之串行的下一个节点（以便迭代处理）
             buckets_[bucket] = first->next;
             // (2)(3) 将当前节点插入到新 bucket 内，成为其对应串行的第一个节点
@@ -796,68 +1422,58 @@ void hashtable<Key, Value, HashFcn, ExtractKey, EqualKey, Allocator>::resize(
 }
 
 template <class Key, class Value, class HashFcn, class ExtractKey,
-          class EqualKey, class Allocator>
+          class EqualKey, class Allocator, class BucketPolicy>
 typename hashtable<Key, Value, HashFcn, ExtractKey, EqualKey,
-                   Allocator>::reference
-hashtable<Key, Value, HashFcn, ExtractKey, EqualKey, Allocator>::find_or_insert(
-    const value_type& obj) {
+                   Allocator, BucketPolicy>::reference
+hashtable<Key, Value, HashFcn, ExtractKey, EqualKey, Allocator,
+          BucketPolicy>::find_or_insert(const value_type& obj) {
   resize(numElements_ + 1);
+  rehash_step();
 
-  size_type n = bkt_num(obj);
-  node_type* first = buckets_[n];
+  const size_type h = hash_(getkey_(obj));
+  node_ptr& head = bucket_of_hash(h);
+  node_type* first = head;
 
   for (node_type* cur = first; cur; cur = cur->next) {
-    if (equals_(getkey_(cur->value), getkey_(obj))) {
+    if (node_equals(cur, h, getkey_(obj))) {
       return cur->value;
     }
   }
 
   node_type* tmp = new_node(obj);
+  set_node_hash(tmp, h);
   tmp->next = first;
-  buckets_[n] = tmp;
+  head = tmp;
   ++numElements_;
   return tmp->value;
 }
 
 template <class Key, class Value, class HashFcn, class ExtractKey,
-          class EqualKey, class Allocator>
+          class EqualKey, class Allocator, class BucketPolicy>
+template <class K>
 typename hashtable<Key, Value, HashFcn, ExtractKey, EqualKey,
-                   Allocator>::iterator
-hashtable<Key, Value, HashFcn, ExtractKey, EqualKey, Allocator>::find(
-    const key_type& key) {
-  size_type n = bkt_num_key(key);
+                   Allocator, BucketPolicy>::node_ptr
+hashtable<Key, Value, HashFcn, ExtractKey, EqualKey, Allocator,
+          BucketPolicy>::find_node(const K& key, size_type h) const {
   node_type* first;
-  for (first = buckets_[n]; first && equals_(getkey_(first->value), key);
+  for (first = bucket_of_hash(h); first && !node_equals(first, h, key);
        first = first->next) {
   }
-  return iterator(first, this);
+  return first;
 }
 
 template <class Key, class Value, class HashFcn, class ExtractKey,
-          class EqualKey, class Allocator>
+          class EqualKey, class Allocator, class BucketPolicy>
+template <class K>
 typename hashtable<Key, Value, HashFcn, ExtractKey, EqualKey,
-                   Allocator>::const_iterator
-hashtable<Key, Value, HashFcn, ExtractKey, EqualKey, Allocator>::find(
-    const key_type& key) const {
-  size_type n = bkt_num_key(key);
-  node_type* first;
-  for (first = buckets_[n]; first && equals_(getkey_(first->value), key);
-       first = first->next) {
-  }
-  return const_iterator(first, this);
-}
-
-template <class Key, class Value, class HashFcn, class ExtractKey,
-          class EqualKey, class Allocator>
-typename hashtable<Key, Value, HashFcn, ExtractKey, EqualKey,
-                   Allocator>::size_type
-hashtable<Key, Value, HashFcn, ExtractKey, EqualKey, Allocator>::count(
-    const key_type& key) const {
-  const size_type n = bkt_num_key(key);
+                   Allocator, BucketPolicy>::size_type
+hashtable<Key, Value, HashFcn, ExtractKey, EqualKey, Allocator,
+          BucketPolicy>::count_key(const K& key) const {
+  const size_type h = hash_(key);
   size_type result = 0;
   // 以下，从 bucket list 的头开始，一一对比每个元素的键值，对比成功就累加1
-  for (const node_type* cur = buckets_[n]; cur; cur = cur->next) {
-    if (equals_(getkey_(cur->value), key)) {
+  for (const node_type* cur = bucket_of_hash(h); cur; cur = cur->next) {
+    if (node_equals(cur, h, key)) {
       ++result;
     }
   }
@@ -866,100 +1482,55 @@ hashtable<Key, Value, HashFcn, ExtractKey, EqualKey, Allocator>::count(
 }
 
 template <class Key, class Value, class HashFcn, class ExtractKey,
-          class EqualKey, class Allocator>
+          class EqualKey, class Allocator, class BucketPolicy>
+template <class K>
 pair<typename hashtable<Key, Value, HashFcn, ExtractKey, EqualKey,
-                        Allocator>::iterator,
+                        Allocator, BucketPolicy>::node_ptr,
      typename hashtable<Key, Value, HashFcn, ExtractKey, EqualKey,
-                        Allocator>::iterator>
-hashtable<Key, Value, HashFcn, ExtractKey, EqualKey, Allocator>::equal_range(
-    const key_type& key) {
-  using Pii = pair<iterator, iterator>;
-  const size_type n = bkt_num_key(key);  // 决定 key 位于 #n bucket
-
-  // 如果 buckets_[n] 已被占用，此时 first 不为 0，进入下面的循环
-  for (node_type* first = buckets_[n]; first; first = first->next) {
+                        Allocator, BucketPolicy>::node_ptr>
+hashtable<Key, Value, HashFcn, ExtractKey, EqualKey, Allocator,
+          BucketPolicy>::equal_range_node(const K& key) const {
+  using Pii = pair<node_ptr, node_ptr>;
+  const size_type h = hash_(key);
+  // 如果 key 所在的 bucket 已被占用，此时 first 不为 0，进入下面的循环
+  for (node_type* first = bucket_of_hash(h); first; first = first->next) {
     // 在 list 中找到 一个节点，其键值等于 key，进入以下循环
     // 然后再找最后一个
-    if (equals_(getkey_(first->value), key)) {
+    if (node_equals(first, h, key)) {
       for (node_type* cur = first->next; cur; cur = cur->next) {
         // 如果找到一个节点的键值不等于 key，则返回
-        if (!equals_(getkey_(first->value), key)) {
-          return Pii(iterator(first, this), iterator(cur, this));
+        if (!node_equals(cur, h, key)) {
+          return Pii(first, cur);
         }
       }
       // 如果找到最后都没有找到一个节点的键值不等于 key，进入下一个 非空 bucket
       // 返回的迭代器，一个是指向 第一个键值等于 key
       // 的节点，另外一个是下一个非空 bucket 的头节点
-      for (size_type m = n + 1; m < buckets_.size(); ++m) {
-        if (buckets_[m]) {
-          return Pii(iterator(first, this), iterator(buckets_[m], this));
-        }
-      }
-
-      return Pii(iterator(first, this), end());
+      return Pii(first, next_bucket_node(first));
     }
   }
 
-  return Pii(end(), end());
-}
-
-template <class Key, class Value, class HashFcn, class ExtractKey,
-          class EqualKey, class Allocator>
-pair<typename hashtable<Key, Value, HashFcn, ExtractKey, EqualKey,
-                        Allocator>::const_iterator,
-     typename hashtable<Key, Value, HashFcn, ExtractKey, EqualKey,
-                        Allocator>::const_iterator>
-hashtable<Key, Value, HashFcn, ExtractKey, EqualKey, Allocator>::euqal_range(
-    const key_type& key) const {
-  using Pii = pair<const_iterator, const_iterator>;
-  const size_type n = bkt_num_key(key);  // 决定 key 位于 #n bucket
-
-  // 如果 buckets_[n] 已被占用，此时 first 不为 0，进入下面的循环
-  for (node_type* first = buckets_[n]; first; first = first->next) {
-    // 在 list 中找到 一个节点，其键值等于 key，进入以下循环
-    // 然后再找最后一个
-    if (equals_(getkey_(first->value), key)) {
-      for (node_type* cur = first->next; cur; cur = cur->next) {
-        // 如果找到一个节点的键值不等于 key，则返回
-        if (!equals_(getkey_(first->value), key)) {
-          return Pii(const_iterator(first, this), const_iterator(cur, this));
-        }
-      }
-      // 如果找到最后都没有找到一个节点的键值不等于 key，进入下一个 非空 bucket
-      // 返回的迭代器，一个是指向 第一个键值等于 key
-      // 的节点，另外一个是下一个非空 bucket 的头节点
-      for (size_type m = n + 1; m < buckets_.size(); ++m) {
-        if (buckets_[m]) {
-          return Pii(const_iterator(first, this),
-                     const_iterator(buckets_[m], this));
-        }
-      }
-
-      return Pii(const_iterator(first, this), end());
-    }
-  }
-
-  return Pii(end(), end());
+  return Pii(nullptr, nullptr);
 }
 
 /************************************************************************************************************/
 // helper function
 
 template <class Key, class Value, class HashFcn, class ExtractKey,
-          class EqualKey, class Allocator>
+          class EqualKey, class Allocator, class BucketPolicy>
 void hashtable<Key, Value, HashFcn, ExtractKey, EqualKey,
-               Allocator>::initialize_buckets(size_type n) {
+               Allocator, BucketPolicy>::initialize_buckets(size_type n) {
   const size_type bucket_nums =
-      next_size(n);  // 返回最接近 n 并大于或等于 n 的质数
+      next_size(n);  // 返回由 BucketPolicy 决定的不小于 n 的 bucket 个数
   buckets_.reserve(bucket_nums);
   buckets_.insert(buckets_.end(), bucket_nums, static_cast<node_type*>(0));
   numElements_ = 0;
 }
 
 template <class Key, class Value, class HashFcn, class ExtractKey,
-          class EqualKey, class Allocator>
-void hashtable<Key, Value, HashFcn, ExtractKey, EqualKey, Allocator>::copy_init(
-    const hashtable& ht) {
+          class EqualKey, class Allocator, class BucketPolicy>
+void hashtable<Key, Value, HashFcn, ExtractKey, EqualKey, Allocator,
+               BucketPolicy>::copy_init(const hashtable& ht) {
   buckets_.clear();
   buckets_.reserve(ht.buckets_.size());
   buckets_.insert(buckets_.end(), ht.buckets_.size(),
@@ -969,33 +1540,48 @@ void hashtable<Key, Value, HashFcn, ExtractKey, EqualKey, Allocator>::copy_init(
       node_ptr cur = ht.buckets_[i];
       if (cur) {
         node_ptr copy = new_node(cur->value);
+        set_node_hash(copy, ht.node_hash(cur));
         buckets_[i] = copy;
 
         for (node_ptr next = cur->next; next;
              cur = next, next = cur->next) {  // 复制链表
           copy->next = new_node(next->value);
           copy = copy->next;
+          set_node_hash(copy, ht.node_hash(next));
         }
       }
     }
+    // ht 还没有搬移的旧 bucket 直接插入到新数组中。键值相同的节点在链表中
+    // 是相邻的，逐个插到链表头之后依然相邻
+    for (size_type i = ht.rehash_pos_; i < ht.old_buckets_.size(); ++i) {
+      for (node_ptr cur = ht.old_buckets_[i]; cur; cur = cur->next) {
+        node_ptr copy = new_node(cur->value);
+        set_node_hash(copy, ht.node_hash(cur));
+        node_ptr& head = buckets_[bkt_num(copy)];
+        copy->next = head;
+        head = copy;
+      }
+    }
     numElements_ = ht.numElements_;
   } catch (...) {
     clear();
+    throw;
   }
 }
 
 template <class Key, class Value, class HashFcn, class ExtractKey,
-          class EqualKey, class Allocator>
+          class EqualKey, class Allocator, class BucketPolicy>
+template <class... Args>
 typename hashtable<Key, Value, HashFcn, ExtractKey, EqualKey,
-                   Allocator>::node_ptr
-hashtable<Key, Value, HashFcn, ExtractKey, EqualKey, Allocator>::new_node(
-    const value_type& obj) {
-  node_ptr tmp = hashtable_node_allocator::allocate(1);
+                   Allocator, BucketPolicy>::node_ptr
+hashtable<Key, Value, HashFcn, ExtractKey, EqualKey, Allocator,
+          BucketPolicy>::new_node(Args&&... args) {
+  node_ptr tmp = hashtable_node_allocator(this->get_alloc()).allocate(1);
   tmp->next = nullptr;
   try {
-    construct(&tmp->value, obj);
+    construct(&tmp->value, toystl::forward<Args>(args)...);
   } catch (...) {
-    hashtable_node_allocator::deallocate(tmp, 1);
+    hashtable_node_allocator(this->get_alloc()).deallocate(tmp, 1);
     throw;
   }
 
@@ -1003,28 +1589,29 @@ hashtable<Key, Value, HashFcn, ExtractKey, EqualKey, Allocator>::new_node(
 }
 
 template <class Key, class Value, class HashFcn, class ExtractKey,
-          class EqualKey, class Allocator>
+          class EqualKey, class Allocator, class BucketPolicy>
 void hashtable<Key, Value, HashFcn, ExtractKey, EqualKey,
-               Allocator>::destroy_node(node_ptr n) {
+               Allocator, BucketPolicy>::destroy_node(node_ptr n) {
   // 优先级：-> 大于 &
   destroy(&n->value);
-  hashtable_node_allocator::deallocate(n, 1);
+  hashtable_node_allocator(this->get_alloc()).deallocate(n, 1);
   n = nullptr;
 }
 
 template <class Key, class Value, class HashFcn, class ExtractKey,
-          class EqualKey, class Allocator>
+          class EqualKey, class Allocator, class BucketPolicy>
 typename hashtable<Key, Value, HashFcn, ExtractKey, EqualKey,
-                   Allocator>::size_type
-hashtable<Key, Value, HashFcn, ExtractKey, EqualKey, Allocator>::next_size(
-    size_type n) const {
-  return next_prime(n);
+                   Allocator, BucketPolicy>::size_type
+hashtable<Key, Value, HashFcn, ExtractKey, EqualKey, Allocator,
+          BucketPolicy>::next_size(size_type n) const {
+  return BucketPolicy::next_size(n);
 }
 
 template <class Key, class Value, class HashFcn, class ExtractKey,
-          class EqualKey, class Allocator>
+          class EqualKey, class Allocator, class BucketPolicy>
 void hashtable<Key, Value, HashFcn, ExtractKey, EqualKey,
-               Allocator>::erase_bucket(size_type n, node_ptr first,
+               Allocator, BucketPolicy>::erase_bucket(size_type n,
+                                                      node_ptr first,
                                         node_ptr last) {
   node_type* cur = buckets_[n];
   if (cur == first) {
@@ -1044,9 +1631,10 @@ void hashtable<Key, Value, HashFcn, ExtractKey, EqualKey,
 }
 
 template <class Key, class Value, class HashFcn, class ExtractKey,
-          class EqualKey, class Allocator>
+          class EqualKey, class Allocator, class BucketPolicy>
 void hashtable<Key, Value, HashFcn, ExtractKey, EqualKey,
-               Allocator>::erase_bucket(size_type n, node_ptr last) {
+               Allocator, BucketPolicy>::erase_bucket(size_type n,
+                                                      node_ptr last) {
   node_type* cur = buckets_[n];
   while (cur != last) {
     node_type* next = cur->next;
@@ -1056,6 +1644,130 @@ void hashtable<Key, Value, HashFcn, ExtractKey, EqualKey,
     --numElements_;
   }
 }
+
+template <class Key, class Value, class HashFcn, class ExtractKey,
+          class EqualKey, class Allocator, class BucketPolicy>
+typename hashtable<Key, Value, HashFcn, ExtractKey, EqualKey,
+                   Allocator, BucketPolicy>::node_ptr
+hashtable<Key, Value, HashFcn, ExtractKey, EqualKey, Allocator,
+          BucketPolicy>::unlink_node(node_ptr np) {
+  node_ptr& head = bucket_of_hash(node_hash(np));
+  if (head == np) {  // 如果节点就在 bucket 的头部，直接摘下
+    head = np->next;
+  } else {  // 否则，需要找到它的前一个节点
+    node_type* cur = head;
+    while (cur->next != np) {
+      cur = cur->next;
+    }
+    cur->next = np->next;
+  }
+  np->next = nullptr;
+  --numElements_;
+
+  return np;
+}
+
+template <class Key, class Value, class HashFcn, class ExtractKey,
+          class EqualKey, class Allocator, class BucketPolicy>
+void hashtable<Key, Value, HashFcn, ExtractKey, EqualKey, Allocator,
+               BucketPolicy>::start_rehash(size_type n) {
+  // 上一轮还没有搬完时，先把它搬完
+  finish_rehash();
+  bucket_type tmp(n, static_cast<node_type*>(0), buckets_.get_allocator());
+  old_buckets_.swap(buckets_);
+  buckets_.swap(tmp);
+  rehash_pos_ = 0;
+  rehash_step();
+}
+
+template <class Key, class Value, class HashFcn, class ExtractKey,
+          class EqualKey, class Allocator, class BucketPolicy>
+void hashtable<Key, Value, HashFcn, ExtractKey, EqualKey, Allocator,
+               BucketPolicy>::migrate_bucket(size_type n) {
+  // 与 resize 相同，逐个摘下旧 bucket 的节点插到新 bucket 的链表头
+  node_type* first = old_buckets_[n];
+  while (first) {
+    node_ptr& head = buckets_[bkt_num(first)];
+    old_buckets_[n] = first->next;
+    first->next = head;
+    head = first;
+    first = old_buckets_[n];
+  }
+}
+
+template <class Key, class Value, class HashFcn, class ExtractKey,
+          class EqualKey, class Allocator, class BucketPolicy>
+void hashtable<Key, Value, HashFcn, ExtractKey, EqualKey, Allocator,
+               BucketPolicy>::rehash_step() {
+  if (!rehashing()) {
+    return;
+  }
+  const size_type old_n = old_buckets_.size();
+  for (size_type i = 0; i != BucketPolicy::rehash_step && rehash_pos_ < old_n;
+       ++i, ++rehash_pos_) {
+    migrate_bucket(rehash_pos_);
+  }
+  if (rehash_pos_ == old_n) {
+    bucket_type(old_buckets_.get_allocator()).swap(old_buckets_);
+    rehash_pos_ = 0;
+  }
+}
+
+template <class Key, class Value, class HashFcn, class ExtractKey,
+          class EqualKey, class Allocator, class BucketPolicy>
+void hashtable<Key, Value, HashFcn, ExtractKey, EqualKey, Allocator,
+               BucketPolicy>::finish_rehash() {
+  if (!rehashing()) {
+    return;
+  }
+  for (; rehash_pos_ < old_buckets_.size(); ++rehash_pos_) {
+    migrate_bucket(rehash_pos_);
+  }
+  bucket_type(old_buckets_.get_allocator()).swap(old_buckets_);
+  rehash_pos_ = 0;
+}
+
+template <class Key, class Value, class HashFcn, class ExtractKey,
+          class EqualKey, class Allocator, class BucketPolicy>
+typename hashtable<Key, Value, HashFcn, ExtractKey, EqualKey,
+                   Allocator, BucketPolicy>::node_ptr
+hashtable<Key, Value, HashFcn, ExtractKey, EqualKey, Allocator,
+          BucketPolicy>::scan_buckets(size_type n, bool in_old) const {
+  if (!in_old) {
+    for (; n < buckets_.size(); ++n) {
+      if (buckets_[n]) {
+        return buckets_[n];
+      }
+    }
+    if (!rehashing()) {
+      return nullptr;
+    }
+    n = rehash_pos_;
+  }
+  for (; n < old_buckets_.size(); ++n) {
+    if (old_buckets_[n]) {
+      return old_buckets_[n];
+    }
+  }
+
+  return nullptr;
+}
+
+template <class Key, class Value, class HashFcn, class ExtractKey,
+          class EqualKey, class Allocator, class BucketPolicy>
+typename hashtable<Key, Value, HashFcn, ExtractKey, EqualKey,
+                   Allocator, BucketPolicy>::node_ptr
+hashtable<Key, Value, HashFcn, ExtractKey, EqualKey, Allocator,
+          BucketPolicy>::next_bucket_node(const node_type* node) const {
+  if (rehashing()) {
+    const size_type n = bkt_num(node, old_buckets_.size());
+    if (n >= rehash_pos_) {
+      return scan_buckets(n + 1, true);
+    }
+  }
+
+  return scan_buckets(bkt_num(node) + 1, false);
+}
 }  // namespace toystl
 
 #endif  // TOYSTL_SRC_HASHTABLE_H_
\ No newline at end of file
@@ -3,7 +3,9 @@
 
 #include <cstddef>
 
+#include "functional.h"
 #include "iterator_base.h"
+#include "utility.h"
 
 namespace toystl {
 /******************************************************************************/
@@ -220,7 +222,164 @@ void make_heap_aux(RandomIter first, RandomIter last, Distance*, Compare comp) {
 
 template <class RandomIter, class Compare>
 void make_heap(RandomIter first, RandomIter last, Compare comp) {
-  toystl::make_heap_aux(first, last, distance_type(first));
+  toystl::make_heap_aux(first, last, distance_type(first), comp);
+}
+
+/******************************************************************************/
+// d 叉堆
+// push_dary_heap / pop_dary_heap / make_dary_heap / sort_dary_heap 与上面的
+// 函数用法相同，多一个模板参数 D 指定每个节点的子节点个数，例如
+// toystl::push_dary_heap<4>(first, last, comp)。
+// 节点 i 的子节点为 D * i + 1 ... D * i + D，父节点为 (i - 1) / D，
+// D 为 2 时与上面的二叉堆布局相同。
+// 树高约为 log_D(n)，pop 时每层要在 D 个子节点中选出最大的，比较次数变多，
+// 但这 D 个子节点连续存放，4 叉或 8 叉的 int 堆每层只访问一两个 cache line，
+// 堆很大时访问内存的层数少得多。元素一律移动而不是拷贝
+/******************************************************************************/
+// 上溯：把 value 放到 holeIndex，沿父节点向上直到 topIndex
+template <size_t D, class RandomIter, class Distance, class T, class Compare>
+void dary_heap_sift_up(RandomIter first, Distance holeIndex, Distance topIndex,
+                       T value, Compare comp) {
+  static_assert(D >= 2, "d-ary heap requires D >= 2");
+  while (holeIndex > topIndex) {
+    const Distance parent = (holeIndex - 1) / static_cast<Distance>(D);
+    if (!comp(*(first + parent), value)) {
+      break;
+    }
+    *(first + holeIndex) = toystl::move(*(first + parent));
+    holeIndex = parent;
+  }
+  *(first + holeIndex) = toystl::move(value);
+}
+
+// 下溯：先把洞一路移到叶子（每层选出最大的子节点补上来），再对 value 上溯，
+// 与 adjust_heap 的做法相同
+template <size_t D, class RandomIter, class Distance, class T, class Compare>
+void dary_heap_adjust(RandomIter first, Distance holeIndex, Distance len,
+                      T value, Compare comp) {
+  static_assert(D >= 2, "d-ary heap requires D >= 2");
+  const Distance topIndex = holeIndex;
+  const Distance d = static_cast<Distance>(D);
+  Distance child = d * holeIndex + 1;
+  while (child + d <= len) {
+    // D 个子节点都存在
+    Distance best = child;
+    for (Distance i = child + 1; i != child + d; ++i) {
+      if (comp(*(first + best), *(first + i))) {
+        best = i;
+      }
+    }
+    *(first + holeIndex) = toystl::move(*(first + best));
+    holeIndex = best;
+    child = d * holeIndex + 1;
+  }
+  if (child < len) {
+    // 最后一个内部节点，子节点不满 D 个
+    Distance best = child;
+    for (Distance i = child + 1; i < len; ++i) {
+      if (comp(*(first + best), *(first + i))) {
+        best = i;
+      }
+    }
+    *(first + holeIndex) = toystl::move(*(first + best));
+    holeIndex = best;
+  }
+  toystl::dary_heap_sift_up<D>(first, holeIndex, topIndex, toystl::move(value),
+                               comp);
+}
+
+template <size_t D, class RandomIter, class Compare, class Distance, class T>
+void push_dary_heap_aux(RandomIter first, RandomIter last, Compare comp,
+                        Distance*, T*) {
+  T value = toystl::move(*(last - 1));
+  toystl::dary_heap_sift_up<D>(first, static_cast<Distance>(last - first - 1),
+                               static_cast<Distance>(0), toystl::move(value),
+                               comp);
+}
+
+template <size_t D, class RandomIter, class Compare>
+void push_dary_heap(RandomIter first, RandomIter last, Compare comp) {
+  toystl::push_dary_heap_aux<D>(first, last, comp, distance_type(first),
+                                value_type(first));
+}
+
+template <size_t D, class RandomIter>
+void push_dary_heap(RandomIter first, RandomIter last) {
+  toystl::push_dary_heap<D>(
+      first, last,
+      toystl::less<typename iterator_traits<RandomIter>::value_type>());
+}
+
+template <size_t D, class RandomIter, class Compare, class Distance, class T>
+void pop_dary_heap_aux(RandomIter first, RandomIter last, Compare comp,
+                       Distance*, T*) {
+  --last;
+  T value = toystl::move(*last);
+  *last = toystl::move(*first);
+  toystl::dary_heap_adjust<D>(first, static_cast<Distance>(0),
+                              static_cast<Distance>(last - first),
+                              toystl::move(value), comp);
+}
+
+template <size_t D, class RandomIter, class Compare>
+void pop_dary_heap(RandomIter first, RandomIter last, Compare comp) {
+  if (last - first > 1) {
+    toystl::pop_dary_heap_aux<D>(first, last, comp, distance_type(first),
+                                 value_type(first));
+  }
+}
+
+template <size_t D, class RandomIter>
+void pop_dary_heap(RandomIter first, RandomIter last) {
+  toystl::pop_dary_heap<D>(
+      first, last,
+      toystl::less<typename iterator_traits<RandomIter>::value_type>());
+}
+
+template <size_t D, class RandomIter, class Compare, class Distance, class T>
+void make_dary_heap_aux(RandomIter first, RandomIter last, Compare comp,
+                        Distance*, T*) {
+  const Distance len = last - first;
+  if (len < 2) {
+    return;
+  }
+  // 从最后一个内部节点开始逐个下溯
+  for (Distance holeIndex = (len - 2) / static_cast<Distance>(D);;
+       --holeIndex) {
+    T value = toystl::move(*(first + holeIndex));
+    toystl::dary_heap_adjust<D>(first, holeIndex, len, toystl::move(value),
+                                comp);
+    if (holeIndex == 0) {
+      return;
+    }
+  }
+}
+
+template <size_t D, class RandomIter, class Compare>
+void make_dary_heap(RandomIter first, RandomIter last, Compare comp) {
+  toystl::make_dary_heap_aux<D>(first, last, comp, distance_type(first),
+                                value_type(first));
+}
+
+template <size_t D, class RandomIter>
+void make_dary_heap(RandomIter first, RandomIter last) {
+  toystl::make_dary_heap<D>(
+      first, last,
+      toystl::less<typename iterator_traits<RandomIter>::value_type>());
+}
+
+template <size_t D, class RandomIter, class Compare>
+void sort_dary_heap(RandomIter first, RandomIter last, Compare comp) {
+  while (last - first > 1) {
+    toystl::pop_dary_heap<D>(first, last--, comp);
+  }
+}
+
+template <size_t D, class RandomIter>
+void sort_dary_heap(RandomIter first, RandomIter last) {
+  toystl::sort_dary_heap<D>(
+      first, last,
+      toystl::less<typename iterator_traits<RandomIter>::value_type>());
 }
 
 }  // namespace toystl
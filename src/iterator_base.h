@@ -269,6 +269,22 @@ inline typename iterator_traits<InputItertor>::difference_type distance(
   return detail::__distance(first, last, iterator_category(first));
 }
 
+// 分段迭代器的 traits。
+// deque 之类的容器由若干段连续的缓冲区组成，迭代器每前进一步都要检查是否
+// 跨段。为这类迭代器特化本模板后，copy、move、fill、find、count、for_each
+// 会逐段处理，每一段都当作原生指针区间，从而用上 memmove 等快速版本。
+// 特化版本需要提供：
+//   is_segmented_iterator  true_type
+//   segment_iterator       遍历各段的迭代器
+//   local_iterator         段内的迭代器（原生指针）
+//   segment(it)、local(it) 拆出 it 所在的段与段内位置
+//   begin(s)、end(s)       段 s 的范围
+//   compose(s, l)          由段和段内位置合成迭代器，l 可以等于 end(s)
+template <class Iterator>
+struct segmented_iterator_traits {
+  using is_segmented_iterator = false_type;
+};
+
 /* 冗余的两个函数 */
 // /**
 //  * 当前迭代器向前移动 n 步后的迭代器
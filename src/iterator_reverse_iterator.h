@@ -21,7 +21,7 @@ class reverse_iterator {
   using iterator_type = Iterator;
 
   reverse_iterator() {}
-  explicit reverse_iterator(iterator_type& x) : current_(x) {}
+  explicit reverse_iterator(const iterator_type& x) : current_(x) {}
 
   template <class U>
   explicit reverse_iterator(const reverse_iterator<U>& other)
@@ -35,10 +35,11 @@ class reverse_iterator {
 
   iterator_type base() const { return current_; }
 
-  // TO DO
   reference operator*() const {
-    return *(current_ - 1);
-    // 以上比较关键，堆逆向迭代器取值，就是将“对应正向迭代器”后退一格而后取值
+    // 逆向迭代器取值，就是将“对应正向迭代器”后退一格而后取值。
+    // 只用到 operator--，双向迭代器同样适用
+    Iterator tmp = current_;
+    return *--tmp;
   }
 
   pointer operator->() const { return &(operator*()); }
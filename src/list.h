@@ -91,7 +91,7 @@ struct list_iterator {
 
 // 双向链表
 template <class T, class Allocator = allocator<T>>
-class list {
+class list : private allocator_holder<Allocator> {
  public:
   using pointer = T*;
   using value_type = T;
@@ -123,6 +123,9 @@ class list {
   // using list_node_allocator = typename
   // Allocator::rebind<detail::list_node<T>>::other;
 
+  // 分配器保存在基类 allocator_holder 中，节点用 rebind 后的分配器分配
+  using alloc_base = allocator_holder<Allocator>;
+
   // SGI STL 中 整个 list class 中的 data 只有一个指针。
   // 只要这一个 node_ ，便可表示整个环状双向链表
   // 指向末尾的空白节点
@@ -138,13 +141,21 @@ class list {
     node_->previous = node_->next = node_;
   }
 
-  list(size_type count, const_reference value) {
+  explicit list(const allocator_type& a) : alloc_base(a) {
+    node_ = allocate_node();
+    node_->previous = node_->next = node_;
+  }
+
+  list(size_type count, const_reference value,
+       const allocator_type& a = allocator_type())
+      : alloc_base(a) {
     node_ = allocate_node();
     node_->previous = node_->next = node_;
     insert(begin(), count, value);
   }
 
-  explicit list(size_type count) {
+  explicit list(size_type count, const allocator_type& a = allocator_type())
+      : alloc_base(a) {
     node_ = allocate_node();
     node_->previous = node_->next = node_;
     insert(begin(), count, value_type());
@@ -154,25 +165,33 @@ class list {
   template <class InputIterator,
             typename std::enable_if<
                 toystl::is_input_iterator<InputIterator>::value, int>::type = 0>
-  list(InputIterator first, InputIterator last) {
+  list(InputIterator first, InputIterator last,
+       const allocator_type& a = allocator_type())
+      : alloc_base(a) {
     node_ = allocate_node();
     node_->previous = node_->next = node_;
     insert(begin(), first, last);
   }
 
-  list(const list& other) : list(other.begin(), other.end()) {
-    node_ = allocate_node();
-    node_->previous = node_->next = node_;
-    insert(begin(), other.cbegin(), other.cend());
-  }
+  // 新容器的分配器由 select_on_container_copy_construction 决定
+  list(const list& other)
+      : list(other.begin(), other.end(),
+             other.get_alloc().select_on_container_copy_construction()) {}
+
+  list(const list& other, const allocator_type& a)
+      : list(other.begin(), other.end(), a) {}
 
-  list(std::initializer_list<T> ilist) {
+  list(std::initializer_list<T> ilist,
+       const allocator_type& a = allocator_type())
+      : alloc_base(a) {
     node_ = allocate_node();
     node_->previous = node_->next = node_;
     insert(begin(), ilist.begin(), ilist.end());
   }
 
-  list(list&& other) noexcept : node_(other.node_) {
+  // 分配器随节点一起移动过来
+  list(list&& other) noexcept : alloc_base(other.get_alloc()),
+                                node_(other.node_) {
     // 其实不用，一开始就是空链表
     // move_from(other);
     other.node_ = nullptr;
@@ -180,6 +199,9 @@ class list {
 
   list& operator=(const list& other) {
     if (this != &other) {
+      copy_assign_alloc(
+          other,
+          typename allocator_type::propagate_on_container_copy_assignment());
       iterator first1 = begin();
       iterator last1 = end();
       const_iterator first2 = other.begin();
@@ -197,18 +219,19 @@ class list {
     return *this;
   }
 
-  list& operator=(list&& other) noexcept {
+  list& operator=(list&& other) noexcept(
+      allocator_nothrow_move_assign<Allocator>::value) {
     if (this != &other) {
-      delete_list();
-      node_ = other.node_;
-      other.node_ = nullptr;
+      move_assign(
+          other,
+          typename allocator_type::propagate_on_container_move_assignment());
     }
 
     return *this;
   }
 
   list& operator=(std::initializer_list<T> ilist) {
-    list tmp(ilist.begin(), ilist.end());
+    list tmp(ilist.begin(), ilist.end(), this->get_alloc());
     swap(tmp);
 
     return *this;
@@ -231,7 +254,7 @@ class list {
     assign_dispatch(ilist.begin(), ilist.end(), false_type());
   }
 
-  allocator_type get_allocator() const { return list_node_allocator(); }
+  allocator_type get_allocator() const { return this->get_alloc(); }
 
   /* 元素访问相关操作 */
 
@@ -375,7 +398,11 @@ class list {
 
   void resize(size_type count) { resize(count, value_type()); }
 
-  void swap(list& other) { toystl::swap(node_, other.node_); }
+  // 分配器按 propagate_on_container_swap 决定是否交换
+  void swap(list& other) {
+    this->swap_alloc(other);
+    toystl::swap(node_, other.node_);
+  }
 
   /* list 相关操作 */
 
@@ -407,11 +434,13 @@ class list {
   // 将 i 所指的元素接合于 position 所指位置之前。
   void splice(iterator position, list&, iterator it) {
     // it 如果 是下面这两种情况，没有意义，什么也不做
-    if (position == it || position == it + 1) {
+    iterator next = it;
+    ++next;
+    if (position == it || position == next) {
       return;
     }
 
-    transfer(position, it, it + 1);
+    transfer(position, it, next);
   }
 
   // 将 [first, last) 内的所有元素接合于 position 所指位置之前
@@ -469,10 +498,47 @@ class list {
   template <class InputIterator>
   void assign_dispatch(InputIterator first2, InputIterator last2, false_type);
 
-  link_type allocate_node() { return list_node_allocator::allocate(1); }
+  link_type allocate_node() {
+    return list_node_allocator(this->get_alloc()).allocate(1);
+  }
 
   void deallocate_node(link_type node) {
-    list_node_allocator::deallocate(node);
+    list_node_allocator(this->get_alloc()).deallocate(node);
+  }
+
+  // 分配器需要传播时，如果两个分配器不相等，原有节点必须由原分配器释放
+  void copy_assign_alloc(const list& other, true_type) {
+    if (this->get_alloc() != other.get_alloc()) {
+      delete_list();
+      this->set_alloc(other.get_alloc());
+      node_ = allocate_node();
+      node_->previous = node_->next = node_;
+    } else {
+      this->set_alloc(other.get_alloc());
+    }
+  }
+
+  void copy_assign_alloc(const list&, false_type) {}
+
+  // 分配器随节点一起转移
+  void move_assign(list& other, true_type) {
+    delete_list();
+    this->set_alloc(other.get_alloc());
+    node_ = other.node_;
+    other.node_ = nullptr;
+  }
+
+  // 分配器不传播：分配器相等时仍然可以直接接管节点，否则只能逐个移动元素
+  void move_assign(list& other, false_type) {
+    if (this->get_alloc() == other.get_alloc()) {
+      move_assign(other, true_type());
+    } else {
+      clear();
+      for (auto& value : other) {
+        push_back(toystl::move(value));
+      }
+      other.clear();
+    }
   }
 
   template <class... Args>
@@ -499,7 +565,8 @@ class list {
   template <class InputIterator>
   iterator insert_range_aux(const_iterator position, InputIterator first,
                             InputIterator last, true_type) {
-    insert(position, first, last);
+    return insert(position, static_cast<size_type>(first),
+                  static_cast<T>(last));
   }
 
   template <class InputIterator>
@@ -642,7 +709,7 @@ void list<T, Allocator>::remove_if(UnaryPredicate p) {
   auto first = begin();
   auto last = end();
   while (first != last) {
-    if (UnaryPredicate(*first)) {
+    if (p(*first)) {
       // 返回下一个位置
       first = erase(first);
     } else {
@@ -689,7 +756,8 @@ void list<T, Allocator>::unique(BinaryPredicate pred) {
   auto first = begin();
   auto last = end();
 
-  auto next = ++first;
+  auto next = first;
+  ++next;
   while (next != last) {
     if (pred(*first, *next)) {
       next = erase(next);
@@ -728,7 +796,7 @@ void list<T, Allocator>::sort(iterator f1, iterator f2, Compare compare) {
     size_type i = 0;
     while (i < fill && !counter[i].empty()) {
       // 第二步：将链表 carry 合并到 counter[i]
-      counter[i].merge(carry);
+      counter[i].merge(carry, compare);
       // 第三步：交换链表 carry 和 counter[i] 的内容
       carry.swap(counter[i++]);
     }
@@ -741,12 +809,13 @@ void list<T, Allocator>::sort(iterator f1, iterator f2, Compare compare) {
   }
 
   // 第六步：把低位不满足进位的剩余数据全部有序的合并到上一位
-  for (size_type j = 0; j < fill; ++j) {
-    counter[j].merge(counter[j - 1]);
+  for (size_type j = 1; j < fill; ++j) {
+    counter[j].merge(counter[j - 1], compare);
   }
 
-  // 第七步：最后将已经排好序的链表内容交换到当前链表
-  swap(counter[fill - 1]);
+  // 第七步：最后将已经排好序的节点接回当前链表
+  // 这里不能用 swap，否则分配器可能随之交换，节点与分配器不再对应
+  splice(end(), counter[fill - 1]);
 }
 
 /* private helper function */
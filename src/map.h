@@ -19,6 +19,7 @@ class map {
   using value_type = pair<const Key, T>;
   using key_compare = Compare;
   using value_compare = Compare;
+  using allocator_type = Allocator;
 
  private:
   using rb_tree_type =
@@ -42,14 +43,40 @@ class map {
 
  public:
   map() {}
+
+  explicit map(const Compare& comp,
+               const allocator_type& a = allocator_type())
+      : tree_(comp, a) {}
+
+  explicit map(const allocator_type& a) : tree_(Compare(), a) {}
+
   map(const map& x) : tree_(x.tree_) {}
-  map& operator=(const map& s) { tree_ = s.tree_; }
+
+  map(const map& x, const allocator_type& a) : tree_(x.tree_, a) {}
+
+  map(map&& x) : tree_(toystl::move(x.tree_)) {}
+
+  map& operator=(const map& s) {
+    tree_ = s.tree_;
+    return *this;
+  }
+
+  map& operator=(map&& s) {
+    tree_ = toystl::move(s.tree_);
+    return *this;
+  }
 
   template <class InputIterator>
-  map(InputIterator first, InputIterator last) {
+  map(InputIterator first, InputIterator last,
+      const Compare& comp = Compare(),
+      const allocator_type& a = allocator_type())
+      : tree_(comp, a) {
     tree_.insert_unique(first, last);
   }
 
+  allocator_type get_allocator() const { return tree_.get_allocator(); }
+  key_compare key_comp() const { return tree_.key_comp(); }
+
   iterator begin() noexcept { return tree_.begin(); }
   const_iterator begin() const noexcept { return tree_.begin(); }
   iterator end() noexcept { return tree_.end(); }
@@ -73,6 +100,15 @@ class map {
   size_type size() const { return tree_.size(); }
   void swap(map& x) { tree_.swap(x.tree_); }
 
+  // 键不存在时插入一个值初始化的元素
+  mapped_type& operator[](const key_type& k) {
+    iterator it = lower_bound(k);
+    if (it == end() || key_comp()(k, it->first)) {
+      it = tree_.insert_unique(it, value_type(k, mapped_type()));
+    }
+    return it->second;
+  }
+
   pair<iterator, bool> insert(const value_type& x) {
     return tree_.insert_unique(x);
   }
@@ -81,8 +117,19 @@ class map {
     return tree_.insert_unique(toystl::move(x));
   }
 
-  iterator insert(iterator position, const value_type& x) {
-    return tree_.insert_unique(position, x);
+  // 以 hint 作为位置提示，新值恰好插入在 hint 之前时只需常数次比较
+  iterator insert(const_iterator hint, const value_type& x) {
+    return tree_.insert_unique(hint, x);
+  }
+
+  template <class... Args>
+  pair<iterator, bool> emplace(Args&&... args) {
+    return tree_.emplace_unique(toystl::forward<Args>(args)...);
+  }
+
+  template <class... Args>
+  iterator emplace_hint(const_iterator hint, Args&&... args) {
+    return tree_.emplace_hint_unique(hint, toystl::forward<Args>(args)...);
   }
 
   template <class InputIterator>
@@ -99,8 +146,8 @@ class map {
   void clear() { tree_.clear(); }
 
   iterator find(const key_type& x) { return tree_.find(x); }
-  const_iterator find(const key_type& x) const { return tree_find(x); }
-  size_type count(const key_type& x) { return tree_.count(x); }
+  const_iterator find(const key_type& x) const { return tree_.find(x); }
+  size_type count(const key_type& x) const { return tree_.count(x); }
   iterator lower_bound(const key_type& x) { return tree_.lower_bound(x); }
   const_iterator lower_bound(const key_type& x) const {
     return tree_.lower_bound(x);
@@ -116,6 +163,15 @@ class map {
     return tree_.equal_range(x);
   }
 
+#ifdef TOYSTL_RB_TREE_ORDER_STATISTICS
+  // 顺序统计，均为 O(log n)：第 n 小的元素、键值小于 x 的元素个数、
+  // 迭代器的序号
+  iterator select(size_type n) { return tree_.select(n); }
+  const_iterator select(size_type n) const { return tree_.select(n); }
+  size_type rank(const key_type& x) const { return tree_.rank(x); }
+  size_type index_of(const_iterator it) const { return tree_.index_of(it); }
+#endif
+
   template <class K1, class T1, class C1, class A1>
   friend bool operator==(const map&, const map&);
   template <class K1, class T1, class C1, class A1>
@@ -146,10 +202,11 @@ class multimap {
   using value_type = pair<const Key, T>;
   using key_compare = Compare;
   using value_compare = Compare;
+  using allocator_type = Allocator;
 
  private:
   using rb_tree_type =
-      toystl::rb_tree<key_type, value_type, toystl::identity<value_type>,
+      toystl::rb_tree<key_type, value_type, toystl::selectfirst<value_type>,
                       Compare, Allocator>;
   rb_tree_type tree_;  // 采用红黑树来实现
 
@@ -169,14 +226,40 @@ class multimap {
 
  public:
   multimap() {}
+
+  explicit multimap(const Compare& comp,
+                    const allocator_type& a = allocator_type())
+      : tree_(comp, a) {}
+
+  explicit multimap(const allocator_type& a) : tree_(Compare(), a) {}
+
   multimap(const multimap& x) : tree_(x.tree_) {}
-  multimap& operator=(const multimap& s) { tree_ = s.tree_; }
+
+  multimap(const multimap& x, const allocator_type& a) : tree_(x.tree_, a) {}
+
+  multimap(multimap&& x) : tree_(toystl::move(x.tree_)) {}
+
+  multimap& operator=(const multimap& s) {
+    tree_ = s.tree_;
+    return *this;
+  }
+
+  multimap& operator=(multimap&& s) {
+    tree_ = toystl::move(s.tree_);
+    return *this;
+  }
 
   template <class InputIterator>
-  multimap(InputIterator first, InputIterator last) {
+  multimap(InputIterator first, InputIterator last,
+           const Compare& comp = Compare(),
+           const allocator_type& a = allocator_type())
+      : tree_(comp, a) {
     tree_.insert_equal(first, last);
   }
 
+  allocator_type get_allocator() const { return tree_.get_allocator(); }
+  key_compare key_comp() const { return tree_.key_comp(); }
+
   iterator begin() noexcept { return tree_.begin(); }
   const_iterator begin() const noexcept { return tree_.begin(); }
   iterator end() noexcept { return tree_.end(); }
@@ -200,12 +283,21 @@ class multimap {
   size_type size() const { return tree_.size(); }
   void swap(multimap& x) { tree_.swap(x.tree_); }
 
-  pair<iterator, bool> insert(const value_type& x) {
-    return tree_.insert_equal(x);
+  iterator insert(const value_type& x) { return tree_.insert_equal(x); }
+
+  // 以 hint 作为位置提示，新值恰好插入在 hint 之前时只需常数次比较
+  iterator insert(const_iterator hint, const value_type& x) {
+    return tree_.insert_equal(hint, x);
+  }
+
+  template <class... Args>
+  iterator emplace(Args&&... args) {
+    return tree_.emplace_equal(toystl::forward<Args>(args)...);
   }
 
-  iterator insert(iterator position, const value_type& x) {
-    return tree_.insert_equal(position, x);
+  template <class... Args>
+  iterator emplace_hint(const_iterator hint, Args&&... args) {
+    return tree_.emplace_hint_equal(hint, toystl::forward<Args>(args)...);
   }
 
   template <class InputIterator>
@@ -222,8 +314,8 @@ class multimap {
   void clear() { tree_.clear(); }
 
   iterator find(const key_type& x) { return tree_.find(x); }
-  const_iterator find(const key_type& x) const { return tree_find(x); }
-  size_type count(const key_type& x) { return tree_.count(x); }
+  const_iterator find(const key_type& x) const { return tree_.find(x); }
+  size_type count(const key_type& x) const { return tree_.count(x); }
   iterator lower_bound(const key_type& x) { return tree_.lower_bound(x); }
   const_iterator lower_bound(const key_type& x) const {
     return tree_.lower_bound(x);
@@ -239,6 +331,15 @@ class multimap {
     return tree_.equal_range(x);
   }
 
+#ifdef TOYSTL_RB_TREE_ORDER_STATISTICS
+  // 顺序统计，均为 O(log n)：第 n 小的元素、键值小于 x 的元素个数、
+  // 迭代器的序号
+  iterator select(size_type n) { return tree_.select(n); }
+  const_iterator select(size_type n) const { return tree_.select(n); }
+  size_type rank(const key_type& x) const { return tree_.rank(x); }
+  size_type index_of(const_iterator it) const { return tree_.index_of(it); }
+#endif
+
   template <class K1, class T1, class C1, class A1>
   friend bool operator==(const multimap&, const multimap&);
   template <class K1, class T1, class C1, class A1>
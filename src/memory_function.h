@@ -38,7 +38,7 @@ template <class InputIterator, class ForwardIterator>
 ForwardIterator __uninitialized_copy_aux(InputIterator first,
                                          InputIterator last,
                                          ForwardIterator result, true_type) {
-  return copy(first, last, result);
+  return toystl::copy(first, last, result);
 }
 
 // 非POD版本
@@ -142,7 +142,7 @@ void uninitialized_copy_n(ForwardIterator first, Size count, const T& value) {
 template <class ForwardIter, class T>
 void __uninitialized_fill_aux(ForwardIter first, ForwardIter last,
                               const T& value, true_type) {
-  fill(first, last, value);
+  toystl::fill(first, last, value);
 }
 
 template <class ForwardIter, class T>
@@ -179,7 +179,7 @@ void uninitialized_fill(ForwardIter first, ForwardIter last, const T& value) {
 template <class ForwardIter, class Size, class T>
 ForwardIter __uninitialized_fill_n_aux(ForwardIter first, Size n,
                                        const T& value, true_type) {
-  return fill_n(first, n, value);
+  return toystl::fill_n(first, n, value);
 }
 
 template <class ForwardIter, class Size, class T>
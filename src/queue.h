@@ -14,10 +14,10 @@ template <class T, class Container = toystl::deque<T>>
 class queue {
  public:
   using container_type = Container;
-  using value_type = Container::value_type;
-  using size_type = Container::size_type;
-  using reference = Container::reference;
-  using const_reference = Container::const_reference;
+  using value_type = typename Container::value_type;
+  using size_type = typename Container::size_type;
+  using reference = typename Container::reference;
+  using const_reference = typename Container::const_reference;
 
  private:
   container_type c_;  // 底层容器
@@ -36,7 +36,7 @@ class queue {
 
   queue(const Container& c) : c_(c) {}
 
-  queue(const Container&& c) : c_(toystl::move(c)) noexcept {}
+  queue(Container&& c) noexcept : c_(toystl::move(c)) {}
 
   queue(const queue& rhs) : c_(rhs.c_) {}
 
@@ -63,7 +63,7 @@ class queue {
   reference front() { return c_.front(); }
   const_reference front() const { return c_.front(); }
   reference back() { return c_.back(); }
-  const_reference back() const { retunr c_.back(); }
+  const_reference back() const { return c_.back(); }
 
   // 容量相关操作
   bool empty() const { return c_.empty(); }
@@ -76,7 +76,7 @@ class queue {
   }
 
   void push(const value_type& value) { c_.push_back(value); }
-  void push(const value_type&& value) { c_.emplace_back(toystl::move()); }
+  void push(value_type&& value) { c_.emplace_back(toystl::move(value)); }
 
   void pop() { c_.pop_front(); }
 
@@ -86,24 +86,17 @@ class queue {
     }
   }
 
-  void swap(queue& rhs) { toystl::swap(c_, rhs.c_); }
+  void swap(queue& rhs) { c_.swap(rhs.c_); }
 
  public:
-  friend bool operator==(const queue& lhs, const queue& rhs);
-  friend bool operator<(const queue& lhs, const queue& rhs);
+  friend bool operator==(const queue& lhs, const queue& rhs) {
+    return lhs.c_ == rhs.c_;
+  }
+  friend bool operator<(const queue& lhs, const queue& rhs) {
+    return lhs.c_ < rhs.c_;
+  }
 };
 
-template <class T, class Container>
-bool operator==(const queue<T, Container>& lhs,
-                const queue<T, Container>& rhs) {
-  return lhs.c_ == rhs.c_;
-}
-
-template <class T, class Container>
-bool operator<(const queue<T, Container>& lhs, const queue<T, Container>& rhs) {
-  return lhs.c_ < rhs.c_;
-}
-
 template <class T, class Container>
 bool operator!=(const queue<T, Container>& lhs,
                 const queue<T, Container>& rhs) {
@@ -134,17 +127,21 @@ void swap(queue<T, Container>& lhs, queue<T, Container>& rhs) {
 }
 
 // priority_queue
+// Arity 为堆的叉数，默认为二叉堆；元素很多时 4 叉或 8 叉堆的 pop 更快
 template <class T, class Container = toystl::vector<T>,
-          class Compare = toystl::less<typename Container::value_type>>
+          class Compare = toystl::less<typename Container::value_type>,
+          size_t Arity = 2>
 class priority_queue {
+  static_assert(Arity >= 2, "priority_queue requires Arity >= 2");
+
  public:
   using container_type = Container;
   using value_compare = Compare;
 
-  using value_type = Container::value_type;
-  using size_type = Container::size_type;
-  using reference = Container::reference;
-  using const_reference = Container::const_reference;
+  using value_type = typename Container::value_type;
+  using size_type = typename Container::size_type;
+  using reference = typename Container::reference;
+  using const_reference = typename Container::const_reference;
 
  private:
   container_type c_;    // 底层容器
@@ -156,50 +153,50 @@ class priority_queue {
   priority_queue(const Compare& c) : c_(), comp_(c) {}
 
   explicit priority_queue(size_type n) : c_(n) {
-    toystl::make_heap(c_.begin(), c.end(), comp_);
+    toystl::make_dary_heap<Arity>(c_.begin(), c_.end(), comp_);
   }
 
   priority_queue(size_type n, const value_type& value) : c_(n, value) {
-    toystl::make_heap(c_.begin(), c_.end(), comp_);
+    toystl::make_dary_heap<Arity>(c_.begin(), c_.end(), comp_);
   }
 
   template <class IIter>
   priority_queue(IIter first, IIter last) : c_(first, last) {
-    toystl::make_heap(c.begin(), c.end(), comp_);
+    toystl::make_dary_heap<Arity>(c_.begin(), c_.end(), comp_);
   }
 
   priority_queue(std::initializer_list<T> ilist) : c_(ilist) {
-    toystl::make_heap(c_.begin(), c_end(), comp_);
+    toystl::make_dary_heap<Arity>(c_.begin(), c_.end(), comp_);
   }
 
   priority_queue(const Container& s) : c_(s) {
-    toystl::make_heap(c_.begin(), c_.end(), comp_);
+    toystl::make_dary_heap<Arity>(c_.begin(), c_.end(), comp_);
   }
 
-  priority_queue(const Container&& s) noexcept : c_(toystl::move(s)) {
-    toystl::make_heap(c.begin(), c.end(), comp_);
+  priority_queue(Container&& s) : c_(toystl::move(s)) {
+    toystl::make_dary_heap<Arity>(c_.begin(), c_.end(), comp_);
   }
 
   priority_queue(const priority_queue& rhs) : c_(rhs.c_), comp_(rhs.comp_) {
-    toystl::make_heap(c_.begin(), c_end(), comp_);
+    toystl::make_dary_heap<Arity>(c_.begin(), c_.end(), comp_);
   }
 
   priority_queue(priority_queue&& rhs) noexcept : c_(toystl::move(rhs.c_)),
                                                   comp_(rhs.comp_) {
-    toystl::make_heap(c_.begin(), c_.end(), comp_);
+    toystl::make_dary_heap<Arity>(c_.begin(), c_.end(), comp_);
   }
 
   priority_queue& operator=(const priority_queue& rhs) {
     c_ = rhs.c_;
     comp_ = rhs.comp_;
-    toystl::make_heap(c_.begin(), c_.end(), comp_);
+    toystl::make_dary_heap<Arity>(c_.begin(), c_.end(), comp_);
     return *this;
   }
 
-  priority_queue& operator=(const priority_queue& rhs) {
+  priority_queue& operator=(priority_queue&& rhs) {
     c_ = toystl::move(rhs.c_);
     comp_ = rhs.comp_;
-    toystl::make_heap(c_.begin(), c_.end(), comp_);
+    toystl::make_dary_heap<Arity>(c_.begin(), c_.end(), comp_);
 
     return *this;
   }
@@ -207,7 +204,7 @@ class priority_queue {
   priority_queue& operator=(std::initializer_list<T> ilist) {
     c_ = ilist;
     comp_ = value_compare();
-    toystl::make_heap(c._begin(), c_end(), comp_);
+    toystl::make_dary_heap<Arity>(c_.begin(), c_.end(), comp_);
 
     return *this;
   }
@@ -224,23 +221,23 @@ class priority_queue {
 
   // 修改容器相关操作
   template <class... Args>
-  void emplace(Args&&... agrs) {
+  void emplace(Args&&... args) {
     c_.emplace_back(toystl::forward<Args>(args)...);
-    toystl::push_heap(c_.begin(), c_.end(), comp_);
+    toystl::push_dary_heap<Arity>(c_.begin(), c_.end(), comp_);
   }
 
   void push(const value_type& value) {
     c_.push_back(value);
-    toystl::push_heap(c.begin(), c.end(), comp_);
+    toystl::push_dary_heap<Arity>(c_.begin(), c_.end(), comp_);
   }
 
   void push(value_type&& value) {
     c_.push_back(toystl::move(value));
-    toystl::push_heap(c_.begin(), c_.end(), comp_);
+    toystl::push_dary_heap<Arity>(c_.begin(), c_.end(), comp_);
   }
 
   void pop() {
-    toystl::pop_heap(c_.begin(), c_.end(), comp_);
+    toystl::pop_dary_heap<Arity>(c_.begin(), c_.end(), comp_);
     c_.pop_back();
   }
 
@@ -251,33 +248,199 @@ class priority_queue {
   }
 
   void swap(priority_queue& rhs) {
-    toystl::swap(c_, rhs.c_);
+    c_.swap(rhs.c_);
     toystl::swap(comp_, rhs.comp_);
   }
 
  public:
-  friend bool operator==(const priority_queue& lhs, const priority_queue& rhs);
-  friend bool operator<(const priority_queue& lhs, const priority_queue& rhs);
+  friend bool operator==(const priority_queue& lhs,
+                         const priority_queue& rhs) {
+    return lhs.c_ == rhs.c_;
+  }
 };
 
-template <class T, class Container, class Compare>
-bool operator==(const priority_queue<T, Container, Compare>& lhs,
-                const priority_queue<T, Container, Compare>& rhs) {
-  return lhs.c_ == rhs.c_;
-}
-
-template <class T, class Container, class Compare>
-bool operator!=(const priority_queue<T, Container, Compare>& lhs,
-                const priority_queue<T, Container, Compare>& rhs) {
-  return lhs.c_ == rhs.c_;
+template <class T, class Container, class Compare, size_t Arity>
+bool operator!=(const priority_queue<T, Container, Compare, Arity>& lhs,
+                const priority_queue<T, Container, Compare, Arity>& rhs) {
+  return !(lhs == rhs);
 }
 
-template <class T, class Container, class Compare>
-void swap(priority_queue<T, Container, Compare>& lhs,
-          priority_queue<T, Container, Compare>& rhs) {
+template <class T, class Container, class Compare, size_t Arity>
+void swap(priority_queue<T, Container, Compare, Arity>& lhs,
+          priority_queue<T, Container, Compare, Arity>& rhs) {
   lhs.swap(rhs);
 }
 
+/******************************************************************************/
+// indexed_priority_queue：可寻址的 d 叉堆
+// push 返回一个 handle，之后可以凭 handle 读取、修改（update / decrease_key）
+// 或删除（erase）堆中的任意元素，适合定时器、调度器这类需要改期和取消的场景。
+// 堆中存放 (值, handle)，position_ 记录每个 handle 当前在堆中的下标，
+// 元素移动时同步更新；handle 在 pop / erase 之后释放，之后的 push 会复用
+/******************************************************************************/
+template <class T, class Compare = toystl::less<T>, size_t Arity = 4>
+class indexed_priority_queue {
+  static_assert(Arity >= 2, "indexed_priority_queue requires Arity >= 2");
+
+ public:
+  using value_type = T;
+  using value_compare = Compare;
+  using size_type = size_t;
+  using handle_type = size_t;
+  using const_reference = const T&;
+
+ private:
+  struct entry {
+    T value;
+    handle_type handle;
+
+    entry(T&& v, handle_type h) : value(toystl::move(v)), handle(h) {}
+  };
+
+  static const size_t npos = static_cast<size_t>(-1);
+
+  toystl::vector<entry> heap_;
+  toystl::vector<size_t> position_;      // handle -> 堆中的下标
+  toystl::vector<handle_type> free_;     // 已释放、可以复用的 handle
+  value_compare comp_;
+
+ public:
+  indexed_priority_queue() = default;
+  explicit indexed_priority_queue(const Compare& comp) : comp_(comp) {}
+
+  bool empty() const { return heap_.empty(); }
+  size_type size() const { return heap_.size(); }
+
+  const_reference top() const { return heap_.front().value; }
+  handle_type top_handle() const { return heap_.front().handle; }
+
+  // handle 对应的元素是否还在堆中
+  bool contains(handle_type h) const {
+    return h < position_.size() && position_[h] != npos;
+  }
+  const_reference get(handle_type h) const { return heap_[position_[h]].value; }
+
+  handle_type push(const value_type& value) { return emplace(value); }
+  handle_type push(value_type&& value) { return emplace(toystl::move(value)); }
+
+  template <class... Args>
+  handle_type emplace(Args&&... args) {
+    // 先构造元素并放到堆尾，成功之后才分配 handle：构造元素或扩容抛出异常时
+    // handle 既不会丢失，也不会被错误地标记为在堆中
+    heap_.emplace_back(T(toystl::forward<Args>(args)...), npos);
+    const size_t i = heap_.size() - 1;
+    handle_type h;
+    if (free_.empty()) {
+      h = position_.size();
+      try {
+        position_.push_back(i);
+      } catch (...) {
+        heap_.pop_back();
+        throw;
+      }
+    } else {
+      h = free_.back();
+      free_.pop_back();
+      position_[h] = i;
+    }
+    heap_[i].handle = h;
+    sift_up(i);
+    return h;
+  }
+
+  void pop() { erase(top_handle()); }
+
+  // 删除任意元素：用最后一个元素填补它的位置，再向上或向下调整
+  void erase(handle_type h) {
+    const size_t i = position_[h];
+    // push_back 可能分配内存而抛出异常，放在修改任何状态之前
+    free_.push_back(h);
+    position_[h] = npos;
+    if (i + 1 != heap_.size()) {
+      heap_[i] = toystl::move(heap_.back());
+      position_[heap_[i].handle] = i;
+      heap_.pop_back();
+      adjust(i);
+    } else {
+      heap_.pop_back();
+    }
+  }
+
+  // 修改元素的值，根据新值向上或向下调整
+  void update(handle_type h, const value_type& value) {
+    const size_t i = position_[h];
+    heap_[i].value = value;
+    adjust(i);
+  }
+
+  // 新值的优先级不低于原值时使用（Compare 为 greater 的小顶堆中就是键值
+  // 变小，例如把定时器提前），只需要上溯
+  void decrease_key(handle_type h, const value_type& value) {
+    const size_t i = position_[h];
+    heap_[i].value = value;
+    sift_up(i);
+  }
+
+  void clear() {
+    heap_.clear();
+    position_.clear();
+    free_.clear();
+  }
+
+ private:
+  void adjust(size_t i) {
+    if (i > 0 && comp_(heap_[(i - 1) / Arity].value, heap_[i].value)) {
+      sift_up(i);
+    } else {
+      sift_down(i);
+    }
+  }
+
+  void sift_up(size_t i) {
+    entry e = toystl::move(heap_[i]);
+    while (i > 0) {
+      const size_t parent = (i - 1) / Arity;
+      if (!comp_(heap_[parent].value, e.value)) {
+        break;
+      }
+      heap_[i] = toystl::move(heap_[parent]);
+      position_[heap_[i].handle] = i;
+      i = parent;
+    }
+    position_[e.handle] = i;
+    heap_[i] = toystl::move(e);
+  }
+
+  void sift_down(size_t i) {
+    const size_t n = heap_.size();
+    entry e = toystl::move(heap_[i]);
+    for (;;) {
+      const size_t child = Arity * i + 1;
+      if (child >= n) {
+        break;
+      }
+      const size_t end = n - child < Arity ? n : child + Arity;
+      size_t best = child;
+      for (size_t c = child + 1; c < end; ++c) {
+        if (comp_(heap_[best].value, heap_[c].value)) {
+          best = c;
+        }
+      }
+      if (!comp_(e.value, heap_[best].value)) {
+        break;
+      }
+      heap_[i] = toystl::move(heap_[best]);
+      position_[heap_[i].handle] = i;
+      i = best;
+    }
+    position_[e.handle] = i;
+    heap_[i] = toystl::move(e);
+  }
+};
+
+template <class T, class Compare, size_t Arity>
+const size_t indexed_priority_queue<T, Compare, Arity>::npos;
+
 }  // namespace toystl
 
 #endif  // TOYSTL_SRC_QUEUE_H_
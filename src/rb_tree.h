@@ -6,6 +6,11 @@
 #include "iterator.h"
 #include "iterator_base.h"
 
+// 定义 TOYSTL_RB_TREE_ORDER_STATISTICS 后，每个节点额外记录以它为根的子树的
+// 节点数，插入、删除和旋转时顺带维护，从而支持 O(log n) 的按序号取元素
+// （select）、求排名（rank）以及迭代器之间的 distance。
+// 每个节点多占一个 size_t，插入和删除多一次从叶子到根的路径更新
+
 namespace toystl {
 // rb_tree 的节点颜色的类型
 using rb_tree_color_type = bool;
@@ -20,6 +25,9 @@ struct rb_tree_node_base {
   base_ptr parent;   // 节点的父节点
   base_ptr left;     // 节点的左子节点
   base_ptr right;    // 节点的右子节点
+#ifdef TOYSTL_RB_TREE_ORDER_STATISTICS
+  size_t size;  // 以该节点为根的子树的节点数
+#endif
 
   static base_ptr s_minimum(base_ptr x) {
     while (x->left != nullptr) {
@@ -36,6 +44,36 @@ struct rb_tree_node_base {
 
     return x;
   }
+
+#ifdef TOYSTL_RB_TREE_ORDER_STATISTICS
+  static size_t s_size(const rb_tree_node_base* x) {
+    return x == nullptr ? 0 : x->size;
+  }
+
+  // 子节点改变之后重新计算 x 的子树大小
+  static void s_update_size(rb_tree_node_base* x) {
+    x->size = s_size(x->left) + s_size(x->right) + 1;
+  }
+
+  // x 在中序遍历中的序号。header（end()）的序号为节点总数。
+  // header 为红色且 header->parent->parent == header，根节点为黑色，
+  // 空树的 header->parent 为空
+  static size_t s_index_of(const rb_tree_node_base* x) {
+    if (x->color == rb_tree_red &&
+        (x->parent == nullptr || x->parent->parent == x)) {
+      return s_size(x->parent);
+    }
+    size_t index = s_size(x->left);
+    while (x->parent->parent != x) {  // 直到根节点
+      const rb_tree_node_base* p = x->parent;
+      if (x == p->right) {
+        index += s_size(p->left) + 1;
+      }
+      x = p;
+    }
+    return index;
+  }
+#endif
 };
 
 // // 红黑树的 header 节点
@@ -187,6 +225,16 @@ inline bool operator!=(const rb_tree_base_iterator& x,
   return x.node != y.node;
 }
 
+#ifdef TOYSTL_RB_TREE_ORDER_STATISTICS
+// 有子树大小时，两个迭代器之间的距离由序号相减得到，O(log n)
+template <class Value, class Ref, class Ptr>
+inline ptrdiff_t distance(rb_tree_iterator<Value, Ref, Ptr> first,
+                          rb_tree_iterator<Value, Ref, Ptr> last) {
+  return static_cast<ptrdiff_t>(rb_tree_node_base::s_index_of(last.node)) -
+         static_cast<ptrdiff_t>(rb_tree_node_base::s_index_of(first.node));
+}
+#endif
+
 /*---------------------------------------*\
 |       p                         p       |
 |      / \                       / \      |
@@ -215,6 +263,10 @@ inline void rb_tree_rotate_left(rb_tree_node_base* x,
   }
   y->left = x;  // 调整 x 与 y 之间的联系
   x->parent = y;
+#ifdef TOYSTL_RB_TREE_ORDER_STATISTICS
+  y->size = x->size;  // y 接管 x 原来的整棵子树
+  rb_tree_node_base::s_update_size(x);
+#endif
 }
 
 /*----------------------------------------*\
@@ -246,6 +298,10 @@ inline void rb_tree_rotate_right(rb_tree_node_base* x,
   // 调整 y 与 x 之间的关系
   y->right = x;
   x->parent = y;
+#ifdef TOYSTL_RB_TREE_ORDER_STATISTICS
+  y->size = x->size;
+  rb_tree_node_base::s_update_size(x);
+#endif
 }
 
 // 插入节点后
@@ -260,6 +316,14 @@ inline void rb_tree_rotate_right(rb_tree_node_base* x,
 // 或黑色，父节点为左（右）孩子，当前节点为左（右）孩子，
 //        让父节点变为黑色，祖父节点变为红色，以祖父节点为支点右（左）旋
 inline void rb_tree_rebalance(rb_tree_node_base* x, rb_tree_node_base*& root) {
+#ifdef TOYSTL_RB_TREE_ORDER_STATISTICS
+  // 新节点的各级祖先的子树都多了一个节点，旋转之前先更新好
+  x->size = 1;
+  for (rb_tree_node_base* p = x; p != root;) {
+    p = p->parent;
+    ++p->size;
+  }
+#endif
   x->color = rb_tree_red;  // 新增节点为红色
   while (x != root && x->parent->color == rb_tree_red) {  // 父节点为红
     if (x->parent == x->parent->parent->left) {  // 父节点为祖父节点的左子节点
@@ -334,6 +398,13 @@ inline rb_tree_node_base* rb_tree_rebalance_for_erase(
   }
   rb_tree_node_base* y =
       (z->left == nullptr || z->right == nullptr) ? z : z_next;
+#ifdef TOYSTL_RB_TREE_ORDER_STATISTICS
+  // 实际从树中摘下的是 y，y 的各级祖先（包括 z）的子树都少了一个节点
+  for (rb_tree_node_base* p = y; p != root;) {
+    p = p->parent;
+    --p->size;
+  }
+#endif
   // x 是 y 的一个独子节点或 NIL节点
   rb_tree_node_base* x = (y->left != nullptr) ? y->left : y->right;
   rb_tree_node_base* x_parent = nullptr;
@@ -358,7 +429,7 @@ inline rb_tree_node_base* rb_tree_rebalance_for_erase(
       y->right = z->right;
       z->right->parent = y;
     } else {
-      x_parent = x;
+      x_parent = y;
     }
 
     // 连接 y 与 z 的父节点
@@ -371,6 +442,9 @@ inline rb_tree_node_base* rb_tree_rebalance_for_erase(
     }
     y->parent = z->parent;
     toystl::swap(y->color, z->color);
+#ifdef TOYSTL_RB_TREE_ORDER_STATISTICS
+    y->size = z->size;
+#endif
 
     y = z;
   }
@@ -478,7 +552,7 @@ inline rb_tree_node_base* rb_tree_rebalance_for_erase(
           x_parent = x_parent->parent;
         } else {
           if (x_brother->left == nullptr ||
-              x_brother->right->color != rb_tree_red) {
+              x_brother->left->color != rb_tree_red) {
             // case3：兄弟节点为黑色，左子节点为红色或者 NIL，右子节点为黑色或
             // NIL
             if (x_brother->right != nullptr) {
@@ -512,12 +586,14 @@ template <class Key, class Value,
           class KeyOfValue,  // 怎么从 value 取出 key
           class Compare,     // 键值大小比较规则
           class Allocator = toystl::allocator<Value>>
-class rb_tree {
+class rb_tree : private allocator_holder<Allocator> {
  protected:
   using base_ptr = rb_tree_node_base*;
   using Node = rb_tree_node<Value>;
   using nodeAllocator = typename Allocator::template rebind<Node>::other;
   using dataAllocator = Allocator;
+  // 分配器保存在基类 allocator_holder 中，节点用 rebind 后的分配器分配
+  using alloc_base = allocator_holder<Allocator>;
 
  public:
   using key_type = Key;
@@ -529,6 +605,7 @@ class rb_tree {
   using link_type = Node*;
   using size_type = size_t;
   using difference_type = ptrdiff_t;
+  using allocator_type = Allocator;
 
   using iterator = rb_tree_iterator<value_type, reference, pointer>;
   using const_iterator =
@@ -537,13 +614,14 @@ class rb_tree {
   using const_reverse_iterator = toystl::reverse_iterator<const_iterator>;
 
  protected:
-  link_type get_node() { return nodeAllocator::allocate(1); }
-  void put_node(link_type p) { nodeAllocator::deallocate(p); }
+  link_type get_node() { return nodeAllocator(this->get_alloc()).allocate(1); }
+  void put_node(link_type p) { nodeAllocator(this->get_alloc()).deallocate(p); }
 
-  link_type create_node(const value_type& x) {
+  template <class... Args>
+  link_type create_node(Args&&... args) {
     link_type tmp = get_node();
     try {
-      construct(&tmp->value_field, x);
+      construct(&tmp->value_field, toystl::forward<Args>(args)...);
     } catch (...) {
       put_node(tmp);
       throw;
@@ -557,6 +635,9 @@ class rb_tree {
     tmp->color = x->color;
     tmp->left = x->left;
     tmp->right = x->right;
+#ifdef TOYSTL_RB_TREE_ORDER_STATISTICS
+    tmp->size = x->size;
+#endif
 
     return tmp;
   }
@@ -604,10 +685,30 @@ class rb_tree {
 
  public:
   iterator insert(base_ptr x, base_ptr y, const value_type& v);
+  iterator insert_node(base_ptr x, base_ptr y, link_type z);
   link_type copy(link_type x, link_type y);
+
+  // 寻找键值 k 的插入位置，返回 (x, y)：y 为插入点的父节点，x 不为空时
+  // 插入到 y 的左侧。键值不允许重复时，若 k 已经存在则 y 为空，x 为该节点
+  pair<base_ptr, base_ptr> get_insert_unique_pos(const key_type& k);
+  pair<base_ptr, base_ptr> get_insert_equal_pos(const key_type& k);
+  // 同上，先检查 hint 附近的位置，提示正确时不必从根节点往下找
+  pair<base_ptr, base_ptr> get_insert_hint_unique_pos(const_iterator hint,
+                                                      const key_type& k);
+  pair<base_ptr, base_ptr> get_insert_hint_equal_pos(const_iterator hint,
+                                                     const key_type& k);
   void erase(link_type x);
 
   void clear();
+
+  // 树为空时，把 [first, last) 中有序的最长前缀直接建成一棵平衡的红黑树，
+  // 返回第一个破坏顺序的位置。unique 为 true 时跳过重复的键值
+  template <class InputIterator>
+  InputIterator build_sorted_prefix(InputIterator first, InputIterator last,
+                                    bool unique);
+  link_type build_balanced(link_type& list, size_type n, size_type depth,
+                           size_type red_depth);
+
   void init() {
     header = get_node();
     header->color = rb_tree_red;  // header 为红色，用来区分 header 和 root
@@ -618,43 +719,115 @@ class rb_tree {
 
  public:
   // 构造、赋值、析构函数
-  rb_tree(const Compare& comp = Compare()) : node_count(0), key_compare(comp) {
+  rb_tree(const Compare& comp = Compare(),
+          const allocator_type& a = allocator_type())
+      : alloc_base(a), node_count(0), key_compare(comp) {
     init();
   }
 
-  rb_tree(const rb_tree& rhs) {
-    if (rhs.root() == nullptr) {
-      init();
-    } else {
-      color(header) = rb_tree_red;
-      root() = copy(rhs.root(), header);
-      leftmost() = minimum(root());
-      rightmost() = maximum(root());
-    }
-    node_count = rhs.node_count;
-    key_compare = rhs.key_compare;
+  // 新容器的分配器由 select_on_container_copy_construction 决定
+  rb_tree(const rb_tree& rhs)
+      : alloc_base(rhs.get_alloc().select_on_container_copy_construction()),
+        node_count(0),
+        key_compare(rhs.key_compare) {
+    init();
+    copy_from(rhs);
+  }
+
+  rb_tree(const rb_tree& rhs, const allocator_type& a)
+      : alloc_base(a), node_count(0), key_compare(rhs.key_compare) {
+    init();
+    copy_from(rhs);
+  }
+
+  // 分配器随节点一起移动过来，rhs 重新获得一个空的 header
+  rb_tree(rb_tree&& rhs)
+      : alloc_base(rhs.get_alloc()),
+        node_count(rhs.node_count),
+        header(rhs.header),
+        key_compare(rhs.key_compare) {
+    rhs.init();
+    rhs.node_count = 0;
   }
 
   rb_tree& operator=(const rb_tree& rhs) {
     if (this != &rhs) {
+      copy_assign_alloc(
+          rhs,
+          typename allocator_type::propagate_on_container_copy_assignment());
       clear();
+      key_compare = rhs.key_compare;
+      copy_from(rhs);
+    }
 
-      if (rhs.root() == nullptr) {
-        root() == nullptr;
-        leftmost() = header;
-        rightmost() = header;
-      } else {
-        root() = copy(rhs.root(), header);
-        leftmost() = minimum(root());
-        rightmost() = maximum(root());
-        node_count = rhs.node_count;
-      }
+    return *this;
+  }
+
+  rb_tree& operator=(rb_tree&& rhs) {
+    if (this != &rhs) {
+      move_assign(
+          rhs,
+          typename allocator_type::propagate_on_container_move_assignment());
     }
 
     return *this;
   }
 
-  ~rb_tree() { clear(); }
+  ~rb_tree() {
+    clear();
+    put_node(header);
+  }
+
+  allocator_type get_allocator() const { return this->get_alloc(); }
+
+ private:
+  // 要求当前树为空
+  void copy_from(const rb_tree& rhs) {
+    if (rhs.root() != nullptr) {
+      root() = copy(rhs.root(), header);
+      leftmost() = minimum(root());
+      rightmost() = maximum(root());
+      node_count = rhs.node_count;
+    }
+  }
+
+  // 分配器需要传播时，如果两个分配器不相等，原有节点必须由原分配器释放
+  void copy_assign_alloc(const rb_tree& rhs, true_type) {
+    if (this->get_alloc() != rhs.get_alloc()) {
+      clear();
+      put_node(header);
+      this->set_alloc(rhs.get_alloc());
+      init();
+    } else {
+      this->set_alloc(rhs.get_alloc());
+    }
+  }
+
+  void copy_assign_alloc(const rb_tree&, false_type) {}
+
+  // 分配器随节点一起转移
+  void move_assign(rb_tree& rhs, true_type) {
+    clear();
+    put_node(header);
+    this->set_alloc(rhs.get_alloc());
+    header = rhs.header;
+    node_count = rhs.node_count;
+    key_compare = rhs.key_compare;
+    rhs.init();
+    rhs.node_count = 0;
+  }
+
+  // 分配器不传播：分配器相等时仍然可以直接接管节点，否则只能逐个拷贝元素
+  void move_assign(rb_tree& rhs, false_type) {
+    if (this->get_alloc() == rhs.get_alloc()) {
+      move_assign(rhs, true_type());
+    } else {
+      clear();
+      key_compare = rhs.key_compare;
+      copy_from(rhs);
+      rhs.clear();
+    }
+  }
 
  public:
   Compare key_comp() const { return key_compare; }
@@ -664,7 +837,7 @@ class rb_tree {
   const_iterator end() const { return header; }
 
   reverse_iterator rbegin() { return reverse_iterator(end()); }
-  const_reverse_iterator rebegin() const {
+  const_reverse_iterator rbegin() const {
     return const_reverse_iterator(end());
   }
   reverse_iterator rend() { return reverse_iterator(begin()); }
@@ -682,8 +855,10 @@ class rb_tree {
   size_type size() const { return node_count; }
   size_type max_size() const { return static_cast<size_type>(-1); }
 
+  // 分配器按 propagate_on_container_swap 决定是否交换
   void swap(rb_tree& rhs) {
     if (this != &rhs) {
+      this->swap_alloc(rhs);
       toystl::swap(header, rhs.header);
       toystl::swap(node_count, rhs.node_count);
       toystl::swap(key_compare, rhs.key_compare);
@@ -691,14 +866,29 @@ class rb_tree {
   }
 
   // 插入
+  // 就地构造新值，节点键值允许重复
+  template <class... Args>
+  iterator emplace_equal(Args&&... args);
+  // 就地构造新值，节点键值不允许重复，若重复则销毁新节点
+  template <class... Args>
+  pair<iterator, bool> emplace_unique(Args&&... args);
+  // 带位置提示的版本：新值应当插入在 hint 之前（或紧挨着 hint）时，
+  // 只需要常数次比较，顺序插入递增的键值均摊 O(1)
+  template <class... Args>
+  iterator emplace_hint_equal(const_iterator hint, Args&&... args);
+  template <class... Args>
+  iterator emplace_hint_unique(const_iterator hint, Args&&... args);
+
   // 插入新值，节点键值允许重复
   iterator insert_equal(const value_type& v);
+  iterator insert_equal(const_iterator hint, const value_type& v);
   void insert_equal(const_iterator first, const_iterator last);
   void insert_equal(const value_type* first, const value_type* last);
   template <class InputIterator>
   void insert_equal(InputIterator first, InputIterator last);
   // 插入新值，节点键值不允许重复，若重复则插入无效
   pair<iterator, bool> insert_unique(const value_type& v);
+  iterator insert_unique(const_iterator hint, const value_type& v);
   void insert_unique(const_iterator first, const_iterator last);
   void insert_unique(const value_type* first, const value_type* last);
   template <class InputIterator>
@@ -724,8 +914,64 @@ class rb_tree {
   const_iterator upper_bound(const Key& k) const;
   pair<iterator, iterator> equal_range(const Key& key);
   pair<const_iterator, const_iterator> equal_range(const Key& key) const;
+
+#ifdef TOYSTL_RB_TREE_ORDER_STATISTICS
+  // 顺序统计
+  // 中序遍历中的第 n 个元素（从 0 开始），n 不小于 size() 时返回 end()
+  iterator select(size_type n) { return select_node(n); }
+  const_iterator select(size_type n) const { return select_node(n); }
+  // 键值小于 k 的元素个数，也就是 lower_bound(k) 的序号
+  size_type rank(const key_type& k) const;
+  // 迭代器的序号，end() 的序号为 size()
+  size_type index_of(const_iterator it) const {
+    return rb_tree_node_base::s_index_of(it.node);
+  }
+
+ private:
+  link_type select_node(size_type n) const;
+#endif
 };
 
+#ifdef TOYSTL_RB_TREE_ORDER_STATISTICS
+template <class Key, class Value, class KeyOfValue, class Compare,
+          class Allocator>
+typename rb_tree<Key, Value, KeyOfValue, Compare, Allocator>::link_type
+rb_tree<Key, Value, KeyOfValue, Compare, Allocator>::select_node(
+    size_type n) const {
+  link_type x = root();
+  while (x != nullptr) {
+    const size_type left_size = rb_tree_node_base::s_size(x->left);
+    if (n < left_size) {
+      x = left(x);
+    } else if (n == left_size) {
+      return x;
+    } else {
+      n -= left_size + 1;
+      x = right(x);
+    }
+  }
+  return header;
+}
+
+template <class Key, class Value, class KeyOfValue, class Compare,
+          class Allocator>
+typename rb_tree<Key, Value, KeyOfValue, Compare, Allocator>::size_type
+rb_tree<Key, Value, KeyOfValue, Compare, Allocator>::rank(
+    const key_type& k) const {
+  size_type result = 0;
+  link_type x = root();
+  while (x != nullptr) {
+    if (key_compare(getKey(x), k)) {  // x 及其左子树都小于 k
+      result += rb_tree_node_base::s_size(x->left) + 1;
+      x = right(x);
+    } else {
+      x = left(x);
+    }
+  }
+  return result;
+}
+#endif
+
 template <class Key, class Value, class KeyOfValue, class Compare,
           class Allocator>
 void rb_tree<Key, Value, KeyOfValue, Compare, Allocator>::clear() {
@@ -743,24 +989,52 @@ template <class Key, class Value, class KeyOfValue, class Compare,
 typename rb_tree<Key, Value, KeyOfValue, Compare, Allocator>::iterator
 rb_tree<Key, Value, KeyOfValue, Compare, Allocator>::insert_equal(
     const value_type& v) {
-  link_type y = header;
-  link_type x = root();  // 从根节点开始
-  while (x != 0) {       // 从根节点开始，往下寻找适当的插入点
-    y = x;
-    x = key_compare(KeyOfValue()(v), getKey(x)) ? left(x) : right(x);
-    // 以上，遇到大的则往左，遇到 小于等于 则往右
-  }
-
-  return insert(x, y, v);
+  pair<base_ptr, base_ptr> pos = get_insert_equal_pos(KeyOfValue()(v));
+  return insert(pos.first, pos.second, v);
   // 以上，x 为新值插入点，y 为插入点之父节点，v 为新值
 }
 
+template <class Key, class Value, class KeyOfValue, class Compare,
+          class Allocator>
+typename rb_tree<Key, Value, KeyOfValue, Compare, Allocator>::iterator
+rb_tree<Key, Value, KeyOfValue, Compare, Allocator>::insert_equal(
+    const_iterator hint, const value_type& v) {
+  pair<base_ptr, base_ptr> pos =
+      get_insert_hint_equal_pos(hint, KeyOfValue()(v));
+  return insert(pos.first, pos.second, v);
+}
+
+template <class Key, class Value, class KeyOfValue, class Compare,
+          class Allocator>
+template <class... Args>
+typename rb_tree<Key, Value, KeyOfValue, Compare, Allocator>::iterator
+rb_tree<Key, Value, KeyOfValue, Compare, Allocator>::emplace_equal(
+    Args&&... args) {
+  link_type z = create_node(toystl::forward<Args>(args)...);
+  pair<base_ptr, base_ptr> pos = get_insert_equal_pos(getKey(z));
+  return insert_node(pos.first, pos.second, z);
+}
+
+template <class Key, class Value, class KeyOfValue, class Compare,
+          class Allocator>
+template <class... Args>
+typename rb_tree<Key, Value, KeyOfValue, Compare, Allocator>::iterator
+rb_tree<Key, Value, KeyOfValue, Compare, Allocator>::emplace_hint_equal(
+    const_iterator hint, Args&&... args) {
+  link_type z = create_node(toystl::forward<Args>(args)...);
+  pair<base_ptr, base_ptr> pos = get_insert_hint_equal_pos(hint, getKey(z));
+  return insert_node(pos.first, pos.second, z);
+}
+
 template <class Key, class Value, class KeyOfValue, class Compare,
           class Allocator>
 void rb_tree<Key, Value, KeyOfValue, Compare, Allocator>::insert_equal(
     const_iterator first, const_iterator last) {
+  if (empty()) {
+    first = build_sorted_prefix(first, last, false);
+  }
   for (; first != last; ++first) {
-    insert_equal(*first);
+    insert_equal(end(), *first);
   }
 }
 
@@ -768,8 +1042,11 @@ template <class Key, class Value, class KeyOfValue, class Compare,
           class Allocator>
 void rb_tree<Key, Value, KeyOfValue, Compare, Allocator>::insert_equal(
     const value_type* first, const value_type* last) {
+  if (empty()) {
+    first = build_sorted_prefix(first, last, false);
+  }
   for (; first != last; ++first) {
-    insert_equal(*first);
+    insert_equal(end(), *first);
   }
 }
 
@@ -778,8 +1055,11 @@ template <class Key, class Value, class KeyOfValue, class Compare,
 template <class InputIterator>
 void rb_tree<Key, Value, KeyOfValue, Compare, Allocator>::insert_equal(
     InputIterator first, InputIterator last) {
+  if (empty()) {
+    first = build_sorted_prefix(first, last, false);
+  }
   for (; first != last; ++first) {
-    insert_equal(*first);
+    insert_equal(end(), *first);
   }
 }
 
@@ -789,44 +1069,69 @@ pair<typename rb_tree<Key, Value, KeyOfValue, Compare, Allocator>::iterator,
      bool>
 rb_tree<Key, Value, KeyOfValue, Compare, Allocator>::insert_unique(
     const value_type& v) {
-  link_type y = header;
-  link_type x = root();
-  bool comp = true;
-  while (x != nullptr) {
-    y = x;
-    comp = key_compare(KeyOfValue()(v),
-                       getKey(x));  // v 的键值小于目前节点的键值？
-    x = comp ? left(x) : right(x);  // 遇大则往左，遇小于或等于则往右
+  pair<base_ptr, base_ptr> pos = get_insert_unique_pos(KeyOfValue()(v));
+  if (pos.second != nullptr) {
+    return pair<iterator, bool>(insert(pos.first, pos.second, v), true);
   }
-  // 离开 while 循环之后，y 所指就是插入点的父节点（此时的它必为叶子节点）
+  // 新值与树中键值重复，那么就不应该插入新值
+  return pair<iterator, bool>(iterator(static_cast<link_type>(pos.first)),
+                              false);
+}
 
-  iterator j = iterator(y);
-  if (comp) {            // 如果离开 while 循环时，
-                         // comp 为真（遇 “大” ，将插入于左侧）
-    if (j == begin()) {  // 如果插入点的父节点为最左节点
-      return pair<iterator, bool>(insert(x, y, v), true);
-    } else {
-      j--;  // 调整 j,让 j 指向 比 j 处的节点键值小的那个节点的迭代器
-    }
+template <class Key, class Value, class KeyOfValue, class Compare,
+          class Allocator>
+typename rb_tree<Key, Value, KeyOfValue, Compare, Allocator>::iterator
+rb_tree<Key, Value, KeyOfValue, Compare, Allocator>::insert_unique(
+    const_iterator hint, const value_type& v) {
+  pair<base_ptr, base_ptr> pos =
+      get_insert_hint_unique_pos(hint, KeyOfValue()(v));
+  if (pos.second != nullptr) {
+    return insert(pos.first, pos.second, v);
+  }
+  return iterator(static_cast<link_type>(pos.first));
+}
+
+template <class Key, class Value, class KeyOfValue, class Compare,
+          class Allocator>
+template <class... Args>
+pair<typename rb_tree<Key, Value, KeyOfValue, Compare, Allocator>::iterator,
+     bool>
+rb_tree<Key, Value, KeyOfValue, Compare, Allocator>::emplace_unique(
+    Args&&... args) {
+  link_type z = create_node(toystl::forward<Args>(args)...);
+  pair<base_ptr, base_ptr> pos = get_insert_unique_pos(getKey(z));
+  if (pos.second != nullptr) {
+    return pair<iterator, bool>(insert_node(pos.first, pos.second, z), true);
   }
-  if (key_compare(getKey(j.node),
-                  KeyOfValue()(v)))  // 判断这二者的键值是否相等。key_compare
-                                     // 为真，说明 getKey(j.node) >
-                                     // KeyOfValue()(v)
-    // 新键值不与既有节点的简直重复，于是执行安插操作
-    return pair<iterator, bool>(insert(x, y, v), true);
-  // 以上 x 为新键值插入点，y 为插入点的父节点，v 为新值
+  destroy_node(z);
+  return pair<iterator, bool>(iterator(static_cast<link_type>(pos.first)),
+                              false);
+}
 
-  // 进行至此，表示新值一定与树中键值重复，那么就不应该插入新值
-  return pair<iterator, bool>(j, false);
+template <class Key, class Value, class KeyOfValue, class Compare,
+          class Allocator>
+template <class... Args>
+typename rb_tree<Key, Value, KeyOfValue, Compare, Allocator>::iterator
+rb_tree<Key, Value, KeyOfValue, Compare, Allocator>::emplace_hint_unique(
+    const_iterator hint, Args&&... args) {
+  link_type z = create_node(toystl::forward<Args>(args)...);
+  pair<base_ptr, base_ptr> pos = get_insert_hint_unique_pos(hint, getKey(z));
+  if (pos.second != nullptr) {
+    return insert_node(pos.first, pos.second, z);
+  }
+  destroy_node(z);
+  return iterator(static_cast<link_type>(pos.first));
 }
 
 template <class Key, class Value, class KeyOfValue, class Compare,
           class Allocator>
 void rb_tree<Key, Value, KeyOfValue, Compare, Allocator>::insert_unique(
     const_iterator first, const_iterator last) {
+  if (empty()) {
+    first = build_sorted_prefix(first, last, true);
+  }
   for (; first != last; ++first) {
-    insert_unique(*first);
+    insert_unique(end(), *first);
   }
 }
 
@@ -834,8 +1139,11 @@ template <class Key, class Value, class KeyOfValue, class Compare,
           class Allocator>
 void rb_tree<Key, Value, KeyOfValue, Compare, Allocator>::insert_unique(
     const value_type* first, const value_type* last) {
+  if (empty()) {
+    first = build_sorted_prefix(first, last, true);
+  }
   for (; first != last; ++first) {
-    insert_unique(*first);
+    insert_unique(end(), *first);
   }
 }
 
@@ -844,11 +1152,105 @@ template <class Key, class Value, class KeyOfValue, class Compare,
 template <class InputIterator>
 void rb_tree<Key, Value, KeyOfValue, Compare, Allocator>::insert_unique(
     InputIterator first, InputIterator last) {
+  if (empty()) {
+    first = build_sorted_prefix(first, last, true);
+  }
   for (; first != last; ++first) {
-    insert_unique(*first);
+    insert_unique(end(), *first);
   }
 }
 
+// 区间插入时以 end() 作为位置提示，非空的树上追加递增的键值也不必
+// 每次从根节点往下找。
+// 有序区间建树分两步：先按顺序创建节点，以 right 指针串成链表；
+// 再模仿中序遍历，每次把链表平分成左右两半递归建树，整个过程 O(n)，
+// 不需要任何旋转。左右子树的大小至多相差 1，所有空链接的深度只能是
+// floor(log2(n + 1)) 或者再多 1，所以把最深的那一层（不满的一层）染成红色、
+// 其余染成黑色，每条路径上的黑色节点数都相同，而且红色节点没有子节点
+template <class Key, class Value, class KeyOfValue, class Compare,
+          class Allocator>
+template <class InputIterator>
+InputIterator
+rb_tree<Key, Value, KeyOfValue, Compare, Allocator>::build_sorted_prefix(
+    InputIterator first, InputIterator last, bool unique) {
+  link_type head = nullptr;
+  link_type tail = nullptr;
+  size_type n = 0;
+  try {
+    for (; first != last; ++first) {
+      if (tail != nullptr) {
+        if (key_compare(KeyOfValue()(*first), getKey(tail))) {
+          break;  // 顺序被破坏，剩下的元素逐个插入
+        }
+        if (unique && !key_compare(getKey(tail), KeyOfValue()(*first))) {
+          continue;  // 与前一个键值相同
+        }
+      }
+      link_type z = create_node(*first);
+      right(z) = nullptr;
+      if (tail == nullptr) {
+        head = z;
+      } else {
+        right(tail) = z;
+      }
+      tail = z;
+      ++n;
+    }
+  } catch (...) {
+    while (head != nullptr) {
+      link_type next = right(head);
+      destroy_node(head);
+      head = next;
+    }
+    throw;
+  }
+
+  if (n != 0) {
+    // 深度小于 red_depth 的各层都是满的
+    size_type red_depth = 0;
+    while ((size_type(2) << red_depth) <= n + 1) {
+      ++red_depth;
+    }
+    root() = build_balanced(head, n, 0, red_depth);
+    parent(root()) = header;
+    leftmost() = minimum(root());
+    rightmost() = tail;
+    node_count = n;
+  }
+
+  return first;
+}
+
+// 以链表 list 的前 n 个节点建树并返回子树的根，list 前进到第 n + 1 个节点
+template <class Key, class Value, class KeyOfValue, class Compare,
+          class Allocator>
+typename rb_tree<Key, Value, KeyOfValue, Compare, Allocator>::link_type
+rb_tree<Key, Value, KeyOfValue, Compare, Allocator>::build_balanced(
+    link_type& list, size_type n, size_type depth, size_type red_depth) {
+  if (n == 0) {
+    return nullptr;
+  }
+  const size_type left_size = n / 2;
+  link_type left_child = build_balanced(list, left_size, depth + 1, red_depth);
+  link_type x = list;
+  list = right(list);
+
+  left(x) = left_child;
+  right(x) = build_balanced(list, n - left_size - 1, depth + 1, red_depth);
+  if (left(x) != nullptr) {
+    parent(left(x)) = x;
+  }
+  if (right(x) != nullptr) {
+    parent(right(x)) = x;
+  }
+  color(x) = depth == red_depth ? rb_tree_red : rb_tree_black;
+#ifdef TOYSTL_RB_TREE_ORDER_STATISTICS
+  x->size = n;
+#endif
+
+  return x;
+}
+
 // 被其他函数调用，插入一定是插入到叶子节点
 // x 是新值插入点，y 是新值插入点父节点，参数 v 为新值
 template <class Key, class Value, class KeyOfValue, class Compare,
@@ -856,15 +1258,23 @@ template <class Key, class Value, class KeyOfValue, class Compare,
 typename rb_tree<Key, Value, KeyOfValue, Compare, Allocator>::iterator
 rb_tree<Key, Value, KeyOfValue, Compare, Allocator>::insert(
     base_ptr x, base_ptr y, const value_type& v) {
+  return insert_node(x, y, create_node(v));
+}
+
+// 把已经构造好的节点 z 链入树中，x、y 的含义同上
+template <class Key, class Value, class KeyOfValue, class Compare,
+          class Allocator>
+typename rb_tree<Key, Value, KeyOfValue, Compare, Allocator>::iterator
+rb_tree<Key, Value, KeyOfValue, Compare, Allocator>::insert_node(base_ptr x,
+                                                                 base_ptr y,
+                                                                 link_type z) {
   link_type pos = static_cast<link_type>(x);         // 新值插入点
   link_type pos_parent = static_cast<link_type>(y);  // 新值插入点的父节点
-  link_type z;                                       // 新值插入的节点
 
-  // 如果新值插入点的父节点是 header 或者 新值插入点是空节点 或者 v 对应的键值
+  // 如果新值插入点的父节点是 header 或者 新值插入点不为空 或者 z 的键值
   // 比 新插入点的父节点的键值要小
   if (pos_parent == header || pos != nullptr ||
-      key_compare(KeyOfValue()(v), getKey(pos_parent))) {
-    z = create_node(v);
+      key_compare(getKey(z), getKey(pos_parent))) {
     left(pos_parent) = z;  // 将新的 value 的节点插入到 父节点的左边
     if (pos_parent == header) {
       root() = z;
@@ -873,7 +1283,6 @@ rb_tree<Key, Value, KeyOfValue, Compare, Allocator>::insert(
       leftmost() = z;
     }
   } else {
-    z = create_node(v);
     right(pos_parent) = z;  // 将新的 value 的节点插入到 父节点的右边
     if (pos_parent == rightmost()) {
       rightmost() = z;
@@ -888,6 +1297,141 @@ rb_tree<Key, Value, KeyOfValue, Compare, Allocator>::insert(
   return static_cast<iterator>(z);
 }
 
+template <class Key, class Value, class KeyOfValue, class Compare,
+          class Allocator>
+pair<typename rb_tree<Key, Value, KeyOfValue, Compare, Allocator>::base_ptr,
+     typename rb_tree<Key, Value, KeyOfValue, Compare, Allocator>::base_ptr>
+rb_tree<Key, Value, KeyOfValue, Compare, Allocator>::get_insert_unique_pos(
+    const key_type& k) {
+  link_type y = header;
+  link_type x = root();
+  bool comp = true;
+  while (x != nullptr) {
+    y = x;
+    comp = key_compare(k, getKey(x));  // k 小于目前节点的键值？
+    x = comp ? left(x) : right(x);     // 遇大则往左，遇小于或等于则往右
+  }
+  // 离开 while 循环之后，y 所指就是插入点的父节点（此时的它必为叶子节点）
+
+  iterator j = iterator(y);
+  if (comp) {  // 离开 while 循环时 comp 为真（遇 “大” ，将插入于左侧）
+    if (j == begin()) {  // 如果插入点的父节点为最左节点
+      return pair<base_ptr, base_ptr>(x, y);
+    }
+    --j;  // 调整 j，让 j 指向比插入点小的那个节点
+  }
+  if (key_compare(getKey(j.node), k)) {  // j 的键值小于 k，不重复
+    return pair<base_ptr, base_ptr>(x, y);
+  }
+  return pair<base_ptr, base_ptr>(j.node, nullptr);
+}
+
+template <class Key, class Value, class KeyOfValue, class Compare,
+          class Allocator>
+pair<typename rb_tree<Key, Value, KeyOfValue, Compare, Allocator>::base_ptr,
+     typename rb_tree<Key, Value, KeyOfValue, Compare, Allocator>::base_ptr>
+rb_tree<Key, Value, KeyOfValue, Compare, Allocator>::get_insert_equal_pos(
+    const key_type& k) {
+  link_type y = header;
+  link_type x = root();  // 从根节点开始，往下寻找适当的插入点
+  while (x != nullptr) {
+    y = x;
+    x = key_compare(k, getKey(x)) ? left(x) : right(x);
+    // 以上，遇到大的则往左，遇到 小于等于 则往右
+  }
+  return pair<base_ptr, base_ptr>(x, y);
+}
+
+// 依次检查 hint 之前、hint 之后两个空隙，k 落在其中时直接挂在
+// 相邻节点空着的子链接上：before 的右子节点为空就挂在 before 右侧，
+// 否则 hint 的左子节点必然为空（hint 左子树的最大值就是 before），
+// 挂在 hint 左侧。都不合适才从根节点往下找
+template <class Key, class Value, class KeyOfValue, class Compare,
+          class Allocator>
+pair<typename rb_tree<Key, Value, KeyOfValue, Compare, Allocator>::base_ptr,
+     typename rb_tree<Key, Value, KeyOfValue, Compare, Allocator>::base_ptr>
+rb_tree<Key, Value, KeyOfValue, Compare, Allocator>::get_insert_hint_unique_pos(
+    const_iterator hint, const key_type& k) {
+  base_ptr pos = hint.node;
+  if (pos == header) {  // 提示为 end()，最常见的是顺序追加
+    if (size() > 0 && key_compare(getKey(rightmost()), k)) {
+      return pair<base_ptr, base_ptr>(nullptr, rightmost());
+    }
+    return get_insert_unique_pos(k);
+  }
+  if (key_compare(k, getKey(pos))) {  // k 在 hint 之前
+    if (pos == leftmost()) {
+      return pair<base_ptr, base_ptr>(pos, pos);
+    }
+    const_iterator before = hint;
+    --before;
+    if (key_compare(getKey(before.node), k)) {
+      if (right(before.node) == nullptr) {
+        return pair<base_ptr, base_ptr>(nullptr, before.node);
+      }
+      return pair<base_ptr, base_ptr>(pos, pos);
+    }
+    return get_insert_unique_pos(k);
+  }
+  if (key_compare(getKey(pos), k)) {  // k 在 hint 之后
+    if (pos == rightmost()) {
+      return pair<base_ptr, base_ptr>(nullptr, pos);
+    }
+    const_iterator after = hint;
+    ++after;
+    if (key_compare(k, getKey(after.node))) {
+      if (right(pos) == nullptr) {
+        return pair<base_ptr, base_ptr>(nullptr, pos);
+      }
+      return pair<base_ptr, base_ptr>(after.node, after.node);
+    }
+    return get_insert_unique_pos(k);
+  }
+  return pair<base_ptr, base_ptr>(pos, nullptr);  // 与 hint 的键值相同
+}
+
+template <class Key, class Value, class KeyOfValue, class Compare,
+          class Allocator>
+pair<typename rb_tree<Key, Value, KeyOfValue, Compare, Allocator>::base_ptr,
+     typename rb_tree<Key, Value, KeyOfValue, Compare, Allocator>::base_ptr>
+rb_tree<Key, Value, KeyOfValue, Compare, Allocator>::get_insert_hint_equal_pos(
+    const_iterator hint, const key_type& k) {
+  base_ptr pos = hint.node;
+  if (pos == header) {
+    if (size() > 0 && !key_compare(k, getKey(rightmost()))) {
+      return pair<base_ptr, base_ptr>(nullptr, rightmost());
+    }
+    return get_insert_equal_pos(k);
+  }
+  if (!key_compare(getKey(pos), k)) {  // k 不大于 hint，插入在 hint 之前
+    if (pos == leftmost()) {
+      return pair<base_ptr, base_ptr>(pos, pos);
+    }
+    const_iterator before = hint;
+    --before;
+    if (!key_compare(k, getKey(before.node))) {
+      if (right(before.node) == nullptr) {
+        return pair<base_ptr, base_ptr>(nullptr, before.node);
+      }
+      return pair<base_ptr, base_ptr>(pos, pos);
+    }
+    return get_insert_equal_pos(k);
+  }
+  // k 大于 hint，插入在 hint 之后
+  if (pos == rightmost()) {
+    return pair<base_ptr, base_ptr>(nullptr, pos);
+  }
+  const_iterator after = hint;
+  ++after;
+  if (!key_compare(getKey(after.node), k)) {
+    if (right(pos) == nullptr) {
+      return pair<base_ptr, base_ptr>(nullptr, pos);
+    }
+    return pair<base_ptr, base_ptr>(after.node, after.node);
+  }
+  return get_insert_equal_pos(k);
+}
+
 template <class Key, class Value, class KeyOfValue, class Compare,
           class Allocator>
 typename rb_tree<Key, Value, KeyOfValue, Compare, Allocator>::link_type
@@ -908,10 +1452,10 @@ rb_tree<Key, Value, KeyOfValue, Compare, Allocator>::copy(link_type x,
       y->left = p;
       p->parent = y;
       if (x->right) {
-        p->right = copy(x->right, p);
+        p->right = copy(right(x), p);
       }
       y = p;
-      x = x->left;
+      x = left(x);
     }
   } catch (...) {
     erase(top);
@@ -957,7 +1501,7 @@ template <class Key, class Value, class KeyOfValue, class Compare,
           class Allocator>
 void rb_tree<Key, Value, KeyOfValue, Compare, Allocator>::erase(iterator first,
                                                                 iterator last) {
-  if (first == begin()&& last = end()) {
+  if (first == begin() && last == end()) {
     clear();
   } else {
     while (first != last) {
@@ -1010,10 +1554,10 @@ rb_tree<Key, Value, KeyOfValue, Compare, Allocator>::find(
     } else {
       x = right(x);
     }
-
-    const_iterator j = const_iterator(y);
-    return (j == end() || key_compare(k, getKey(j.node))) ? end() : j;
   }
+
+  const_iterator j = const_iterator(y);
+  return (j == end() || key_compare(k, getKey(j.node))) ? end() : j;
 }
 
 template <class Key, class Value, class KeyOfValue, class Compare,
@@ -1042,9 +1586,9 @@ rb_tree<Key, Value, KeyOfValue, Compare, Allocator>::lower_bound(const Key& k) {
     } else {
       x = right(x);  // x < k
     }
-
-    return iterator(y);
   }
+
+  return iterator(y);
 }
 
 template <class Key, class Value, class KeyOfValue, class Compare,
@@ -1062,9 +1606,9 @@ rb_tree<Key, Value, KeyOfValue, Compare, Allocator>::lower_bound(
     } else {
       x = right(x);
     }
-
-    return const_iterator(y);
   }
+
+  return const_iterator(y);
 }
 
 template <class Key, class Value, class KeyOfValue, class Compare,
@@ -1081,9 +1625,9 @@ rb_tree<Key, Value, KeyOfValue, Compare, Allocator>::upper_bound(const Key& k) {
     } else {
       x = right(x);
     }
-
-    return iterator(y);
   }
+
+  return iterator(y);
 }
 
 template <class Key, class Value, class KeyOfValue, class Compare,
@@ -1101,9 +1645,9 @@ rb_tree<Key, Value, KeyOfValue, Compare, Allocator>::upper_bound(
     } else {
       x = right(x);
     }
-
-    return const_iterator(y);
   }
+
+  return const_iterator(y);
 }
 
 template <class Key, class Value, class KeyOfValue, class Compare,
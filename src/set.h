@@ -17,6 +17,7 @@ class set {
   using value_type = Key;
   using key_compare = Compare;
   using value_compare = Compare;
+  using allocator_type = Allocator;
 
  private:
   using rb_tree_type =
@@ -41,14 +42,40 @@ class set {
 
  public:
   set() {}
+
+  explicit set(const Compare& comp,
+               const allocator_type& a = allocator_type())
+      : tree_(comp, a) {}
+
+  explicit set(const allocator_type& a) : tree_(Compare(), a) {}
+
   set(const set& x) : tree_(x.tree_) {}
-  set& operator=(const set& s) { tree_ = s.tree_; }
+
+  set(const set& x, const allocator_type& a) : tree_(x.tree_, a) {}
+
+  set(set&& x) : tree_(toystl::move(x.tree_)) {}
+
+  set& operator=(const set& s) {
+    tree_ = s.tree_;
+    return *this;
+  }
+
+  set& operator=(set&& s) {
+    tree_ = toystl::move(s.tree_);
+    return *this;
+  }
 
   template <class InputIterator>
-  set(InputIterator first, InputIterator last) {
+  set(InputIterator first, InputIterator last,
+      const Compare& comp = Compare(),
+      const allocator_type& a = allocator_type())
+      : tree_(comp, a) {
     tree_.insert_unique(first, last);
   }
 
+  allocator_type get_allocator() const { return tree_.get_allocator(); }
+  key_compare key_comp() const { return tree_.key_comp(); }
+
   iterator begin() noexcept { return tree_.begin(); }
   const_iterator begin() const noexcept { return tree_.begin(); }
   iterator end() noexcept { return tree_.end(); }
@@ -78,9 +105,21 @@ class set {
     return toystl::pair<iterator, bool>(p.first, p.second);
   }
 
-  iterator insert(iterator position, const value_type& x) {
-    using tree_iterator = typename rb_tree_type::iterator;
-    return tree_.insert_unique((tree_iterator&)position, x);
+  // 以 hint 作为位置提示，新值恰好插入在 hint 之前时只需常数次比较
+  iterator insert(const_iterator hint, const value_type& x) {
+    return tree_.insert_unique(hint, x);
+  }
+
+  template <class... Args>
+  pair<iterator, bool> emplace(Args&&... args) {
+    toystl::pair<typename rb_tree_type::iterator, bool> p =
+        tree_.emplace_unique(toystl::forward<Args>(args)...);
+    return toystl::pair<iterator, bool>(p.first, p.second);
+  }
+
+  template <class... Args>
+  iterator emplace_hint(const_iterator hint, Args&&... args) {
+    return tree_.emplace_hint_unique(hint, toystl::forward<Args>(args)...);
   }
 
   template <class InputIterator>
@@ -110,6 +149,14 @@ class set {
     return tree_.equal_range(x);
   }
 
+#ifdef TOYSTL_RB_TREE_ORDER_STATISTICS
+  // 顺序统计，均为 O(log n)：第 n 小的元素、键值小于 x 的元素个数、
+  // 迭代器的序号
+  iterator select(size_type n) const { return tree_.select(n); }
+  size_type rank(const key_type& x) const { return tree_.rank(x); }
+  size_type index_of(const_iterator it) const { return tree_.index_of(it); }
+#endif
+
   template <class K1, class C1, class A1>
   friend bool operator==(const set&, const set&);
   template <class K1, class C1, class A1>
@@ -137,6 +184,7 @@ class multiset {
   using value_type = Key;
   using key_compare = Compare;
   using value_compare = Compare;
+  using allocator_type = Allocator;
 
  private:
   using rb_tree_type =
@@ -161,14 +209,40 @@ class multiset {
 
  public:
   multiset() {}
+
+  explicit multiset(const Compare& comp,
+                    const allocator_type& a = allocator_type())
+      : tree_(comp, a) {}
+
+  explicit multiset(const allocator_type& a) : tree_(Compare(), a) {}
+
   multiset(const multiset& x) : tree_(x.tree_) {}
-  multiset& operator=(const multiset& s) { tree_ = s.tree_; }
+
+  multiset(const multiset& x, const allocator_type& a) : tree_(x.tree_, a) {}
+
+  multiset(multiset&& x) : tree_(toystl::move(x.tree_)) {}
+
+  multiset& operator=(const multiset& s) {
+    tree_ = s.tree_;
+    return *this;
+  }
+
+  multiset& operator=(multiset&& s) {
+    tree_ = toystl::move(s.tree_);
+    return *this;
+  }
 
   template <class InputIterator>
-  multiset(InputIterator first, InputIterator last) {
+  multiset(InputIterator first, InputIterator last,
+           const Compare& comp = Compare(),
+           const allocator_type& a = allocator_type())
+      : tree_(comp, a) {
     tree_.insert_equal(first, last);
   }
 
+  allocator_type get_allocator() const { return tree_.get_allocator(); }
+  key_compare key_comp() const { return tree_.key_comp(); }
+
   iterator begin() noexcept { return tree_.begin(); }
   const_iterator begin() const noexcept { return tree_.begin(); }
   iterator end() noexcept { return tree_.end(); }
@@ -194,9 +268,19 @@ class multiset {
 
   iterator insert(const value_type& x) { return tree_.insert_equal(x); }
 
-  iterator insert(iterator position, const value_type& x) {
-    using tree_iterator = typename rb_tree_type::iterator;
-    return tree_.insert_equal((tree_iterator&)position, x);
+  // 以 hint 作为位置提示，新值恰好插入在 hint 之前时只需常数次比较
+  iterator insert(const_iterator hint, const value_type& x) {
+    return tree_.insert_equal(hint, x);
+  }
+
+  template <class... Args>
+  iterator emplace(Args&&... args) {
+    return tree_.emplace_equal(toystl::forward<Args>(args)...);
+  }
+
+  template <class... Args>
+  iterator emplace_hint(const_iterator hint, Args&&... args) {
+    return tree_.emplace_hint_equal(hint, toystl::forward<Args>(args)...);
   }
 
   template <class InputIterator>
@@ -226,6 +310,14 @@ class multiset {
     return tree_.equal_range(x);
   }
 
+#ifdef TOYSTL_RB_TREE_ORDER_STATISTICS
+  // 顺序统计，均为 O(log n)：第 n 小的元素、键值小于 x 的元素个数、
+  // 迭代器的序号
+  iterator select(size_type n) const { return tree_.select(n); }
+  size_type rank(const key_type& x) const { return tree_.rank(x); }
+  size_type index_of(const_iterator it) const { return tree_.index_of(it); }
+#endif
+
   template <class K1, class C1, class A1>
   friend bool operator==(const multiset&, const multiset&);
   template <class K1, class C1, class A1>
@@ -0,0 +1,524 @@
+#ifndef TOYSTL_SRC_SMALL_VECTOR_H_
+#define TOYSTL_SRC_SMALL_VECTOR_H_
+
+#include <initializer_list>
+#include <stdexcept>
+#include <type_traits>  // std::aligned_storage
+
+#include "algobase.h"
+#include "allocator.h"
+#include "iterator.h"
+#include "memory_function.h"
+#include "type_traits.h"
+#include "utility.h"
+#include "vector.h"
+
+namespace toystl {
+// 带内联存储的 vector
+// 前 N 个元素直接保存在对象内部的缓冲区中，不需要分配内存；
+// 元素个数超过 N 时才按 Growth 策略向分配器申请堆空间，之后的行为与 vector
+// 相同。适合绝大多数情况下元素都很少的场景。
+// 与 vector 不同，内联存储时移动构造和 swap 需要逐个移动元素，迭代器会失效。
+// 插入和扩容的算法继承自 vector_base，只有释放空间和 shrink_to_fit
+// 需要区分内联缓冲区。
+template <class T, std::size_t N, class Alloc = toystl::allocator<T>,
+          class Growth = vector_growth_2x>
+class small_vector
+    : private vector_base<T, Alloc, Growth,
+                          small_vector<T, N, Alloc, Growth>> {
+  static_assert(N > 0, "small_vector requires N > 0");
+
+ public:
+  using allocator_type = Alloc;
+  using data_allocator = Alloc;
+
+  using value_type = T;
+  using pointer = T*;
+  using const_pointer = const T*;
+  using iterator = value_type*;
+  using const_iterator = const value_type*;
+  using reference = T&;
+  using const_reference = const T&;
+  using size_type = size_t;
+  using difference_type = ptrdiff_t;
+
+  using reverse_iterator = toystl::reverse_iterator<iterator>;
+  using const_reverse_iterator = toystl::reverse_iterator<const_iterator>;
+
+  static const size_type inline_capacity = N;
+
+ private:
+  using base = vector_base<T, Alloc, Growth, small_vector>;
+  friend class vector_base<T, Alloc, Growth, small_vector>;
+
+  using base::start_;
+  using base::finish_;
+  using base::end_of_storage_;
+  using base::emplace_aux;
+  using base::fill_insert;
+  using base::range_insert;
+  using base::reallocate_emplace;
+  using base::reallocate_storage;
+
+  // 内联缓冲区，只提供存储，元素由 start_ / finish_ 管理
+  typename std::aligned_storage<sizeof(T) * N, alignof(T)>::type buffer_;
+
+  // 移动赋值不抛异常的条件：内联元素的移动构造不抛异常，并且可以直接接管
+  // 对方的堆空间（见 allocator_nothrow_move_assign）
+  using nothrow_move_assignable =
+      m_bool_constant<std::is_nothrow_move_constructible<T>::value &&
+                      allocator_nothrow_move_assign<Alloc>::value>;
+
+ public:
+  small_vector() noexcept { reset_to_inline(); }
+
+  explicit small_vector(const allocator_type& a) noexcept : base(a) {
+    reset_to_inline();
+  }
+
+  small_vector(size_type n, const T& value,
+               const allocator_type& a = allocator_type())
+      : base(a) {
+    reset_to_inline();
+    insert(end(), n, value);
+  }
+
+  explicit small_vector(size_type n,
+                        const allocator_type& a = allocator_type())
+      : base(a) {
+    reset_to_inline();
+    resize(n);
+  }
+
+  template <class InputIterator,
+            typename std::enable_if<
+                toystl::is_input_iterator<InputIterator>::value, int>::type = 0>
+  small_vector(InputIterator first, InputIterator last,
+               const allocator_type& a = allocator_type())
+      : base(a) {
+    reset_to_inline();
+    insert(end(), first, last);
+  }
+
+  small_vector(std::initializer_list<T> ilist,
+               const allocator_type& a = allocator_type())
+      : small_vector(ilist.begin(), ilist.end(), a) {}
+
+  small_vector(const small_vector& other)
+      : small_vector(
+            other.begin(), other.end(),
+            other.get_alloc().select_on_container_copy_construction()) {}
+
+  small_vector(const small_vector& other, const allocator_type& a)
+      : small_vector(other.begin(), other.end(), a) {}
+
+  // 对方使用堆空间时直接接管，否则逐个移动内联的元素，
+  // 因此只有元素的移动构造不抛异常时才是 noexcept
+  small_vector(small_vector&& other) noexcept(
+      std::is_nothrow_move_constructible<T>::value)
+      : base(other.get_alloc()) {
+    reset_to_inline();
+    steal_or_move(other);
+  }
+
+  ~small_vector() {
+    data_allocator::destroy(start_, finish_);
+    deallocate_storage();
+  }
+
+  small_vector& operator=(const small_vector& rhs) {
+    if (this != &rhs) {
+      copy_assign_alloc(
+          rhs,
+          typename allocator_type::propagate_on_container_copy_assignment());
+      assign(rhs.begin(), rhs.end());
+    }
+    return *this;
+  }
+
+  small_vector& operator=(small_vector&& rhs) noexcept(
+      nothrow_move_assignable::value) {
+    if (this != &rhs) {
+      move_assign(
+          rhs,
+          typename allocator_type::propagate_on_container_move_assignment());
+    }
+    return *this;
+  }
+
+  small_vector& operator=(std::initializer_list<T> ilist) {
+    assign(ilist.begin(), ilist.end());
+    return *this;
+  }
+
+  // assign 尽量复用已有的空间，分配器不变
+  void assign(size_type n, const_reference value) {
+    const value_type value_copy = value;
+    clear();
+    insert(end(), n, value_copy);
+  }
+
+  template <class InputIterator,
+            typename std::enable_if<
+                toystl::is_input_iterator<InputIterator>::value, int>::type = 0>
+  void assign(InputIterator first, InputIterator last) {
+    clear();
+    insert(end(), first, last);
+  }
+
+  void assign(std::initializer_list<T> ilist) {
+    assign(ilist.begin(), ilist.end());
+  }
+
+  allocator_type get_allocator() const { return this->get_alloc(); }
+
+  /* 访问元素相关操作 */
+
+  reference at(size_type position) {
+    range_check(position);
+    return (*this)[position];
+  }
+
+  const_reference at(size_type position) const {
+    range_check(position);
+    return (*this)[position];
+  }
+
+  reference operator[](size_type position) { return *(begin() + position); }
+
+  const_reference operator[](size_type position) const {
+    return *(begin() + position);
+  }
+
+  reference front() { return *begin(); }
+
+  const_reference front() const { return *begin(); }
+
+  reference back() { return *(end() - 1); }
+
+  const_reference back() const { return *(end() - 1); }
+
+  pointer data() { return start_; }
+
+  const_pointer data() const { return start_; }
+
+  /* 迭代器相关操作 */
+
+  iterator begin() { return start_; }
+
+  const_iterator begin() const { return start_; }
+
+  const_iterator cbegin() const { return start_; }
+
+  iterator end() { return finish_; }
+
+  const_iterator end() const { return finish_; }
+
+  const_iterator cend() const { return finish_; }
+
+  reverse_iterator rbegin() { return reverse_iterator(end()); }
+
+  const_reverse_iterator rbegin() const {
+    return const_reverse_iterator(end());
+  }
+
+  reverse_iterator rend() { return reverse_iterator(begin()); }
+
+  const_reverse_iterator rend() const {
+    return const_reverse_iterator(begin());
+  }
+
+  /* 容量相关操作 */
+
+  bool empty() const { return start_ == finish_; }
+
+  size_type size() const { return static_cast<size_type>(finish_ - start_); }
+
+  size_type max_size() const {
+    return static_cast<size_type>(size_type(-1) / sizeof(T));
+  }
+
+  size_type capacity() const {
+    return static_cast<size_type>(end_of_storage_ - start_);
+  }
+
+  // 元素是否保存在内联缓冲区中
+  bool is_inline() const { return start_ == inline_begin(); }
+
+  void reserve(size_type newCapacity) {
+    if (newCapacity > capacity()) {
+      reallocate_storage(newCapacity);
+    }
+  }
+
+  void resize(size_type newSize) {
+    if (newSize < size()) {
+      erase(begin() + newSize, end());
+    } else {
+      reserve(newSize);
+      for (; finish_ != start_ + newSize; ++finish_) {
+        data_allocator::construct(finish_);
+      }
+    }
+  }
+
+  void resize(size_type newSize, const_reference x) {
+    if (newSize < size()) {
+      erase(begin() + newSize, end());
+    } else {
+      insert(end(), newSize - size(), x);
+    }
+  }
+
+  // 元素个数不超过 N 时搬回内联缓冲区
+  void shrink_to_fit();
+
+  /* 修改容器相关操作 */
+
+  void clear() {
+    data_allocator::destroy(start_, finish_);
+    finish_ = start_;
+  }
+
+  void push_back(const value_type& value) { emplace_back(value); }
+
+  void push_back(value_type&& value) { emplace_back(toystl::move(value)); }
+
+  template <class... Args>
+  void emplace_back(Args&&... args) {
+    if (finish_ != end_of_storage_) {
+      data_allocator::construct(finish_, toystl::forward<Args>(args)...);
+      ++finish_;
+    } else {
+      reallocate_emplace(finish_, toystl::forward<Args>(args)...);
+    }
+  }
+
+  void pop_back() {
+    --finish_;
+    data_allocator::destroy(finish_);
+  }
+
+  template <class... Args>
+  iterator emplace(const_iterator position, Args&&... args) {
+    return emplace_aux(const_cast<iterator>(position),
+                       toystl::forward<Args>(args)...);
+  }
+
+  iterator insert(const_iterator position, const value_type& value) {
+    return emplace(position, value);
+  }
+
+  iterator insert(const_iterator position, value_type&& value) {
+    return emplace(position, toystl::move(value));
+  }
+
+  iterator insert(const_iterator position, size_type n,
+                  const value_type& value) {
+    return fill_insert(const_cast<iterator>(position), n, value);
+  }
+
+  template <class InputIterator,
+            typename std::enable_if<
+                toystl::is_input_iterator<InputIterator>::value, int>::type = 0>
+  iterator insert(const_iterator position, InputIterator first,
+                  InputIterator last) {
+    const size_type offset = static_cast<size_type>(position - start_);
+    range_insert(start_ + offset, first, last, iterator_category(first));
+    return start_ + offset;
+  }
+
+  iterator insert(const_iterator position, std::initializer_list<T> ilist) {
+    return insert(position, ilist.begin(), ilist.end());
+  }
+
+  iterator erase(const_iterator position) {
+    iterator pos = const_cast<iterator>(position);
+    if (pos + 1 != finish_) {
+      toystl::move(pos + 1, finish_, pos);
+    }
+    pop_back();
+    return pos;
+  }
+
+  iterator erase(const_iterator first, const_iterator last) {
+    iterator xfirst = const_cast<iterator>(first);
+    iterator xlast = const_cast<iterator>(last);
+    if (xfirst != xlast) {
+      iterator new_finish = toystl::move(xlast, finish_, xfirst);
+      data_allocator::destroy(new_finish, finish_);
+      finish_ = new_finish;
+    }
+    return xfirst;
+  }
+
+  void swap(small_vector& other);
+
+ private:
+  iterator inline_begin() { return reinterpret_cast<iterator>(&buffer_); }
+
+  const_iterator inline_begin() const {
+    return reinterpret_cast<const_iterator>(&buffer_);
+  }
+
+  void reset_to_inline() {
+    start_ = inline_begin();
+    finish_ = start_;
+    end_of_storage_ = start_ + N;
+  }
+
+  // 释放堆空间，不析构元素；vector_base 扩容时也通过它释放旧空间
+  void deallocate_storage() {
+    if (!is_inline()) {
+      this->get_alloc().deallocate(start_, capacity());
+    }
+  }
+
+  void range_check(size_type position) const {
+    if (position >= size()) {
+      throw std::out_of_range("small_vector");
+    }
+  }
+
+  // 对方的元素在堆上时接管其空间，否则逐个移动过来；要求本容器为空且内联
+  void steal_or_move(small_vector& other);
+
+  void copy_assign_alloc(const small_vector& rhs, true_type) {
+    if (this->get_alloc() != rhs.get_alloc()) {
+      // 旧的堆空间必须由原来的分配器释放
+      clear();
+      deallocate_storage();
+      reset_to_inline();
+    }
+    this->set_alloc(rhs.get_alloc());
+  }
+
+  void copy_assign_alloc(const small_vector&, false_type) {}
+
+  void move_assign(small_vector& rhs, true_type) {
+    data_allocator::destroy(start_, finish_);
+    deallocate_storage();
+    reset_to_inline();
+    this->set_alloc(rhs.get_alloc());
+    steal_or_move(rhs);
+  }
+
+  void move_assign(small_vector& rhs, false_type) {
+    if (this->get_alloc() == rhs.get_alloc()) {
+      move_assign(rhs, true_type());
+    } else {
+      // 分配器不同，不能接管对方的空间
+      assign(toystl::make_move_iterator(rhs.begin()),
+             toystl::make_move_iterator(rhs.end()));
+      rhs.clear();
+    }
+  }
+};
+
+template <class T, std::size_t N, class Alloc, class Growth>
+const typename small_vector<T, N, Alloc, Growth>::size_type
+    small_vector<T, N, Alloc, Growth>::inline_capacity;
+
+template <class T, std::size_t N, class Alloc, class Growth>
+void small_vector<T, N, Alloc, Growth>::shrink_to_fit() {
+  if (is_inline() || finish_ == end_of_storage_) {
+    return;
+  }
+  if (size() > N) {
+    reallocate_storage(size());
+    return;
+  }
+  // 元素个数不超过 N，搬回内联缓冲区
+  iterator old_start = start_;
+  iterator old_finish = finish_;
+  const size_type old_capacity = capacity();
+  reset_to_inline();
+  try {
+    finish_ = toystl::uninitialized_move(old_start, old_finish, start_);
+  } catch (...) {
+    start_ = old_start;
+    finish_ = old_finish;
+    end_of_storage_ = old_start + old_capacity;
+    throw;
+  }
+  data_allocator::destroy(old_start, old_finish);
+  this->get_alloc().deallocate(old_start, old_capacity);
+}
+
+template <class T, std::size_t N, class Alloc, class Growth>
+void small_vector<T, N, Alloc, Growth>::swap(small_vector& other) {
+  if (this == &other) {
+    return;
+  }
+  if (!is_inline() && !other.is_inline()) {
+    toystl::swap(start_, other.start_);
+    toystl::swap(finish_, other.finish_);
+    toystl::swap(end_of_storage_, other.end_of_storage_);
+    this->swap_alloc(other);
+    return;
+  }
+  // 至少一方使用内联缓冲区，只能借助临时对象移动元素
+  small_vector tmp(toystl::move(other));
+  other = toystl::move(*this);
+  *this = toystl::move(tmp);
+}
+
+template <class T, std::size_t N, class Alloc, class Growth>
+void small_vector<T, N, Alloc, Growth>::steal_or_move(small_vector& other) {
+  if (!other.is_inline()) {
+    start_ = other.start_;
+    finish_ = other.finish_;
+    end_of_storage_ = other.end_of_storage_;
+  } else {
+    finish_ = toystl::uninitialized_move(other.start_, other.finish_, start_);
+    data_allocator::destroy(other.start_, other.finish_);
+  }
+  other.reset_to_inline();
+}
+
+template <class T, std::size_t N, class Alloc, class Growth>
+bool operator==(const small_vector<T, N, Alloc, Growth>& left,
+                const small_vector<T, N, Alloc, Growth>& right) {
+  return left.size() == right.size() &&
+         toystl::equal(left.cbegin(), left.cend(), right.cbegin());
+}
+
+template <class T, std::size_t N, class Alloc, class Growth>
+bool operator!=(const small_vector<T, N, Alloc, Growth>& left,
+                const small_vector<T, N, Alloc, Growth>& right) {
+  return !(left == right);
+}
+
+template <class T, std::size_t N, class Alloc, class Growth>
+bool operator<(const small_vector<T, N, Alloc, Growth>& left,
+               const small_vector<T, N, Alloc, Growth>& right) {
+  return toystl::lexicographical_compare(left.cbegin(), left.cend(),
+                                         right.cbegin(), right.cend());
+}
+
+template <class T, std::size_t N, class Alloc, class Growth>
+bool operator>(const small_vector<T, N, Alloc, Growth>& left,
+               const small_vector<T, N, Alloc, Growth>& right) {
+  return right < left;
+}
+
+template <class T, std::size_t N, class Alloc, class Growth>
+bool operator<=(const small_vector<T, N, Alloc, Growth>& left,
+                const small_vector<T, N, Alloc, Growth>& right) {
+  return !(right < left);
+}
+
+template <class T, std::size_t N, class Alloc, class Growth>
+bool operator>=(const small_vector<T, N, Alloc, Growth>& left,
+                const small_vector<T, N, Alloc, Growth>& right) {
+  return !(left < right);
+}
+
+template <class T, std::size_t N, class Alloc, class Growth>
+void swap(small_vector<T, N, Alloc, Growth>& left,
+          small_vector<T, N, Alloc, Growth>& right) {
+  left.swap(right);
+}
+}  // namespace toystl
+
+#endif  // TOYSTL_SRC_SMALL_VECTOR_H_
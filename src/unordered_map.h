@@ -14,22 +14,33 @@ namespace toystl {
 
 template <class Key, class Value, class HashFcn = toystl::hash<Key>,
           class EqualKey = toystl::equal_to<Key>,
-          class Allocator = toystl::allocator<Value>>
+          class Allocator = toystl::allocator<Value>,
+          class BucketPolicy = hashtable_prime_policy>
 class unordered_map;
 
+// unordered_multimap 的前置声明，两者之间可以互相 merge
+template <class Key, class Value, class HashFcn = toystl::hash<Key>,
+          class EqualKey = toystl::equal_to<Key>,
+          class Allocator = toystl::allocator<Value>,
+          class BucketPolicy = hashtable_prime_policy>
+class unordered_multimap;
+
 template <class Key, class Value, class HashFcn, class EqualKey,
-          class Allocator>
+          class Allocator, class BucketPolicy>
 inline bool operator==(
-    const unordered_map<Key, Value, HashFcn, EqualKey, Allocator>& us1,
-    const unordered_map<Key, Value, HashFcn, EqualKey, Allocator>& us2);
+    const unordered_map<Key, Value, HashFcn, EqualKey, Allocator,
+                        BucketPolicy>& us1,
+    const unordered_map<Key, Value, HashFcn, EqualKey, Allocator,
+                        BucketPolicy>& us2);
 
 template <class Key, class Value, class HashFcn, class EqualKey,
-          class Allocator>
+          class Allocator, class BucketPolicy>
 class unordered_map {
  private:
   using hashtable_type =
       hashtable<Key, toystl::pair<const Key, Value>, HashFcn,
-                selectfirst<pair<const Key, Value>>, EqualKey, Allocator>;
+                selectfirst<pair<const Key, Value>>, EqualKey, Allocator,
+                BucketPolicy>;
   hashtable_type ht_;  // 底层以 hashtable 完成
 
  public:
@@ -52,6 +63,9 @@ class unordered_map {
 
   using allocator_type = typename hashtable_type::allocator_type;
 
+  using node_type = typename hashtable_type::node_handle;
+  using insert_return_type = typename hashtable_type::insert_return_type;
+
   hasher hash_fcn() const { return ht_.hash_fcn(); }
   key_equal key_eq() const { return ht_.key_eq(); }
   allocator_type get_allocator() const { return ht_.get_allocator(); }
@@ -60,11 +74,20 @@ class unordered_map {
   // 构造、赋值、移动、析构函数
   unordered_map() : ht_(100, hasher(), key_equal()) {}
 
-  explicit unordered_map(size_type bucket_size)
-      : ht_(bucket_size, hasher(), key_equal()) {}
+  explicit unordered_map(size_type bucket_size,
+                const allocator_type& a = allocator_type())
+      : ht_(bucket_size, hasher(), key_equal(), a) {}
+
+  unordered_map(size_type bucket_size, const hasher& hf,
+                const allocator_type& a = allocator_type())
+      : ht_(bucket_size, hf, key_equal(), a) {}
 
-  unordered_map(size_type bucket_size, const hasher& hf)
-      : ht_(bucket_size, hf, key_equal()) {}
+  unordered_map(size_type bucket_size, const hasher& hf, const key_equal& equal,
+                const allocator_type& a)
+      : ht_(bucket_size, hf, equal, a) {}
+
+  explicit unordered_map(const allocator_type& a)
+      : ht_(100, hasher(), key_equal(), a) {}
 
   template <class InputIterator>
   unordered_map(InputIterator first, InputIterator last,
@@ -88,8 +111,10 @@ class unordered_map {
 
   unordered_map(const unordered_map& rhs) : ht_(rhs.ht_) {}
 
-  unordered_map(const unordered_map&& rhs) noexcept
-      : ht_(toystl::move(rhs.ht_)) {}
+  unordered_map(const unordered_map& rhs, const allocator_type& a)
+      : ht_(rhs.ht_, a) {}
+
+  unordered_map(unordered_map&& rhs) noexcept : ht_(toystl::move(rhs.ht_)) {}
 
   unordered_map& operator=(const unordered_map& rhs) {
     // 其实这里的自赋值处理可以不用，hashtable 保证
@@ -100,9 +125,10 @@ class unordered_map {
     return *this;
   }
 
-  unordered_map& operator=(unordered_map&& rhs) noexcept {
+  unordered_map& operator=(unordered_map&& rhs) noexcept(
+      std::is_nothrow_move_assignable<hashtable_type>::value) {
     // 其实这里的自赋值处理可以不用，hashtable 保证
-    if (this != rhs) {
+    if (this != &rhs) {
       ht_ = toystl::move(rhs.ht_);
     }
 
@@ -154,12 +180,57 @@ class unordered_map {
     return ht_.insert_unique_noresize(obj);
   }
 
+  // emplace：直接在节点中构造 value_type
+  template <class... Args>
+  pair<iterator, bool> emplace(Args&&... args) {
+    return ht_.emplace_unique(toystl::forward<Args>(args)...);
+  }
+
+  // try_emplace：键值不存在时才构造节点，实值由 args 构造；
+  // 键值已存在时什么也不做，args 不会被移动
+  template <class... Args>
+  pair<iterator, bool> try_emplace(const key_type& key, Args&&... args) {
+    return ht_.try_emplace_unique(key, toystl::forward<Args>(args)...);
+  }
+
+  template <class... Args>
+  pair<iterator, bool> try_emplace(key_type&& key, Args&&... args) {
+    return ht_.try_emplace_unique(toystl::move(key),
+                                  toystl::forward<Args>(args)...);
+  }
+
+  // insert_or_assign：键值不存在时插入，否则把 obj 赋给已有的实值
+  template <class M>
+  pair<iterator, bool> insert_or_assign(const key_type& key, M&& obj) {
+    pair<iterator, bool> p =
+        ht_.try_emplace_unique(key, toystl::forward<M>(obj));
+    if (!p.second) {
+      p.first->second = toystl::forward<M>(obj);
+    }
+    return p;
+  }
+
+  template <class M>
+  pair<iterator, bool> insert_or_assign(key_type&& key, M&& obj) {
+    pair<iterator, bool> p =
+        ht_.try_emplace_unique(toystl::move(key), toystl::forward<M>(obj));
+    if (!p.second) {
+      p.first->second = toystl::forward<M>(obj);
+    }
+    return p;
+  }
+
   iterator find(const key_type& key) { return ht_.find(key); }
 
   const_iterator find(const key_type& key) const { return ht_.find(key); }
 
+  // 键值已存在时不构造任何临时对象
   Value& operator[](const key_type& key) {
-    return ht_.find_or_insert(value_type(key, Value())).second;
+    return ht_.try_emplace_unique(key).first->second;
+  }
+
+  Value& operator[](key_type&& key) {
+    return ht_.try_emplace_unique(toystl::move(key)).first->second;
   }
 
   size_type count(const key_type& key) const { return ht_.count(key); }
@@ -172,12 +243,61 @@ class unordered_map {
     return ht_.equal_range(key);
   }
 
+  // 异构查找，要求 hasher 和 key_equal 都声明了 is_transparent
+  template <class K>
+  iterator find(const K& key) {
+    return ht_.find(key);
+  }
+
+  template <class K>
+  const_iterator find(const K& key) const {
+    return ht_.find(key);
+  }
+
+  template <class K>
+  size_type count(const K& key) const {
+    return ht_.count(key);
+  }
+
+  template <class K>
+  pair<iterator, iterator> equal_range(const K& key) {
+    return ht_.equal_range(key);
+  }
+
+  template <class K>
+  pair<const_iterator, const_iterator> equal_range(const K& key) const {
+    return ht_.equal_range(key);
+  }
+
   size_type erase(const key_type& key) { return ht_.erase(key); }
 
   void erase(iterator it) { return ht_.erase(it); }
 
   void erase(iterator f, iterator l) { return ht_.erase(f, l); }
 
+  // 节点操作：在容器之间转移节点，不重新分配节点，也不复制元素
+  node_type extract(const_iterator pos) { return ht_.extract(pos); }
+
+  node_type extract(const key_type& key) { return ht_.extract(key); }
+
+  insert_return_type insert(node_type&& nh) {
+    return ht_.insert_unique(toystl::move(nh));
+  }
+
+  void merge(unordered_map& src) { ht_.merge_unique(src.ht_); }
+
+  void merge(unordered_map&& src) { ht_.merge_unique(src.ht_); }
+
+  void merge(unordered_multimap<Key, Value, HashFcn, EqualKey, Allocator,
+                                BucketPolicy>& src) {
+    ht_.merge_unique(src.ht_);
+  }
+
+  void merge(unordered_multimap<Key, Value, HashFcn, EqualKey, Allocator,
+                                BucketPolicy>&& src) {
+    ht_.merge_unique(src.ht_);
+  }
+
   void clear() { ht_.clear(); }
 
  public:
@@ -190,28 +310,41 @@ class unordered_map {
   size_type elems_in_bucket(size_type n) const {
     return ht_.elems_in_bucket(n);
   }
+
+  template <class K1, class V1, class H1, class E1, class A1, class B1>
+  friend class unordered_multimap;
+
+  template <class K1, class V1, class H1, class E1, class A1, class B1>
+  friend bool operator==(const unordered_map<K1, V1, H1, E1, A1, B1>&,
+                         const unordered_map<K1, V1, H1, E1, A1, B1>&);
 };
 
 template <class Key, class Value, class HashFcn, class EqualKey,
-          class Allocator>
+          class Allocator, class BucketPolicy>
 inline bool operator==(
-    const unordered_map<Key, Value, HashFcn, EqualKey, Allocator>& us1,
-    const unordered_map<Key, Value, HashFcn, EqualKey, Allocator>& us2) {
+    const unordered_map<Key, Value, HashFcn, EqualKey, Allocator,
+                        BucketPolicy>& us1,
+    const unordered_map<Key, Value, HashFcn, EqualKey, Allocator,
+                        BucketPolicy>& us2) {
   return us1.ht_ == us2.ht_;
 }
 
 template <class Key, class Value, class HashFcn, class EqualKey,
-          class Allocator>
+          class Allocator, class BucketPolicy>
 inline bool operator!=(
-    const unordered_map<Key, Value, HashFcn, EqualKey, Allocator>& us1,
-    const unordered_map<Key, Value, HashFcn, EqualKey, Allocator>& us2) {
+    const unordered_map<Key, Value, HashFcn, EqualKey, Allocator,
+                        BucketPolicy>& us1,
+    const unordered_map<Key, Value, HashFcn, EqualKey, Allocator,
+                        BucketPolicy>& us2) {
   return !(us1 == us2);
 }
 
 template <class Key, class Value, class HashFcn, class EqualKey,
-          class Allocator>
-void swap(unordered_map<Key, Value, HashFcn, EqualKey, Allocator>& us1,
-          unordered_map<Key, Value, HashFcn, EqualKey, Allocator>& us2) {
+          class Allocator, class BucketPolicy>
+void swap(unordered_map<Key, Value, HashFcn, EqualKey, Allocator,
+                        BucketPolicy>& us1,
+          unordered_map<Key, Value, HashFcn, EqualKey, Allocator,
+                        BucketPolicy>& us2) {
   us1.swap(us2);
 }
 /******************************************************************************/
@@ -220,24 +353,22 @@ void swap(unordered_map<Key, Value, HashFcn, EqualKey, Allocator>& us1,
 // mystl::hash
 // 参数四代表键值比较方式，缺省使用 mystl::equal_to
 /******************************************************************************/
-template <class Key, class Value, class HashFcn = toystl::hash<Key>,
-          class EqualKey = toystl::equal_to<Key>,
-          class Allocator = toystl::allocator<Value>>
-class unordered_multimap;
-
 template <class Key, class Value, class HashFcn, class EqualKey,
-          class Allocator>
+          class Allocator, class BucketPolicy>
 inline bool operator==(
-    const unordered_multimap<Key, Value, HashFcn, EqualKey, Allocator>& us1,
-    const unordered_multimap<Key, Value, HashFcn, EqualKey, Allocator>& us2);
+    const unordered_multimap<Key, Value, HashFcn, EqualKey, Allocator,
+                             BucketPolicy>& us1,
+    const unordered_multimap<Key, Value, HashFcn, EqualKey, Allocator,
+                             BucketPolicy>& us2);
 
 template <class Key, class Value, class HashFcn, class EqualKey,
-          class Allocator>
+          class Allocator, class BucketPolicy>
 class unordered_multimap {
  private:
   using hashtable_type =
       hashtable<Key, pair<const Key, Value>, HashFcn,
-                selectfirst<pair<const Key, Value>>, EqualKey, Allocator>;
+                selectfirst<pair<const Key, Value>>, EqualKey, Allocator,
+                BucketPolicy>;
   hashtable_type ht_;  // 底层以 hashtable 完成
 
  public:
@@ -260,6 +391,8 @@ class unordered_multimap {
 
   using allocator_type = typename hashtable_type::allocator_type;
 
+  using node_type = typename hashtable_type::node_handle;
+
   hasher hash_fcn() const { return ht_.hash_fcn(); }
   key_equal key_eq() const { return ht_.key_eq(); }
   allocator_type get_allocator() const { return ht_.get_allocator(); }
@@ -268,11 +401,20 @@ class unordered_multimap {
   // 构造、赋值、移动、析构函数
   unordered_multimap() : ht_(100, hasher(), key_equal()) {}
 
-  explicit unordered_multimap(size_type bucket_size)
-      : ht_(bucket_size, hasher(), key_equal()) {}
+  explicit unordered_multimap(size_type bucket_size,
+                     const allocator_type& a = allocator_type())
+      : ht_(bucket_size, hasher(), key_equal(), a) {}
+
+  unordered_multimap(size_type bucket_size, const hasher& hf,
+                     const allocator_type& a = allocator_type())
+      : ht_(bucket_size, hf, key_equal(), a) {}
+
+  unordered_multimap(size_type bucket_size, const hasher& hf,
+                     const key_equal& equal, const allocator_type& a)
+      : ht_(bucket_size, hf, equal, a) {}
 
-  unordered_multimap(size_type bucket_size, const hasher& hf)
-      : ht_(bucket_size, hf, key_equal()) {}
+  explicit unordered_multimap(const allocator_type& a)
+      : ht_(100, hasher(), key_equal(), a) {}
 
   template <class InputIterator>
   unordered_multimap(InputIterator first, InputIterator last,
@@ -297,21 +439,25 @@ class unordered_multimap {
 
   unordered_multimap(const unordered_multimap& rhs) : ht_(rhs.ht_) {}
 
-  unordered_multimap(const unordered_multimap&& rhs) noexcept
+  unordered_multimap(const unordered_multimap& rhs, const allocator_type& a)
+      : ht_(rhs.ht_, a) {}
+
+  unordered_multimap(unordered_multimap&& rhs) noexcept
       : ht_(toystl::move(rhs.ht_)) {}
 
   unordered_multimap& operator=(const unordered_multimap& rhs) {
     // 其实这里的自赋值处理可以不用，hashtable 保证
-    if (this != rhs) {
+    if (this != &rhs) {
       ht_ = rhs.ht_;
     }
 
     return *this;
   }
 
-  unordered_multimap& operator=(unordered_multimap&& rhs) noexcept {
+  unordered_multimap& operator=(unordered_multimap&& rhs) noexcept(
+      std::is_nothrow_move_assignable<hashtable_type>::value) {
     // 其实这里的自赋值处理可以不用，hashtable 保证
-    if (this != rhs) {
+    if (this != &rhs) {
       ht_ = toystl::move(rhs.ht_);
     }
 
@@ -346,9 +492,7 @@ class unordered_multimap {
   // 修改容器操作
 
   // insert
-  pair<iterator, bool> insert(const value_type& value) {
-    return ht_.insert_equal(value);
-  }
+  iterator insert(const value_type& value) { return ht_.insert_equal(value); }
 
   template <class InputIterator>
   void insert(InputIterator first, InputIterator last) {
@@ -356,10 +500,16 @@ class unordered_multimap {
   }
 
   // insert_noresize
-  pair<iterator, bool> insert_noresize(const value_type& obj) {
+  iterator insert_noresize(const value_type& obj) {
     return ht_.insert_equal_noresize(obj);
   }
 
+  // emplace：直接在节点中构造 value_type
+  template <class... Args>
+  iterator emplace(Args&&... args) {
+    return ht_.emplace_equal(toystl::forward<Args>(args)...);
+  }
+
   iterator find(const key_type& key) { return ht_.find(key); }
 
   const_iterator find(const key_type& key) const { return ht_.find(key); }
@@ -374,12 +524,61 @@ class unordered_multimap {
     return ht_.equal_range(key);
   }
 
+  // 异构查找，要求 hasher 和 key_equal 都声明了 is_transparent
+  template <class K>
+  iterator find(const K& key) {
+    return ht_.find(key);
+  }
+
+  template <class K>
+  const_iterator find(const K& key) const {
+    return ht_.find(key);
+  }
+
+  template <class K>
+  size_type count(const K& key) const {
+    return ht_.count(key);
+  }
+
+  template <class K>
+  pair<iterator, iterator> equal_range(const K& key) {
+    return ht_.equal_range(key);
+  }
+
+  template <class K>
+  pair<const_iterator, const_iterator> equal_range(const K& key) const {
+    return ht_.equal_range(key);
+  }
+
   size_type erase(const key_type& key) { return ht_.erase(key); }
 
   void erase(iterator it) { return ht_.erase(it); }
 
   void erase(iterator f, iterator l) { return ht_.erase(f, l); }
 
+  // 节点操作：在容器之间转移节点，不重新分配节点，也不复制元素
+  node_type extract(const_iterator pos) { return ht_.extract(pos); }
+
+  node_type extract(const key_type& key) { return ht_.extract(key); }
+
+  iterator insert(node_type&& nh) {
+    return ht_.insert_equal(toystl::move(nh));
+  }
+
+  void merge(unordered_multimap& src) { ht_.merge_equal(src.ht_); }
+
+  void merge(unordered_multimap&& src) { ht_.merge_equal(src.ht_); }
+
+  void merge(unordered_map<Key, Value, HashFcn, EqualKey, Allocator,
+                           BucketPolicy>& src) {
+    ht_.merge_equal(src.ht_);
+  }
+
+  void merge(unordered_map<Key, Value, HashFcn, EqualKey, Allocator,
+                           BucketPolicy>&& src) {
+    ht_.merge_equal(src.ht_);
+  }
+
   void clear() { ht_.clear(); }
 
  public:
@@ -392,28 +591,41 @@ class unordered_multimap {
   size_type elems_in_bucket(size_type n) const {
     return ht_.elems_in_bucket(n);
   }
+
+  template <class K1, class V1, class H1, class E1, class A1, class B1>
+  friend class unordered_map;
+
+  template <class K1, class V1, class H1, class E1, class A1, class B1>
+  friend bool operator==(const unordered_multimap<K1, V1, H1, E1, A1, B1>&,
+                         const unordered_multimap<K1, V1, H1, E1, A1, B1>&);
 };
 
 template <class Key, class Value, class HashFcn, class EqualKey,
-          class Allocator>
+          class Allocator, class BucketPolicy>
 inline bool operator==(
-    const unordered_multimap<Key, Value, HashFcn, EqualKey, Allocator>& us1,
-    const unordered_multimap<Key, Value, HashFcn, EqualKey, Allocator>& us2) {
+    const unordered_multimap<Key, Value, HashFcn, EqualKey, Allocator,
+                             BucketPolicy>& us1,
+    const unordered_multimap<Key, Value, HashFcn, EqualKey, Allocator,
+                             BucketPolicy>& us2) {
   return us1.ht_ == us2.ht_;
 }
 
 template <class Key, class Value, class HashFcn, class EqualKey,
-          class Allocator>
+          class Allocator, class BucketPolicy>
 inline bool operator!=(
-    const unordered_multimap<Key, Value, HashFcn, EqualKey, Allocator>& us1,
-    const unordered_multimap<Key, Value, HashFcn, EqualKey, Allocator>& us2) {
+    const unordered_multimap<Key, Value, HashFcn, EqualKey, Allocator,
+                             BucketPolicy>& us1,
+    const unordered_multimap<Key, Value, HashFcn, EqualKey, Allocator,
+                             BucketPolicy>& us2) {
   return !(us1 == us2);
 }
 
 template <class Key, class Value, class HashFcn, class EqualKey,
-          class Allocator>
-void swap(unordered_multimap<Key, Value, HashFcn, EqualKey, Allocator>& us1,
-          unordered_multimap<Key, Value, HashFcn, EqualKey, Allocator>& us2) {
+          class Allocator, class BucketPolicy>
+void swap(unordered_multimap<Key, Value, HashFcn, EqualKey, Allocator,
+                             BucketPolicy>& us1,
+          unordered_multimap<Key, Value, HashFcn, EqualKey, Allocator,
+                             BucketPolicy>& us2) {
   us1.swap(us2);
 }
 }  // namespace toystl
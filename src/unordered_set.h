@@ -16,19 +16,31 @@ namespace toystl {
 /******************************************************************************/
 template <class Value, class HashFcn = toystl::hash<Value>,
           class EqualKey = toystl::equal_to<Value>,
-          class Allocator = toystl::allocator<Value>>
+          class Allocator = toystl::allocator<Value>,
+          class BucketPolicy = hashtable_prime_policy>
 class unordered_set;
 
-template <class Value, class HashFcn, class EqualKey, class Allocator>
+// unordered_multiset 的前置声明，两者之间可以互相 merge
+template <class Value, class HashFcn = toystl::hash<Value>,
+          class EqualKey = toystl::equal_to<Value>,
+          class Allocator = toystl::allocator<Value>,
+          class BucketPolicy = hashtable_prime_policy>
+class unordered_multiset;
+
+template <class Value, class HashFcn, class EqualKey, class Allocator,
+          class BucketPolicy>
 inline bool operator==(
-    const unordered_set<Value, HashFcn, EqualKey, Allocator>& us1,
-    const unordered_set<Value, HashFcn, EqualKey, Allocator>& us2);
+    const unordered_set<Value, HashFcn, EqualKey, Allocator, BucketPolicy>& us1,
+    const unordered_set<Value, HashFcn, EqualKey, Allocator,
+                        BucketPolicy>& us2);
 
-template <class Value, class HashFcn, class EqualKey, class Allocator>
+template <class Value, class HashFcn, class EqualKey, class Allocator,
+          class BucketPolicy>
 class unordered_set {
  private:
   using hashtable_type =
-      hashtable<Value, Value, HashFcn, identity<Value>, EqualKey, Allocator>;
+      hashtable<Value, Value, HashFcn, identity<Value>, EqualKey, Allocator,
+                BucketPolicy>;
   hashtable_type ht_;  // 底层以 hashtable 完成
 
  public:
@@ -49,6 +61,9 @@ class unordered_set {
 
   using allocator_type = typename hashtable_type::allocator_type;
 
+  using node_type = typename hashtable_type::node_handle;
+  using insert_return_type = hashtable_insert_return<iterator, node_type>;
+
   hasher hash_fcn() const { return ht_.hash_fcn(); }
   key_equal key_eq() const { return ht_.key_eq(); }
   allocator_type get_allocator() const { return ht_.get_allocator(); }
@@ -57,11 +72,20 @@ class unordered_set {
   // 构造、赋值、移动、析构函数
   unordered_set() : ht_(100, hasher(), key_equal()) {}
 
-  explicit unordered_set(size_type bucket_size)
-      : ht_(bucket_size, hasher(), key_equal()) {}
+  explicit unordered_set(size_type bucket_size,
+                const allocator_type& a = allocator_type())
+      : ht_(bucket_size, hasher(), key_equal(), a) {}
 
-  unordered_set(size_type bucket_size, const hasher& hf)
-      : ht_(bucket_size, hf, key_equal()) {}
+  unordered_set(size_type bucket_size, const hasher& hf,
+                const allocator_type& a = allocator_type())
+      : ht_(bucket_size, hf, key_equal(), a) {}
+
+  unordered_set(size_type bucket_size, const hasher& hf, const key_equal& equal,
+                const allocator_type& a)
+      : ht_(bucket_size, hf, equal, a) {}
+
+  explicit unordered_set(const allocator_type& a)
+      : ht_(100, hasher(), key_equal(), a) {}
 
   template <class InputIterator>
   unordered_set(InputIterator first, InputIterator last,
@@ -85,8 +109,10 @@ class unordered_set {
 
   unordered_set(const unordered_set& rhs) : ht_(rhs.ht_) {}
 
-  unordered_set(const unordered_set&& rhs) noexcept
-      : ht_(toystl::move(rhs.ht_)) {}
+  unordered_set(const unordered_set& rhs, const allocator_type& a)
+      : ht_(rhs.ht_, a) {}
+
+  unordered_set(unordered_set&& rhs) noexcept : ht_(toystl::move(rhs.ht_)) {}
 
   unordered_set& operator=(const unordered_set& rhs) {
     // 其实这里的自赋值处理可以不用，hashtable 保证
@@ -97,7 +123,8 @@ class unordered_set {
     return *this;
   }
 
-  unordered_set& operator=(unordered_set&& rhs) noexcept {
+  unordered_set& operator=(unordered_set&& rhs) noexcept(
+      std::is_nothrow_move_assignable<hashtable_type>::value) {
     // 其实这里的自赋值处理可以不用，hashtable 保证
     if (this != &rhs) {
       ht_ = toystl::move(rhs.ht_);
@@ -135,7 +162,8 @@ class unordered_set {
 
   // insert
   pair<iterator, bool> insert(const value_type& value) {
-    return ht_.insert_unique(value);
+    pair<typename hashtable_type::iterator, bool> p = ht_.insert_unique(value);
+    return pair<iterator, bool>(p.first, p.second);
   }
 
   template <class InputIterator>
@@ -150,6 +178,14 @@ class unordered_set {
     return pair<iterator, bool>(p.first, p.second);
   }
 
+  // emplace：直接在节点中构造元素
+  template <class... Args>
+  pair<iterator, bool> emplace(Args&&... args) {
+    pair<typename hashtable_type::iterator, bool> p =
+        ht_.emplace_unique(toystl::forward<Args>(args)...);
+    return pair<iterator, bool>(p.first, p.second);
+  }
+
   iterator find(const key_type& key) const { return ht_.find(key); }
 
   size_type count(const key_type& key) const { return ht_.count(key); }
@@ -158,12 +194,53 @@ class unordered_set {
     return ht_.equal_range(key);
   }
 
+  // 异构查找，要求 hasher 和 key_equal 都声明了 is_transparent
+  template <class K>
+  iterator find(const K& key) const {
+    return ht_.find(key);
+  }
+
+  template <class K>
+  size_type count(const K& key) const {
+    return ht_.count(key);
+  }
+
+  template <class K>
+  pair<iterator, iterator> equal_range(const K& key) const {
+    return ht_.equal_range(key);
+  }
+
   size_type erase(const key_type& key) { return ht_.erase(key); }
 
   void erase(iterator it) { return ht_.erase(it); }
 
   void erase(iterator f, iterator l) { return ht_.erase(f, l); }
 
+  // 节点操作：在容器之间转移节点，不重新分配节点，也不复制元素
+  node_type extract(const_iterator pos) { return ht_.extract(pos); }
+
+  node_type extract(const key_type& key) { return ht_.extract(key); }
+
+  insert_return_type insert(node_type&& nh) {
+    typename hashtable_type::insert_return_type r =
+        ht_.insert_unique(toystl::move(nh));
+    return insert_return_type{r.position, r.inserted, toystl::move(r.node)};
+  }
+
+  void merge(unordered_set& src) { ht_.merge_unique(src.ht_); }
+
+  void merge(unordered_set&& src) { ht_.merge_unique(src.ht_); }
+
+  void merge(unordered_multiset<Value, HashFcn, EqualKey, Allocator,
+                                BucketPolicy>& src) {
+    ht_.merge_unique(src.ht_);
+  }
+
+  void merge(unordered_multiset<Value, HashFcn, EqualKey, Allocator,
+                                BucketPolicy>&& src) {
+    ht_.merge_unique(src.ht_);
+  }
+
   void clear() { ht_.clear(); }
 
  public:
@@ -176,25 +253,38 @@ class unordered_set {
   size_type elems_in_bucket(size_type n) const {
     return ht_.elems_in_bucket(n);
   }
+
+  template <class V1, class H1, class E1, class A1, class B1>
+  friend class unordered_multiset;
+
+  template <class V1, class H1, class E1, class A1, class B1>
+  friend bool operator==(const unordered_set<V1, H1, E1, A1, B1>&,
+                         const unordered_set<V1, H1, E1, A1, B1>&);
 };
 
-template <class Value, class HashFcn, class EqualKey, class Allocator>
+template <class Value, class HashFcn, class EqualKey, class Allocator,
+          class BucketPolicy>
 inline bool operator==(
-    const unordered_set<Value, HashFcn, EqualKey, Allocator>& us1,
-    const unordered_set<Value, HashFcn, EqualKey, Allocator>& us2) {
+    const unordered_set<Value, HashFcn, EqualKey, Allocator, BucketPolicy>& us1,
+    const unordered_set<Value, HashFcn, EqualKey, Allocator,
+                        BucketPolicy>& us2) {
   return us1.ht_ == us2.ht_;
 }
 
-template <class Value, class HashFcn, class EqualKey, class Allocator>
+template <class Value, class HashFcn, class EqualKey, class Allocator,
+          class BucketPolicy>
 inline bool operator!=(
-    const unordered_set<Value, HashFcn, EqualKey, Allocator>& us1,
-    const unordered_set<Value, HashFcn, EqualKey, Allocator>& us2) {
+    const unordered_set<Value, HashFcn, EqualKey, Allocator, BucketPolicy>& us1,
+    const unordered_set<Value, HashFcn, EqualKey, Allocator,
+                        BucketPolicy>& us2) {
   return !(us1 == us2);
 }
 
-template <class Value, class HashFcn, class EqualKey, class Allocator>
-void swap(unordered_set<Value, HashFcn, EqualKey, Allocator>& us1,
-          unordered_set<Value, HashFcn, EqualKey, Allocator>& us2) {
+template <class Value, class HashFcn, class EqualKey, class Allocator,
+          class BucketPolicy>
+void swap(unordered_set<Value, HashFcn, EqualKey, Allocator, BucketPolicy>& us1,
+          unordered_set<Value, HashFcn, EqualKey, Allocator,
+                        BucketPolicy>& us2) {
   us1.swap(us2);
 }
 
@@ -203,21 +293,21 @@ void swap(unordered_set<Value, HashFcn, EqualKey, Allocator>& us1,
 // 参数一代表键值类型，参数二代表哈希函数，缺省使用 mystl::hash，
 // 参数三代表键值比较方式，缺省使用 mystl::equal_to
 /******************************************************************************/
-template <class Value, class HashFcn = toystl::hash<Value>,
-          class EqualKey = toystl::equal_to<Value>,
-          class Allocator = toystl::allocator<Value>>
-class unordered_multiset;
-
-template <class Value, class HashFcn, class EqualKey, class Allocator>
+template <class Value, class HashFcn, class EqualKey, class Allocator,
+          class BucketPolicy>
 inline bool operator==(
-    const unordered_multiset<Value, HashFcn, EqualKey, Allocator>& us1,
-    const unordered_multiset<Value, HashFcn, EqualKey, Allocator>& us2);
+    const unordered_multiset<Value, HashFcn, EqualKey, Allocator,
+                             BucketPolicy>& us1,
+    const unordered_multiset<Value, HashFcn, EqualKey, Allocator,
+                             BucketPolicy>& us2);
 
-template <class Value, class HashFcn, class EqualKey, class Allocator>
+template <class Value, class HashFcn, class EqualKey, class Allocator,
+          class BucketPolicy>
 class unordered_multiset {
  private:
   using hashtable_type =
-      hashtable<Value, Value, HashFcn, identity<Value>, EqualKey, Allocator>;
+      hashtable<Value, Value, HashFcn, identity<Value>, EqualKey, Allocator,
+                BucketPolicy>;
   hashtable_type ht_;  // 底层以 hashtable 完成
 
  public:
@@ -238,6 +328,8 @@ class unordered_multiset {
 
   using allocator_type = typename hashtable_type::allocator_type;
 
+  using node_type = typename hashtable_type::node_handle;
+
   hasher hash_fcn() const { return ht_.hash_fcn(); }
   key_equal key_eq() const { return ht_.key_eq(); }
   allocator_type get_allocator() const { return ht_.get_allocator(); }
@@ -246,11 +338,20 @@ class unordered_multiset {
   // 构造、赋值、移动、析构函数
   unordered_multiset() : ht_(100, hasher(), key_equal()) {}
 
-  explicit unordered_multiset(size_type bucket_size)
-      : ht_(bucket_size, hasher(), key_equal()) {}
+  explicit unordered_multiset(size_type bucket_size,
+                     const allocator_type& a = allocator_type())
+      : ht_(bucket_size, hasher(), key_equal(), a) {}
+
+  unordered_multiset(size_type bucket_size, const hasher& hf,
+                     const allocator_type& a = allocator_type())
+      : ht_(bucket_size, hf, key_equal(), a) {}
 
-  unordered_multiset(size_type bucket_size, const hasher& hf)
-      : ht_(bucket_size, hf, key_equal()) {}
+  unordered_multiset(size_type bucket_size, const hasher& hf,
+                     const key_equal& equal, const allocator_type& a)
+      : ht_(bucket_size, hf, equal, a) {}
+
+  explicit unordered_multiset(const allocator_type& a)
+      : ht_(100, hasher(), key_equal(), a) {}
 
   template <class InputIterator>
   unordered_multiset(InputIterator first, InputIterator last,
@@ -275,7 +376,10 @@ class unordered_multiset {
 
   unordered_multiset(const unordered_multiset& rhs) : ht_(rhs.ht_) {}
 
-  unordered_multiset(const unordered_multiset&& rhs) noexcept
+  unordered_multiset(const unordered_multiset& rhs, const allocator_type& a)
+      : ht_(rhs.ht_, a) {}
+
+  unordered_multiset(unordered_multiset&& rhs) noexcept
       : ht_(toystl::move(rhs.ht_)) {}
 
   unordered_multiset& operator=(const unordered_multiset& rhs) {
@@ -287,7 +391,8 @@ class unordered_multiset {
     return *this;
   }
 
-  unordered_multiset& operator=(unordered_multiset&& rhs) noexcept {
+  unordered_multiset& operator=(unordered_multiset&& rhs) noexcept(
+      std::is_nothrow_move_assignable<hashtable_type>::value) {
     // 其实这里的自赋值处理可以不用，hashtable 保证
     if (this != &rhs) {
       ht_ = toystl::move(rhs.ht_);
@@ -324,9 +429,7 @@ class unordered_multiset {
   // 修改容器操作
 
   // insert
-  pair<iterator, bool> insert(const value_type& value) {
-    return ht_.insert_equal(value);
-  }
+  iterator insert(const value_type& value) { return ht_.insert_equal(value); }
 
   template <class InputIterator>
   void insert(InputIterator first, InputIterator last) {
@@ -334,10 +437,14 @@ class unordered_multiset {
   }
 
   // insert_noresize
-  pair<iterator, bool> insert_noresize(const value_type& obj) {
-    pair<typename hashtable_type::iterator, bool> p =
-        ht_.insert_equal_noresize(obj);
-    return pair<iterator, bool>(p.first, p.second);
+  iterator insert_noresize(const value_type& obj) {
+    return ht_.insert_equal_noresize(obj);
+  }
+
+  // emplace：直接在节点中构造元素
+  template <class... Args>
+  iterator emplace(Args&&... args) {
+    return ht_.emplace_equal(toystl::forward<Args>(args)...);
   }
 
   iterator find(const key_type& key) const { return ht_.find(key); }
@@ -348,12 +455,51 @@ class unordered_multiset {
     return ht_.equal_range(key);
   }
 
+  // 异构查找，要求 hasher 和 key_equal 都声明了 is_transparent
+  template <class K>
+  iterator find(const K& key) const {
+    return ht_.find(key);
+  }
+
+  template <class K>
+  size_type count(const K& key) const {
+    return ht_.count(key);
+  }
+
+  template <class K>
+  pair<iterator, iterator> equal_range(const K& key) const {
+    return ht_.equal_range(key);
+  }
+
   size_type erase(const key_type& key) { return ht_.erase(key); }
 
   void erase(iterator it) { return ht_.erase(it); }
 
   void erase(iterator f, iterator l) { return ht_.erase(f, l); }
 
+  // 节点操作：在容器之间转移节点，不重新分配节点，也不复制元素
+  node_type extract(const_iterator pos) { return ht_.extract(pos); }
+
+  node_type extract(const key_type& key) { return ht_.extract(key); }
+
+  iterator insert(node_type&& nh) {
+    return ht_.insert_equal(toystl::move(nh));
+  }
+
+  void merge(unordered_multiset& src) { ht_.merge_equal(src.ht_); }
+
+  void merge(unordered_multiset&& src) { ht_.merge_equal(src.ht_); }
+
+  void merge(unordered_set<Value, HashFcn, EqualKey, Allocator,
+                           BucketPolicy>& src) {
+    ht_.merge_equal(src.ht_);
+  }
+
+  void merge(unordered_set<Value, HashFcn, EqualKey, Allocator,
+                           BucketPolicy>&& src) {
+    ht_.merge_equal(src.ht_);
+  }
+
   void clear() { ht_.clear(); }
 
  public:
@@ -366,25 +512,41 @@ class unordered_multiset {
   size_type elems_in_bucket(size_type n) const {
     return ht_.elems_in_bucket(n);
   }
+
+  template <class V1, class H1, class E1, class A1, class B1>
+  friend class unordered_set;
+
+  template <class V1, class H1, class E1, class A1, class B1>
+  friend bool operator==(const unordered_multiset<V1, H1, E1, A1, B1>&,
+                         const unordered_multiset<V1, H1, E1, A1, B1>&);
 };
 
-template <class Value, class HashFcn, class EqualKey, class Allocator>
+template <class Value, class HashFcn, class EqualKey, class Allocator,
+          class BucketPolicy>
 inline bool operator==(
-    const unordered_multiset<Value, HashFcn, EqualKey, Allocator>& us1,
-    const unordered_multiset<Value, HashFcn, EqualKey, Allocator>& us2) {
+    const unordered_multiset<Value, HashFcn, EqualKey, Allocator,
+                             BucketPolicy>& us1,
+    const unordered_multiset<Value, HashFcn, EqualKey, Allocator,
+                             BucketPolicy>& us2) {
   return us1.ht_ == us2.ht_;
 }
 
-template <class Value, class HashFcn, class EqualKey, class Allocator>
+template <class Value, class HashFcn, class EqualKey, class Allocator,
+          class BucketPolicy>
 inline bool operator!=(
-    const unordered_multiset<Value, HashFcn, EqualKey, Allocator>& us1,
-    const unordered_multiset<Value, HashFcn, EqualKey, Allocator>& us2) {
+    const unordered_multiset<Value, HashFcn, EqualKey, Allocator,
+                             BucketPolicy>& us1,
+    const unordered_multiset<Value, HashFcn, EqualKey, Allocator,
+                             BucketPolicy>& us2) {
   return !(us1 == us2);
 }
 
-template <class Value, class HashFcn, class EqualKey, class Allocator>
-void swap(unordered_multiset<Value, HashFcn, EqualKey, Allocator>& us1,
-          unordered_multiset<Value, HashFcn, EqualKey, Allocator>& us2) {
+template <class Value, class HashFcn, class EqualKey, class Allocator,
+          class BucketPolicy>
+void swap(unordered_multiset<Value, HashFcn, EqualKey, Allocator,
+                             BucketPolicy>& us1,
+          unordered_multiset<Value, HashFcn, EqualKey, Allocator,
+                             BucketPolicy>& us2) {
   us1.swap(us2);
 }
 }  // namespace toystl
@@ -1,6 +1,9 @@
 #ifndef TOYSTL_SRC_UTILITY_H_
 #define TOYSTL_SRC_UTILITY_H_
 
+#include <cstddef>
+#include <tuple>  // std::tuple, std::get
+
 #include "type_traits.h"
 
 namespace toystl {
@@ -54,6 +57,26 @@ void swap(Tp (&a)[N], Tp (&b)[N]) {
   toystl::swap_range(a, a + N, b);
 }
 
+// index_sequence：编译期的下标序列 0, 1, ..., N - 1，用于展开 tuple
+template <size_t... I>
+struct index_sequence {};
+
+template <size_t N, size_t... I>
+struct make_index_sequence_aux : make_index_sequence_aux<N - 1, N - 1, I...> {};
+
+template <size_t... I>
+struct make_index_sequence_aux<0, I...> {
+  using type = index_sequence<I...>;
+};
+
+template <size_t N>
+using make_index_sequence = typename make_index_sequence_aux<N>::type;
+
+// piecewise_construct：pair 的 first 和 second 分别由两个 tuple 中的参数
+// 就地构造，不需要先构造临时对象
+struct piecewise_construct_t {};
+constexpr piecewise_construct_t piecewise_construct = piecewise_construct_t();
+
 // pair
 template <class T1, class T2>
 struct pair {
@@ -82,13 +105,21 @@ struct pair {
   pair(const pair& p) = default;
   pair(pair&& p) = default;
 
+  // 例如 pair(piecewise_construct, std::forward_as_tuple(key),
+  //           std::forward_as_tuple(args...))
+  template <class... Args1, class... Args2>
+  pair(piecewise_construct_t, std::tuple<Args1...> args1,
+       std::tuple<Args2...> args2)
+      : pair(args1, args2, make_index_sequence<sizeof...(Args1)>(),
+             make_index_sequence<sizeof...(Args2)>()) {}
+
   template <class U1, class U2>
   explicit pair(pair&& p)
       : first(toystl::move(p.first)), second(toystl::move(p.second)) {}
 
   // operator=
   pair& operator=(const pair& rhs) {
-    if (this != rhs) {
+    if (this != &rhs) {
       first = rhs.first;
       second = rhs.second;
     }
@@ -97,7 +128,7 @@ struct pair {
   }
 
   pair& operator=(pair&& rhs) {
-    if (this != rhs) {
+    if (this != &rhs) {
       first = toystl::move(rhs.first);
       second = toystl::move(rhs.second);
     }
@@ -109,6 +140,8 @@ struct pair {
   pair& operator=(const pair<Other1, Other2>& other) {
     first = other.first;
     second = other.second;
+
+    return *this;
   }
 
   template <class Other1, class Other2>
@@ -122,11 +155,18 @@ struct pair {
   ~pair() = default;
 
   void swap(pair& other) {
-    if (this != other) {
+    if (this != &other) {
       toystl::swap(first, other.first);
       toystl::swap(second, other.second);
     }
   }
+
+ private:
+  template <class... Args1, class... Args2, size_t... I1, size_t... I2>
+  pair(std::tuple<Args1...>& args1, std::tuple<Args2...>& args2,
+       index_sequence<I1...>, index_sequence<I2...>)
+      : first(toystl::forward<Args1>(std::get<I1>(args1))...),
+        second(toystl::forward<Args2>(std::get<I2>(args2))...) {}
 };
 
 // 重载比较操作符
@@ -1,7 +1,9 @@
 #ifndef TOYSTL_SRC_VECTOR_H_
 #define TOYSTL_SRC_VECTOR_H_
 
+#include <string.h>  // memmove
 #include <initializer_list>
+#include <stdexcept>
 
 #include "algobase.h"
 #include "alloc.h"
@@ -12,8 +14,310 @@
 #include "utility.h"
 
 namespace toystl {
-template <class T, class Alloc = toystl::allocator<T>>
-class vector {
+// vector 的扩容策略，作为 vector 的第三个模板参数。
+// next_capacity(capacity, required, elem_size) 返回扩容后的容量（元素个数），
+// 其中 capacity 为当前容量，required 为至少需要容纳的元素个数，
+// elem_size 为元素大小。返回值小于 required 时按 required 处理。
+
+// 2 倍扩容（默认），重新分配的次数最少
+struct vector_growth_2x {
+  static std::size_t next_capacity(std::size_t capacity, std::size_t required,
+                                   std::size_t) {
+    return capacity * 2 < required ? required : capacity * 2;
+  }
+};
+
+// 1.5 倍扩容，最后一次扩容多占用的内存更少，而且之前释放的旧空间之和
+// 有机会容纳新空间
+struct vector_growth_1_5x {
+  static std::size_t next_capacity(std::size_t capacity, std::size_t required,
+                                   std::size_t) {
+    std::size_t n = capacity + capacity / 2;
+    return n < required ? required : n;
+  }
+};
+
+// 在 Base 的基础上把申请的字节数对齐：小块凑满 toystl::alloc 的 size class，
+// 大块上调到 PageSize 的整数倍，超过 HugePageSize 时上调到大页的整数倍，
+// 避免分配器内部的尾部空间被浪费
+template <class Base = vector_growth_2x, std::size_t PageSize = 4096,
+          std::size_t HugePageSize = 2 * 1024 * 1024>
+struct vector_growth_page_aligned {
+  static std::size_t next_capacity(std::size_t capacity, std::size_t required,
+                                   std::size_t elem_size) {
+    std::size_t n = Base::next_capacity(capacity, required, elem_size);
+    if (n < required) {
+      n = required;
+    }
+    std::size_t bytes = n * elem_size;
+    if (bytes >= HugePageSize) {
+      bytes = round_up(bytes, HugePageSize);
+    } else if (bytes >= PageSize) {
+      bytes = round_up(bytes, PageSize);
+    } else {
+      bytes = alloc::good_size(bytes);
+    }
+    return bytes / elem_size;
+  }
+
+ private:
+  static std::size_t round_up(std::size_t bytes, std::size_t align) {
+    return (bytes + align - 1) / align * align;
+  }
+};
+
+// vector 与 small_vector 共用的存储和插入、扩容算法。
+// [start_, finish_) 为已构造的元素，[finish_, end_of_storage_) 为备用空间，
+// 扩容时元素一律移动到 get_alloc() 分配的新空间上。
+// 派生类 Derived 需要把 vector_base 声明为友元，并提供：
+//   deallocate_storage()：释放当前空间，不析构元素；
+//   reallocate_emplace(pos, args...)：可选，空间已满时在 pos 处构造新元素，
+//   不提供时使用这里的版本。
+template <class T, class Alloc, class Growth, class Derived>
+class vector_base : protected allocator_holder<Alloc> {
+ protected:
+  using data_allocator = Alloc;
+  using iterator = T*;
+  using size_type = size_t;
+  using alloc_base = allocator_holder<Alloc>;
+
+  iterator start_;           // 目前使用空间的头
+  iterator finish_;          // 目前使用空间的尾
+  iterator end_of_storage_;  // 目前可用空间的尾
+
+  vector_base() : start_(nullptr), finish_(nullptr), end_of_storage_(nullptr) {}
+
+  explicit vector_base(const Alloc& a)
+      : alloc_base(a),
+        start_(nullptr),
+        finish_(nullptr),
+        end_of_storage_(nullptr) {}
+
+  Derived& derived() { return static_cast<Derived&>(*this); }
+
+  size_type storage_capacity() const {
+    return static_cast<size_type>(end_of_storage_ - start_);
+  }
+
+  // 按扩容策略计算至少容纳 required 个元素时的新容量
+  size_type next_capacity(size_type required) const {
+    const size_type max_size =
+        static_cast<size_type>(size_type(-1) / sizeof(T));
+    if (required > max_size) {
+      throw std::length_error("vector");
+    }
+    const size_type n =
+        Growth::next_capacity(storage_capacity(), required, sizeof(T));
+    if (n < required) {
+      return required;
+    }
+    return n > max_size ? max_size : n;
+  }
+
+  // 析构当前的元素、释放当前空间，改用 [new_start, new_finish)，容量为 len
+  void replace_storage(iterator new_start, iterator new_finish,
+                       size_type len) {
+    data_allocator::destroy(start_, finish_);
+    derived().deallocate_storage();
+    start_ = new_start;
+    finish_ = new_finish;
+    end_of_storage_ = new_start + len;
+  }
+
+  // 把元素搬到容量为 newCapacity 的新空间上
+  void reallocate_storage(size_type newCapacity);
+
+  // 空间已满，在 pos 处构造新元素并扩容
+  template <class... Args>
+  void reallocate_emplace(iterator pos, Args&&... args);
+
+  template <class... Args>
+  iterator emplace_aux(iterator pos, Args&&... args);
+
+  iterator fill_insert(iterator pos, size_type n, const T& value);
+
+  template <class InputIterator>
+  void range_insert(iterator pos, InputIterator first, InputIterator last,
+                    input_iterator_tag);
+
+  template <class ForwardIterator>
+  void range_insert(iterator pos, ForwardIterator first, ForwardIterator last,
+                    forward_iterator_tag);
+};
+
+template <class T, class Alloc, class Growth, class Derived>
+void vector_base<T, Alloc, Growth, Derived>::reallocate_storage(
+    size_type newCapacity) {
+  const size_type old_size = static_cast<size_type>(finish_ - start_);
+  iterator tmp = this->get_alloc().allocate(newCapacity);
+  try {
+    toystl::uninitialized_move(start_, finish_, tmp);
+  } catch (...) {
+    this->get_alloc().deallocate(tmp, newCapacity);
+    throw;
+  }
+  replace_storage(tmp, tmp + old_size, newCapacity);
+}
+
+template <class T, class Alloc, class Growth, class Derived>
+template <class... Args>
+void vector_base<T, Alloc, Growth, Derived>::reallocate_emplace(
+    iterator pos, Args&&... args) {
+  const size_type len =
+      next_capacity(static_cast<size_type>(finish_ - start_) + 1);
+  iterator newstart = this->get_alloc().allocate(len);
+  iterator newpos = newstart + (pos - start_);
+  // 先构造新元素，args 可能引用本容器中的元素
+  try {
+    data_allocator::construct(newpos, toystl::forward<Args>(args)...);
+  } catch (...) {
+    this->get_alloc().deallocate(newstart, len);
+    throw;
+  }
+  iterator newfinish = newstart;
+  try {
+    newfinish = toystl::uninitialized_move(start_, pos, newstart);
+    newfinish = toystl::uninitialized_move(pos, finish_, newpos + 1);
+  } catch (...) {
+    data_allocator::destroy(newstart, newfinish);
+    data_allocator::destroy(newpos);
+    this->get_alloc().deallocate(newstart, len);
+    throw;
+  }
+  replace_storage(newstart, newfinish, len);
+}
+
+template <class T, class Alloc, class Growth, class Derived>
+template <class... Args>
+typename vector_base<T, Alloc, Growth, Derived>::iterator
+vector_base<T, Alloc, Growth, Derived>::emplace_aux(iterator pos,
+                                                    Args&&... args) {
+  const size_type n = static_cast<size_type>(pos - start_);
+  if (finish_ == end_of_storage_) {
+    derived().reallocate_emplace(pos, toystl::forward<Args>(args)...);
+  } else if (pos == finish_) {
+    data_allocator::construct(finish_, toystl::forward<Args>(args)...);
+    ++finish_;
+  } else {
+    // args 可能引用本容器中的元素，搬移之前先构造出来
+    T value(toystl::forward<Args>(args)...);
+    data_allocator::construct(finish_, toystl::move(*(finish_ - 1)));
+    ++finish_;
+    toystl::move_backward(pos, finish_ - 2, finish_ - 1);
+    *pos = toystl::move(value);
+  }
+  return start_ + n;
+}
+
+template <class T, class Alloc, class Growth, class Derived>
+typename vector_base<T, Alloc, Growth, Derived>::iterator
+vector_base<T, Alloc, Growth, Derived>::fill_insert(iterator pos, size_type n,
+                                                    const T& value) {
+  const size_type offset = static_cast<size_type>(pos - start_);
+  if (n == 0) {
+    return pos;
+  }
+  // value 可能引用本容器中的元素
+  const T value_copy = value;
+  if (static_cast<size_type>(end_of_storage_ - finish_) >= n) {
+    // 备用空间足够
+    const size_type elems_after = static_cast<size_type>(finish_ - pos);
+    iterator old_finish = finish_;
+    if (elems_after > n) {
+      // 插入点之后的元素比新增的多：末尾 n 个元素移到未初始化的空间，
+      // 其余的向后移动，再把 [pos, pos + n) 赋值为 value
+      toystl::uninitialized_move(finish_ - n, finish_, finish_);
+      finish_ += n;
+      toystl::move_backward(pos, old_finish - n, old_finish);
+      toystl::fill(pos, pos + n, value_copy);
+    } else {
+      // 插入点之后的元素不比新增的多：先在备用空间构造多出来的 value，
+      // 再把 [pos, old_finish) 移过去，最后赋值
+      finish_ = toystl::uninitialized_fill_n(finish_, n - elems_after,
+                                             value_copy);
+      finish_ = toystl::uninitialized_move(pos, old_finish, finish_);
+      toystl::fill(pos, old_finish, value_copy);
+    }
+  } else {
+    // 备用空间不足，配置新的空间
+    const size_type len =
+        next_capacity(static_cast<size_type>(finish_ - start_) + n);
+    iterator new_start = this->get_alloc().allocate(len);
+    iterator new_finish = new_start;
+    try {
+      new_finish = toystl::uninitialized_move(start_, pos, new_start);
+      new_finish = toystl::uninitialized_fill_n(new_finish, n, value_copy);
+      new_finish = toystl::uninitialized_move(pos, finish_, new_finish);
+    } catch (...) {
+      data_allocator::destroy(new_start, new_finish);
+      this->get_alloc().deallocate(new_start, len);
+      throw;
+    }
+    replace_storage(new_start, new_finish, len);
+  }
+  return start_ + offset;
+}
+
+template <class T, class Alloc, class Growth, class Derived>
+template <class InputIterator>
+void vector_base<T, Alloc, Growth, Derived>::range_insert(iterator pos,
+                                                          InputIterator first,
+                                                          InputIterator last,
+                                                          input_iterator_tag) {
+  for (; first != last; ++first) {
+    pos = emplace_aux(pos, *first);
+    ++pos;
+  }
+}
+
+template <class T, class Alloc, class Growth, class Derived>
+template <class ForwardIterator>
+void vector_base<T, Alloc, Growth, Derived>::range_insert(
+    iterator pos, ForwardIterator first, ForwardIterator last,
+    forward_iterator_tag) {
+  if (first == last) {
+    return;
+  }
+  const size_type n = static_cast<size_type>(toystl::distance(first, last));
+  if (static_cast<size_type>(end_of_storage_ - finish_) >= n) {
+    // 备用空间足够，做法与 fill_insert 相同
+    const size_type elems_after = static_cast<size_type>(finish_ - pos);
+    iterator old_finish = finish_;
+    if (elems_after > n) {
+      toystl::uninitialized_move(finish_ - n, finish_, finish_);
+      finish_ += n;
+      toystl::move_backward(pos, old_finish - n, old_finish);
+      toystl::copy(first, last, pos);
+    } else {
+      // [first, mid) 的元素个数等于插入点之后现有元素的个数
+      ForwardIterator mid = first;
+      toystl::advance(mid, elems_after);
+      finish_ = toystl::uninitialized_copy(mid, last, finish_);
+      finish_ = toystl::uninitialized_move(pos, old_finish, finish_);
+      toystl::copy(first, mid, pos);
+    }
+  } else {
+    const size_type len =
+        next_capacity(static_cast<size_type>(finish_ - start_) + n);
+    iterator new_start = this->get_alloc().allocate(len);
+    iterator new_finish = new_start;
+    try {
+      new_finish = toystl::uninitialized_move(start_, pos, new_start);
+      new_finish = toystl::uninitialized_copy(first, last, new_finish);
+      new_finish = toystl::uninitialized_move(pos, finish_, new_finish);
+    } catch (...) {
+      data_allocator::destroy(new_start, new_finish);
+      this->get_alloc().deallocate(new_start, len);
+      throw;
+    }
+    replace_storage(new_start, new_finish, len);
+  }
+}
+
+template <class T, class Alloc = toystl::allocator<T>,
+          class Growth = vector_growth_2x>
+class vector
+    : private vector_base<T, Alloc, Growth, vector<T, Alloc, Growth>> {
  public:
   using allocator_type = Alloc;
   using data_allocator = Alloc;
@@ -47,27 +351,41 @@ class vector {
  private:
   // 删除这个，占用空间！
   // allocator_type dataAllocator;       // 内存空间配置器
-
-  iterator start_;           // 目前使用空间的头
-  iterator finish_;          // 目前使用空间的尾
-  iterator end_of_storage_;  // 目前可用空间的尾
-
-  // 弃用
-  // // 扩容因子 设为 1.5
-  // constexpr static double grow_factor = 1.5;
+  // 分配器和 start_ / finish_ / end_of_storage_ 保存在基类 vector_base 中，
+  // 无状态的分配器不占用空间；插入和扩容的算法与 small_vector 共用
+  using base = vector_base<T, Alloc, Growth, vector>;
+  friend class vector_base<T, Alloc, Growth, vector>;
+
+  using base::start_;
+  using base::finish_;
+  using base::end_of_storage_;
+  using base::next_capacity;
+  using base::emplace_aux;
+  using base::fill_insert;
+  using base::range_insert;
 
  public:
   // 构造函数（只实现了部分）
-  vector() : start_(nullptr), finish_(nullptr), end_of_storage_(nullptr) {}
-  vector(size_type n, const T& value) { fill_initialize(n, value); }
+  vector() {}
 
-  explicit vector(size_type n) : vector(n, T()) {}
+  explicit vector(const allocator_type& a) : base(a) {}
+
+  vector(size_type n, const T& value,
+         const allocator_type& a = allocator_type())
+      : base(a) {
+    fill_initialize(n, value);
+  }
+
+  explicit vector(size_type n, const allocator_type& a = allocator_type())
+      : vector(n, T(), a) {}
 
   // 这边只接受传入迭代器
   template <class InputIterator,
             typename std::enable_if<
                 toystl::is_input_iterator<InputIterator>::value, int>::type = 0>
-  vector(InputIterator first, InputIterator last) {
+  vector(InputIterator first, InputIterator last,
+         const allocator_type& a = allocator_type())
+      : base(a) {
     // 如果 InputIterator 为整数类型，则此构造函数的效果如同
     // vector(static_cast<size_type>(first), static_cast<value_type>(last)),
     // 实际调用的是 fill_initialize，构造
@@ -79,13 +397,21 @@ class vector {
 
   // 列表初始化
   // 实际上调用的是上面那个构造函数
-  vector(const std::initializer_list<T> iList) {
+  vector(const std::initializer_list<T> iList,
+         const allocator_type& a = allocator_type())
+      : base(a) {
     range_initialize(iList.begin(), iList.end());
   }
 
   // 拷贝构造函数
   // 调用这个函数的时候，两个vector 的 value_type 必须一样
-  vector(const vector& other) : vector(other.begin(), other.end()) {}
+  // 新容器的分配器由 select_on_container_copy_construction 决定
+  vector(const vector& other)
+      : vector(other.begin(), other.end(),
+               other.get_alloc().select_on_container_copy_construction()) {}
+
+  vector(const vector& other, const allocator_type& a)
+      : vector(other.begin(), other.end(), a) {}
 
   // 移动构造函数, vector列表初始化，已经把 start finish end 初始化为 nullptr 了
   // 所以这里的效果就是 将这个对象的 end finish end 赋值为 other 的，然后将
@@ -94,9 +420,11 @@ class vector {
   //     swap(other);
   // }
   // 以上的实现不好，改为下面的实现
-  vector(vector&& other) noexcept : start_(other.start_),
-                                    finish_(other.finish_),
-                                    end_of_storage_(other.end_of_storage_) {
+  // 分配器随内存一起移动过来
+  vector(vector&& other) noexcept : base(other.get_alloc()) {
+    start_ = other.start_;
+    finish_ = other.finish_;
+    end_of_storage_ = other.end_of_storage_;
     other.start_ = nullptr;
     other.finish_ = nullptr;
     other.end_of_storage_ = nullptr;
@@ -114,7 +442,7 @@ class vector {
     // 先析构，后回收内存。在
     // finish_（包含finish_）之后的位置没有元素，只需要回收内存即可
     data_allocator::destroy(start_, finish_);
-    data_allocator::deallocate(
+    this->get_alloc().deallocate(
         start_, static_cast<std::size_t>(end_of_storage_ - start_));
     // 不需要重置 start_, finish_, end_of_storage_。
   }
@@ -129,10 +457,13 @@ class vector {
     // }
 
     if (this != &rhs) {
+      copy_assign_alloc(
+          rhs,
+          typename allocator_type::propagate_on_container_copy_assignment());
       const size_type len = rhs.size();
       // 如果 rhs.size() > this->capacity()
       if (len > capacity()) {
-        vector tmp(rhs.begin(), rhs.end());
+        vector tmp(rhs.begin(), rhs.end(), this->get_alloc());
         swap(tmp);
       } else if (size() >= len) {
         auto i = toystl::copy(rhs.begin(), rhs.end(), begin());
@@ -141,7 +472,7 @@ class vector {
       } else {
         toystl::copy(rhs.begin(), rhs.begin() + size(), start_);
         toystl::uninitialized_copy(rhs.begin() + size(), rhs.end(), finish_);
-        end_of_storage_ = finish_ = start_ + len;
+        finish_ = start_ + len;
       }
     }
 
@@ -150,41 +481,41 @@ class vector {
 
   // 移动赋值运算符
   // fixed : 移动复制运算符需要释放左侧运算对象
-  vector& operator=(vector&& rhs) noexcept {
-    data_allocator::destroy(start_, finish_);
-    data_allocator::deallocate(
-        start_, static_cast<std::size_t>(end_of_storage_ - start_));
-    start_ = rhs.start_;
-    finish_ = rhs.finish_;
-    end_of_storage_ = rhs.end_of_storage_;
-    rhs.start_ = nullptr;
-    rhs.finish_ = nullptr;
-    rhs.end_of_storage_ = nullptr;
+  vector& operator=(vector&& rhs) noexcept(
+      allocator_nothrow_move_assign<Alloc>::value) {
+    if (this != &rhs) {
+      move_assign(
+          rhs,
+          typename allocator_type::propagate_on_container_move_assignment());
+    }
 
     return *this;
   }
 
   vector& operator=(std::initializer_list<T> iList) {
-    vector tmp(iList.begin(), iList.end());
+    vector tmp(iList.begin(), iList.end(), this->get_alloc());
     swap(tmp);
 
     return *this;
   }
 
   /* 简化版的赋值函数。释放了原来的数据空间，并分配了新的数据空间 */
+  /* 临时对象使用本容器的分配器，赋值后分配器不变 */
   vector& assign(size_type n, const_reference value) {
-    return *this = vector(n, value);
+    return *this = vector(n, value, this->get_alloc());
   }
 
   template <class InputIterator>
   vector& assign(InputIterator first, InputIterator last) {
-    return *this = vector(first, last);
+    return *this = vector(first, last, this->get_alloc());
   }
 
   vector& assign(std::initializer_list<T> ilist) {
-    return *this = vector(ilist);
+    return *this = vector(ilist, this->get_alloc());
   }
 
+  allocator_type get_allocator() const { return this->get_alloc(); }
+
   /* 访问元素相关操作 */
 
   // vector.at()，比 operator[] 安全，进行了越界检查
@@ -314,7 +645,8 @@ class vector {
   template <class InputIterator>
   void insert_dispatch(const_iterator position, InputIterator first,
                        InputIterator last, false_type) {
-    range_insert(position, first, last, toystl::iterator_category(first));
+    range_insert(const_cast<iterator>(position), first, last,
+                 toystl::iterator_category(first));
   }
 
   template <class InputIterator>
@@ -361,13 +693,59 @@ class vector {
   }
 
   // 与另外一个 vector 交换
+  // 分配器按 propagate_on_container_swap 决定是否交换
   void swap(vector& other) noexcept {
+    this->swap_alloc(other);
     toystl::swap(start_, other.start_);
     toystl::swap(finish_, other.finish_);
     toystl::swap(end_of_storage_, other.end_of_storage_);
   }
 
  private:
+  // 释放全部元素和内存
+  void deallocate_all() {
+    data_allocator::destroy(start_, finish_);
+    this->get_alloc().deallocate(
+        start_, static_cast<std::size_t>(end_of_storage_ - start_));
+    start_ = finish_ = end_of_storage_ = nullptr;
+  }
+
+  // 分配器需要传播时，如果两个分配器不相等，原有内存必须由原分配器释放
+  void copy_assign_alloc(const vector& rhs, true_type) {
+    if (this->get_alloc() != rhs.get_alloc()) {
+      deallocate_all();
+    }
+    this->set_alloc(rhs.get_alloc());
+  }
+
+  void copy_assign_alloc(const vector&, false_type) {}
+
+  // 分配器随内存一起转移
+  void move_assign(vector& rhs, true_type) {
+    deallocate_all();
+    this->set_alloc(rhs.get_alloc());
+    start_ = rhs.start_;
+    finish_ = rhs.finish_;
+    end_of_storage_ = rhs.end_of_storage_;
+    rhs.start_ = nullptr;
+    rhs.finish_ = nullptr;
+    rhs.end_of_storage_ = nullptr;
+  }
+
+  // 分配器不传播：分配器相等时仍然可以直接接管内存，否则只能逐个移动元素
+  void move_assign(vector& rhs, false_type) {
+    if (this->get_alloc() == rhs.get_alloc()) {
+      move_assign(rhs, true_type());
+    } else {
+      clear();
+      reserve(rhs.size());
+      for (auto& value : rhs) {
+        emplace_back(toystl::move(value));
+      }
+      rhs.clear();
+    }
+  }
+
   void fill_initialize(size_type n, const_reference x);
 
   template <class ForwardIterator>
@@ -402,7 +780,7 @@ class vector {
   //  */
   // void reallocate(size_type newSize) {
   //     vector tmp;
-  //     tmp.start_ = data_allocator::allocate(newSize);
+  //     tmp.start_ = this->get_alloc().allocate(newSize);
   //     tmp.finish_ = toystl::uninitialized_copy(start_, finish_, tmp.start_);
   //     tmp.end_of_storage_ = tmp.start_ + newSize;
 
@@ -415,41 +793,61 @@ class vector {
     }
   }
 
-  void insert_aux(iterator position, const value_type& value);
-
-  iterator fill_insert(iterator pos, size_type n, const value_type& value);
+  // 释放当前空间，不析构元素，供 vector_base 扩容时调用
+  void deallocate_storage() {
+    this->get_alloc().deallocate(
+        start_, static_cast<std::size_t>(end_of_storage_ - start_));
+  }
 
-  template <class InputIterator>
-  void range_insert(iterator pos, InputIterator first, InputIterator last,
-                    input_iterator_tag);
+  // 空间已满时在 pos 处构造新元素，可以 realloc 时原地扩容
+  template <class... Args>
+  void reallocate_emplace(iterator pos, Args&&... args);
 
-  template <class ForwardIterator>
-  void range_insert(iterator pos, ForwardIterator first, ForwardIterator last,
-                    forward_iterator_tag);
+  template <class... Args>
+  void reallocate_emplace_aux(false_type, iterator pos, Args&&... args);
 
   template <class... Args>
-  void reallocate_emplace(iterator pos, Args&&... args);
+  void reallocate_emplace_aux(true_type, iterator pos, Args&&... args);
+
+  // 元素 trivially copyable 且分配器提供 reallocate 时，扩容直接 realloc：
+  // 大块内存可能就地扩展，省去逐个搬移元素和释放旧空间
+  using realloc_relocatable =
+      m_bool_constant<__type_traits<T>::is_POD_type::value &&
+                      allocator_has_reallocate<Alloc>::value>;
+
+  // 把容量调整为 newCapacity，[start_, finish_) 中的元素随之搬移
+  void reallocate_storage(size_type newCapacity, false_type);
+  void reallocate_storage(size_type newCapacity, true_type);
 
   template <class Iter>
   void range_initialize(Iter first, Iter last);
 };
 
-template <class T, class Alloc>
-void vector<T, Alloc>::reserve(size_type newCapacity) {
+template <class T, class Alloc, class Growth>
+void vector<T, Alloc, Growth>::reserve(size_type newCapacity) {
   if (newCapacity > capacity()) {
-    const size_type old_size = size();
-    iterator tmp = data_allocator::allocate(newCapacity);
-    toystl::uninitialized_copy(start_, finish_, tmp);
-    data_allocator::destroy(start_, finish_);
-    data_allocator::deallocate(
-        start_, static_cast<std::size_t>(end_of_storage_ - start_));
-    start_ = tmp;
-    finish_ = tmp + old_size;
-    end_of_storage_ = tmp + newCapacity;
+    reallocate_storage(newCapacity, realloc_relocatable());
   }
 }
-template <class T, class Alloc>
-void vector<T, Alloc>::resize(size_type newSize, const_reference x) {
+
+template <class T, class Alloc, class Growth>
+void vector<T, Alloc, Growth>::reallocate_storage(size_type newCapacity,
+                                                  false_type) {
+  base::reallocate_storage(newCapacity);
+}
+
+template <class T, class Alloc, class Growth>
+void vector<T, Alloc, Growth>::reallocate_storage(size_type newCapacity,
+                                                  true_type) {
+  const size_type old_size = size();
+  // reallocate 失败时抛出异常，原来的空间保持不变
+  iterator tmp = this->get_alloc().reallocate(start_, capacity(), newCapacity);
+  start_ = tmp;
+  finish_ = tmp + old_size;
+  end_of_storage_ = tmp + newCapacity;
+}
+template <class T, class Alloc, class Growth>
+void vector<T, Alloc, Growth>::resize(size_type newSize, const_reference x) {
   if (newSize < size()) {
     erase(begin() + newSize, end());
   } else {
@@ -457,23 +855,16 @@ void vector<T, Alloc>::resize(size_type newSize, const_reference x) {
   }
 }
 
-template <class T, class Alloc>
-void vector<T, Alloc>::shrink_to_fit() {
+template <class T, class Alloc, class Growth>
+void vector<T, Alloc, Growth>::shrink_to_fit() {
   if (finish_ < end_of_storage_) {
-    auto shrink_to_size = size();
-    iterator tmp = data_allocator::allocate(shrink_to_size);
-    toystl::uninitialized_copy(start_, finish_, tmp);
-    data_allocator::destroy(start_, finish_);
-    data_allocator::deallocate(
-        start_, static_cast<std::size_t>(end_of_storage_ - start_));
-    start_ = tmp;
-    finish_ = tmp + shrink_to_size;
-    end_of_storage_ = tmp + shrink_to_size;
+    base::reallocate_storage(size());
   }
 }
 
-template <class T, class Alloc>
-typename vector<T, Alloc>::iterator vector<T, Alloc>::erase(iterator position) {
+template <class T, class Alloc, class Growth>
+typename vector<T, Alloc, Growth>::iterator vector<T, Alloc, Growth>::erase(
+    iterator position) {
   // 如果清除的元素不是最后一个元素，那么需要把清除位置的后面元素往前面挪
   if (position + 1 != end()) {
     // copy 函数，输出区间的起点与输入区间不重叠，没有问题。
@@ -485,72 +876,38 @@ typename vector<T, Alloc>::iterator vector<T, Alloc>::erase(iterator position) {
   return position;
 }
 
-template <class T, class Alloc>
-typename vector<T, Alloc>::iterator vector<T, Alloc>::erase(iterator first,
-                                                            iterator last) {
+template <class T, class Alloc, class Growth>
+typename vector<T, Alloc, Growth>::iterator vector<T, Alloc, Growth>::erase(
+    iterator first, iterator last) {
   iterator newEnd = toystl::copy(last, finish_, first);
   data_allocator::destroy(newEnd, end());  // 销毁元素
   finish_ = finish_ - (last - first);
   return first;
 }
 
-template <class T, class Alloc>
-typename vector<T, Alloc>::iterator vector<T, Alloc>::insert(
+template <class T, class Alloc, class Growth>
+typename vector<T, Alloc, Growth>::iterator vector<T, Alloc, Growth>::insert(
     const_iterator position, const_reference value) {
-  iterator xposition = const_cast<iterator>(position);
-  const size_type n = xposition - begin();
-  if (finish_ != end_of_storage_ && xposition == finish_) {
-    // 有空间并且是插入点是最后一个位置
-    data_allocator::construct(&*finish_, value);
-    ++finish_;
-  } else {
-    insert_aux(xposition, value);
-  }
-
-  return begin() + n;
+  return emplace(position, value);
 }
 
-template <class T, class Alloc>
-typename vector<T, Alloc>::iterator vector<T, Alloc>::insert(
+template <class T, class Alloc, class Growth>
+typename vector<T, Alloc, Growth>::iterator vector<T, Alloc, Growth>::insert(
     const_iterator position, const T&& value) {
-  iterator xposition = const_cast<iterator>(position);
-  const size_type n = xposition - begin();
-  if (finish_ != end_of_storage_ && xposition == finish_) {
-    // 有空间并且是插入点是最后一个位置
-    data_allocator::construct(&*finish_, toystl::move(value));
-    ++finish_;
-  } else {
-    insert_aux(xposition, std::move(value));
-  }
-
-  return begin() + n;
+  return emplace(position, toystl::move(value));
 }
 
-template <class T, class Alloc>
+template <class T, class Alloc, class Growth>
 template <class... Args>
-typename vector<T, Alloc>::iterator vector<T, Alloc>::emplace(
+typename vector<T, Alloc, Growth>::iterator vector<T, Alloc, Growth>::emplace(
     const_iterator position, Args&&... args) {
-  iterator xpos = const_cast<iterator>(position);
-  const size_type n = xpos - start_;
-  if (finish_ != end_of_storage_ && xpos == finish_) {
-    data_allocator::construct(&*finish_, toystl::forward<Args>(args)...);
-    ++finish_;
-  } else if (finish_ != end_of_storage_) {
-    auto newfinish = finish_;
-    data_allocator::construct(&*finish_, *(finish_ - 1));
-    ++newfinish;
-    toystl::copy_backward(xpos, finish_ - 1, finish_);
-    *xpos = value_type(toystl::forward<Args>(args)...);
-  } else {
-    reallocate_emplace(xpos, toystl::forward<Args>(args)...);
-  }
-
-  return begin() + n;
+  return emplace_aux(const_cast<iterator>(position),
+                     toystl::forward<Args>(args)...);
 }
 
-template <class T, class Alloc>
+template <class T, class Alloc, class Growth>
 template <class... Args>
-void vector<T, Alloc>::emplace_back(Args&&... args) {
+void vector<T, Alloc, Growth>::emplace_back(Args&&... args) {
   if (finish_ < end_of_storage_) {
     data_allocator::construct(&*finish_, toystl::forward<Args>(args)...);
     ++finish_;
@@ -559,20 +916,21 @@ void vector<T, Alloc>::emplace_back(Args&&... args) {
   }
 }
 
-template <class T, class Alloc>
-void vector<T, Alloc>::push_back(const value_type& value) {
+template <class T, class Alloc, class Growth>
+void vector<T, Alloc, Growth>::push_back(const value_type& value) {
   if (finish_ != end_of_storage_) {
     data_allocator::construct(finish_, value);
     ++finish_;
   } else {
-    insert_aux(end(), value);
+    reallocate_emplace(finish_, value);
   }
 }
 
-template <class T, class Alloc>
-void vector<T, Alloc>::fill_initialize(size_type n, const_reference x) {
+template <class T, class Alloc, class Growth>
+void vector<T, Alloc, Growth>::fill_initialize(size_type n,
+                                               const_reference x) {
   iterator result =
-      data_allocator::allocate(n);  // 分配可以容纳 n 个 T 类型大小的内存空间
+      this->get_alloc().allocate(n);  // 分配可以容纳 n 个 T 类型大小的内存空间
   toystl::uninitialized_fill_n(result, n,
                                x);  // 在内存空间上构造 n 个 T 类型的元素
 
@@ -581,250 +939,73 @@ void vector<T, Alloc>::fill_initialize(size_type n, const_reference x) {
   end_of_storage_ = finish_;
 }
 
-template <class T, class Alloc>
+template <class T, class Alloc, class Growth>
 template <class ForwardIterator>
-void vector<T, Alloc>::copy_initialize(ForwardIterator first,
-                                       ForwardIterator last,
-                                       forward_iterator_tag) {
+void vector<T, Alloc, Growth>::copy_initialize(ForwardIterator first,
+                                               ForwardIterator last,
+                                               forward_iterator_tag) {
   auto copySize = static_cast<size_type>(distance(first, last));
-  start_ = data_allocator::allocate(copySize);
+  start_ = this->get_alloc().allocate(copySize);
   finish_ = toystl::uninitialized_copy(first, last, start_);
   end_of_storage_ = finish_;
 }
 
-template <class T, class Alloc>
-template <class InputIterator>
-void vector<T, Alloc>::copy_initialize(InputIterator first, InputIterator last,
-                                       input_iterator_tag) {
-  while (first != last) {
-    if (capacity() == size()) {
-      reallocate(empty() ? 1 : 2 * size());
-    }
-    push_back(*first);
-  }
-}
-
-template <class T, class Alloc>
-void vector<T, Alloc>::insert_aux(iterator position, const value_type& value) {
-  if (finish_ != end_of_storage_) {  // 如果还有备用空间
-    // 在备用空间起始处构造一个元素，并以 vector 的最后一个元素值为其初值
-    data_allocator::construct(finish_, *(finish_ - 1));
-    ++finish_;
-    T value_copy = value;
-    toystl::copy_backward(position, finish_ - 2, finish_ - 1);
-    *position = value_copy;
-  } else {  // 已无备用空间
-    const size_type old_size = size();
-    const size_type len = (old_size != 0) ? (old_size * 2) : 1;
-    iterator newstart = data_allocator::allocate(len);
-    iterator newfinish = newstart;
-    T value_copy = value;
-    try {
-      newfinish = toystl::uninitialized_move(start_, position, newstart);
-      data_allocator::construct(&(*newfinish), value_copy);
-      ++newfinish;
-      newfinish = toystl::uninitialized_move(position, finish_, newfinish);
-    } catch (...) {
-      data_allocator::destroy(newstart, newfinish);
-      data_allocator::deallocate(newstart, static_cast<std::size_t>(len));
-      throw;
-    }
-
-    // 以下清除并释放旧的 vector
-    data_allocator::destroy(start_, finish_);
-    data_allocator::deallocate(
-        start_, static_cast<std::size_t>(end_of_storage_ - start_));
-    start_ = newstart;
-    finish_ = newfinish;
-    end_of_storage_ = newstart + len;
-  }
-}
-
-template <class T, class Alloc>
-typename vector<T, Alloc>::iterator vector<T, Alloc>::fill_insert(
-    iterator pos, size_type n, const value_type& value) {
-  if (n == 0) {
-    return pos;
-  }
-
-  const size_type before_pos = pos - start_;
-  const value_type value_copy = value;
-  if (static_cast<size_type>(end_of_storage_ - finish_) >= n) {
-    // 如果备用空间大于等于增加的空间
-    const size_type elems_after = finish_ - pos;
-    auto old_finish = finish_;
-    if (elems_after > n) {
-      // 如果插入点后的现有元素个数 大于 新增元素个数
-      // 1、将源区间[finish-n, finish)填充到目标区间[finish, finish+n)
-      // 把插入点后的元素往后面搬，搬到 从 finish_ 开始，给新增元素腾地方
-      // 注意，和下面的 copy
-      // 不同，这里不仅仅需要拷贝，还需要在相应的位置构造元素
-      toystl::uninitialized_copy(finish_ - n, finish_, finish_);
-      finish_ = finish_ + n;
-      // 2、将源区间[position,old_finish-n)从逆向cpoy到目标区间[old_finish-n,
-      // old_finish)
-      // 这里的话，直接拷贝就好了
-      // 注意，这里是 copy_backward ，将 [first, last)
-      // 区间内的每一个元素，以逆行的方向复制到 以 result - 1
-      // 为起点，方向也为逆行的区间上。
-      toystl::copy_backward(pos, old_finish - n, old_finish);
-      // 3、将目标区间[position, position+n) 填充成 x_copy
-      toystl::fill(pos, pos + n, value_copy);
-    } else {
-      // 如果插入点之后的现有元素个数 小于等于 新增元素个数
-      toystl::uninitialized_fill_n(finish_, n - elems_after, value_copy);
-      finish_ += n - elems_after;
-      toystl::uninitialized_copy(pos, old_finish, finish_);
-      fill(pos, old_finish, value_copy);
-    }
-  } else {
-    // 如果备用空间不足，配置额外的内存
-    const size_type old_size = size();
-    const size_type len = old_size + toystl::max(old_size, n);
-    iterator new_start = data_allocator::allocate(len);
-    iterator new_finish = new_start;
-    try {
-      new_finish = toystl::uninitialized_copy(start_, pos, new_start);
-      new_finish = toystl::uninitialized_fill_n(new_finish, n, value_copy);
-      new_finish = toystl::uninitialized_copy(pos, finish_, new_finish);
-    } catch (...) {
-      data_allocator::destroy(new_start, new_finish);
-      data_allocator::deallocate(new_start, static_cast<std::size_t>(len));
-      throw;
-    }
-
-    // 以下清除并释放旧的 vector
-    data_allocator::destroy(start_, finish_);
-    data_allocator::deallocate(
-        start_, static_cast<std::size_t>(end_of_storage_ - start_));
-    // 以下调整 start finish end_of_storage 到新的 vector
-    start_ = new_start;
-    finish_ = new_finish;
-    end_of_storage_ = new_start + len;
-  }
-
-  return start_ + before_pos;
-}
-
-template <class T, class Alloc>
+template <class T, class Alloc, class Growth>
 template <class InputIterator>
-void vector<T, Alloc>::range_insert(iterator pos, InputIterator first,
-                                    InputIterator last, input_iterator_tag) {
+void vector<T, Alloc, Growth>::copy_initialize(InputIterator first,
+                                               InputIterator last,
+                                               input_iterator_tag) {
+  start_ = finish_ = end_of_storage_ = nullptr;
   for (; first != last; ++first) {
-    pos = insert(pos, *first);
-    ++pos;
+    emplace_back(*first);
   }
 }
 
-template <class T, class Alloc>
-template <class ForwardIterator>
-void vector<T, Alloc>::range_insert(iterator pos, ForwardIterator first,
-                                    ForwardIterator last,
-                                    forward_iterator_tag) {
-  if (first != last) {
-    size_type n = toystl::distance(first, last);
-    if (size_type(end_of_storage_ - finish_) >= n) {
-      // 如果剩下的空间满足需要的大小
-      const size_type elems_after = finish_ - pos;
-      auto old_finish = finish_;
-      if (elems_after > n) {
-        // 如果插入点后的现有元素个数 大于 新增元素个数
-        // 1、将源区间[finish-n, finish)填充到目标区间[finish, finish+n)
-        // 把插入点后的元素往后面搬，搬到 从 finish_ 开始，给新增元素腾地方
-        // 注意，和下面的 copy
-        // 不同，这里不仅仅需要拷贝，还需要在相应的位置构造元素
-        toystl::uninitialized_copy(finish_ - n, finish_, finish_);
-        finish_ = finish_ + n;
-        // 2、将源区间[position,old_finish-n)从逆向cpoy到目标区间[old_finish-n,
-        // old_finish)
-        // 这里的话，直接拷贝就好了
-        // 注意，这里是 copy_backward ，将 [first, last)
-        // 区间内的每一个元素，以逆行的方向复制到 以 result - 1
-        // 为起点，方向也为逆行的区间上。
-        toystl::copy_backward(pos, old_finish - n, old_finish);
-        // 3、将目标区间[position, position+n) 填充成 x_copy
-        toystl::copy(first, last, pos);
-      } else {
-        // 如果插入点之后的现有元素个数 小于等于 新增元素个数
-        ForwardIterator mid = first;
-        // [first, mid) 上的元素个数 等于 插入点之后现有元素的个数
-        toystl::advance(mid, elems_after);
-        // 1、先把[mid last) 拷贝到 [finish_, finish_ + n - elems_after)
-        uninitialized_copy(mid, last, finish_);
-        finish_ += n - elems_after;
-        // 2、再把[pos, oldfinish) 拷贝到 [finish_, finish_ + elems_after)
-        uninitialized_copy(pos, old_finish, finish_);
-        finish_ += elems_after;
-        // 3、最后一步，再把 [first, mid) 拷贝到 [pos, pos + elems_after)
-        toystl::copy(first, mid, pos);
-      }
-    } else {
-      // 如果剩下的空间 不 满足需要的大小，需要配置额外的内存
-      const size_type old_size = size();
-      const size_type len = old_size + toystl::max(old_size, n);
-      iterator new_start = data_allocator::allocate(len);
-      iterator new_finish = new_start;
-      try {
-        new_finish = toystl::uninitialized_copy(start_, pos, new_start);
-        new_finish = toystl::uninitialized_copy(first, last, new_finish);
-        new_finish = toystl::uninitialized_copy(pos, finish_, new_finish);
-      } catch (...) {
-        data_allocator::destroy(new_start, new_finish);
-        data_allocator::deallocate(new_start, static_cast<std::size_t>(len));
-        throw;
-      }
-
-      // 以下清除并释放旧的 vector
-      data_allocator::destroy(start_, finish_);
-      data_allocator::deallocate(
-          start_, static_cast<std::size_t>(end_of_storage_ - start_));
-      // 以下调整 start finish end_of_storage 到新的 vector
-      start_ = new_start;
-      finish_ = new_finish;
-      end_of_storage_ = new_start + len;
-    }
-  }
+template <class T, class Alloc, class Growth>
+template <class... Args>
+void vector<T, Alloc, Growth>::reallocate_emplace(iterator pos,
+                                                  Args&&... args) {
+  reallocate_emplace_aux(realloc_relocatable(), pos,
+                         toystl::forward<Args>(args)...);
 }
 
-template <class T, class Alloc>
+template <class T, class Alloc, class Growth>
 template <class... Args>
-void vector<T, Alloc>::reallocate_emplace(iterator pos, Args&&... args) {
+void vector<T, Alloc, Growth>::reallocate_emplace_aux(true_type, iterator pos,
+                                                      Args&&... args) {
+  // args 可能引用本容器中的元素，realloc 之后就失效了，先构造出来
+  value_type value(toystl::forward<Args>(args)...);
+  const size_type offset = static_cast<size_type>(pos - start_);
   const size_type oldsize = size();
-  const size_type len = (oldsize != 0) ? (2 * oldsize) : 1;
-  auto newstart = data_allocator::allocate(len);
-  iterator newfinish = newstart;
-  try {
-    newfinish = uninitialized_move(start_, pos, newstart);
-    data_allocator::construct(&(*newfinish), toystl::forward<Args>(args)...);
-    ++newfinish;
-    newfinish = uninitialized_move(pos, finish_, newfinish);
-  } catch (...) {
-    data_allocator::destroy(newstart, newfinish);
-    data_allocator::deallocate(newstart, static_cast<std::size_t>(len));
-    throw;
+  reallocate_storage(next_capacity(oldsize + 1), true_type());
+  pos = start_ + offset;
+  if (pos != finish_) {
+    memmove(pos + 1, pos, sizeof(T) * (finish_ - pos));
   }
+  data_allocator::construct(pos, value);
+  ++finish_;
+}
 
-  // 以下清除并释放旧的 vector
-  data_allocator::destroy(start_, finish_);
-  data_allocator::deallocate(
-      start_, static_cast<std::size_t>(end_of_storage_ - start_));
-  start_ = newstart;
-  finish_ = newfinish;
-  end_of_storage_ = newstart + len;
+template <class T, class Alloc, class Growth>
+template <class... Args>
+void vector<T, Alloc, Growth>::reallocate_emplace_aux(false_type,
+                                                      iterator pos,
+                                                      Args&&... args) {
+  base::reallocate_emplace(pos, toystl::forward<Args>(args)...);
 }
 
-template <class T, class Alloc>
+template <class T, class Alloc, class Growth>
 template <class Iter>
-void vector<T, Alloc>::range_initialize(Iter first, Iter last) {
+void vector<T, Alloc, Growth>::range_initialize(Iter first, Iter last) {
   size_type len = distance(first, last);
   const size_type initsize = toystl::max(static_cast<size_type>(last - first),
                                          static_cast<size_type>(16));
   try {
-    start_ = data_allocator::allocate(initsize);
+    start_ = this->get_alloc().allocate(initsize);
     finish_ = start_ + len;
     end_of_storage_ = start_ + initsize;
   } catch (...) {
-    data_allocator::deallocate(start_, static_cast<std::size_t>(len));
+    this->get_alloc().deallocate(start_, static_cast<std::size_t>(len));
     start_ = nullptr;
     finish_ = nullptr;
     end_of_storage_ = nullptr;
@@ -842,47 +1023,48 @@ void vector<T, Alloc>::range_initialize(Iter first, Iter last) {
 // 重载了 == != < <= > >=
 
 // =
-template <class T, class Allocator>
-bool operator==(const vector<T, Allocator>& left,
-                const vector<T, Allocator>& right) {
+template <class T, class Allocator, class Growth>
+bool operator==(const vector<T, Allocator, Growth>& left,
+                const vector<T, Allocator, Growth>& right) {
   return left.size() == right.size() &&
          toystl::equal(left.cbegin(), left.cend(), right.cbegin());
 }
 
 // != 依靠 = 来实现
-template <class T, class Allocator>
-bool operator!=(const vector<T, Allocator>& left,
-                const vector<T, Allocator>& right) {
+template <class T, class Allocator, class Growth>
+bool operator!=(const vector<T, Allocator, Growth>& left,
+                const vector<T, Allocator, Growth>& right) {
   return !(left == right);
 }
 
-template <class T, class Allocator>
-bool operator<(const vector<T, Allocator>& left,
-               const vector<T, Allocator>& right) {
+template <class T, class Allocator, class Growth>
+bool operator<(const vector<T, Allocator, Growth>& left,
+               const vector<T, Allocator, Growth>& right) {
   return toystl::lexicographical_compare(left.cbegin(), left.cend(),
                                          right.cbegin(), right.cend());
 }
 
-template <class T, class Allocator>
-bool operator>(const vector<T, Allocator>& left,
-               const vector<T, Allocator>& right) {
+template <class T, class Allocator, class Growth>
+bool operator>(const vector<T, Allocator, Growth>& left,
+               const vector<T, Allocator, Growth>& right) {
   return right < left;
 }
 
-template <class T, class Allocator>
-bool operator<=(const vector<T, Allocator>& left,
-                const vector<T, Allocator>& right) {
+template <class T, class Allocator, class Growth>
+bool operator<=(const vector<T, Allocator, Growth>& left,
+                const vector<T, Allocator, Growth>& right) {
   return !(right < left);
 }
 
-template <class T, class Allocator>
-bool operator>=(const vector<T, Allocator>& left,
-                const vector<T, Allocator>& right) {
+template <class T, class Allocator, class Growth>
+bool operator>=(const vector<T, Allocator, Growth>& left,
+                const vector<T, Allocator, Growth>& right) {
   return !(left < right);
 }
 
-template <class T, class Allocator>
-void swap(vector<T, Allocator>& left, vector<T, Allocator>& right) {
+template <class T, class Allocator, class Growth>
+void swap(vector<T, Allocator, Growth>& left,
+          vector<T, Allocator, Growth>& right) {
   left.swap(right);
 }
 }  // namespace toystl